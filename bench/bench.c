@@ -0,0 +1,238 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+#include <kithare/core/ast.h>
+#include <kithare/core/error.h>
+#include <kithare/core/lexer.h>
+#include <kithare/core/parser.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/buffer.h>
+#include <kithare/lib/io.h>
+#include <kithare/lib/string.h>
+
+#include "corpus.h"
+
+
+typedef enum {
+    Phase_DECODE,
+    Phase_LEXICATE,
+    Phase_PARSE,
+    Phase_STRING,
+    Phase_DELETE,
+    Phase_COUNT
+} Phase;
+
+static const char* phase_names[Phase_COUNT] = {"decode", "lexicate", "parse", "string", "delete"};
+
+
+static double now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#endif
+}
+
+static size_t peakRssKb(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss / 1024; // In bytes there
+#else
+    return (size_t)usage.ru_maxrss;
+#endif
+#endif
+}
+
+static khstring stringOf(const char* cstring) {
+    khbuffer buffer = khbuffer_new(cstring);
+    khstring string = kh_decodeUtf8(&buffer);
+    khbuffer_delete(&buffer);
+    return string;
+}
+
+static int usage(void) {
+    fputs("usage: kcr-bench [--size <bytes>] [--seed <seed>] [--runs <runs>] [--file <file.kh>]\n"
+          "                 [--write <file.kh>]\n\n"
+          "Times each phase of the front-end over a generated corpus of about 4 MB, or over a file,\n"
+          "keeping the best of the runs, and prints the results as JSON. --write only writes the\n"
+          "corpus out to the file\n",
+          stderr);
+    return 1;
+}
+
+
+// Each phase runs once a run, and the best time of each is kept. The errors are the parser's ones,
+// which a generated corpus should have none of
+static void runPhases(khbuffer* source, size_t runs, double best[Phase_COUNT], size_t* token_count,
+                      size_t* statement_count, size_t* error_count) {
+    for (size_t i = 0; i < Phase_COUNT; i++) {
+        best[i] = -1.0;
+    }
+
+    for (size_t run = 0; run < runs; run++) {
+        double phases[Phase_COUNT];
+        double start = now();
+
+        khstring decoded = kh_decodeUtf8(source);
+        phases[Phase_DECODE] = now() - start;
+        khstring_delete(&decoded);
+
+        start = now();
+        kharray(khToken) tokens = kh_lexicate(source);
+        phases[Phase_LEXICATE] = now() - start;
+
+        // Cleaning up after lexing isn't part of any phase
+        *token_count = kharray_size(&tokens);
+        kharray_delete(&tokens);
+        kh_flushErrors();
+        kh_flushIdentifiers();
+
+        start = now();
+        kharray(khAstStatement) ast = kh_parse(source);
+        phases[Phase_PARSE] = now() - start;
+        *statement_count = kharray_size(&ast);
+        *error_count = kh_hasErrors();
+
+        start = now();
+        for (size_t i = 0; i < kharray_size(&ast); i++) {
+            khstring string = khAstStatement_string(&ast[i], *source);
+            khstring_delete(&string);
+        }
+        phases[Phase_STRING] = now() - start;
+
+        start = now();
+        kharray_delete(&ast);
+        phases[Phase_DELETE] = now() - start;
+
+        kh_flushErrors();
+        kh_flushIdentifiers();
+
+        for (size_t i = 0; i < Phase_COUNT; i++) {
+            if (best[i] < 0.0 || phases[i] < best[i]) {
+                best[i] = phases[i];
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t size = 4000000;
+    uint64_t seed = 0x4B697468617265u;
+    size_t runs = 5;
+    const char* file = NULL;
+    const char* write = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            return usage();
+        }
+
+        if (strcmp(argv[i], "--size") == 0) {
+            size = (size_t)strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--seed") == 0) {
+            seed = (uint64_t)strtoull(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "--runs") == 0) {
+            runs = (size_t)strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--file") == 0) {
+            file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--write") == 0) {
+            write = argv[++i];
+        }
+        else {
+            return usage();
+        }
+    }
+
+    if (runs == 0) {
+        return usage();
+    }
+
+    khbuffer source;
+    if (file != NULL) {
+        khstring file_name = stringOf(file);
+        bool success;
+        source = kh_readFile(&file_name, &success);
+        khstring_delete(&file_name);
+
+        if (!success) {
+            fprintf(stderr, "kcr-bench: could not read %s\n", file);
+            khbuffer_delete(&source);
+            return 1;
+        }
+    }
+    else {
+        source = bench_generateCorpus(size, seed);
+    }
+
+    if (write != NULL) {
+        khstring file_name = stringOf(write);
+        bool success = kh_writeFile(&file_name, source, khbuffer_size(&source));
+        khstring_delete(&file_name);
+        khbuffer_delete(&source);
+
+        if (!success) {
+            fprintf(stderr, "kcr-bench: could not write %s\n", write);
+        }
+        return !success;
+    }
+
+    double best[Phase_COUNT];
+    size_t token_count = 0;
+    size_t statement_count = 0;
+    size_t error_count = 0;
+    runPhases(&source, runs, best, &token_count, &statement_count, &error_count);
+
+    double megabytes = (double)khbuffer_size(&source) / 1e6;
+    printf("{\n\"source\": \"%s\",\n\"seed\": %llu,\n\"size\": %zu,\n\"runs\": %zu,\n\"tokens\": %zu,\n"
+           "\"statements\": %zu,\n\"errors\": %zu,\n\"phases\": {\n",
+           file != NULL ? "file" : "corpus", (unsigned long long)seed, khbuffer_size(&source), runs,
+           token_count, statement_count, error_count);
+
+    for (size_t i = 0; i < Phase_COUNT; i++) {
+        double seconds = best[i] > 0.0 ? best[i] : 1e-9;
+        printf("    \"%s\": {\"seconds\": %.6f, \"mb_per_s\": %.2f, \"tokens_per_s\": %.0f}%s\n",
+               phase_names[i], best[i], megabytes / seconds, (double)token_count / seconds,
+               i < Phase_COUNT - 1 ? "," : "");
+    }
+
+    printf("},\n\"peak_rss_kb\": %zu\n}\n", peakRssKb());
+
+    khbuffer_delete(&source);
+    return 0;
+}
@@ -0,0 +1,560 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <kithare/lib/buffer.h>
+
+#include "corpus.h"
+
+
+typedef struct {
+    khbuffer buffer;
+    uint64_t state;
+    size_t indent;
+} Generator;
+
+static const char* names[] = {
+    "value", "count", "index", "buffer", "node", "parent", "child", "left", "right", "size",
+    "offset", "result", "total", "width", "height", "depth", "key", "item", "scale", "cursor",
+    "limit", "token", "entry", "origin", "target", "state", "flags", "weight", "step", "length",
+};
+
+static const char* type_names[] = {
+    "Vector", "Matrix", "Parser", "Lexer", "Token", "Module", "Graph", "Buffer", "Stream", "Tree",
+    "Allocator", "Table", "Window", "Reader", "Writer", "Queue", "Scanner", "Visitor", "Symbol",
+    "Frame",
+};
+
+static const char* module_names[] = {
+    "std", "io", "math", "net", "os", "time", "util", "strings", "vec", "core", "json", "text",
+};
+
+static const char* types[] = {
+    "int", "uint", "float", "double", "char", "bool", "byte", "str", "long", "short",
+};
+
+static const char* binary_operators[] = {
+    " + ", " - ", " * ", " / ", " % ", " ^ ", " & ", " | ", " ~ ", " << ", " >> ", " @ ",
+    " < ", " > ", " <= ", " >= ", " == ", " != ", " and ", " or ", " xor ",
+};
+
+static const char* unary_operators[] = {"-", "+", "~", "not ", "++", "--"};
+
+static const char* assign_operators[] = {" = ", " += ", " -= ", " *= ", " /= ", " <<= ", " |= "};
+
+static const char* words[] = {
+    "the ", "quick ", "brown ", "fox ", "jumps ", "over ", "lazy ", "dog ", "lorem ", "ipsum ",
+    "\\n", "\\t", "\\\"", "\\\\", "\\x7F", "\\u00E9", "caf\xC3\xA9 ", "\xE6\x97\xA5\xE6\x9C\xAC ",
+    "\xF0\x9F\x8E\x89 ", "na\xC3\xAFve ", "%d ", "{} ",
+};
+
+#define COUNT(ARRAY) (sizeof(ARRAY) / sizeof(*(ARRAY)))
+
+
+// splitmix64, so the corpus only depends on the seed
+static inline uint64_t next(Generator* generator) {
+    uint64_t z = (generator->state += 0x9E3779B97F4A7C15u);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+    return z ^ (z >> 31);
+}
+
+static inline size_t below(Generator* generator, size_t bound) {
+    return (size_t)(next(generator) % bound);
+}
+
+static inline void emit(Generator* generator, const char* cstring) {
+    khbuffer_concatenateCstring(&generator->buffer, cstring);
+}
+
+static inline void emitNumber(Generator* generator, uint64_t number) {
+    char digits[24];
+    snprintf(digits, sizeof(digits), "%llu", (unsigned long long)number);
+    emit(generator, digits);
+}
+
+static inline void emitName(Generator* generator) {
+    emit(generator, names[below(generator, COUNT(names))]);
+    if (below(generator, 3) == 0) {
+        emitNumber(generator, below(generator, 100));
+    }
+}
+
+static inline void emitTypeName(Generator* generator) {
+    emit(generator, type_names[below(generator, COUNT(type_names))]);
+}
+
+static inline void emitLine(Generator* generator) {
+    khbuffer_append(&generator->buffer, '\n');
+    for (size_t i = 0; i < generator->indent; i++) {
+        emit(generator, "    ");
+    }
+}
+
+static void emitType(Generator* generator) {
+    switch (below(generator, 5)) {
+        case 0:
+            emitTypeName(generator);
+            emit(generator, "!(int, float)");
+            break;
+
+        case 1:
+            emitTypeName(generator);
+            emit(generator, "!");
+            emit(generator, types[below(generator, 6)]);
+            break;
+
+        default:
+            emit(generator, types[below(generator, COUNT(types))]);
+            break;
+    }
+}
+
+static void emitString(Generator* generator) {
+    switch (below(generator, 6)) {
+        case 0: {
+            emit(generator, "\"\"\"");
+            size_t lines = 1 + below(generator, 4);
+            for (size_t i = 0; i < lines; i++) {
+                size_t count = 4 + below(generator, 12);
+                for (size_t j = 0; j < count; j++) {
+                    emit(generator, words[below(generator, 10)]);
+                }
+                emit(generator, "\n");
+            }
+            emit(generator, "\"\"\"");
+        } break;
+
+        case 1:
+            emit(generator, below(generator, 2) ? "b\"buf\\x00\\xFF\"" : "'c'");
+            break;
+
+        default: {
+            emit(generator, "\"");
+            size_t count = 2 + below(generator, below(generator, 8) == 0 ? 80 : 16);
+            for (size_t i = 0; i < count; i++) {
+                emit(generator, words[below(generator, COUNT(words))]);
+            }
+            emit(generator, "\"");
+        } break;
+    }
+}
+
+static void emitLiteral(Generator* generator) {
+    switch (below(generator, 10)) {
+        case 0:
+            emitNumber(generator, next(generator) >> below(generator, 64));
+            emit(generator, "u");
+            break;
+
+        case 1:
+            emitNumber(generator, below(generator, 1000));
+            emit(generator, ".");
+            emitNumber(generator, below(generator, 1000));
+            emit(generator, below(generator, 2) ? "e3" : "f");
+            break;
+
+        case 2:
+            emit(generator, below(generator, 2) ? "0xFF" : "0b1011");
+            break;
+
+        case 3:
+        case 4:
+            emitString(generator);
+            break;
+
+        default:
+            emitNumber(generator, below(generator, 100000));
+            break;
+    }
+}
+
+static void emitExpression(Generator* generator, size_t depth);
+
+static void emitArguments(Generator* generator, size_t depth) {
+    size_t count = below(generator, 4);
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) {
+            emit(generator, ", ");
+        }
+        emitExpression(generator, depth);
+    }
+}
+
+static void emitPrimary(Generator* generator, size_t depth) {
+    if (depth == 0) {
+        if (below(generator, 2)) {
+            emitName(generator);
+        }
+        else {
+            emitLiteral(generator);
+        }
+        return;
+    }
+
+    switch (below(generator, 14)) {
+        case 0:
+            emit(generator, "(");
+            emitExpression(generator, depth - 1);
+            emit(generator, ")");
+            break;
+
+        case 1:
+            emit(generator, "[");
+            emitArguments(generator, depth - 1);
+            emit(generator, "]");
+            break;
+
+        case 2: {
+            emit(generator, "{");
+            size_t count = 1 + below(generator, 3);
+            for (size_t i = 0; i < count; i++) {
+                if (i > 0) {
+                    emit(generator, ", ");
+                }
+                emitLiteral(generator);
+                emit(generator, ": ");
+                emitExpression(generator, depth - 1);
+            }
+            emit(generator, "}");
+        } break;
+
+        case 3:
+            emit(generator, "(");
+            emitExpression(generator, depth - 1);
+            emit(generator, ", ");
+            emitExpression(generator, depth - 1);
+            emit(generator, ")");
+            break;
+
+        case 4:
+            emit(generator, "def(a: int, b: float) -> int { return a");
+            emit(generator, binary_operators[below(generator, 4)]);
+            emitExpression(generator, depth - 1);
+            emit(generator, " }");
+            break;
+
+        case 5:
+        case 6:
+            emitName(generator);
+            emit(generator, "(");
+            emitArguments(generator, depth - 1);
+            emit(generator, ")");
+            break;
+
+        case 7:
+            emitName(generator);
+            emit(generator, "[");
+            emitExpression(generator, depth - 1);
+            emit(generator, "]");
+            break;
+
+        case 8:
+            emitName(generator);
+            emit(generator, ".");
+            emitName(generator);
+            emit(generator, ".");
+            emitName(generator);
+            break;
+
+        case 9:
+            emitTypeName(generator);
+            emit(generator, "!int(");
+            emitArguments(generator, depth - 1);
+            emit(generator, ")");
+            break;
+
+        case 10:
+            emit(generator, unary_operators[below(generator, COUNT(unary_operators))]);
+            emitPrimary(generator, depth - 1);
+            break;
+
+        default:
+            emitPrimary(generator, 0);
+            break;
+    }
+}
+
+static void emitExpression(Generator* generator, size_t depth) {
+    emitPrimary(generator, depth);
+
+    size_t operations = depth == 0 ? 0 : below(generator, 4);
+    for (size_t i = 0; i < operations; i++) {
+        const char* operator = binary_operators[below(generator, COUNT(binary_operators))];
+        emit(generator, operator);
+
+        // Unary operators bind looser than `^`, so they can't follow it
+        emitPrimary(generator, operator[1] == '^' ? 0 : depth - 1);
+    }
+
+    if (depth > 0 && below(generator, 16) == 0) {
+        emit(generator, " if ");
+        emitPrimary(generator, depth - 1);
+        emit(generator, " else ");
+        emitPrimary(generator, depth - 1);
+    }
+}
+
+// Mostly shallow, but every so often deep enough to nest a few hundred tokens
+static inline size_t expressionDepth(Generator* generator) {
+    return below(generator, 8) == 0 ? 5 : 1 + below(generator, 3);
+}
+
+static void emitBlock(Generator* generator, size_t depth);
+
+static void emitStatement(Generator* generator, size_t depth) {
+    emitLine(generator);
+
+    switch (below(generator, depth == 0 ? 4 : 12)) {
+        case 0:
+            emit(generator, below(generator, 4) ? "" : below(generator, 2) ? "ref " : "wild ");
+            emitName(generator);
+            emit(generator, ": ");
+            emitType(generator);
+            emit(generator, " = ");
+            emitExpression(generator, expressionDepth(generator));
+            break;
+
+        case 1:
+            emitName(generator);
+            emit(generator, " := ");
+            emitExpression(generator, expressionDepth(generator));
+            break;
+
+        case 2:
+            emitName(generator);
+            emit(generator, assign_operators[below(generator, COUNT(assign_operators))]);
+            emitExpression(generator, 1 + below(generator, 3));
+            break;
+
+        case 3:
+            emitName(generator);
+            emit(generator, "(");
+            emitArguments(generator, 2);
+            emit(generator, ")");
+            break;
+
+        case 4:
+        case 5:
+            emit(generator, "if ");
+            emitExpression(generator, 2);
+            emitBlock(generator, depth - 1);
+            while (below(generator, 3) == 0) {
+                emit(generator, " elif ");
+                emitExpression(generator, 2);
+                emitBlock(generator, depth - 1);
+            }
+            if (below(generator, 2)) {
+                emit(generator, " else");
+                emitBlock(generator, depth - 1);
+            }
+            break;
+
+        case 6:
+            emit(generator, "while ");
+            emitExpression(generator, 2);
+            emitBlock(generator, depth - 1);
+            break;
+
+        case 7:
+            emit(generator, "do");
+            emitBlock(generator, depth - 1);
+            emit(generator, " while ");
+            emitExpression(generator, 1);
+            break;
+
+        case 8:
+            emit(generator, "for ");
+            emitName(generator);
+            emit(generator, below(generator, 2) ? ", j in 0.." : " in 0..");
+            emitExpression(generator, 1);
+            emitBlock(generator, depth - 1);
+            break;
+
+        case 9:
+            emit(generator, "return ");
+            emitExpression(generator, expressionDepth(generator));
+            break;
+
+        case 10:
+            emit(generator, below(generator, 2) ? "break" : "continue");
+            break;
+
+        default:
+            emit(generator, "# ");
+            emit(generator, words[below(generator, 10)]);
+            emitLine(generator);
+            emitName(generator);
+            emit(generator, ", ");
+            emitName(generator);
+            emit(generator, " := ");
+            emitExpression(generator, expressionDepth(generator));
+            break;
+    }
+}
+
+static void emitBlock(Generator* generator, size_t depth) {
+    emit(generator, " {");
+    generator->indent++;
+
+    size_t count = 1 + below(generator, 5);
+    for (size_t i = 0; i < count; i++) {
+        emitStatement(generator, depth);
+    }
+
+    generator->indent--;
+    emitLine(generator);
+    emit(generator, "}");
+}
+
+static void emitFunction(Generator* generator) {
+    emit(generator, below(generator, 4) == 0 ? "static def " : "def ");
+    emitName(generator);
+    if (below(generator, 4) == 0) {
+        emit(generator, "!(T, U)");
+    }
+
+    emit(generator, "(");
+    size_t arguments = below(generator, 5);
+    for (size_t i = 0; i < arguments; i++) {
+        if (i > 0) {
+            emit(generator, ", ");
+        }
+        emitName(generator);
+        emit(generator, ": ");
+        emitType(generator);
+        if (i + 1 == arguments && below(generator, 3) == 0) {
+            emit(generator, " = ");
+            emitLiteral(generator);
+        }
+    }
+    emit(generator, ")");
+
+    if (below(generator, 3)) {
+        emit(generator, " -> ");
+        emitType(generator);
+    }
+
+    emitBlock(generator, 1 + below(generator, 3));
+}
+
+static void emitClass(Generator* generator) {
+    bool is_class = below(generator, 3);
+    emit(generator, is_class ? "class " : "struct ");
+    emitTypeName(generator);
+    emitNumber(generator, below(generator, 1000));
+    if (below(generator, 2)) {
+        emit(generator, "!T");
+    }
+    if (is_class && below(generator, 2)) {
+        emit(generator, " inherits ");
+        emitTypeName(generator);
+    }
+
+    emit(generator, " {");
+    generator->indent++;
+
+    size_t fields = 1 + below(generator, 6);
+    for (size_t i = 0; i < fields; i++) {
+        emitLine(generator);
+        emitName(generator);
+        emit(generator, ": ");
+        emitType(generator);
+        if (below(generator, 2)) {
+            emit(generator, " = ");
+            emitExpression(generator, 1);
+        }
+    }
+
+    size_t methods = below(generator, 4);
+    for (size_t i = 0; i < methods; i++) {
+        emitLine(generator);
+        emitLine(generator);
+        emitFunction(generator);
+    }
+
+    generator->indent--;
+    emitLine(generator);
+    emit(generator, "}");
+}
+
+static void emitEnum(Generator* generator) {
+    emit(generator, "enum ");
+    emitTypeName(generator);
+    emitNumber(generator, below(generator, 1000));
+    emit(generator, " {");
+
+    size_t members = 1 + below(generator, 10);
+    for (size_t i = 0; i < members; i++) {
+        emit(generator, i > 0 ? ", " : " ");
+        emit(generator, names[below(generator, COUNT(names))]);
+        emitNumber(generator, i);
+    }
+    emit(generator, " }");
+}
+
+static void emitDependency(Generator* generator) {
+    bool is_import = below(generator, 4);
+    emit(generator, is_import ? "import " : "include ");
+    if (below(generator, 4) == 0) {
+        emit(generator, ".");
+    }
+
+    size_t parts = 1 + below(generator, 3);
+    for (size_t i = 0; i < parts; i++) {
+        if (i > 0) {
+            emit(generator, ".");
+        }
+        emit(generator, module_names[below(generator, COUNT(module_names))]);
+    }
+
+    if (is_import && below(generator, 3) == 0) {
+        emit(generator, " as ");
+        emit(generator, module_names[below(generator, COUNT(module_names))]);
+    }
+}
+
+
+khbuffer bench_generateCorpus(size_t size, uint64_t seed) {
+    Generator generator = {.buffer = khbuffer_new(""), .state = seed, .indent = 0};
+    khbuffer_reserve(&generator.buffer, size + 4096);
+
+    // Every few declarations come some imports, like where a new file would start
+    while (khbuffer_size(&generator.buffer) < size) {
+        size_t declaration = below(&generator, 32);
+        if (declaration < 2) {
+            size_t count = 1 + below(&generator, 6);
+            for (size_t i = 0; i < count; i++) {
+                emitDependency(&generator);
+                emitLine(&generator);
+            }
+        }
+        else if (declaration < 12) {
+            emitClass(&generator);
+        }
+        else if (declaration < 14) {
+            emitEnum(&generator);
+        }
+        else if (declaration < 16) {
+            emitName(&generator);
+            emit(&generator, ": ");
+            emitType(&generator);
+            emit(&generator, " = ");
+            emitExpression(&generator, 3);
+        }
+        else {
+            emitFunction(&generator);
+        }
+
+        emitLine(&generator);
+        emitLine(&generator);
+    }
+
+    return generator.buffer;
+}
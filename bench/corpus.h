@@ -0,0 +1,27 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <kithare/lib/buffer.h>
+
+
+// A Kithare source of about that many bytes, the same one for the same seed: imports and includes,
+// classes, structs and enums with fields and methods, functions of nested control flow, deeply nested
+// expressions and long string literals. It isn't meant to make sense, only to parse like real code
+khbuffer bench_generateCorpus(size_t size, uint64_t seed);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -40,6 +40,15 @@ means that you want to use 4 cores, and so on.
 To just run tests, do 'python3 build.py --make test'. Note that this command is
 only going to run the tests, it does not do anything else.
 
+To benchmark the lexer and parser, do 'python3 build.py --make bench'. This
+builds Kithare along with a 'kcr-bench' executable next to it, and runs the
+latter over a generated corpus of Kithare sources. Run it yourself for its
+options, like 'kcr-bench --size 16000000' or 'kcr-bench --write corpus.kh'.
+
+For 'kcr lexicate --stats' and 'kcr parse --stats', which print the time of
+each phase and counts of tokens, AST nodes and allocations, build with
+'CFLAGS=-Dkh_STATS python3 build.py'. Without it, none of that is compiled in.
+
 'python3 build.py --clean {action}' can be used to clean generated files or
 folders, where action can be:
 - dep: Cleans installed dependencies
@@ -19,6 +19,7 @@ from typing import Optional
 from .cflags import CompilerFlags
 from .compilerpool import CompilerPool
 from .constants import (
+    BENCH_EXE,
     C_STD_FLAG,
     COMPILER,
     CPP_STD_FLAG,
@@ -79,6 +80,7 @@ class KithareBuilder:
             args.make == "installer",
         )
 
+        self.make: Optional[str] = args.make
         self._handle_make_and_clean(args.make, args.clean)
         self.j_flag: Optional[int] = args.j
         if self.j_flag is not None and self.j_flag <= 0:
@@ -221,16 +223,39 @@ class KithareBuilder:
 
         self.cflags.load_from_env()
 
-    def build_sources(self, build_skippable: bool):
+    def get_sources(self, srcdir: str = "src"):
+        """
+        Get the C and CPP source files in srcdir, each paired with its objfile
+        """
+        sources: list[tuple[Path, Path]] = []
+        objdir = self.builddir if srcdir == "src" else self.builddir / srcdir
+        for file in self.basepath.glob(f"{srcdir}/**/*.c*"):
+            if file.suffix not in {".c", ".cpp"}:
+                # not a C or CPP file
+                continue
+
+            ofile = objdir / f"{file.stem}.o"
+            if any(ofile == other for _, other in sources):
+                raise BuildError("Got duplicate filename in Kithare source")
+
+            sources.append((file, ofile))
+
+        return sources
+
+    def build_sources(self, build_skippable: bool, srcdir: str = "src"):
         """
         Generate obj files from source files, returns a list of generated
         objfiles. May also return None if all older objfiles are up date and
-        dist exe already exists.
+        dist exe already exists. srcdir is the dir of the sources, relative
+        to the repo, whose objfiles go into a subdir of the same name unless
+        it is 'src'
         """
         skipped_files: list[Path] = []
         objfiles: list[Path] = []
+        objdir = self.builddir if srcdir == "src" else self.builddir / srcdir
+        objdir.mkdir(parents=True, exist_ok=True)
 
-        print("Building Kithare sources...")
+        print(f"Building Kithare sources in '{srcdir}'...")
         compilerpool = CompilerPool(self.j_flag, self.cflags)
 
         print(f"Building on {min(compilerpool.maxpoolsize, CPU_COUNT)} core(s)")
@@ -238,15 +263,7 @@ class KithareBuilder:
             print(f"Using {compilerpool.maxpoolsize} subprocess(es)")
 
         print()  # newline
-        for file in self.basepath.glob("src/**/*.c*"):
-            if file.suffix not in {".c", ".cpp"}:
-                # not a C or CPP file
-                continue
-
-            ofile = self.builddir / f"{file.stem}.o"
-            if ofile in objfiles:
-                raise BuildError("Got duplicate filename in Kithare source")
-
+        for file, ofile in self.get_sources(srcdir):
             objfiles.append(ofile)
             if build_skippable and not should_build(
                 file, ofile, self.basepath / INCLUDE_DIRNAME
@@ -306,6 +323,9 @@ class KithareBuilder:
             self.cflags.to_json(build_conf)
 
         objfiles = self.build_sources(build_skippable)
+        if self.make == "bench":
+            self.build_bench(build_skippable, objfiles is None)
+
         if objfiles is None:
             print("Skipping final exe(s) build, since it is already built")
             return
@@ -367,6 +387,41 @@ class KithareBuilder:
 
         print("Kithare has been built successfully!")
 
+    def build_bench(self, build_skippable: bool, kithare_built: bool):
+        """
+        Generate the benchmark exe, from the sources in 'bench' and every
+        Kithare source but the CLI, which has the main of kcr. kithare_built
+        tells whether the objfiles of the latter were all up to date
+        """
+        benchpath = self.exepath.with_name(BENCH_EXE)
+        benchfiles = self.build_sources(build_skippable, "bench")
+        if benchfiles is None and kithare_built and benchpath.is_file():
+            print("Skipping benchmark exe build, since it is already built")
+            return
+
+        # from the current sources, as stale objfiles of removed ones may be left
+        objfiles = [ofile for _, ofile in self.get_sources() if ofile.stem != "cli"]
+        objfiles.extend(ofile for _, ofile in self.get_sources("bench"))
+
+        print("Building benchmark executable")
+        run_cmd(
+            self.cflags.get_compiler(),
+            "-o",
+            benchpath,
+            *objfiles,
+            *self.cflags.flags_by_ext("o"),
+            strict=True,
+        )
+        print()  # newline
+
+    def run_bench(self):
+        """
+        Run the benchmark exe over the generated corpus, it prints its results
+        as JSON
+        """
+        print("Running benchmarks")
+        sys.exit(run_cmd(self.exepath.with_name(BENCH_EXE)))
+
     def build(self):
         """
         Build Kithare
@@ -409,3 +464,7 @@ class KithareBuilder:
 
         if t_4 - t_3 > 0.042:
             print(f"Generating the installer took {t_4 - t_3:.3f} seconds")
+
+        if self.make == "bench":
+            print()  # newline
+            self.run_bench()
@@ -24,8 +24,10 @@ VERSION_PACKAGE_REV = "0"
 
 COMPILER = "MinGW" if platform.system() == "Windows" else "GCC"
 EXE = "kcr"
+BENCH_EXE = "kcr-bench"
 if COMPILER == "MinGW":
     EXE += ".exe"
+    BENCH_EXE += ".exe"
 
 _CPU_COUNT = os.cpu_count()
 CPU_COUNT = 1 if _CPU_COUNT is None else _CPU_COUNT
@@ -391,7 +391,7 @@ def parse_args():
 
     parser.add_argument(
         "--make",
-        choices=("debug", "test", "installer"),
+        choices=("debug", "test", "installer", "bench"),
         help="Specifies the action that the build script should take",
     )
 
@@ -11,11 +11,13 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <kithare/lib/array.h>
 #include <kithare/lib/buffer.h>
 #include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
 
 
 typedef struct khAstStatement khAstStatement;
@@ -45,6 +47,7 @@ typedef enum {
     khAstStatementType_RETURN
 } khAstStatementType;
 
+const char* khAstStatementType_name(khAstStatementType type);
 khstring khAstStatementType_string(khAstStatementType type);
 
 
@@ -60,7 +63,7 @@ typedef struct {
 
 khAstVariable khAstVariable_copy(khAstVariable* variable);
 void khAstVariable_delete(khAstVariable* variable);
-khstring khAstVariable_string(khAstVariable* variable, char32_t* origin);
+void khAstVariable_write(khAstVariable* variable, uint8_t* origin, khWriter* writer);
 
 
 typedef enum {
@@ -97,6 +100,7 @@ typedef enum {
     khAstExpressionType_TEMPLATIZE
 } khAstExpressionType;
 
+const char* khAstExpressionType_name(khAstExpressionType type);
 khstring khAstExpressionType_string(khAstExpressionType type);
 
 
@@ -106,7 +110,7 @@ typedef struct {
 
 khAstTuple khAstTuple_copy(khAstTuple* tuple);
 void khAstTuple_delete(khAstTuple* tuple);
-khstring khAstTuple_string(khAstTuple* tuple, char32_t* origin);
+void khAstTuple_write(khAstTuple* tuple, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -115,7 +119,7 @@ typedef struct {
 
 khAstArray khAstArray_copy(khAstArray* array);
 void khAstArray_delete(khAstArray* array);
-khstring khAstArray_string(khAstArray* array, char32_t* origin);
+void khAstArray_write(khAstArray* array, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -125,7 +129,7 @@ typedef struct {
 
 khAstDict khAstDict_copy(khAstDict* dict);
 void khAstDict_delete(khAstDict* dict);
-khstring khAstDict_string(khAstDict* dict, char32_t* origin);
+void khAstDict_write(khAstDict* dict, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -138,7 +142,7 @@ typedef struct {
 khAstSignature khAstSignature_copy(khAstSignature* signature);
 
 void khAstSignature_delete(khAstSignature* signature);
-khstring khAstSignature_string(khAstSignature* signature, char32_t* origin);
+void khAstSignature_write(khAstSignature* signature, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -151,7 +155,7 @@ typedef struct {
 
 khAstLambda khAstLambda_copy(khAstLambda* lambda);
 void khAstLambda_delete(khAstLambda* lambda);
-khstring khAstLambda_string(khAstLambda* lambda, char32_t* origin);
+void khAstLambda_write(khAstLambda* lambda, uint8_t* origin, khWriter* writer);
 
 
 typedef enum {
@@ -162,6 +166,7 @@ typedef enum {
     khAstUnaryExpressionType_BIT_NOT
 } khAstUnaryExpressionType;
 
+const char* khAstUnaryExpressionType_name(khAstUnaryExpressionType type);
 khstring khAstUnaryExpressionType_string(khAstUnaryExpressionType type);
 
 
@@ -172,7 +177,7 @@ typedef struct {
 
 khAstUnaryExpression khAstUnaryExpression_copy(khAstUnaryExpression* unary_exp);
 void khAstUnaryExpression_delete(khAstUnaryExpression* unary_exp);
-khstring khAstUnaryExpression_string(khAstUnaryExpression* unary_exp, char32_t* origin);
+void khAstUnaryExpression_write(khAstUnaryExpression* unary_exp, uint8_t* origin, khWriter* writer);
 
 
 typedef enum {
@@ -212,6 +217,7 @@ typedef enum {
     khAstBinaryExpressionType_IP_BIT_RSHIFT
 } khAstBinaryExpressionType;
 
+const char* khAstBinaryExpressionType_name(khAstBinaryExpressionType type);
 khstring khAstBinaryExpressionType_string(khAstBinaryExpressionType type);
 
 
@@ -223,7 +229,7 @@ typedef struct {
 
 khAstBinaryExpression khAstBinaryExpression_copy(khAstBinaryExpression* binary_exp);
 void khAstBinaryExpression_delete(khAstBinaryExpression* binary_exp);
-khstring khAstBinaryExpression_string(khAstBinaryExpression* binary_exp, char32_t* origin);
+void khAstBinaryExpression_write(khAstBinaryExpression* binary_exp, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -234,7 +240,8 @@ typedef struct {
 
 khAstTernaryExpression khAstTernaryExpression_copy(khAstTernaryExpression* ternary_exp);
 void khAstTernaryExpression_delete(khAstTernaryExpression* ternary_exp);
-khstring khAstTernaryExpression_string(khAstTernaryExpression* ternary_exp, char32_t* origin);
+void khAstTernaryExpression_write(khAstTernaryExpression* ternary_exp, uint8_t* origin,
+                                  khWriter* writer);
 
 
 typedef enum {
@@ -246,6 +253,7 @@ typedef enum {
     khAstComparisonExpressionType_GREATER_EQUAL
 } khAstComparisonExpressionType;
 
+const char* khAstComparisonExpressionType_name(khAstComparisonExpressionType type);
 khstring khAstComparisonExpressionType_string(khAstComparisonExpressionType type);
 
 
@@ -256,7 +264,8 @@ typedef struct {
 
 khAstComparisonExpression khAstComparisonExpression_copy(khAstComparisonExpression* comparison_exp);
 void khAstComparisonExpression_delete(khAstComparisonExpression* comparison_exp);
-khstring khAstComparisonExpression_string(khAstComparisonExpression* comparison_exp, char32_t* origin);
+void khAstComparisonExpression_write(khAstComparisonExpression* comparison_exp, uint8_t* origin,
+                                     khWriter* writer);
 
 
 typedef struct {
@@ -266,7 +275,7 @@ typedef struct {
 
 khAstCallExpression khAstCallExpression_copy(khAstCallExpression* call_exp);
 void khAstCallExpression_delete(khAstCallExpression* call_exp);
-khstring khAstCallExpression_string(khAstCallExpression* call_exp, char32_t* origin);
+void khAstCallExpression_write(khAstCallExpression* call_exp, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -276,7 +285,7 @@ typedef struct {
 
 khAstIndexExpression khAstIndexExpression_copy(khAstIndexExpression* index_exp);
 void khAstIndexExpression_delete(khAstIndexExpression* index_exp);
-khstring khAstIndexExpression_string(khAstIndexExpression* index_exp, char32_t* origin);
+void khAstIndexExpression_write(khAstIndexExpression* index_exp, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -286,7 +295,7 @@ typedef struct {
 
 khAstScopeExpression khAstScopeExpression_copy(khAstScopeExpression* scope_exp);
 void khAstScopeExpression_delete(khAstScopeExpression* scope_exp);
-khstring khAstScopeExpression_string(khAstScopeExpression* scope_exp, char32_t* origin);
+void khAstScopeExpression_write(khAstScopeExpression* scope_exp, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -296,12 +305,13 @@ typedef struct {
 
 khAstTemplatizeExpression khAstTemplatizeExpression_copy(khAstTemplatizeExpression* templatize_exp);
 void khAstTemplatizeExpression_delete(khAstTemplatizeExpression* templatize_exp);
-khstring khAstTemplatizeExpression_string(khAstTemplatizeExpression* templatize_exp, char32_t* origin);
+void khAstTemplatizeExpression_write(khAstTemplatizeExpression* templatize_exp, uint8_t* origin,
+                                     khWriter* writer);
 
 
 struct khAstExpression {
-    char32_t* begin;
-    char32_t* end;
+    uint8_t* begin;
+    uint8_t* end;
 
     khAstExpressionType type;
     union {
@@ -338,7 +348,18 @@ struct khAstExpression {
 
 khAstExpression khAstExpression_copy(khAstExpression* expression);
 void khAstExpression_delete(khAstExpression* expression);
-khstring khAstExpression_string(khAstExpression* expression, char32_t* origin);
+void khAstExpression_write(khAstExpression* expression, uint8_t* origin, khWriter* writer);
+khstring khAstExpression_string(khAstExpression* expression, uint8_t* origin);
+// Moves every position in it by the offset, for when its source has moved
+void khAstExpression_relocate(khAstExpression* expression, ptrdiff_t offset);
+
+// Takes the expression out, leaving an invalid one with nothing to delete in its place, so whatever
+// held it can be deleted without it
+static inline khAstExpression khAstExpression_move(khAstExpression* expression) {
+    khAstExpression moved = *expression;
+    *expression = (khAstExpression){.begin = NULL, .end = NULL, .type = khAstExpressionType_INVALID};
+    return moved;
+}
 
 
 typedef struct {
@@ -349,7 +370,7 @@ typedef struct {
 
 khAstImport khAstImport_copy(khAstImport* import_v);
 void khAstImport_delete(khAstImport* import_v);
-khstring khAstImport_string(khAstImport* import_v, char32_t* origin);
+void khAstImport_write(khAstImport* import_v, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -359,7 +380,7 @@ typedef struct {
 
 khAstInclude khAstInclude_copy(khAstInclude* include);
 void khAstInclude_delete(khAstInclude* include);
-khstring khAstInclude_string(khAstInclude* include, char32_t* origin);
+void khAstInclude_write(khAstInclude* include, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -376,7 +397,7 @@ typedef struct {
 
 khAstFunction khAstFunction_copy(khAstFunction* function);
 void khAstFunction_delete(khAstFunction* function);
-khstring khAstFunction_string(khAstFunction* function, char32_t* origin);
+void khAstFunction_write(khAstFunction* function, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -389,7 +410,7 @@ typedef struct {
 
 khAstClass khAstClass_copy(khAstClass* class_v);
 void khAstClass_delete(khAstClass* class_v);
-khstring khAstClass_string(khAstClass* class_v, char32_t* origin);
+void khAstClass_write(khAstClass* class_v, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -401,7 +422,7 @@ typedef struct {
 
 khAstStruct khAstStruct_copy(khAstStruct* struct_v);
 void khAstStruct_delete(khAstStruct* struct_v);
-khstring khAstStruct_string(khAstStruct* struct_v, char32_t* origin);
+void khAstStruct_write(khAstStruct* struct_v, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -411,7 +432,7 @@ typedef struct {
 
 khAstEnum khAstEnum_copy(khAstEnum* enum_v);
 void khAstEnum_delete(khAstEnum* enum_v);
-khstring khAstEnum_string(khAstEnum* enum_v, char32_t* origin);
+void khAstEnum_write(khAstEnum* enum_v, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -422,7 +443,7 @@ typedef struct {
 
 khAstAlias khAstAlias_copy(khAstAlias* alias);
 void khAstAlias_delete(khAstAlias* alias);
-khstring khAstAlias_string(khAstAlias* alias, char32_t* origin);
+void khAstAlias_write(khAstAlias* alias, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -433,7 +454,7 @@ typedef struct {
 
 khAstIfBranch khAstIfBranch_copy(khAstIfBranch* if_branch);
 void khAstIfBranch_delete(khAstIfBranch* if_branch);
-khstring khAstIfBranch_string(khAstIfBranch* if_branch, char32_t* origin);
+void khAstIfBranch_write(khAstIfBranch* if_branch, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -443,7 +464,7 @@ typedef struct {
 
 khAstWhileLoop khAstWhileLoop_copy(khAstWhileLoop* while_loop);
 void khAstWhileLoop_delete(khAstWhileLoop* while_loop);
-khstring khAstWhileLoop_string(khAstWhileLoop* while_loop, char32_t* origin);
+void khAstWhileLoop_write(khAstWhileLoop* while_loop, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -453,7 +474,7 @@ typedef struct {
 
 khAstDoWhileLoop khAstDoWhileLoop_copy(khAstDoWhileLoop* do_while_loop);
 void khAstDoWhileLoop_delete(khAstDoWhileLoop* do_while_loop);
-khstring khAstDoWhileLoop_string(khAstDoWhileLoop* do_while_loop, char32_t* origin);
+void khAstDoWhileLoop_write(khAstDoWhileLoop* do_while_loop, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -464,7 +485,7 @@ typedef struct {
 
 khAstForLoop khAstForLoop_copy(khAstForLoop* for_loop);
 void khAstForLoop_delete(khAstForLoop* for_loop);
-khstring khAstForLoop_string(khAstForLoop* for_loop, char32_t* origin);
+void khAstForLoop_write(khAstForLoop* for_loop, uint8_t* origin, khWriter* writer);
 
 
 typedef struct {
@@ -473,12 +494,12 @@ typedef struct {
 
 khAstReturn khAstReturn_copy(khAstReturn* return_v);
 void khAstReturn_delete(khAstReturn* return_v);
-khstring khAstReturn_string(khAstReturn* return_v, char32_t* origin);
+void khAstReturn_write(khAstReturn* return_v, uint8_t* origin, khWriter* writer);
 
 
 struct khAstStatement {
-    char32_t* begin;
-    char32_t* end;
+    uint8_t* begin;
+    uint8_t* end;
 
     khAstStatementType type;
     union {
@@ -503,7 +524,21 @@ struct khAstStatement {
 
 khAstStatement khAstStatement_copy(khAstStatement* ast);
 void khAstStatement_delete(khAstStatement* ast);
-khstring khAstStatement_string(khAstStatement* ast, char32_t* origin);
+void khAstStatement_write(khAstStatement* ast, uint8_t* origin, khWriter* writer);
+khstring khAstStatement_string(khAstStatement* ast, uint8_t* origin);
+void khAstStatement_relocate(khAstStatement* ast, ptrdiff_t offset);
+
+
+// Functions called on each expression and statement in a node, parents before their children; either
+// of them can be NULL
+typedef struct {
+    void (*expression)(khAstExpression* expression, void* data);
+    void (*statement)(khAstStatement* statement, void* data);
+    void* data;
+} khAstVisitor;
+
+void khAstExpression_visit(khAstExpression* expression, khAstVisitor* visitor);
+void khAstStatement_visit(khAstStatement* statement, khAstVisitor* visitor);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,136 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <kithare/lib/array.h>
+#include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
+
+
+// Operations of the register machine, typed by what they operate on, as every register's type is known
+// when it's compiled. `a`, `b` and `c` are registers of the frame unless said otherwise, and `wide` is
+// either an immediate, an index, or a jump offset from the instruction after it
+typedef enum {
+    khOpcode_MOVE,          // a = b
+    khOpcode_LOAD_INT,      // a = wide
+    khOpcode_LOAD_CONSTANT, // a = constants[wide]
+    khOpcode_LOAD_STRING,   // a = &strings[wide]
+
+    khOpcode_INT_TO_FLOAT, // a = (float)b
+    khOpcode_FLOAT_TO_INT, // a = (int)b, truncated
+    khOpcode_TO_BOOL,      // a = b != 0
+
+    khOpcode_ADD_INT,
+    khOpcode_ADD_INT_IMMEDIATE, // a = b + c, c being a signed immediate
+    khOpcode_SUB_INT,
+    khOpcode_MUL_INT,
+    khOpcode_DIV_INT, // Truncated, raising on a division by zero like MOD_INT
+    khOpcode_MOD_INT,
+    khOpcode_POW_INT,
+    khOpcode_NEGATE_INT,
+    khOpcode_BIT_AND,
+    khOpcode_BIT_OR,
+    khOpcode_BIT_XOR,
+    khOpcode_BIT_NOT,
+    khOpcode_BIT_LSHIFT, // By the count modulo 64, like BIT_RSHIFT
+    khOpcode_BIT_RSHIFT,
+
+    khOpcode_ADD_FLOAT,
+    khOpcode_SUB_FLOAT,
+    khOpcode_MUL_FLOAT,
+    khOpcode_DIV_FLOAT,
+    khOpcode_MOD_FLOAT,
+    khOpcode_POW_FLOAT,
+    khOpcode_NEGATE_FLOAT,
+
+    // Results are bools, 0 or 1; greater ones are less ones with their operands swapped
+    khOpcode_EQUAL_INT,
+    khOpcode_UNEQUAL_INT,
+    khOpcode_LESS_INT,
+    khOpcode_LESS_EQUAL_INT,
+    khOpcode_EQUAL_FLOAT,
+    khOpcode_UNEQUAL_FLOAT,
+    khOpcode_LESS_FLOAT,
+    khOpcode_LESS_EQUAL_FLOAT,
+    khOpcode_NOT,
+
+    khOpcode_JUMP,        // By wide
+    khOpcode_JUMP_IF,     // By wide, if a isn't 0
+    khOpcode_JUMP_UNLESS, // By wide, if a is 0
+
+    khOpcode_CALL,           // Function wide, its frame starting at a, where its arguments are
+    khOpcode_RETURN,         // The caller's register at the start of this frame = a
+    khOpcode_RETURN_NONE,    // Also ends the script, from its top-level
+    khOpcode_MISSING_RETURN, // At the end of functions returning values, raising when it's reached
+
+    // Print a, then the character b unless it's 0
+    khOpcode_PRINT_INT,
+    khOpcode_PRINT_FLOAT,
+    khOpcode_PRINT_BOOL,
+    khOpcode_PRINT_STRING,
+    khOpcode_PRINT_CHAR, // Only the character b
+
+    khOpcode_COUNT
+} khOpcode;
+
+const char* khOpcode_name(khOpcode opcode);
+khstring khOpcode_string(khOpcode opcode);
+
+
+// 8 bytes, either three registers or a register and a wide operand
+typedef struct {
+    uint16_t opcode;
+    uint16_t a;
+    union {
+        struct {
+            uint16_t b;
+            uint16_t c;
+        };
+        int32_t wide;
+    };
+} khInstruction;
+
+// Registers aren't tagged, the instructions reading them know what's in them
+typedef union {
+    int64_t integer; // Bools too, as 0 or 1
+    double float_v;
+    khstring* string;
+} khValue;
+
+
+typedef struct {
+    khstring name;
+    size_t arguments; // In its first registers
+    size_t registers; // The size of its frame
+    kharray(khInstruction) code;
+    kharray(uint8_t*) positions; // Where each instruction comes from in the source, for runtime errors
+} khBytecodeFunction;
+
+void khBytecodeFunction_delete(khBytecodeFunction* function);
+
+
+typedef struct {
+    kharray(khBytecodeFunction) functions; // The first one is the top-level of the script
+    kharray(khValue) constants;            // Ints wider than 32 bits, and floats
+    kharray(khstring) strings;
+} khBytecode;
+
+void khBytecode_delete(khBytecode* bytecode);
+// As a JSON object, an instruction being a string of its opcode and operands
+void khBytecode_write(khBytecode* bytecode, khWriter* writer);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,70 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <kithare/core/ast.h>
+#include <kithare/core/token.h>
+#include <kithare/lib/arena.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/buffer.h>
+#include <kithare/lib/io.h>
+#include <kithare/lib/string.h>
+
+
+// Bumped whenever the layout of the images, the tokens or the AST changes, which makes older images
+// stale
+#define kh_CACHE_VERSION 5
+
+// Tokens or an AST, with the errors raised while making them, stored as a binary image: a copy of their
+// memory where pointers are offsets into the image (and positions are offsets into the source), and
+// each distinct string is stored once. Loading one maps it and turns the offsets back into pointers.
+// Images are only loaded by builds of the same version and memory layout, and with the very source they
+// keep a copy of, anything else is a miss
+typedef struct {
+    khMappedFile file;
+    khArena arena; // Where the arrays of the image reallocate into, if they're grown
+} khCache;
+
+// An empty cache, to be loaded into
+static inline khCache khCache_new(void) {
+#ifdef _WIN32
+    khMappedFile file = {.data = NULL, .size = 0, .handle = INVALID_HANDLE_VALUE};
+#else
+    khMappedFile file = {.data = NULL, .size = 0};
+#endif
+    return (khCache){.file = file, .arena = khArena_new()};
+}
+
+// What's loaded stays valid until the cache is deleted, it must not be moved either
+static inline void khCache_delete(khCache* cache) {
+    khMappedFile_delete(&cache->file);
+    khArena_delete(&cache->arena);
+}
+
+
+// Path of the image of the source in the directory, named after a hash of its content
+khstring kh_cachePath(khstring* directory, khbuffer* source, const char32_t* extension);
+
+// Storing takes the errors from `kh_getErrors`, loading raises them again. A load which misses (no
+// image, a stale one or one of another source) gives NULL and leaves the cache empty
+bool kh_storeTokens(khstring* file_name, khbuffer* source, kharray(khToken) * tokens);
+kharray(khToken) kh_loadTokens(khstring* file_name, khbuffer* source, khCache* cache);
+
+bool kh_storeAst(khstring* file_name, khbuffer* source, kharray(khAstStatement) * ast);
+kharray(khAstStatement) kh_loadAst(khstring* file_name, khbuffer* source, khCache* cache);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,29 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <kithare/core/ast.h>
+#include <kithare/core/bytecode.h>
+#include <kithare/core/error.h>
+#include <kithare/lib/array.h>
+
+
+// Compiles the statements of a script into bytecode, raising what can't be compiled; a script which
+// raised any errors mustn't be run. Its top-level statements run in order, and functions are declared
+// at the top-level, where they can be called from before where they are. There isn't more than ints,
+// floats (and doubles, which are the same), bools and strings yet, nor more than `print`, `int` and
+// `float` as built-in functions. Variables of the top-level are only seen by the top-level
+khBytecode kh_compile(kharray(khAstStatement) * ast);
+
+
+#ifdef __cplusplus
+}
+#endif
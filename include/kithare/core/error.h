@@ -10,13 +10,25 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #include <kithare/lib/array.h>
+#include <kithare/lib/buffer.h>
+#include <kithare/lib/lines.h>
 #include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
 
 
-typedef enum { khErrorType_LEXER, khErrorType_PARSER, khErrorType_UNSPECIFIED } khErrorType;
+typedef enum {
+    khErrorType_LEXER,
+    khErrorType_PARSER,
+    khErrorType_MODULE,
+    khErrorType_SEMANTIC,
+    khErrorType_COMPILER,
+    khErrorType_RUNTIME,
+    khErrorType_UNSPECIFIED
+} khErrorType;
 
 
 typedef struct {
@@ -37,9 +49,28 @@ static inline void khError_delete(khError* error) {
 
 void kh_raiseError(khError error);
 size_t kh_hasErrors(void);
+// The thread's errors, which are only read through it. Popping or swapping them through it would leave
+// duplicates of those raised after unnoticed; that's done with `kh_truncateErrors` and `kh_swapErrors`
 kharray(khError) * kh_getErrors(void);
+// Drops the errors raised after there were as many as the size
+void kh_truncateErrors(size_t size);
+// Puts the errors in place of the thread's, which are given back (empty if there were none)
+kharray(khError) kh_swapErrors(kharray(khError) errors);
 void kh_flushErrors(void);
 
+// Once the errors of the thread are as many as the limit, the others raised are dropped, and lexing and
+// parsing stop early. It's shared by every thread, and 0 (the default) is no limit
+void kh_setErrorLimit(size_t limit);
+size_t kh_getErrorLimit(void);
+bool kh_isErrorLimitReached(void);
+
+// Writes the error raised in the source as an object with its index, line, column and message; the line
+// table is of the source
+void khError_write(khError* error, khbuffer* source, khLineTable* lines, khWriter* writer);
+// One error per line
+void kh_writeErrorList(khWriter* writer, kharray(khError) * errors, khbuffer* source,
+                       khLineTable* lines);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,155 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <kithare/core/ast.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/buffer.h>
+#include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
+
+
+// Index of no node or string, and offset of no position
+#define kh_FLAT_NONE UINT32_MAX
+
+
+typedef enum {
+    khFlatKind_LIST,  // Of its children, like a block, arguments, or the blocks of an if branch
+    khFlatKind_NAMES, // Of the names in `range`, with no children
+    khFlatKind_NONE,  // In place of an optional node which isn't there
+    khFlatKind_VARIABLE,
+    khFlatKind_EXPRESSION,
+    khFlatKind_STATEMENT
+} khFlatKind;
+
+typedef enum {
+    khFlatFlag_STATIC = 1 << 0,
+    khFlatFlag_WILD = 1 << 1,
+    khFlatFlag_REF = 1 << 2, // Of variables, and of the argument types of signatures
+    khFlatFlag_INCASE = 1 << 3,
+    khFlatFlag_RELATIVE = 1 << 4,
+    khFlatFlag_RETURN_REF = 1 << 5
+} khFlatFlag;
+
+// A node of the flat AST, whose children are right after it, each followed by its own children. The
+// ones a node has are always in the same order, like the members of its AST struct, and optional ones
+// are `NONE` nodes when they're not there:
+//     VARIABLE                 names, opt_type, opt_initializer
+//     tuple, array, return     values
+//     dict                     keys, values
+//     signature                argument_types, opt_return_type
+//     lambda                   arguments, opt_variadic_argument, opt_return_type, block
+//     unary                    operand
+//     binary                   left, right
+//     ternary                  condition, value, otherwise
+//     comparison               operands
+//     call, index              callee or indexee, arguments
+//     scope                    value, scope_names
+//     templatize               value, template_arguments
+//     variable statement       the VARIABLE
+//     expression statement     the expression
+//     import, include          path
+//     function                 identifiers, template_arguments, arguments, opt_variadic_argument,
+//                              opt_return_type, block
+//     class                    template_arguments, opt_base_type, block
+//     struct                   template_arguments, block
+//     enum                     members
+//     alias                    expression
+//     if branch                branch_conditions, branch_blocks as a list of lists, else_block
+//     while, do while          condition, block
+//     for                      iterators, iteratee, block
+// where lists of expressions, variables or statements are `LIST`s and lists of strings are `NAMES`
+typedef struct {
+    uint8_t kind;      // khFlatKind
+    uint8_t type;      // khAstExpressionType or khAstStatementType
+    uint8_t operation; // khAstUnaryExpressionType or khAstBinaryExpressionType
+    uint8_t flags;     // khFlatFlag
+    uint32_t begin;    // Offsets from the origin of the source, or kh_FLAT_NONE
+    uint32_t end;
+    uint32_t next; // Index after its last descendant, which is its next sibling if it has one
+
+    union {
+        // Of identifiers, strings, the names of classes, structs, enums and aliases, and the aliases
+        // of imports, which may be kh_FLAT_NONE
+        uint32_t string;
+        uint32_t buffer;
+        char32_t char_v;
+        uint8_t byte;
+        int64_t integer;
+        uint64_t uinteger;
+        float float_v;
+        double double_v;
+        float ifloat;
+        double idouble;
+
+        // Of `NAMES` in the names, and of comparisons in the operations
+        struct {
+            uint32_t first;
+            uint32_t count;
+        } range;
+    };
+} khFlatNode;
+
+// An AST flattened into one array, so passes over it are linear scans instead of chasing pointers.
+// It's a copy, the AST can be deleted after
+typedef struct {
+    kharray(khFlatNode) nodes; // In pre-order, the first being a `LIST` of the top-level statements
+    kharray(khstring) strings; // Equal ones are only there once, so names can be compared by index
+    kharray(khbuffer) buffers;
+    kharray(uint32_t) names;     // Indices in the strings, of the `NAMES`
+    kharray(uint8_t) operations; // khAstComparisonExpressionType of comparisons
+} khFlatAst;
+
+// Positions are made offsets from the origin. It's done without recursion, so no nesting is too deep
+khFlatAst kh_flattenAst(kharray(khAstStatement) * ast, uint8_t* origin);
+void khFlatAst_delete(khFlatAst* flat);
+
+// Writes the node as its AST node would be written, or a JSON list of the `LIST`s and `NAMES`
+void khFlatAst_write(khFlatAst* flat, uint32_t node, khWriter* writer);
+
+// The child at that index, kh_FLAT_NONE if it has fewer
+static inline uint32_t khFlatAst_child(khFlatAst* flat, uint32_t node, size_t index) {
+    uint32_t child = node + 1;
+    for (size_t i = 0; i < index && child < flat->nodes[node].next; i++) {
+        child = flat->nodes[child].next;
+    }
+    return child < flat->nodes[node].next ? child : kh_FLAT_NONE;
+}
+
+static inline size_t khFlatAst_childCount(khFlatAst* flat, uint32_t node) {
+    size_t count = 0;
+    for (uint32_t child = node + 1; child < flat->nodes[node].next; child = flat->nodes[child].next) {
+        count++;
+    }
+    return count;
+}
+
+
+// Called on each node of a subtree in pre-order with its parent, kh_FLAT_NONE for the first, and which
+// child of it the node is. Its children are skipped if `enter` gives false, otherwise `leave` is called
+// after them. Either of them can be NULL
+typedef struct {
+    bool (*enter)(khFlatAst* flat, uint32_t node, uint32_t parent, uint32_t slot, void* data);
+    void (*leave)(khFlatAst* flat, uint32_t node, void* data);
+    void* data;
+} khFlatVisitor;
+
+// Walks the subtree in a loop, keeping the nodes it's in on a stack of its own
+void khFlatAst_visit(khFlatAst* flat, uint32_t node, khFlatVisitor* visitor);
+
+
+#ifdef __cplusplus
+}
+#endif
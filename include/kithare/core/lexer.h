@@ -15,22 +15,49 @@ extern "C" {
 
 #include <kithare/core/error.h>
 #include <kithare/core/token.h>
+#include <kithare/lib/arena.h>
 #include <kithare/lib/array.h>
+#include <kithare/lib/buffer.h>
+#include <kithare/lib/intern.h>
 #include <kithare/lib/string.h>
 
 
-kharray(khToken) kh_lexicate(khstring* string);
+// Buffers of a MiB or more are lexed by `kh_lexicateParallel` on the threads set by
+// `kh_setLexerThreads`, unless there's an error limit
+kharray(khToken) kh_lexicate(khbuffer* buffer);
+// Splits the buffer at newlines into chunks, each lexed on a thread as if no string or comment goes on
+// into it. Where the one before doesn't end right where a chunk begins, that guess was wrong, and only
+// that chunk is lexed again. The tokens, errors and interned identifiers are those `kh_lexicate` gives
+kharray(khToken) kh_lexicateParallel(khbuffer* buffer, size_t threads);
 
-khToken kh_lexToken(char32_t** cursor);
-khToken kh_lexWord(char32_t** cursor);
-khToken kh_lexNumber(char32_t** cursor);
-khToken kh_lexSymbol(char32_t** cursor);
+// Threads `kh_lexicate` lexes large buffers on, shared by every thread; 1 (the default) keeps it on the
+// calling one. Set it only while nothing else is run in parallel, as it adds threads of its own
+void kh_setLexerThreads(size_t threads);
+size_t kh_getLexerThreads(void);
 
-char32_t kh_lexChar(char32_t** cursor, bool with_quotes, bool is_byte);
-khstring kh_lexString(char32_t** cursor, bool is_buffer);
+// Identifiers of the tokens are interned per thread, so equal identifiers can be compared by pointer.
+// They stay valid until `kh_flushIdentifiers` is called
+khstring kh_internIdentifier(const uint8_t* memory, size_t size);
+void kh_flushIdentifiers(void);
+// Moves the identifiers out of the thread, so they outlive it; they're freed by `khInterner_delete`
+khInterner kh_takeIdentifiers(void);
+// Interns into the other identifiers from now on, giving back the ones used so far
+khInterner kh_swapIdentifiers(khInterner other);
 
-uint64_t kh_lexInt(char32_t** cursor, uint8_t base, size_t max_length, bool* had_overflowed);
-double kh_lexFloat(char32_t** cursor, uint8_t base);
+khToken kh_lexToken(uint8_t** cursor);
+khToken kh_lexWord(uint8_t** cursor);
+khToken kh_lexNumber(uint8_t** cursor);
+khToken kh_lexSymbol(uint8_t** cursor);
+
+char32_t kh_lexChar(uint8_t** cursor, bool with_quotes, bool is_byte);
+khstring kh_lexString(uint8_t** cursor, bool is_buffer);
+// The values of string and buffer tokens, decoded from the source they were lexed from, which has to
+// still be there. Nothing is raised, as it already was when they were lexed; the arena may be NULL
+khstring kh_decodeString(khToken* token, khArena* arena);
+khbuffer kh_decodeBuffer(khToken* token, khArena* arena);
+
+uint64_t kh_lexInt(uint8_t** cursor, uint8_t base, size_t max_length, bool* had_overflowed);
+double kh_lexFloat(uint8_t** cursor, uint8_t base);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,76 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <kithare/core/ast.h>
+#include <kithare/core/error.h>
+#include <kithare/lib/arena.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/buffer.h>
+#include <kithare/lib/intern.h>
+#include <kithare/lib/string.h>
+
+
+typedef struct khModule khModule;
+
+// A top-level import or include of the module
+typedef struct {
+    khAstStatement* statement;
+    khModule* module; // NULL if it wasn't found
+} khDependency;
+
+struct khModule {
+    khstring path; // Absolute and normalized, with `/` separators
+    khbuffer source;
+    kharray(khAstStatement) ast; // In the arena, with the identifiers interned by the module
+    khArena arena;
+    khInterner identifiers;
+    kharray(khError) errors; // Raised while parsing it and resolving its dependencies
+    kharray(khDependency) dependencies;
+    size_t id; // In the order the modules were found
+};
+
+typedef struct {
+    khModule* entry; // NULL if its file wasn't found
+    kharray(khModule*) modules; // Each one after the modules it depends on, so the entry is last
+} khModuleGraph;
+
+
+// Loads the module of the file, then every module it imports or includes and so on, each only once
+// however many modules depend on it. `import a.b` is the file `a/b.kh`; relative to the module's
+// directory for `import .a.b`, otherwise in the first search directory which has it (the entry's
+// directory if there are none). Modules are parsed in parallel on up to that many threads, which steal
+// work from each other. Missing modules and circular dependencies are raised in the modules depending
+// on them, as `khErrorType_MODULE` errors
+khModuleGraph kh_loadModules(khstring* file_name, kharray(khstring) * search_directories,
+                             size_t threads);
+void khModuleGraph_delete(khModuleGraph* graph);
+
+// The path of an import or include as it's written, like `.a.b`
+khstring kh_dependencyName(khAstStatement* statement);
+// Normalized path of the file which the import or include of the module refers to, found as
+// `kh_loadModules` does; NULL if there's none
+khstring kh_findDependency(khstring* module_path, khAstStatement* statement,
+                           kharray(khstring) * search_directories);
+
+// Absolute, without `.` and empty parts and with `..` cancelling the part before it, so a module is
+// found under one path however it's reached
+khstring kh_normalizePath(khstring* path);
+// The directory the file is in, `.` if the path has none
+khstring kh_directoryOf(khstring* path);
+
+
+#ifdef __cplusplus
+}
+#endif
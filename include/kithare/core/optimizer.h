@@ -0,0 +1,37 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <kithare/core/ast.h>
+#include <kithare/lib/arena.h>
+#include <kithare/lib/array.h>
+
+
+// Passes over the AST, run in this order, flags of which can be combined
+typedef enum {
+    // Operations on literals into literals, with ints wrapping around like they do at runtime; what
+    // would raise at runtime, like a division by zero, is left as it is
+    khAstPass_FOLD = 1 << 0,
+    // If and elif arms whose conditions are constants, while loops which never run, and statements
+    // after a return, break or continue in the same block, besides declarations
+    khAstPass_PRUNE = 1 << 1,
+
+    khAstPass_ALL = khAstPass_FOLD | khAstPass_PRUNE
+} khAstPass;
+
+// Optimizes the AST in place. `arena` is the one it was parsed into (or loaded into, from a cache),
+// NULL if it's on the heap; what's taken out of it is only deleted if it's on the heap
+void kh_optimize(kharray(khAstStatement) * ast, khAstPass passes, khArena* arena);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,13 +12,56 @@ extern "C" {
 
 #include <kithare/core/ast.h>
 #include <kithare/core/error.h>
+#include <kithare/core/token.h>
+#include <kithare/lib/arena.h>
 #include <kithare/lib/array.h>
+#include <kithare/lib/buffer.h>
+#include <kithare/lib/intern.h>
 
 
-kharray(khAstStatement) kh_parse(khstring* string);
+kharray(khAstStatement) kh_parse(khbuffer* buffer);
+// Places the whole AST in the arena, so it's freed at once by `khArena_delete` instead of
+// `khAstStatement_delete`, and copies of it are on the heap. Same as `kh_parse` if `arena` is NULL.
+// The identifiers of either are interned instead, see `kh_internIdentifier`
+kharray(khAstStatement) kh_parseArena(khbuffer* buffer, khArena* arena);
 
-khAstStatement kh_parseStatement(char32_t** cursor);
-khAstExpression kh_parseExpression(char32_t** cursor, bool ignore_newline, bool filter_type);
+
+// Given each top-level statement as soon as it's parsed, after the errors it raised; returns whether
+// to go on parsing
+typedef bool (*khStatementCallback)(khAstStatement* statement, void* context);
+
+// Parses a statement at a time, lexing only as far ahead of it as it needs, so what's kept at once is
+// bounded by the biggest statement rather than the whole source. With an arena, the statement is in it,
+// and it's reset after the callback returns; otherwise the statement is on the heap, and the callback
+// takes it. Identifiers are interned, as with `kh_parseArena`
+void kh_parseStream(khbuffer* buffer, khArena* arena, khStatementCallback callback, void* context);
+
+
+// A parsed source which can be edited, after which only the top-level statements the edit could have
+// changed are parsed again; the others are moved along with their part of the source. Errors belong to
+// the statement which raised them, lexer errors to the one their token is in, and unlike `kh_parse`
+// the same error raised by two statements isn't merged into one
+typedef struct {
+    khbuffer source;
+    kharray(khAstStatement) ast;  // In the arena, with its identifiers interned by the tree
+    kharray(khError) errors;      // Raised while lexing and parsing it, in the order of the statements
+    kharray(size_t) error_starts; // Where the errors of each statement start in `errors`
+    khArena arena;
+    khInterner identifiers;
+    size_t stale; // Bytes parsed again since the last full parse, whose old nodes are left in the arena
+} khSyntaxTree;
+
+// Takes the source
+khSyntaxTree khSyntaxTree_new(khbuffer source);
+void khSyntaxTree_delete(khSyntaxTree* tree);
+// Replaces the bytes of the source from `begin` to `end` with the replacement. Every position in the
+// tree, its errors included, then points into the new source
+void khSyntaxTree_edit(khSyntaxTree* tree, size_t begin, size_t end, const uint8_t* replacement,
+                       size_t size);
+
+// The cursor of these points into a token stream which ends with an EOF token, see `kh_parse`
+khAstStatement kh_parseStatement(khToken** cursor);
+khAstExpression kh_parseExpression(khToken** cursor, bool ignore_newline, bool filter_type);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,91 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <kithare/core/ast.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/hashmap.h>
+#include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
+
+
+typedef enum {
+    khSymbolType_IMPORT,
+    khSymbolType_FUNCTION,
+    khSymbolType_CLASS,
+    khSymbolType_STRUCT,
+    khSymbolType_ENUM,
+    khSymbolType_ENUM_MEMBER,
+    khSymbolType_ALIAS,
+    khSymbolType_VARIABLE,
+    khSymbolType_ARGUMENT,
+    khSymbolType_TEMPLATE_ARGUMENT,
+    khSymbolType_ITERATOR
+} khSymbolType;
+
+const char* khSymbolType_name(khSymbolType type);
+
+
+typedef struct {
+    khSymbolType type;
+    khstring name; // Interned, shared with the AST
+    uint8_t* begin; // Of what declared it
+    size_t scope;
+    size_t members; // Scope of a class's, struct's or enum's members, SIZE_MAX for anything else
+} khSymbol;
+
+// Of the symbols in a scope, by their names' pointers
+typedef struct {
+    khstring key;
+    size_t symbol;
+} khScopeEntry;
+
+typedef struct {
+    size_t parent; // SIZE_MAX for the module's
+    uint8_t* begin; // Of what opened it, NULL for the module's
+    khhashmap(khScopeEntry) names; // The first of each name declared in it; NULL while it's empty
+} khScope;
+
+// A use of a name, in an identifier or a scope expression's scope names
+typedef struct {
+    khstring name;
+    uint8_t* begin;
+    size_t symbol; // SIZE_MAX if it's built in, or may be from an included module
+} khReference;
+
+typedef struct {
+    kharray(khSymbol) symbols;
+    kharray(khScope) scopes; // Each after its parent, the module's first
+    kharray(khReference) references; // In the order they're in the source
+} khSymbolTable;
+
+void khSymbolTable_delete(khSymbolTable* table);
+void khSymbolTable_write(khSymbolTable* table, uint8_t* origin, khWriter* writer);
+
+// The symbol of the name seen from the scope, going up through its parents, SIZE_MAX if there's none
+size_t khSymbolTable_lookup(khSymbolTable* table, size_t scope, khstring* name);
+
+
+// Declares everything in the statements and resolves each name used in them, raising names which
+// aren't declared (unless the module includes another, which they may be from) or redeclared in the
+// same scope. Names are compared by pointer, so the identifiers must be interned, as the parser's are
+// until `kh_flushIdentifiers`; the table shares them. Declarations in a block are seen throughout it,
+// besides variables, which are only seen after they are; in the module and in classes and structs,
+// those are too. Members of enums are resolved in scope expressions, like `Enum.MEMBER`
+khSymbolTable kh_resolve(kharray(khAstStatement) * ast);
+
+
+#ifdef __cplusplus
+}
+#endif
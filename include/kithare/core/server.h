@@ -0,0 +1,72 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include <kithare/core/error.h>
+#include <kithare/core/parser.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/hashmap.h>
+#include <kithare/lib/lines.h>
+#include <kithare/lib/string.h>
+
+
+// A source kept in memory by the server, with everything made of it, so only what's edited is redone
+typedef struct {
+    khSyntaxTree tree;
+    khLineTable lines; // Of the tree's source, made again after each edit
+
+    // Normalized paths of its top-level imports and includes, NULL for those not found, along with the
+    // errors raised for them. NULL until they're resolved, which is done again after an edit
+    kharray(khstring) dependencies;
+    kharray(khError) dependency_errors;
+    khstring dependency_root; // What they were resolved from without search directories, or NULL
+
+    kharray(khError) name_errors; // Raised by `kh_resolve`, NULL until it's done after an edit
+} khServerFile;
+
+typedef struct {
+    khstring key; // Normalized path
+    khServerFile* file;
+} khServerEntry;
+
+typedef struct {
+    khhashmap(khServerEntry) files;
+    kharray(khstring) search_directories; // As `kh_loadModules`'s
+    size_t threads; // Modules found for the first time are loaded on up to that many
+} khServer;
+
+
+// Takes the search directories
+khServer khServer_new(kharray(khstring) search_directories, size_t threads);
+void khServer_delete(khServer* server);
+
+// Serves requests read from the input until an `exit` one or its end. A request is a line of a command
+// and its arguments, the path being last so it may have spaces:
+//     open <path>                        reads the file again, then gives its diagnostics
+//     change <size> <path>               the content follows as that many bytes, which replace it all
+//     edit <begin> <end> <size> <path>   the bytes from begin to end are replaced by the ones following
+//     diagnostics <path>                 errors raised by lexing, parsing and resolving names
+//     parse <path>                       the AST and its errors
+//     modules <path>                     it and the modules it depends on, in the order they are found
+//     close <path>                       forgets the file
+//     exit
+// Files are read the first time they're needed, and kept until they're closed. Each response is a JSON
+// object, framed like in the language server protocol, with a `Content-Length: <size>\r\n\r\n` header
+void khServer_serve(khServer* server, FILE* input, FILE* output);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,59 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include <kithare/core/ast.h>
+#include <kithare/core/token.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/writer.h>
+
+
+// Instrumentation for `--stats`, only compiled in with `kh_STATS` defined; otherwise every one of
+// these is an empty macro, so there's nothing left of it. Counters are summed over every thread
+typedef enum {
+    khStatsPhase_READ,
+    khStatsPhase_LEXICATE,
+    khStatsPhase_PARSE,
+    khStatsPhase_SERIALIZE,
+    khStatsPhase_COUNT
+} khStatsPhase;
+
+#ifdef kh_STATS
+
+uint64_t kh_nanoseconds(void);
+void kh_addPhaseTime(khStatsPhase phase, uint64_t nanoseconds);
+
+// By their types; the allocation counter that arrays and the parser call is declared in `array.h`
+void kh_countTokens(kharray(khToken) * tokens);
+void kh_countAst(kharray(khAstStatement) * ast);
+
+// As a JSON object
+void kh_writeStats(khWriter* writer);
+
+// Declares the timer, then adds the time since to the phase
+#define kh_startTimer(TIMER) uint64_t TIMER = kh_nanoseconds()
+#define kh_stopTimer(TIMER, PHASE) kh_addPhaseTime(PHASE, kh_nanoseconds() - (TIMER))
+
+#else
+
+#define kh_countTokens(TOKENS) ((void)0)
+#define kh_countAst(AST) ((void)0)
+#define kh_startTimer(TIMER)
+#define kh_stopTimer(TIMER, PHASE) ((void)0)
+
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -15,6 +15,7 @@ extern "C" {
 #include <kithare/lib/array.h>
 #include <kithare/lib/buffer.h>
 #include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
 
 
 typedef enum {
@@ -41,6 +42,7 @@ typedef enum {
     khTokenType_IDOUBLE
 } khTokenType;
 
+const char* khTokenType_name(khTokenType type);
 khstring khTokenType_string(khTokenType type);
 
 
@@ -72,6 +74,7 @@ typedef enum {
     khKeywordToken_RETURN
 } khKeywordToken;
 
+const char* khKeywordToken_name(khKeywordToken keyword);
 khstring khKeywordToken_string(khKeywordToken keyword);
 
 
@@ -93,6 +96,7 @@ typedef enum {
     khDelimiterToken_ELLIPSIS
 } khDelimiterToken;
 
+const char* khDelimiterToken_name(khDelimiterToken delimiter);
 khstring khDelimiterToken_string(khDelimiterToken delimiter);
 
 
@@ -142,23 +146,25 @@ typedef enum {
     khOperatorToken_IP_BIT_RSHIFT
 } khOperatorToken;
 
+const char* khOperatorToken_name(khOperatorToken operator_v);
 khstring khOperatorToken_string(khOperatorToken operator_v);
 
 
+// Only 24 bytes on 64-bit targets, with nothing to free: identifiers are interned, and the values of
+// strings and buffers aren't kept but decoded again from the source, by `kh_decodeString` and
+// `kh_decodeBuffer`. Arrays of tokens need no deleter, and copies of them are just their bytes.
+// A single token can't be 4 GiB or longer
 typedef struct {
-    char32_t* begin;
-    char32_t* end;
-
-    khTokenType type;
+    uint8_t* begin;
+    uint32_t length; // In bytes, see `khToken_end`
+    uint8_t type;    // A `khTokenType`, as a byte
     union {
-        khstring identifier;
+        khstring identifier; // Interned, see `kh_internIdentifier`
         khKeywordToken keyword;
         khDelimiterToken delimiter;
         khOperatorToken operator_v;
 
         char32_t char_v;
-        khstring string;
-        khbuffer buffer;
 
         uint8_t byte;
         int64_t integer;
@@ -170,83 +176,87 @@ typedef struct {
     };
 } khToken;
 
-khToken khToken_copy(khToken* token);
-void khToken_delete(khToken* token);
-khstring khToken_string(khToken* token, char32_t* origin);
+void khToken_write(khToken* token, uint8_t* origin, khWriter* writer);
+khstring khToken_string(khToken* token, uint8_t* origin);
+
+static inline uint8_t* khToken_end(khToken* token) {
+    return token->begin + token->length;
+}
+
+#define _khToken_new(TYPE, BEGIN, END, ...)                                                        \
+    ((khToken){.begin = (BEGIN), .length = (uint32_t)((END) - (BEGIN)), .type = (TYPE), __VA_ARGS__})
 
-static inline khToken khToken_fromInvalid(char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_INVALID};
+static inline khToken khToken_fromInvalid(uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_INVALID, begin, end);
 }
 
-static inline khToken khToken_fromEof(char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_EOF};
+static inline khToken khToken_fromEof(uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_EOF, begin, end);
 }
 
-static inline khToken khToken_fromNewline(char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_NEWLINE};
+static inline khToken khToken_fromNewline(uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_NEWLINE, begin, end);
 }
 
-static inline khToken khToken_fromComment(char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_COMMENT};
+static inline khToken khToken_fromComment(uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_COMMENT, begin, end);
 }
 
-static inline khToken khToken_fromIdentifier(khstring identifier, char32_t* begin, char32_t* end) {
-    return (khToken){
-        .begin = begin, .end = end, .type = khTokenType_IDENTIFIER, .identifier = identifier};
+static inline khToken khToken_fromIdentifier(khstring identifier, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_IDENTIFIER, begin, end, .identifier = identifier);
 }
 
-static inline khToken khToken_fromKeyword(khKeywordToken keyword, char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_KEYWORD, .keyword = keyword};
+static inline khToken khToken_fromKeyword(khKeywordToken keyword, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_KEYWORD, begin, end, .keyword = keyword);
 }
 
-static inline khToken khToken_fromDelimiter(khDelimiterToken delimiter, char32_t* begin,
-                                            char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_DELIMITER, .delimiter = delimiter};
+static inline khToken khToken_fromDelimiter(khDelimiterToken delimiter, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_DELIMITER, begin, end, .delimiter = delimiter);
 }
 
-static inline khToken khToken_fromOperator(khOperatorToken operator_v, char32_t* begin, char32_t* end) {
-    return (khToken){
-        .begin = begin, .end = end, .type = khTokenType_OPERATOR, .operator_v = operator_v};
+static inline khToken khToken_fromOperator(khOperatorToken operator_v, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_OPERATOR, begin, end, .operator_v = operator_v);
 }
 
-static inline khToken khToken_fromChar(char32_t char_v, char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_CHAR, .char_v = char_v};
+static inline khToken khToken_fromChar(char32_t char_v, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_CHAR, begin, end, .char_v = char_v);
 }
 
-static inline khToken khToken_fromString(khstring string, char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_STRING, .string = string};
+// The values of these are in the source, from the opening quote or the `b` before it to the end
+static inline khToken khToken_fromString(uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_STRING, begin, end);
 }
 
-static inline khToken khToken_fromBuffer(khbuffer buffer, char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_BUFFER, .buffer = buffer};
+static inline khToken khToken_fromBuffer(uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_BUFFER, begin, end);
 }
 
-static inline khToken khToken_fromByte(uint8_t byte, char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_BYTE, .byte = byte};
+static inline khToken khToken_fromByte(uint8_t byte, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_BYTE, begin, end, .byte = byte);
 }
 
-static inline khToken khToken_fromInteger(int64_t integer, char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_INTEGER, .integer = integer};
+static inline khToken khToken_fromInteger(int64_t integer, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_INTEGER, begin, end, .integer = integer);
 }
 
-static inline khToken khToken_fromUinteger(uint64_t uinteger, char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_UINTEGER, .uinteger = uinteger};
+static inline khToken khToken_fromUinteger(uint64_t uinteger, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_UINTEGER, begin, end, .uinteger = uinteger);
 }
 
-static inline khToken khToken_fromFloat(float float_v, char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_FLOAT, .float_v = float_v};
+static inline khToken khToken_fromFloat(float float_v, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_FLOAT, begin, end, .float_v = float_v);
 }
 
-static inline khToken khToken_fromDouble(double double_v, char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_DOUBLE, .double_v = double_v};
+static inline khToken khToken_fromDouble(double double_v, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_DOUBLE, begin, end, .double_v = double_v);
 }
 
-static inline khToken khToken_fromIfloat(float ifloat, char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_IFLOAT, .ifloat = ifloat};
+static inline khToken khToken_fromIfloat(float ifloat, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_IFLOAT, begin, end, .ifloat = ifloat);
 }
 
-static inline khToken khToken_fromIdouble(double idouble, char32_t* begin, char32_t* end) {
-    return (khToken){.begin = begin, .end = end, .type = khTokenType_IDOUBLE, .idouble = idouble};
+static inline khToken khToken_fromIdouble(double idouble, uint8_t* begin, uint8_t* end) {
+    return _khToken_new(khTokenType_IDOUBLE, begin, end, .idouble = idouble);
 }
 
 
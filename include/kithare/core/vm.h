@@ -0,0 +1,33 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <kithare/core/bytecode.h>
+#include <kithare/core/error.h>
+#include <kithare/lib/writer.h>
+
+
+// Runs the compiled script from its top-level, with `print` writing into the output. A runtime error,
+// like a division by zero, is raised and stops it, and false is returned
+bool kh_execute(khBytecode* bytecode, khWriter* output);
+
+// Powers of ints as the VM does them, by squaring and wrapping around; a negative exponent gives 0
+// unless the base is 1 or -1, as ints can't be fractions. Constant folding shares them
+uint64_t kh_powUint(uint64_t base, uint64_t exponent);
+int64_t kh_powInt(int64_t base, int64_t exponent);
+
+
+#ifdef __cplusplus
+}
+#endif
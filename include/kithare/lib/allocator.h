@@ -0,0 +1,27 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+
+// Hooks for where memory comes from, a NULL allocator being the heap. `reallocate` is given NULL
+// memory (and an `old_size` of 0) for new allocations, and what it returns doesn't need to be zeroed.
+// Allocators which free everything at once, like `khArena`, leave `free` as NULL
+typedef struct khAllocator {
+    void* (*reallocate)(struct khAllocator* allocator, void* memory, size_t old_size, size_t new_size);
+    void (*free)(struct khAllocator* allocator, void* memory, size_t size);
+} khAllocator;
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,153 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+
+
+// Every allocation is aligned to this, so any type can be placed in the arena
+#define _khArena_ALIGNMENT _Alignof(max_align_t)
+#define _khArena_align(SIZE) (((SIZE) + _khArena_ALIGNMENT - 1) & ~(_khArena_ALIGNMENT - 1))
+
+// Default capacity of a block, bigger allocations get a block for themselves
+#define _khArena_BLOCK_SIZE 65536
+
+typedef struct _khArenaBlock {
+    struct _khArenaBlock* previous;
+    size_t size;
+    size_t used;
+} _khArenaBlock;
+
+// Memory of a block starts after its (aligned) header
+#define _khArena_blockData(BLOCK) ((char*)(BLOCK) + _khArena_align(sizeof(_khArenaBlock)))
+
+// A bump allocator; allocations are never freed one by one, only all at once with `khArena_delete`.
+// It's also usable as a `khAllocator` through `khArena_allocator`, so it must not be moved after that
+typedef struct {
+    khAllocator allocator;
+    _khArenaBlock* block;
+} khArena;
+
+
+static inline khArena khArena_new(void) {
+    return (khArena){.allocator = {.reallocate = NULL, .free = NULL}, .block = NULL};
+}
+
+static inline void khArena_delete(khArena* arena) {
+    _khArenaBlock* block = arena->block;
+    while (block != NULL) {
+        _khArenaBlock* previous = block->previous;
+        free(block);
+        block = previous;
+    }
+
+    arena->block = NULL;
+}
+
+// Frees everything allocated so far, keeping the current block to be used again, so an arena which is
+// reset after each unit of work doesn't go back to the heap every time
+static inline void khArena_reset(khArena* arena) {
+    _khArenaBlock* block = arena->block;
+    if (block == NULL) {
+        return;
+    }
+
+    _khArenaBlock* previous = block->previous;
+    while (previous != NULL) {
+        _khArenaBlock* next = previous->previous;
+        free(previous);
+        previous = next;
+    }
+
+    block->previous = NULL;
+    memset(_khArena_blockData(block), 0, block->used);
+    block->used = 0;
+}
+
+// The returned memory is zeroed, as blocks are calloc-ed and zeroed again when they're reused
+static inline void* khArena_allocate(khArena* arena, size_t size) {
+    size = _khArena_align(size);
+    _khArenaBlock* block = arena->block;
+
+    if (block == NULL || block->used + size > block->size) {
+        size_t block_size = size > _khArena_BLOCK_SIZE ? size : _khArena_BLOCK_SIZE;
+        _khArenaBlock* new_block = calloc(_khArena_align(sizeof(_khArenaBlock)) + block_size, 1);
+        *new_block = (_khArenaBlock){.previous = NULL, .size = block_size, .used = size};
+
+        // Big allocations are chained behind the current block, so its remaining space still gets used
+        if (block != NULL && size > _khArena_BLOCK_SIZE) {
+            new_block->previous = block->previous;
+            block->previous = new_block;
+        }
+        else {
+            new_block->previous = block;
+            arena->block = new_block;
+        }
+
+        return _khArena_blockData(new_block);
+    }
+
+    void* memory = _khArena_blockData(block) + block->used;
+    block->used += size;
+    return memory;
+}
+
+// Grows in place if `memory` is the latest allocation of the arena and there's space for it, otherwise
+// it's copied into a new allocation; the old memory stays in the arena until it's deleted
+static inline void* khArena_reallocate(khArena* arena, void* memory, size_t old_size, size_t new_size) {
+    _khArenaBlock* block = arena->block;
+    old_size = _khArena_align(old_size);
+    new_size = _khArena_align(new_size);
+
+    // Never shrinks, so the rest of the block is kept zeroed
+    if (memory != NULL && new_size <= old_size) {
+        return memory;
+    }
+
+    if (memory != NULL && block != NULL &&
+        (char*)memory + old_size == _khArena_blockData(block) + block->used &&
+        block->used - old_size + new_size <= block->size) {
+        block->used = block->used - old_size + new_size;
+        return memory;
+    }
+
+    void* new_memory = khArena_allocate(arena, new_size);
+    if (memory != NULL) {
+        memcpy(new_memory, memory, old_size);
+    }
+
+    return new_memory;
+}
+
+static inline void* _khArena_reallocateHook(khAllocator* allocator, void* memory, size_t old_size,
+                                            size_t new_size) {
+    return khArena_reallocate((khArena*)allocator, memory, old_size, new_size);
+}
+
+// NULL (the heap) if `arena` is NULL
+static inline khAllocator* khArena_allocator(khArena* arena) {
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    // Hooked here rather than in `khArena_new`, as a zeroed arena is an empty one too
+    arena->allocator = (khAllocator){.reallocate = _khArena_reallocateHook, .free = NULL};
+    return &arena->allocator;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
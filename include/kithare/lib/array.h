@@ -10,16 +10,24 @@
 extern "C" {
 #endif
 
+#include <assert.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <kithare/lib/allocator.h>
+#include <kithare/lib/arena.h>
+
 
 typedef struct {
-    size_t type_size;
+    uint32_t type_size;
+    bool is_static; // Empty arrays share a static block, see `kharray_new`
     void (*deleter)(void*);
     size_t size;
     size_t reserved;
+    khAllocator* allocator; // NULL on heap allocated arrays
 } _kharrayHeader;
 
 
@@ -28,8 +36,9 @@ typedef struct {
 #define _kharray_header(ARRAY) (((_kharrayHeader*)(*ARRAY))[-1])
 #define _kharray_typeSize(ARRAY) (_kharray_header(ARRAY).type_size)
 #define _kharray_deleter(ARRAY) (_kharray_header(ARRAY).deleter)
-#define kharray_size(ARRAY) (_kharray_header(ARRAY).size)
+#define kharray_size(ARRAY) ((size_t)_kharray_header(ARRAY).size) // Not assignable, see below
 #define kharray_reserved(ARRAY) (_kharray_header(ARRAY).reserved)
+#define kharray_allocator(ARRAY) (_kharray_header(ARRAY).allocator)
 
 // Verifies that the argument given is a pointer to a pointer (Known as a pointer to an array; e.g:
 // int**, char**), then casts it into a void**
@@ -40,50 +49,139 @@ typedef struct {
         (void**)__kh_ptr;                                                  \
     })
 
+// Sizes are only written through this, as an empty array may still be a read-only static block (see
+// `kharray_new`); it stays empty, and the size can't go past what's been reserved
+#define kharray_setSize(ARRAY, SIZE) _kharray_setSize(_kharray_verify(ARRAY), SIZE)
+static inline void _kharray_setSize(void** array, size_t size) {
+    assert(size <= _kharray_header(array).reserved);
+    if (!_kharray_header(array).is_static) {
+        _kharray_header(array).size = size;
+    }
+}
 
-#define kharray_new(TYPE, DELETER) (TYPE*)_kharray_new(sizeof(TYPE), (void (*)(void*))(DELETER))
-static inline void* _kharray_new(size_t type_size, void (*deleter)(void*)) {
-    // Don't forget to allocate an extra null-terminator space in case it's a string
-    void* array = calloc(sizeof(_kharrayHeader) + type_size, 1);
-    *(_kharrayHeader*)array =
-        (_kharrayHeader){.type_size = type_size, .size = 0, .reserved = 0, .deleter = deleter};
+
+// Counts allocations for `--stats`, defined along with the rest of `kithare/core/stats.h`. Nothing
+// without `kh_STATS`
+#ifdef kh_STATS
+void kh_countAllocation(size_t size);
+#else
+#define kh_countAllocation(SIZE) ((void)0)
+#endif
+
+// Reallocates with the allocator, or on the heap if it's NULL, zeroing whatever memory it gains
+static inline void* _kharray_reallocate(khAllocator* allocator, void* memory, size_t old_size,
+                                        size_t new_size) {
+    void* new_memory = allocator != NULL ? allocator->reallocate(allocator, memory, old_size, new_size)
+                                         : realloc(memory, new_size);
+    if (new_size > old_size) {
+        memset(new_memory + old_size, 0, new_size - old_size);
+    }
+
+    return new_memory;
+}
+
+// Size of an array's memory, header included. Don't forget the extra null-terminator space in case
+// it's a string
+#define _kharray_memorySize(TYPE_SIZE, RESERVED) \
+    (sizeof(_kharrayHeader) + (TYPE_SIZE) * ((RESERVED) + 1))
+
+// On the heap, an empty array points into a static block of its call site until it's given any memory,
+// so arrays which stay empty cost no allocation. That block is read-only, so sizes are only set with
+// `kharray_setSize`, which leaves it alone. DELETER must be a constant expression
+#define kharray_new(TYPE, DELETER) kharray_allocatorNew(TYPE, DELETER, NULL)
+
+#define _kharray_static(TYPE, DELETER)                                                           \
+    ({                                                                                           \
+        static const struct {                                                                    \
+            _kharrayHeader header;                                                               \
+            TYPE null_terminator;                                                                \
+        } __kh_static = {.header = {.type_size = sizeof(TYPE),                                   \
+                                    .is_static = true,                                           \
+                                    .deleter = (void (*)(void*))(DELETER),                       \
+                                    .size = 0,                                                   \
+                                    .reserved = 0,                                               \
+                                    .allocator = NULL}};                                         \
+        _Static_assert(offsetof(typeof(__kh_static), null_terminator) == sizeof(_kharrayHeader), \
+                       "the null-terminator must follow the header");                            \
+        (TYPE*)&__kh_static.null_terminator;                                                     \
+    })
+
+// Arrays of allocators which free everything at once (`free` being NULL) are freed along with it, and
+// so is anything they contain; their deleter is never called
+#define kharray_allocatorNew(TYPE, DELETER, ALLOCATOR)                                       \
+    ({                                                                                       \
+        khAllocator* __kh_allocator = ALLOCATOR;                                             \
+        __kh_allocator == NULL                                                               \
+            ? _kharray_static(TYPE, DELETER)                                                 \
+            : (TYPE*)_kharray_new(sizeof(TYPE), (void (*)(void*))(DELETER), __kh_allocator); \
+    })
+static inline void* _kharray_new(size_t type_size, void (*deleter)(void*), khAllocator* allocator) {
+    kh_countAllocation(_kharray_memorySize(type_size, 0));
+    void* array = _kharray_reallocate(allocator, NULL, 0, _kharray_memorySize(type_size, 0));
+    *(_kharrayHeader*)array = (_kharrayHeader){.type_size = type_size,
+                                               .is_static = false,
+                                               .deleter = deleter,
+                                               .size = 0,
+                                               .reserved = 0,
+                                               .allocator = allocator};
     return array + sizeof(_kharrayHeader);
 }
 
-#define kharray_copy(ARRAY, COPIER)                                                                \
-    ({                                                                                             \
-        typeof(ARRAY) __kh_array_ptr = ARRAY;                                                      \
-        typeof(*__kh_array_ptr) __kh_array = *__kh_array_ptr;                                      \
-                                                                                                   \
-        /* The copied array */                                                                     \
-        typeof(__kh_array) __kh_copy =                                                             \
-            calloc(sizeof(_kharrayHeader) +                                                        \
-                       _kharray_typeSize(__kh_array_ptr) * (kharray_size(__kh_array_ptr) + 1),     \
-                   1);                                                                             \
-                                                                                                   \
-        /* Placing the array header and fitting the reserve count, then offsetting the copy */     \
-        *(_kharrayHeader*)__kh_copy = _kharray_header(__kh_array_ptr);                             \
-        ((_kharrayHeader*)__kh_copy)->reserved = kharray_size(__kh_array_ptr);                     \
-        __kh_copy = (typeof(__kh_array))((_kharrayHeader*)__kh_copy + 1);                          \
-                                                                                                   \
-        /* Call the copy constructor of each element, unless it's NULL */                          \
-        if (COPIER == NULL) {                                                                      \
-            memcpy(__kh_copy, __kh_array,                                                          \
-                   _kharray_typeSize(__kh_array_ptr) * kharray_size(__kh_array_ptr));              \
-        }                                                                                          \
-        else {                                                                                     \
-            for (size_t __kh_i = 0; __kh_i < kharray_size(__kh_array_ptr); __kh_i++) {             \
-                __kh_copy[__kh_i] =                                                                \
-                    ((typeof (*__kh_array) (*)(typeof(__kh_array)))(COPIER))(&__kh_array[__kh_i]); \
-            }                                                                                      \
-        }                                                                                          \
-                                                                                                   \
-        __kh_copy;                                                                                 \
+#define kharray_arenaNew(TYPE, DELETER, ARENA) \
+    kharray_allocatorNew(TYPE, DELETER, khArena_allocator(ARENA))
+
+#define kharray_copy(ARRAY, COPIER) kharray_allocatorCopy(ARRAY, COPIER, NULL)
+#define kharray_arenaCopy(ARRAY, COPIER, ARENA) \
+    kharray_allocatorCopy(ARRAY, COPIER, khArena_allocator(ARENA))
+
+#define kharray_allocatorCopy(ARRAY, COPIER, ALLOCATOR)                                                \
+    ({                                                                                                 \
+        typeof(ARRAY) __kh_array_ptr = ARRAY;                                                          \
+        typeof(*__kh_array_ptr) __kh_array = *__kh_array_ptr;                                          \
+        khAllocator* __kh_allocator = ALLOCATOR;                                                       \
+        typeof(__kh_array) __kh_copy = __kh_array;                                                     \
+                                                                                                       \
+        /* Static blocks are never modified, so they're shared by copies on the heap as well */        \
+        if (!_kharray_header(__kh_array_ptr).is_static || __kh_allocator != NULL) {                    \
+            /* The copied array */                                                                     \
+            __kh_copy = _kharray_reallocate(                                                           \
+                __kh_allocator, NULL, 0,                                                               \
+                _kharray_memorySize(_kharray_typeSize(__kh_array_ptr), kharray_size(__kh_array_ptr))); \
+                                                                                                       \
+            /* Placing the array header and fitting the reserve count, then offsetting the copy */     \
+            *(_kharrayHeader*)__kh_copy = _kharray_header(__kh_array_ptr);                             \
+            ((_kharrayHeader*)__kh_copy)->is_static = false;                                           \
+            ((_kharrayHeader*)__kh_copy)->reserved = kharray_size(__kh_array_ptr);                     \
+            ((_kharrayHeader*)__kh_copy)->allocator = __kh_allocator;                                  \
+            __kh_copy = (typeof(__kh_array))((_kharrayHeader*)__kh_copy + 1);                          \
+                                                                                                       \
+            /* Call the copy constructor of each element, unless it's NULL */                          \
+            if (COPIER == NULL) {                                                                      \
+                memcpy(__kh_copy, __kh_array,                                                          \
+                       _kharray_typeSize(__kh_array_ptr) * kharray_size(__kh_array_ptr));              \
+            }                                                                                          \
+            else {                                                                                     \
+                for (size_t __kh_i = 0; __kh_i < kharray_size(__kh_array_ptr); __kh_i++) {             \
+                    __kh_copy[__kh_i] = ((typeof (*__kh_array) (*)(typeof(__kh_array)))(COPIER))(      \
+                        &__kh_array[__kh_i]);                                                          \
+                }                                                                                      \
+            }                                                                                          \
+        }                                                                                              \
+                                                                                                       \
+        __kh_copy;                                                                                     \
     })
 
 #define kharray_delete(ARRAY) _kharray_delete(_kharray_verify(ARRAY))
 #define kharray_arrayDeleter(TYPE) ((void (*)(TYPE**))_kharray_delete)
 static inline void _kharray_delete(void** array) {
+    khAllocator* allocator = kharray_allocator(array);
+
+    // Static blocks aren't owned, and allocators without `free` own their arrays and elements
+    if (_kharray_header(array).is_static || (allocator != NULL && allocator->free == NULL)) {
+        *array = NULL;
+        return;
+    }
+
     if (_kharray_deleter(array) != NULL) {
         // Increment by type size
         for (size_t i = 0; i < _kharray_typeSize(array) * kharray_size(array);
@@ -93,23 +191,41 @@ static inline void _kharray_delete(void** array) {
     }
 
     // Don't forget to undo the header offset before freeing it
-    free(*array - sizeof(_kharrayHeader));
+    void* memory = *array - sizeof(_kharrayHeader);
+    if (allocator != NULL) {
+        allocator->free(allocator, memory,
+                        _kharray_memorySize(_kharray_typeSize(array), kharray_reserved(array)));
+    }
+    else {
+        free(memory);
+    }
+
     *array = NULL;
 }
 
 #define kharray_reserve(ARRAY, SIZE) _kharray_reserve(_kharray_verify(ARRAY), SIZE)
 static inline void _kharray_reserve(void** array, size_t size) {
-    if (kharray_reserved(array) >= size) {
+    // Static blocks are always left, even for nothing, so a reserved array can be written to
+    if (kharray_reserved(array) >= size && !_kharray_header(array).is_static) {
         return;
     }
 
-    // Also, don't forget the null-terminator space
-    void* expanded_array = calloc(sizeof(_kharrayHeader) + _kharray_typeSize(array) * (size + 1), 1);
-    *(_kharrayHeader*)expanded_array = _kharray_header(array);
-    memcpy(expanded_array + sizeof(_kharrayHeader), *array,
-           _kharray_typeSize(array) * kharray_size(array));
-    // Undo offset, free!
-    free(*array - sizeof(_kharrayHeader));
+    size_t type_size = _kharray_typeSize(array);
+    void* expanded_array;
+    kh_countAllocation(_kharray_memorySize(type_size, size));
+
+    // A static block is left for memory of its own, instead of being reallocated
+    if (_kharray_header(array).is_static) {
+        expanded_array = calloc(_kharray_memorySize(type_size, size), 1);
+        *(_kharrayHeader*)expanded_array = _kharray_header(array);
+        ((_kharrayHeader*)expanded_array)->is_static = false;
+    }
+    else {
+        // Which can possibly be grown in place, only the new part gets zeroed
+        expanded_array = _kharray_reallocate(kharray_allocator(array), *array - sizeof(_kharrayHeader),
+                                             _kharray_memorySize(type_size, kharray_reserved(array)),
+                                             _kharray_memorySize(type_size, size));
+    }
 
     ((_kharrayHeader*)expanded_array)->reserved = size;
     *array = expanded_array + sizeof(_kharrayHeader);
@@ -117,19 +233,19 @@ static inline void _kharray_reserve(void** array, size_t size) {
 
 #define kharray_fit(ARRAY) _kharray_fit(_kharray_verify(ARRAY));
 static inline void _kharray_fit(void** array) {
-    // Pretty much the same implementation of `_kharray_reserve` but with this part different
-    if (kharray_reserved(array) == kharray_size(array)) {
+    // Memory of allocators without `free` can't be given back
+    khAllocator* allocator = kharray_allocator(array);
+    if (kharray_reserved(array) == kharray_size(array) ||
+        (allocator != NULL && allocator->free == NULL)) {
         return;
     }
 
-    void* shrunk_array =
-        calloc(sizeof(_kharrayHeader) + _kharray_typeSize(array) * (kharray_size(array) + 1), 1);
-    *(_kharrayHeader*)shrunk_array = _kharray_header(array);
-    memcpy(shrunk_array + sizeof(_kharrayHeader), *array,
-           _kharray_typeSize(array) * kharray_size(array));
-    free(*array - sizeof(_kharrayHeader));
+    void* shrunk_array = _kharray_reallocate(
+        allocator, *array - sizeof(_kharrayHeader),
+        _kharray_memorySize(_kharray_typeSize(array), kharray_reserved(array)),
+        _kharray_memorySize(_kharray_typeSize(array), kharray_size(array)));
 
-    ((_kharrayHeader*)shrunk_array)->reserved = kharray_size(array);
+    ((_kharrayHeader*)shrunk_array)->reserved = ((_kharrayHeader*)shrunk_array)->size;
     *array = shrunk_array + sizeof(_kharrayHeader);
 }
 
@@ -137,6 +253,9 @@ static inline void _kharray_fit(void** array) {
 static inline void _kharray_pop(void** array, size_t items) {
     // If it's trying to pop more items than the array actually has, cap it
     items = items > kharray_size(array) ? kharray_size(array) : items;
+    if (items == 0) {
+        return; // Static blocks are never written to
+    }
 
     if (_kharray_deleter(array) != NULL) {
         for (size_t i = items; i > 0; i--) {
@@ -147,7 +266,7 @@ static inline void _kharray_pop(void** array, size_t items) {
     // Clean after yourself
     memset(*array + _kharray_typeSize(array) * (kharray_size(array) - items), 0,
            _kharray_typeSize(array) * items);
-    kharray_size(array) -= items;
+    _kharray_setSize(array, kharray_size(array) - items);
 }
 
 #define kharray_reverse(ARRAY) _kharray_reverse(_kharray_verify(ARRAY))
@@ -175,9 +294,10 @@ static inline void _kharray_reverse(void** array) {
         typeof(PTR) __kh_ptr = PTR;                                                                   \
         size_t __kh_size = SIZE;                                                                      \
                                                                                                       \
-        /* If the reserved memory isn't enough, try to allocate more by *2 of the existing memory */  \
+        /* If the reserved memory isn't enough, try to allocate more by *2 of the existing memory;    \
+         * starting with 4, as most arrays (like those of the AST) never get any bigger */            \
         if (kharray_size(__kh_array_ptr) + __kh_size > kharray_reserved(__kh_array_ptr)) {            \
-            size_t __kh_exsize = kharray_size(__kh_array_ptr) ? kharray_size(__kh_array_ptr) * 2 : 2; \
+            size_t __kh_exsize = kharray_size(__kh_array_ptr) ? kharray_size(__kh_array_ptr) * 2 : 4; \
             kharray_reserve(__kh_array_ptr, __kh_exsize < kharray_size(__kh_array_ptr) + __kh_size    \
                                                 ? kharray_size(__kh_array_ptr) + __kh_size            \
                                                 : __kh_exsize);                                       \
@@ -197,7 +317,7 @@ static inline void _kharray_reverse(void** array) {
             }                                                                                         \
         }                                                                                             \
                                                                                                       \
-        kharray_size(__kh_array_ptr) += __kh_size;                                                    \
+        kharray_setSize(__kh_array_ptr, kharray_size(__kh_array_ptr) + __kh_size);                    \
     }
 
 #define kharray_append(ARRAY, ITEM)                              \
@@ -212,6 +332,27 @@ static inline void _kharray_reverse(void** array) {
 #define kharray_concatenate(ARRAY, OTHER, COPIER) \
     kharray_memory(ARRAY, *(OTHER), kharray_size(OTHER), COPIER)
 
+// Empties the array without deleting its items, for when they've been moved out of it
+#define kharray_forget(ARRAY) _kharray_forget(_kharray_verify(ARRAY))
+static inline void _kharray_forget(void** array) {
+    if (kharray_size(array) == 0) {
+        return; // Static blocks are never written to
+    }
+
+    memset(*array, 0, _kharray_typeSize(array) * kharray_size(array));
+    _kharray_setSize(array, 0);
+}
+
+// Moves the items of the other array onto the end of the array rather than copying them, then deletes
+// the other one without them
+#define kharray_move(ARRAY, OTHER)                         \
+    {                                                      \
+        typeof(OTHER) ___kh_other_ptr = OTHER;             \
+        kharray_concatenate(ARRAY, ___kh_other_ptr, NULL); \
+        kharray_forget(___kh_other_ptr);                   \
+        kharray_delete(___kh_other_ptr);                   \
+    }
+
 
 #ifdef __cplusplus
 }
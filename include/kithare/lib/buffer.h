@@ -69,104 +69,58 @@ static inline void khbuffer_concatenateCstring(khbuffer* buffer, const char* cst
     kharray_memory(buffer, (uint8_t*)cstring, strlen(cstring), NULL);
 }
 
+// Compared with `memcmp`, in blocks rather than a byte at a time
 static inline bool khbuffer_equal(khbuffer* a, khbuffer* b) {
-    if (khbuffer_size(a) != khbuffer_size(b)) {
-        return false;
-    }
-
-    for (size_t i = 0; i < khbuffer_size(a); i++) {
-        if ((*a)[i] != (*b)[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    return khbuffer_size(a) == khbuffer_size(b) && memcmp(*a, *b, khbuffer_size(a)) == 0;
 }
 
 static inline bool khbuffer_equalCstring(khbuffer* buffer, const char* cstring) {
     size_t length = strlen(cstring);
-    if (khbuffer_size(buffer) != length) {
-        return false;
-    }
-
-    for (size_t i = 0; i < length; i++) {
-        if ((*buffer)[i] != cstring[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    return khbuffer_size(buffer) == length && memcmp(*buffer, cstring, length) == 0;
 }
 
 static inline bool khbuffer_startsWith(khbuffer* buffer, khbuffer* prefix) {
-    if (khbuffer_size(buffer) < khbuffer_size(prefix)) {
-        return false;
-    }
-
-    for (size_t i = 0; i < khbuffer_size(prefix); i++) {
-        if ((*buffer)[i] != (*prefix)[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    return khbuffer_size(buffer) >= khbuffer_size(prefix) &&
+           memcmp(*buffer, *prefix, khbuffer_size(prefix)) == 0;
 }
 
 static inline bool khbuffer_startsWithCstring(khbuffer* buffer, const char* cstring) {
     size_t length = strlen(cstring);
-    if (khbuffer_size(buffer) < length) {
-        return false;
-    }
-
-    for (size_t i = 0; i < length; i++) {
-        if ((*buffer)[i] != cstring[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    return khbuffer_size(buffer) >= length && memcmp(*buffer, cstring, length) == 0;
 }
 
 static inline bool khbuffer_endsWith(khbuffer* buffer, khbuffer* suffix) {
-    if (khbuffer_size(buffer) < khbuffer_size(suffix)) {
-        return false;
-    }
-
-    for (size_t i = 0; i < khbuffer_size(suffix); i++) {
-        if ((*buffer)[khbuffer_size(buffer) - khbuffer_size(suffix) + i] != (*suffix)[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    return khbuffer_size(buffer) >= khbuffer_size(suffix) &&
+           memcmp(*buffer + khbuffer_size(buffer) - khbuffer_size(suffix), *suffix,
+                  khbuffer_size(suffix)) == 0;
 }
 
 static inline bool khbuffer_endsWithCstring(khbuffer* buffer, const char* cstring) {
     size_t length = strlen(cstring);
-    if (khbuffer_size(buffer) < length) {
-        return false;
-    }
-
-    for (size_t i = 0; i < length; i++) {
-        if ((*buffer)[khbuffer_size(buffer) - length + i] != cstring[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    return khbuffer_size(buffer) >= length &&
+           memcmp(*buffer + khbuffer_size(buffer) - length, cstring, length) == 0;
 }
 
 static inline khstring khbuffer_quote(khbuffer* buffer) {
     khstring quoted_buffer = khstring_new(U"\"");
-
-    for (uint8_t* byte = *buffer; byte < *buffer + khbuffer_size(buffer); byte++) {
-        if (*byte == '\'') {
-            khstring_append(&quoted_buffer, U'\'');
+    // At least a character for each byte, and the quotes
+    khstring_reserve(&quoted_buffer, khbuffer_size(buffer) + 2);
+
+    uint8_t* byte = *buffer;
+    uint8_t* end = *buffer + khbuffer_size(buffer);
+
+    while (byte < end) {
+        // Runs needing no escapes are widened in blocks, single quotes too as they're in double ones
+        size_t plain = kh_printablePrefix(byte, end - byte);
+        khstring_reserve(&quoted_buffer, khstring_size(&quoted_buffer) + plain);
+        kh_widenAscii(quoted_buffer + khstring_size(&quoted_buffer), byte, plain);
+        if (plain > 0) {
+            kharray_setSize(&quoted_buffer, kharray_size(&quoted_buffer) + plain);
         }
-        else {
-            khstring escaped = kh_escapeChar(*byte);
-            khstring_concatenate(&quoted_buffer, &escaped);
-            khstring_delete(&escaped);
+        byte += plain;
+
+        if (byte < end) {
+            khstring_appendEscaped(&quoted_buffer, *byte++);
         }
     }
 
@@ -174,7 +128,6 @@ static inline khstring khbuffer_quote(khbuffer* buffer) {
     return quoted_buffer;
 }
 
-
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,359 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "buffer.h"
+#include "string.h"
+
+
+// 64-bit product of two 64-bit numbers, folded from its 128 bits
+static inline uint64_t _kh_hashMix(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t product = (__uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else
+    uint64_t a_high = a >> 32, a_low = (uint32_t)a, b_high = b >> 32, b_low = (uint32_t)b;
+    uint64_t high = a_high * b_high, middle = a_high * b_low, middle2 = a_low * b_high;
+    uint64_t low = a_low * b_low;
+
+    uint64_t carry = ((low >> 32) + (uint32_t)middle + (uint32_t)middle2) >> 32;
+    high += (middle >> 32) + (middle2 >> 32) + carry;
+    low += (middle << 32) + (middle2 << 32);
+    return low ^ high;
+#endif
+}
+
+static inline uint64_t _kh_hashRead64(const uint8_t* memory) {
+    uint64_t value;
+    memcpy(&value, memory, 8);
+    return value;
+}
+
+static inline uint64_t _kh_hashRead32(const uint8_t* memory) {
+    uint32_t value;
+    memcpy(&value, memory, 4);
+    return value;
+}
+
+// Hash of the memory, 16 bytes at a time, after wyhash; unlike FNV-1a it doesn't go byte by byte, and
+// every bit of it is mixed well enough to take the low ones as an index
+static inline uint64_t kh_hash(const void* memory, size_t size) {
+    const uint64_t secrets[4] = {0xA0761D6478BD642Full, 0xE7037ED1A0B428DBull, 0x8EBC6AF09C88C6E3ull,
+                                 0x589965CC75374CC3ull};
+    const uint8_t* bytes = (const uint8_t*)memory;
+    uint64_t seed = _kh_hashMix(secrets[0], secrets[1]);
+    uint64_t a, b;
+
+    if (size <= 16) {
+        if (size >= 4) {
+            // Overlapping reads, up to 8 bytes from each end
+            size_t middle = (size >> 3) << 2;
+            a = (_kh_hashRead32(bytes) << 32) | _kh_hashRead32(bytes + middle);
+            b = (_kh_hashRead32(bytes + size - 4) << 32) | _kh_hashRead32(bytes + size - 4 - middle);
+        }
+        else if (size > 0) {
+            a = ((uint64_t)bytes[0] << 16) | ((uint64_t)bytes[size >> 1] << 8) | bytes[size - 1];
+            b = 0;
+        }
+        else {
+            a = b = 0;
+        }
+    }
+    else {
+        size_t left = size;
+        for (; left > 16; left -= 16, bytes += 16) {
+            seed = _kh_hashMix(_kh_hashRead64(bytes) ^ secrets[1], _kh_hashRead64(bytes + 8) ^ seed);
+        }
+
+        // The last 16 bytes, which may overlap with those before
+        a = _kh_hashRead64(bytes + left - 16);
+        b = _kh_hashRead64(bytes + left - 8);
+    }
+
+    uint64_t mixed = _kh_hashMix(a ^ secrets[1], b ^ seed);
+    return _kh_hashMix(mixed ^ secrets[2] ^ size, mixed ^ secrets[3]);
+}
+
+
+// Hashers and comparers for the common keys, which are given pointers to them
+static inline uint64_t khhashmap_hashString(const void* key) {
+    khstring* string = (khstring*)key;
+    return kh_hash(*string, khstring_size(string) * sizeof(char32_t));
+}
+
+static inline bool khhashmap_equalString(const void* a, const void* b) {
+    return khstring_equal((khstring*)a, (khstring*)b);
+}
+
+static inline uint64_t khhashmap_hashBuffer(const void* key) {
+    khbuffer* buffer = (khbuffer*)key;
+    return kh_hash(*buffer, kharray_size(buffer));
+}
+
+static inline bool khhashmap_equalBuffer(const void* a, const void* b) {
+    khbuffer* a_buffer = (khbuffer*)a;
+    khbuffer* b_buffer = (khbuffer*)b;
+    return kharray_size(a_buffer) == kharray_size(b_buffer) &&
+           memcmp(*a_buffer, *b_buffer, kharray_size(a_buffer)) == 0;
+}
+
+static inline uint64_t khhashmap_hashUint64(const void* key) {
+    return kh_hash(key, sizeof(uint64_t));
+}
+
+static inline bool khhashmap_equalUint64(const void* a, const void* b) {
+    return *(uint64_t*)a == *(uint64_t*)b;
+}
+
+static inline uint64_t khhashmap_hashPointer(const void* key) {
+    return kh_hash(key, sizeof(void*));
+}
+
+static inline bool khhashmap_equalPointer(const void* a, const void* b) {
+    return *(void**)a == *(void**)b;
+}
+
+
+// Kept along with each entry; the low 32 bits of the hash are enough for an index, and only keys with
+// the same ones are compared
+typedef struct {
+    uint32_t hash;
+    uint32_t distance; // From where its hash points to, plus 1; 0 on empty slots
+} _khhashmapSlot;
+
+typedef struct {
+    uint32_t entry_size;
+    uint64_t (*hasher)(const void* key);
+    bool (*equal)(const void* a, const void* b);
+    void (*deleter)(void*);
+    size_t size;
+    size_t capacity; // 0, or a power of 2
+} _khhashmapHeader;
+
+
+// A map is a pointer to its entries, like arrays are to their items: `ENTRY` is a struct whose first
+// member is its `key`, with anything else after it. It's open addressed with Robin Hood hashing, each
+// entry being at most as far from where its hash points to as the ones before it, so lookups of missing
+// keys stop early. The entries are in `map[0]` to `map[khhashmap_capacity(&map) - 1]`, wherever
+// `khhashmap_isOccupied` is true, and they move whenever the map is modified
+#define khhashmap(ENTRY) ENTRY* // Type alias
+#define _khhashmap_header(MAP) (((_khhashmapHeader*)(*MAP))[-1])
+#define _khhashmap_slots(MAP) \
+    ((_khhashmapSlot*)((uint8_t*)*(MAP) + _khhashmap_header(MAP).entry_size * khhashmap_capacity(MAP)))
+#define khhashmap_size(MAP) (_khhashmap_header(MAP).size)
+#define khhashmap_capacity(MAP) (_khhashmap_header(MAP).capacity)
+#define khhashmap_isOccupied(MAP, INDEX) (_khhashmap_slots(MAP)[INDEX].distance != 0)
+
+static inline size_t _khhashmap_memorySize(size_t entry_size, size_t capacity) {
+    return sizeof(_khhashmapHeader) + (entry_size + sizeof(_khhashmapSlot)) * capacity;
+}
+
+// The hasher and comparer are given pointers to keys, like `khhashmap_hashString` is, and the deleter
+// is called on each entry that's removed, replaced, or left in the map when it's deleted
+#define khhashmap_new(ENTRY, HASHER, EQUAL, DELETER)                                                 \
+    ({                                                                                              \
+        _Static_assert(offsetof(ENTRY, key) == 0, "the key must be the first member of the entry"); \
+        (ENTRY*)_khhashmap_new(sizeof(ENTRY), HASHER, EQUAL, (void (*)(void*))(DELETER), 0);       \
+    })
+static inline void* _khhashmap_new(size_t entry_size, uint64_t (*hasher)(const void* key),
+                                   bool (*equal)(const void* a, const void* b),
+                                   void (*deleter)(void*), size_t capacity) {
+    kh_countAllocation(_khhashmap_memorySize(entry_size, capacity));
+    void* map = calloc(1, _khhashmap_memorySize(entry_size, capacity));
+    *(_khhashmapHeader*)map = (_khhashmapHeader){.entry_size = entry_size,
+                                                 .hasher = hasher,
+                                                 .equal = equal,
+                                                 .deleter = deleter,
+                                                 .size = 0,
+                                                 .capacity = capacity};
+    return (uint8_t*)map + sizeof(_khhashmapHeader);
+}
+
+#define khhashmap_delete(MAP) _khhashmap_delete(_kharray_verify(MAP))
+static inline void _khhashmap_delete(void** map) {
+    _khhashmapHeader* header = &_khhashmap_header(map);
+    if (header->deleter != NULL) {
+        for (size_t i = 0; i < header->capacity; i++) {
+            if (khhashmap_isOccupied(map, i)) {
+                header->deleter((uint8_t*)*map + header->entry_size * i);
+            }
+        }
+    }
+
+    free(header);
+    *map = NULL;
+}
+
+// Puts the entry where it belongs, displacing the entries which are closer to where they belong, which
+// are put further along in turn. Its key mustn't be in the map, and there must be room for it
+static inline void* _khhashmap_place(void** map, const void* entry, uint32_t hash) {
+    _khhashmapHeader* header = &_khhashmap_header(map);
+    _khhashmapSlot* slots = _khhashmap_slots(map);
+    size_t mask = header->capacity - 1;
+
+    uint8_t carried[header->entry_size];
+    memcpy(carried, entry, header->entry_size);
+    _khhashmapSlot carried_slot = {.hash = hash, .distance = 1};
+    void* placed = NULL;
+
+    for (size_t index = hash & mask;; index = (index + 1) & mask, carried_slot.distance++) {
+        uint8_t* item = (uint8_t*)*map + header->entry_size * index;
+
+        if (slots[index].distance == 0) {
+            memcpy(item, carried, header->entry_size);
+            slots[index] = carried_slot;
+            header->size++;
+            return placed != NULL ? placed : item;
+        }
+        else if (slots[index].distance < carried_slot.distance) {
+            uint8_t swap[header->entry_size];
+            memcpy(swap, item, header->entry_size);
+            memcpy(item, carried, header->entry_size);
+            memcpy(carried, swap, header->entry_size);
+
+            _khhashmapSlot swap_slot = slots[index];
+            slots[index] = carried_slot;
+            carried_slot = swap_slot;
+
+            if (placed == NULL) {
+                placed = item;
+            }
+        }
+    }
+}
+
+// Twice as big, keeping it at most 7/8 full
+static inline void _khhashmap_grow(void** map) {
+    _khhashmapHeader* header = &_khhashmap_header(map);
+    size_t capacity = header->capacity ? header->capacity * 2 : 8;
+    void* grown =
+        _khhashmap_new(header->entry_size, header->hasher, header->equal, header->deleter, capacity);
+
+    _khhashmapSlot* slots = _khhashmap_slots(map);
+    for (size_t i = 0; i < header->capacity; i++) {
+        if (slots[i].distance != 0) {
+            _khhashmap_place(&grown, (uint8_t*)*map + header->entry_size * i, slots[i].hash);
+        }
+    }
+
+    free(header);
+    *map = grown;
+}
+
+// Index of the key's entry, or the capacity if it isn't in the map
+static inline size_t _khhashmap_index(void** map, const void* key, uint64_t hash) {
+    _khhashmapHeader* header = &_khhashmap_header(map);
+    if (header->capacity == 0) {
+        return 0;
+    }
+
+    _khhashmapSlot* slots = _khhashmap_slots(map);
+    size_t mask = header->capacity - 1;
+
+    // Past an entry closer to where it belongs than this one would be, it can't be any further
+    uint32_t distance = 1;
+    for (size_t index = hash & mask; slots[index].distance >= distance;
+         index = (index + 1) & mask, distance++) {
+        if (slots[index].hash == (uint32_t)hash &&
+            header->equal((uint8_t*)*map + header->entry_size * index, key)) {
+            return index;
+        }
+    }
+
+    return header->capacity;
+}
+
+// The entry of the key, NULL if there isn't one
+#define khhashmap_find(MAP, KEY)                                                             \
+    ({                                                                                       \
+        typeof(MAP) __kh_map = MAP;                                                          \
+        typeof((*__kh_map)->key) __kh_key = KEY;                                             \
+        (typeof(*__kh_map))_khhashmap_find(_kharray_verify(__kh_map), &__kh_key);            \
+    })
+static inline void* _khhashmap_find(void** map, const void* key) {
+    size_t index = _khhashmap_index(map, key, _khhashmap_header(map).hasher(key));
+    return index < khhashmap_capacity(map) ? (uint8_t*)*map + _khhashmap_header(map).entry_size * index
+                                           : NULL;
+}
+
+// Inserts the entry, replacing (and deleting) the one of the same key if there's one; the entry it's
+// put in is given back
+#define khhashmap_put(MAP, ENTRY)                                                  \
+    ({                                                                             \
+        typeof(MAP) __kh_map = MAP;                                                \
+        typeof(**__kh_map) __kh_entry = ENTRY;                                     \
+        (typeof(*__kh_map))_khhashmap_put(_kharray_verify(__kh_map), &__kh_entry); \
+    })
+static inline void* _khhashmap_put(void** map, const void* entry) {
+    uint64_t hash = _khhashmap_header(map).hasher(entry);
+    size_t index = _khhashmap_index(map, entry, hash);
+
+    if (index < khhashmap_capacity(map)) {
+        uint8_t* item = (uint8_t*)*map + _khhashmap_header(map).entry_size * index;
+        if (_khhashmap_header(map).deleter != NULL) {
+            _khhashmap_header(map).deleter(item);
+        }
+
+        memcpy(item, entry, _khhashmap_header(map).entry_size);
+        return item;
+    }
+
+    if ((khhashmap_size(map) + 1) * 8 > khhashmap_capacity(map) * 7) {
+        _khhashmap_grow(map);
+    }
+    return _khhashmap_place(map, entry, (uint32_t)hash);
+}
+
+// Removes and deletes the entry of the key, if there's one. Entries after it are moved back, so none of
+// them is left any further from where it belongs than it'd be if it was never there
+#define khhashmap_remove(MAP, KEY)                                              \
+    ({                                                                          \
+        typeof(MAP) __kh_map = MAP;                                             \
+        typeof((*__kh_map)->key) __kh_key = KEY;                                \
+        _khhashmap_remove(_kharray_verify(__kh_map), &__kh_key);                \
+    })
+static inline bool _khhashmap_remove(void** map, const void* key) {
+    _khhashmapHeader* header = &_khhashmap_header(map);
+    size_t index = _khhashmap_index(map, key, header->hasher(key));
+    if (index == header->capacity) {
+        return false;
+    }
+
+    if (header->deleter != NULL) {
+        header->deleter((uint8_t*)*map + header->entry_size * index);
+    }
+
+    _khhashmapSlot* slots = _khhashmap_slots(map);
+    size_t mask = header->capacity - 1;
+    for (size_t next = (index + 1) & mask; slots[next].distance > 1;
+         index = next, next = (next + 1) & mask) {
+        memcpy((uint8_t*)*map + header->entry_size * index, (uint8_t*)*map + header->entry_size * next,
+               header->entry_size);
+        slots[index] = (_khhashmapSlot){.hash = slots[next].hash, .distance = slots[next].distance - 1};
+    }
+
+    memset((uint8_t*)*map + header->entry_size * index, 0, header->entry_size);
+    slots[index] = (_khhashmapSlot){.hash = 0, .distance = 0};
+    header->size--;
+    return true;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,108 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "arena.h"
+#include "array.h"
+#include "hashmap.h"
+#include "string.h"
+
+
+typedef struct {
+    khstring key;
+} _khInternerEntry;
+
+// Keeps a single copy of each distinct string, so equal interned strings are the same pointer. They
+// live in the interner's arena, which makes `khstring_delete` a no-op on them, and copying them with
+// `khstring_copy` gives a regular string. They are shared, so never modify them. A zeroed interner is
+// an empty one
+typedef struct {
+    khhashmap(_khInternerEntry) strings; // NULL until anything is interned
+    khstring decoded;                    // What's being interned from UTF-8, reused every time
+    khArena arena;
+} khInterner;
+
+
+static inline khInterner khInterner_new(void) {
+    return (khInterner){.strings = NULL, .decoded = NULL, .arena = khArena_new()};
+}
+
+// Invalidates every string it has interned
+static inline void khInterner_delete(khInterner* interner) {
+    if (interner->strings != NULL) {
+        khhashmap_delete(&interner->strings);
+        khstring_delete(&interner->decoded);
+    }
+
+    khArena_delete(&interner->arena);
+    *interner = khInterner_new();
+}
+
+static inline void _khInterner_start(khInterner* interner) {
+    if (interner->strings == NULL) {
+        interner->strings = khhashmap_new(_khInternerEntry, khhashmap_hashString,
+                                          khhashmap_equalString, NULL);
+        interner->decoded = khstring_new(U"");
+    }
+}
+
+// The interned copy of the string is only made the first time it's met
+static inline khstring khInterner_intern(khInterner* interner, khstring* string) {
+    _khInterner_start(interner);
+
+    _khInternerEntry* entry = khhashmap_find(&interner->strings, *string);
+    if (entry != NULL) {
+        return entry->key;
+    }
+
+    khstring interned = kharray_arenaNew(char32_t, NULL, &interner->arena);
+    kharray_reserve(&interned, khstring_size(string));
+    kharray_memory(&interned, *string, khstring_size(string), NULL);
+
+    khhashmap_put(&interner->strings, ((_khInternerEntry){.key = interned}));
+    return interned;
+}
+
+// Interns UTF-8 memory, decoded into a string the interner reuses, so it only allocates the first time
+// it's met. Invalid sequences are interned as U+FFFD, like `kh_decodeUtf8` does
+static inline khstring khInterner_internUtf8(khInterner* interner, const uint8_t* memory, size_t size) {
+    _khInterner_start(interner);
+
+    kharray_reserve(&interner->decoded, size); // At most a character for each byte
+    kharray_setSize(&interner->decoded, _kh_decodeUtf8Into(interner->decoded, memory, size));
+    return khInterner_intern(interner, &interner->decoded);
+}
+
+// Interns every string of the other one, calling back with each of them and the one interned for it
+static inline void khInterner_merge(khInterner* interner, khInterner* other,
+                                    void (*merged)(khstring from, khstring to, void* data),
+                                    void* data) {
+    if (other->strings == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < khhashmap_capacity(&other->strings); i++) {
+        if (khhashmap_isOccupied(&other->strings, i)) {
+            khstring from = other->strings[i].key;
+            merged(from, khInterner_intern(interner, &from), data);
+        }
+    }
+}
+
+
+#ifdef __cplusplus
+}
+#endif
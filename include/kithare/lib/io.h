@@ -10,13 +10,23 @@
 extern "C" {
 #endif
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wchar.h>
 
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include "array.h"
@@ -36,15 +46,23 @@ static inline void kh_putln(khstring* string, FILE* stream) {
     khbuffer_delete(&buffer);
 }
 
-static inline khbuffer kh_readFile(khstring* file_name, bool* success) {
-    khbuffer buffer = khbuffer_new("");
-
 #ifdef _WIN32
+// Has to be freed afterwards
+static inline char16_t* _kh_char16FileName(khstring* file_name) {
     char16_t* char16_file_name = (char16_t*)calloc(khstring_size(file_name) + 1, sizeof(char16_t));
     for (size_t i = 0; i < khstring_size(file_name); i++) {
         char16_file_name[i] = (char16_t)(*file_name)[i];
     }
 
+    return char16_file_name;
+}
+#endif
+
+static inline khbuffer kh_readFile(khstring* file_name, bool* success) {
+    khbuffer buffer = khbuffer_new("");
+
+#ifdef _WIN32
+    char16_t* char16_file_name = _kh_char16FileName(file_name);
     FILE* file = _wfopen(char16_file_name, L"rb");
     free(char16_file_name);
 #else
@@ -54,13 +72,20 @@ static inline khbuffer kh_readFile(khstring* file_name, bool* success) {
 #endif
 
     if (file != NULL) {
-        fseek(file, 0, SEEK_END);
-        khbuffer_reserve(&buffer, ftell(file));
+        // Read it all at once when the size is known
+        long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
         rewind(file);
 
-        int chr;
-        while ((chr = fgetc(file)) != EOF) {
-            khbuffer_append(&buffer, chr);
+        if (size > 0) {
+            khbuffer_reserve(&buffer, size);
+            kharray_setSize(&buffer, fread(buffer, 1, size, file));
+        }
+
+        // Then by chunks for whatever is left, like from pipes or files which have grown
+        uint8_t chunk[4096];
+        size_t chunk_size;
+        while ((chunk_size = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            kharray_memory(&buffer, &chunk[0], chunk_size, NULL);
         }
 
         *success = true;
@@ -73,6 +98,330 @@ static inline khbuffer kh_readFile(khstring* file_name, bool* success) {
     return buffer;
 }
 
+// Written into a temporary file next to it first, which then replaces it, so it's never seen partially
+// written by others reading it at the same time
+static inline bool kh_writeFile(khstring* file_name, const uint8_t* data, size_t size) {
+    // Unique to the process and the write, as threads may write the same file at once
+    static atomic_uint_fast32_t writes = 0;
+
+    khstring temporary_name = khstring_copy(file_name);
+    khstring_concatenateCstring(&temporary_name, U".tmp");
+
+#ifdef _WIN32
+    khstring process_id = kh_uintToString(GetCurrentProcessId(), 16);
+#else
+    khstring process_id = kh_uintToString(getpid(), 16);
+#endif
+    khstring_concatenate(&temporary_name, &process_id);
+    khstring_delete(&process_id);
+
+    khstring_append(&temporary_name, U'.');
+    khstring write_id = kh_uintToString(atomic_fetch_add(&writes, 1), 16);
+    khstring_concatenate(&temporary_name, &write_id);
+    khstring_delete(&write_id);
+
+#ifdef _WIN32
+    char16_t* char16_temporary_name = _kh_char16FileName(&temporary_name);
+    FILE* file = _wfopen(char16_temporary_name, L"wb");
+#else
+    khbuffer utf8_temporary_name = kh_encodeUtf8(&temporary_name);
+    FILE* file = fopen((char*)utf8_temporary_name, "wb");
+#endif
+    khstring_delete(&temporary_name);
+
+    bool success = file != NULL;
+    if (success) {
+        success = fwrite(data, 1, size, file) == size;
+        success = fclose(file) == 0 && success;
+    }
+
+#ifdef _WIN32
+    char16_t* char16_file_name = _kh_char16FileName(file_name);
+    if (success) {
+        success = MoveFileExW((wchar_t*)char16_temporary_name, (wchar_t*)char16_file_name,
+                              MOVEFILE_REPLACE_EXISTING);
+    }
+    if (file != NULL && !success) {
+        DeleteFileW((wchar_t*)char16_temporary_name);
+    }
+
+    free(char16_file_name);
+    free(char16_temporary_name);
+#else
+    khbuffer utf8_file_name = kh_encodeUtf8(file_name);
+    if (success) {
+        success = rename((char*)utf8_temporary_name, (char*)utf8_file_name) == 0;
+    }
+    if (file != NULL && !success) {
+        remove((char*)utf8_temporary_name);
+    }
+
+    khbuffer_delete(&utf8_file_name);
+    khbuffer_delete(&utf8_temporary_name);
+#endif
+
+    return success;
+}
+
+// Also succeeds if the directory already exists
+static inline bool kh_makeDirectory(khstring* path) {
+#ifdef _WIN32
+    char16_t* char16_path = _kh_char16FileName(path);
+    bool success = CreateDirectoryW((wchar_t*)char16_path, NULL) ||
+                   GetLastError() == ERROR_ALREADY_EXISTS;
+    free(char16_path);
+#else
+    khbuffer utf8_path = kh_encodeUtf8(path);
+    bool success = mkdir((char*)utf8_path, 0777) == 0 || errno == EEXIST;
+    khbuffer_delete(&utf8_path);
+#endif
+
+    return success;
+}
+
+static inline bool kh_isDirectory(khstring* path) {
+#ifdef _WIN32
+    char16_t* char16_path = _kh_char16FileName(path);
+    DWORD attributes = GetFileAttributesW((wchar_t*)char16_path);
+    free(char16_path);
+
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    khbuffer utf8_path = kh_encodeUtf8(path);
+    struct stat status;
+    bool is_directory = stat((char*)utf8_path, &status) == 0 && S_ISDIR(status.st_mode);
+    khbuffer_delete(&utf8_path);
+
+    return is_directory;
+#endif
+}
+
+static inline bool kh_isFile(khstring* path) {
+#ifdef _WIN32
+    char16_t* char16_path = _kh_char16FileName(path);
+    DWORD attributes = GetFileAttributesW((wchar_t*)char16_path);
+    free(char16_path);
+
+    return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    khbuffer utf8_path = kh_encodeUtf8(path);
+    struct stat status;
+    bool is_file = stat((char*)utf8_path, &status) == 0 && !S_ISDIR(status.st_mode);
+    khbuffer_delete(&utf8_path);
+
+    return is_file;
+#endif
+}
+
+// With symbolic links resolved where they're supported; a copy of the path if it doesn't exist
+static inline khstring kh_absolutePath(khstring* path) {
+#ifdef _WIN32
+    char16_t* char16_path = _kh_char16FileName(path);
+    wchar_t full_path[MAX_PATH];
+    DWORD size = GetFullPathNameW((wchar_t*)char16_path, MAX_PATH, full_path, NULL);
+    free(char16_path);
+
+    if (size == 0 || size >= MAX_PATH) {
+        return khstring_copy(path);
+    }
+
+    khstring absolute = khstring_new(U"");
+    for (DWORD i = 0; i < size; i++) {
+        khstring_append(&absolute, full_path[i]);
+    }
+    return absolute;
+#else
+    khbuffer utf8_path = kh_encodeUtf8(path);
+    char* resolved = realpath((char*)utf8_path, NULL);
+    khbuffer_delete(&utf8_path);
+
+    if (resolved == NULL) {
+        return khstring_copy(path);
+    }
+
+    khbuffer utf8_absolute = khbuffer_new(resolved);
+    khstring absolute = kh_decodeUtf8(&utf8_absolute);
+    khbuffer_delete(&utf8_absolute);
+    free(resolved);
+    return absolute;
+#endif
+}
+
+// Names of the entries in the directory, without `.` and `..`, in no particular order
+static inline kharray(khstring) kh_readDirectory(khstring* path, bool* success) {
+    kharray(khstring) names = kharray_new(khstring, khstring_delete);
+
+#ifdef _WIN32
+    khstring pattern = khstring_copy(path);
+    khstring_concatenateCstring(&pattern, U"\\*");
+    char16_t* char16_pattern = _kh_char16FileName(&pattern);
+    khstring_delete(&pattern);
+
+    WIN32_FIND_DATAW entry;
+    HANDLE find = FindFirstFileW((wchar_t*)char16_pattern, &entry);
+    free(char16_pattern);
+
+    *success = find != INVALID_HANDLE_VALUE;
+    if (!*success) {
+        return names;
+    }
+
+    do {
+        khstring name = khstring_new(U"");
+        for (wchar_t* wchr = entry.cFileName; *wchr != L'\0'; wchr++) {
+            khstring_append(&name, *wchr);
+        }
+
+        if (khstring_equalCstring(&name, U".") || khstring_equalCstring(&name, U"..")) {
+            khstring_delete(&name);
+        }
+        else {
+            kharray_append(&names, name);
+        }
+    } while (FindNextFileW(find, &entry));
+
+    FindClose(find);
+#else
+    khbuffer utf8_path = kh_encodeUtf8(path);
+    DIR* directory = opendir((char*)utf8_path);
+    khbuffer_delete(&utf8_path);
+
+    *success = directory != NULL;
+    if (!*success) {
+        return names;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != NULL) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            khbuffer name = khbuffer_new(entry->d_name);
+            kharray_append(&names, kh_decodeUtf8(&name));
+            khbuffer_delete(&name);
+        }
+    }
+
+    closedir(directory);
+#endif
+
+    return names;
+}
+
+
+// A view of a whole file, mapped into memory without copying it
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE handle;
+    HANDLE mapping;
+#endif
+} khMappedFile;
+
+// A copy-on-write view, which is private to the process and can be written to without the file being
+// modified. Fails on what can't be mapped, like pipes. Sources are read with `kh_readFile` instead, as
+// the lexer needs them null-terminated
+static inline khMappedFile kh_mapFilePrivate(khstring* file_name, bool* success) {
+    khMappedFile mapped_file = {.data = NULL, .size = 0};
+    *success = false;
+
+#ifdef _WIN32
+    mapped_file.handle = INVALID_HANDLE_VALUE;
+    mapped_file.mapping = NULL;
+
+    char16_t* char16_file_name = _kh_char16FileName(file_name);
+    HANDLE handle = CreateFileW((wchar_t*)char16_file_name, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    free(char16_file_name);
+
+    LARGE_INTEGER size;
+    if (handle == INVALID_HANDLE_VALUE) {
+        return mapped_file;
+    }
+    else if (!GetFileSizeEx(handle, &size) || GetFileType(handle) != FILE_TYPE_DISK) {
+        CloseHandle(handle);
+        return mapped_file;
+    }
+
+    mapped_file.handle = handle;
+    mapped_file.size = (size_t)size.QuadPart;
+
+    // Empty files can't be mapped, but there's nothing to view anyway
+    if (mapped_file.size > 0) {
+        mapped_file.mapping = CreateFileMappingW(handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (mapped_file.mapping == NULL) {
+            CloseHandle(handle);
+            return (khMappedFile){.data = NULL, .size = 0, .handle = INVALID_HANDLE_VALUE};
+        }
+
+        mapped_file.data = MapViewOfFile(mapped_file.mapping, FILE_MAP_COPY, 0, 0, 0);
+        if (mapped_file.data == NULL) {
+            CloseHandle(mapped_file.mapping);
+            CloseHandle(handle);
+            return (khMappedFile){.data = NULL, .size = 0, .handle = INVALID_HANDLE_VALUE};
+        }
+    }
+#else
+    khbuffer utf8_file_name = kh_encodeUtf8(file_name);
+    int descriptor = open((char*)utf8_file_name, O_RDONLY);
+    khbuffer_delete(&utf8_file_name);
+
+    struct stat status;
+    if (descriptor < 0) {
+        return mapped_file;
+    }
+    else if (fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode)) {
+        close(descriptor);
+        return mapped_file;
+    }
+
+    mapped_file.size = status.st_size;
+
+    // Empty files can't be mapped, but there's nothing to view anyway
+    if (mapped_file.size > 0) {
+        void* data = mmap(NULL, mapped_file.size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+
+        if (data == MAP_FAILED) {
+            close(descriptor);
+            return (khMappedFile){.data = NULL, .size = 0};
+        }
+
+        // It's only read through once from the start
+        madvise(data, mapped_file.size, MADV_SEQUENTIAL);
+        mapped_file.data = data;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(descriptor);
+#endif
+
+    *success = true;
+    return mapped_file;
+}
+
+static inline void khMappedFile_delete(khMappedFile* mapped_file) {
+#ifdef _WIN32
+    if (mapped_file->data != NULL) {
+        UnmapViewOfFile(mapped_file->data);
+    }
+    if (mapped_file->mapping != NULL) {
+        CloseHandle(mapped_file->mapping);
+    }
+    if (mapped_file->handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(mapped_file->handle);
+    }
+
+    mapped_file->handle = INVALID_HANDLE_VALUE;
+    mapped_file->mapping = NULL;
+#else
+    if (mapped_file->data != NULL) {
+        munmap((void*)mapped_file->data, mapped_file->size);
+    }
+#endif
+
+    mapped_file->data = NULL;
+    mapped_file->size = 0;
+}
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,82 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "array.h"
+#include "buffer.h"
+
+
+// Where each line of a UTF-8 source starts, made in a single pass over it, so that finding the line of
+// a position is a binary search instead of counting the newlines before it every time
+typedef struct {
+    kharray(size_t) starts; // Offsets of the lines, the first one being 0
+} khLineTable;
+
+typedef struct {
+    size_t line;   // From 1
+    size_t column; // From 1, in code points
+} khLocation;
+
+
+static inline khLineTable khLineTable_new(khbuffer* source) {
+    khLineTable table = {.starts = kharray_new(size_t, NULL)};
+    kharray_append(&table.starts, 0);
+
+    const uint8_t* begin = *source;
+    const uint8_t* end = begin + khbuffer_size(source);
+    for (const uint8_t* cursor = begin; cursor < end; cursor++) {
+        cursor = (const uint8_t*)memchr(cursor, '\n', end - cursor);
+        if (cursor == NULL) {
+            break;
+        }
+
+        kharray_append(&table.starts, (size_t)(cursor + 1 - begin));
+    }
+
+    return table;
+}
+
+static inline void khLineTable_delete(khLineTable* table) {
+    kharray_delete(&table->starts);
+}
+
+// The offset is of a byte in the source the table was made of, or its end
+static inline khLocation kh_locate(khLineTable* table, khbuffer* source, size_t offset) {
+    // The last line which starts at or before it
+    size_t low = 0;
+    size_t high = kharray_size(&table->starts);
+    while (high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+        if (table->starts[middle] <= offset) {
+            low = middle;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    // Counting the bytes that start a code point, which aren't continuation bytes
+    size_t column = 1;
+    for (size_t i = table->starts[low]; i < offset && i < khbuffer_size(source); i++) {
+        column += ((*source)[i] & 0xC0) != 0x80;
+    }
+
+    return (khLocation){.line = low + 1, .column = column};
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,345 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Whichever is the widest the compiler targets, otherwise the scalar fallbacks are used. NEON is only
+// used on AArch64, as 32-bit ARM lacks its reductions across a vector, like `vmaxvq_u8`
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define _kh_NEON
+#include <arm_neon.h>
+#endif
+
+
+// Length of the ASCII-only prefix of the memory
+static inline size_t kh_asciiPrefix(const uint8_t* memory, size_t size) {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(memory + i));
+        if (_mm256_movemask_epi8(block) != 0) {
+            break;
+        }
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(memory + i));
+        if (_mm_movemask_epi8(block) != 0) {
+            break;
+        }
+    }
+#elif defined(_kh_NEON)
+    for (; i + 16 <= size; i += 16) {
+        if (vmaxvq_u8(vld1q_u8(memory + i)) >= 0x80) {
+            break;
+        }
+    }
+#else
+    // 8 bytes at a time in a register
+    for (; i + 8 <= size; i += 8) {
+        uint64_t block;
+        memcpy(&block, memory + i, 8);
+        if (block & 0x8080808080808080ull) {
+            break;
+        }
+    }
+#endif
+
+    while (i < size && memory[i] < 0x80) {
+        i++;
+    }
+
+    return i;
+}
+
+// Length of the ASCII-only prefix of the UTF-32 string (`char32_t`)
+static inline size_t kh_asciiPrefix32(const uint32_t* string, size_t size) {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 8 <= size; i += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(string + i));
+        if (!_mm256_testz_si256(block, _mm256_set1_epi32(~0x7F))) {
+            break;
+        }
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= size; i += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(string + i));
+        __m128i non_ascii = _mm_and_si128(block, _mm_set1_epi32(~0x7F));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(non_ascii, _mm_setzero_si128())) != 0xFFFF) {
+            break;
+        }
+    }
+#elif defined(_kh_NEON)
+    for (; i + 4 <= size; i += 4) {
+        if (vmaxvq_u32(vld1q_u32(string + i)) >= 0x80) {
+            break;
+        }
+    }
+#endif
+
+    while (i < size && string[i] < 0x80) {
+        i++;
+    }
+
+    return i;
+}
+
+// Widens ASCII bytes into UTF-32 (`char32_t`) code points
+static inline void kh_widenAscii(uint32_t* output, const uint8_t* memory, size_t size) {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 8 <= size; i += 8) {
+        __m128i block = _mm_loadl_epi64((const __m128i*)(memory + i));
+        _mm256_storeu_si256((__m256i*)(output + i), _mm256_cvtepu8_epi32(block));
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(memory + i));
+        __m128i low = _mm_unpacklo_epi8(block, _mm_setzero_si128());
+        __m128i high = _mm_unpackhi_epi8(block, _mm_setzero_si128());
+
+        _mm_storeu_si128((__m128i*)(output + i), _mm_unpacklo_epi16(low, _mm_setzero_si128()));
+        _mm_storeu_si128((__m128i*)(output + i + 4), _mm_unpackhi_epi16(low, _mm_setzero_si128()));
+        _mm_storeu_si128((__m128i*)(output + i + 8), _mm_unpacklo_epi16(high, _mm_setzero_si128()));
+        _mm_storeu_si128((__m128i*)(output + i + 12), _mm_unpackhi_epi16(high, _mm_setzero_si128()));
+    }
+#elif defined(_kh_NEON)
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t block = vld1q_u8(memory + i);
+        uint16x8_t low = vmovl_u8(vget_low_u8(block));
+        uint16x8_t high = vmovl_u8(vget_high_u8(block));
+
+        vst1q_u32(output + i, vmovl_u16(vget_low_u16(low)));
+        vst1q_u32(output + i + 4, vmovl_u16(vget_high_u16(low)));
+        vst1q_u32(output + i + 8, vmovl_u16(vget_low_u16(high)));
+        vst1q_u32(output + i + 12, vmovl_u16(vget_high_u16(high)));
+    }
+#endif
+
+    for (; i < size; i++) {
+        output[i] = memory[i];
+    }
+}
+
+// Narrows ASCII code points into bytes
+static inline void kh_narrowAscii(uint8_t* output, const uint32_t* string, size_t size) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Saturating packs are fine, as everything is below 0x80
+    for (; i + 16 <= size; i += 16) {
+        __m128i low = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(string + i)),
+                                      _mm_loadu_si128((const __m128i*)(string + i + 4)));
+        __m128i high = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(string + i + 8)),
+                                       _mm_loadu_si128((const __m128i*)(string + i + 12)));
+        _mm_storeu_si128((__m128i*)(output + i), _mm_packus_epi16(low, high));
+    }
+#elif defined(_kh_NEON)
+    for (; i + 8 <= size; i += 8) {
+        uint16x8_t block = vcombine_u16(vmovn_u32(vld1q_u32(string + i)),
+                                        vmovn_u32(vld1q_u32(string + i + 4)));
+        vst1_u8(output + i, vmovn_u16(block));
+    }
+#endif
+
+    for (; i < size; i++) {
+        output[i] = string[i];
+    }
+}
+
+
+// The scans below stop at the first byte or code point out of a set, found in a block from the mask of
+// which ones are in it
+
+static inline bool _kh_isWordAscii(uint8_t chr) {
+    return (chr >= 'a' && chr <= 'z') || (chr >= 'A' && chr <= 'Z') || (chr >= '0' && chr <= '9') ||
+           chr == '_';
+}
+
+// Length of the prefix of ASCII letters, digits and underscores, the ASCII characters of a word
+static inline size_t kh_wordPrefix(const uint8_t* memory, size_t size) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(memory + i));
+        // Letters folded into lowercase; compared signed, bytes beyond ASCII are out of every range
+        __m128i lower = _mm_or_si128(block, _mm_set1_epi8(0x20));
+        __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                        _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+        __m128i digits = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)),
+                                       _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+        __m128i underscores = _mm_cmpeq_epi8(block, _mm_set1_epi8('_'));
+
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letters, digits), underscores));
+        if (mask != 0xFFFF) {
+            return i + __builtin_ctz(~mask);
+        }
+    }
+#elif defined(_kh_NEON)
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t block = vld1q_u8(memory + i);
+        uint8x16_t lower = vorrq_u8(block, vdupq_n_u8(0x20));
+        uint8x16_t letters =
+            vandq_u8(vcgeq_u8(lower, vdupq_n_u8('a')), vcleq_u8(lower, vdupq_n_u8('z')));
+        uint8x16_t digits =
+            vandq_u8(vcgeq_u8(block, vdupq_n_u8('0')), vcleq_u8(block, vdupq_n_u8('9')));
+        uint8x16_t underscores = vceqq_u8(block, vdupq_n_u8('_'));
+
+        if (vminvq_u8(vorrq_u8(vorrq_u8(letters, digits), underscores)) == 0) {
+            break;
+        }
+    }
+#endif
+
+    while (i < size && _kh_isWordAscii(memory[i])) {
+        i++;
+    }
+
+    return i;
+}
+
+// Length of the prefix of ASCII which a string literal holds as it is, stopping at double quotes,
+// backslashes, newlines, NULs and bytes beyond ASCII
+static inline size_t kh_literalPrefix(const uint8_t* memory, size_t size) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(memory + i));
+        __m128i quotes = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('"')),
+                                      _mm_cmpeq_epi8(block, _mm_set1_epi8('\\')));
+        __m128i ends = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')),
+                                    _mm_cmpeq_epi8(block, _mm_setzero_si128()));
+
+        // Bytes beyond ASCII have their top bit set
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(quotes, ends), block));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#elif defined(_kh_NEON)
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t block = vld1q_u8(memory + i);
+        uint8x16_t quotes =
+            vorrq_u8(vceqq_u8(block, vdupq_n_u8('"')), vceqq_u8(block, vdupq_n_u8('\\')));
+        uint8x16_t ends = vorrq_u8(vceqq_u8(block, vdupq_n_u8('\n')), vceqzq_u8(block));
+
+        if (vmaxvq_u8(vorrq_u8(vorrq_u8(quotes, ends), vcgeq_u8(block, vdupq_n_u8(0x80)))) != 0) {
+            break;
+        }
+    }
+#endif
+
+    while (i < size && memory[i] < 0x80 && memory[i] != '"' && memory[i] != '\\' &&
+           memory[i] != '\n' && memory[i] != '\0') {
+        i++;
+    }
+
+    return i;
+}
+
+// Length of the prefix of printable ASCII besides double quotes and backslashes, which are quoted as
+// they are
+static inline size_t kh_printablePrefix(const uint8_t* memory, size_t size) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(memory + i));
+        // Compared signed, bytes beyond ASCII are below the space
+        __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(0x1F)),
+                                          _mm_cmplt_epi8(block, _mm_set1_epi8(0x7F)));
+        __m128i escaped = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('"')),
+                                       _mm_cmpeq_epi8(block, _mm_set1_epi8('\\')));
+
+        int mask = _mm_movemask_epi8(_mm_andnot_si128(escaped, printable));
+        if (mask != 0xFFFF) {
+            return i + __builtin_ctz(~mask);
+        }
+    }
+#elif defined(_kh_NEON)
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t block = vld1q_u8(memory + i);
+        uint8x16_t printable =
+            vandq_u8(vcgeq_u8(block, vdupq_n_u8(0x20)), vcltq_u8(block, vdupq_n_u8(0x7F)));
+        uint8x16_t escaped =
+            vorrq_u8(vceqq_u8(block, vdupq_n_u8('"')), vceqq_u8(block, vdupq_n_u8('\\')));
+
+        if (vminvq_u8(vbicq_u8(printable, escaped)) == 0) {
+            break;
+        }
+    }
+#endif
+
+    while (i < size && memory[i] >= 0x20 && memory[i] < 0x7F && memory[i] != '"' && memory[i] != '\\') {
+        i++;
+    }
+
+    return i;
+}
+
+// Same as `kh_printablePrefix`, of a UTF-32 string (`char32_t`)
+static inline size_t kh_printablePrefix32(const uint32_t* string, size_t size) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 4 <= size; i += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(string + i));
+        // Compared signed, anything from 2^31 is below the space
+        __m128i printable = _mm_and_si128(_mm_cmpgt_epi32(block, _mm_set1_epi32(0x1F)),
+                                          _mm_cmplt_epi32(block, _mm_set1_epi32(0x7F)));
+        __m128i escaped = _mm_or_si128(_mm_cmpeq_epi32(block, _mm_set1_epi32('"')),
+                                       _mm_cmpeq_epi32(block, _mm_set1_epi32('\\')));
+
+        // 4 bits of the mask per code point
+        int mask = _mm_movemask_epi8(_mm_andnot_si128(escaped, printable));
+        if (mask != 0xFFFF) {
+            return i + __builtin_ctz(~mask) / 4;
+        }
+    }
+#elif defined(_kh_NEON)
+    for (; i + 4 <= size; i += 4) {
+        uint32x4_t block = vld1q_u32(string + i);
+        uint32x4_t printable =
+            vandq_u32(vcgeq_u32(block, vdupq_n_u32(0x20)), vcltq_u32(block, vdupq_n_u32(0x7F)));
+        uint32x4_t escaped =
+            vorrq_u32(vceqq_u32(block, vdupq_n_u32('"')), vceqq_u32(block, vdupq_n_u32('\\')));
+
+        if (vminvq_u32(vbicq_u32(printable, escaped)) == 0) {
+            break;
+        }
+    }
+#endif
+
+    while (i < size && string[i] >= 0x20 && string[i] < 0x7F && string[i] != '"' && string[i] != '\\') {
+        i++;
+    }
+
+    return i;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
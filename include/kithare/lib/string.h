@@ -25,6 +25,7 @@ typedef __CHAR32_TYPE__ char32_t;
 #endif
 
 #include "array.h"
+#include "simd.h"
 
 
 typedef kharray(uint8_t) khbuffer;
@@ -87,97 +88,43 @@ static inline void khstring_concatenateCstring(khstring* string, const char32_t*
     kharray_memory(string, (char32_t*)cstring, size, NULL);
 }
 
+// Compared with `memcmp`, in blocks rather than a code point at a time
 static inline bool khstring_equal(khstring* a, khstring* b) {
-    if (khstring_size(a) != khstring_size(b)) {
-        return false;
-    }
-
-    for (size_t i = 0; i < khstring_size(a); i++) {
-        if ((*a)[i] != (*b)[i]) {
-            return false;
-        }
-    }
+    return khstring_size(a) == khstring_size(b) &&
+           memcmp(*a, *b, khstring_size(a) * sizeof(char32_t)) == 0;
+}
 
-    return true;
+static inline size_t _khstring_cstringSize(const char32_t* cstring) {
+    size_t size = 0;
+    for (; cstring[size] != U'\0'; size++) {}
+    return size;
 }
 
 static inline bool khstring_equalCstring(khstring* a, const char32_t* b) {
-    size_t length = 0;
-    for (; b[length] != '\0'; length++) {}
-
-    if (khstring_size(a) != length) {
-        return false;
-    }
-
-    for (size_t i = 0; i < khstring_size(a); i++) {
-        if ((*a)[i] != b[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    size_t size = _khstring_cstringSize(b);
+    return khstring_size(a) == size && memcmp(*a, b, size * sizeof(char32_t)) == 0;
 }
 
 static inline bool khstring_startsWith(khstring* string, khstring* prefix) {
-    if (khstring_size(string) < khstring_size(prefix)) {
-        return false;
-    }
-
-    for (size_t i = 0; i < khstring_size(prefix); i++) {
-        if ((*string)[i] != (*prefix)[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    return khstring_size(string) >= khstring_size(prefix) &&
+           memcmp(*string, *prefix, khstring_size(prefix) * sizeof(char32_t)) == 0;
 }
 
 static inline bool khstring_startsWithCstring(khstring* string, const char32_t* prefix) {
-    size_t length = 0;
-    for (; prefix[length] != '\0'; length++) {}
-
-    if (khstring_size(string) < length) {
-        return false;
-    }
-
-    for (size_t i = 0; i < length; i++) {
-        if ((*string)[i] != prefix[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    size_t size = _khstring_cstringSize(prefix);
+    return khstring_size(string) >= size && memcmp(*string, prefix, size * sizeof(char32_t)) == 0;
 }
 
 static inline bool khstring_endsWith(khstring* string, khstring* suffix) {
-    if (khstring_size(string) < khstring_size(suffix)) {
-        return false;
-    }
-
-    for (size_t i = 0; i < khstring_size(suffix); i++) {
-        if ((*string)[khstring_size(string) - khstring_size(suffix) + i] != (*suffix)[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    return khstring_size(string) >= khstring_size(suffix) &&
+           memcmp(*string + khstring_size(string) - khstring_size(suffix), *suffix,
+                  khstring_size(suffix) * sizeof(char32_t)) == 0;
 }
 
 static inline bool khstring_endsWithCstring(khstring* string, const char32_t* suffix) {
-    size_t length = 0;
-    for (; suffix[length] != '\0'; length++) {}
-
-    if (khstring_size(string) < length) {
-        return false;
-    }
-
-    for (size_t i = 0; i < length; i++) {
-        if ((*string)[khstring_size(string) - length + i] != suffix[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    size_t size = _khstring_cstringSize(suffix);
+    return khstring_size(string) >= size &&
+           memcmp(*string + khstring_size(string) - size, suffix, size * sizeof(char32_t)) == 0;
 }
 
 static inline khstring kh_uintToString(uint64_t uint_v, uint8_t base) {
@@ -255,161 +202,241 @@ static inline khstring kh_floatToString(double floating, uint8_t precision, uint
     return string;
 }
 
-static inline char32_t kh_utf8(uint8_t** cursor) {
+// Decodes a character and passes it, not reading at or beyond `end` unless it's NULL (which is fine for
+// null-terminated memory). Gives -1 on invalid sequences, which are overlong, surrogates, beyond
+// U+10FFFF or truncated, but still passes at least a byte of them
+static inline char32_t _kh_utf8(uint8_t** cursor, const uint8_t* end) {
+    uint8_t lead = *(*cursor)++;
+
     // Pass ASCII characters
-    if ((uint8_t)(**cursor) < 128) {
-        return *(*cursor)++;
+    if (lead < 128) {
+        return lead;
     }
 
     char32_t chr = 0;
+    char32_t minimum = 0;
     uint8_t continuation = 0;
 
-    if ((**cursor & 0b11100000) == 0b11000000) {
-        chr = **cursor & 0b00011111;
+    if ((lead & 0b11100000) == 0b11000000) {
+        chr = lead & 0b00011111;
+        minimum = 0x80;
         continuation = 1;
     }
-    else if ((**cursor & 0b11110000) == 0b11100000) {
-        chr = **cursor & 0b00001111;
+    else if ((lead & 0b11110000) == 0b11100000) {
+        chr = lead & 0b00001111;
+        minimum = 0x800;
         continuation = 2;
     }
-    else if ((**cursor & 0b11111000) == 0b11110000) {
-        chr = **cursor & 0b00000111;
+    else if ((lead & 0b11111000) == 0b11110000) {
+        chr = lead & 0b00000111;
+        minimum = 0x10000;
         continuation = 3;
     }
-    else if ((**cursor & 0b11111100) == 0b11111000) {
-        chr = **cursor & 0b00000011;
-        continuation = 4;
-    }
-    else if ((**cursor & 0b11111110) == 0b11111100) {
-        chr = **cursor & 0b00000001;
-        continuation = 5;
+    // Stray continuation bytes, or the 5 and 6 byte sequences which are no longer part of UTF-8
+    else {
+        return -1;
     }
 
-    for ((*cursor)++; continuation > 0; continuation--, (*cursor)++) {
-        if ((**cursor & 0b11000000) != 0b10000000) {
+    for (; continuation > 0; continuation--, (*cursor)++) {
+        if (*cursor == end || (**cursor & 0b11000000) != 0b10000000) {
             return -1;
         }
 
         chr = (chr << 6) | (**cursor & 0b00111111);
     }
 
+    if (chr < minimum || chr > 0x10FFFF || (chr >= 0xD800 && chr <= 0xDFFF)) {
+        return -1;
+    }
+
     return chr;
 }
 
+// Memory being null-terminated, see `_kh_utf8`
+static inline char32_t kh_utf8(uint8_t** cursor) {
+    return _kh_utf8(cursor, NULL);
+}
+
+// Invalid code points are encoded as U+FFFD, the replacement character
 static inline khbuffer kh_encodeUtf8(khstring* string) {
     khbuffer buffer = kharray_new(uint8_t, NULL); // Can't use `khbuffer_new`
-    kharray_reserve(&buffer, khstring_size(string));
-
-    // Can't use `khbuffer_append`
-    for (char32_t* chr = *string; chr < *string + khstring_size(string); chr++) {
-        if (*chr > 0xFFFF) {
-            kharray_append(&buffer, 0b11110000 | (uint8_t)(0b00000111 & (*chr >> 18)));
-            kharray_append(&buffer, 0b10000000 | (uint8_t)(0b00111111 & (*chr >> 12)));
-            kharray_append(&buffer, 0b10000000 | (uint8_t)(0b00111111 & (*chr >> 6)));
-            kharray_append(&buffer, 0b10000000 | (uint8_t)(0b00111111 & *chr));
-        }
-        else if (*chr > 0x7FF) {
-            kharray_append(&buffer, 0b11100000 | (uint8_t)(0b00001111 & (*chr >> 12)));
-            kharray_append(&buffer, 0b10000000 | (uint8_t)(0b00111111 & (*chr >> 6)));
-            kharray_append(&buffer, 0b10000000 | (uint8_t)(0b00111111 & *chr));
-        }
-        else if (*chr > 0x7F) {
-            kharray_append(&buffer, 0b11000000 | (uint8_t)(0b00011111 & (*chr >> 6)));
-            kharray_append(&buffer, 0b10000000 | (uint8_t)(0b00111111 & *chr));
-        }
-        else {
-            kharray_append(&buffer, *chr);
+    char32_t* chr = *string;
+    char32_t* end = *string + khstring_size(string);
+
+    // Knowing the exact size first, so it's written straight into the buffer
+    size_t size = 0;
+    for (char32_t* counter = chr; counter < end; counter++) {
+        // Beyond U+10FFFF is encoded as U+FFFD, in 3 bytes
+        size += 1 + (*counter > 0x7F) + (*counter > 0x7FF) + (*counter > 0xFFFF) -
+                (*counter > 0x10FFFF);
+    }
+
+    kharray_reserve(&buffer, size);
+    uint8_t* output = buffer;
+
+    while (chr < end) {
+        // ASCII runs are narrowed in blocks
+        size_t ascii = kh_asciiPrefix32(chr, end - chr);
+        kh_narrowAscii(output, chr, ascii);
+        chr += ascii;
+        output += ascii;
+
+        for (; chr < end && *chr > 0x7F; chr++) {
+            char32_t code_point = *chr;
+            if (code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+                code_point = 0xFFFD;
+            }
+
+            if (code_point > 0xFFFF) {
+                *output++ = 0b11110000 | (uint8_t)(0b00000111 & (code_point >> 18));
+                *output++ = 0b10000000 | (uint8_t)(0b00111111 & (code_point >> 12));
+                *output++ = 0b10000000 | (uint8_t)(0b00111111 & (code_point >> 6));
+                *output++ = 0b10000000 | (uint8_t)(0b00111111 & code_point);
+            }
+            else if (code_point > 0x7FF) {
+                *output++ = 0b11100000 | (uint8_t)(0b00001111 & (code_point >> 12));
+                *output++ = 0b10000000 | (uint8_t)(0b00111111 & (code_point >> 6));
+                *output++ = 0b10000000 | (uint8_t)(0b00111111 & code_point);
+            }
+            else {
+                *output++ = 0b11000000 | (uint8_t)(0b00011111 & (code_point >> 6));
+                *output++ = 0b10000000 | (uint8_t)(0b00111111 & code_point);
+            }
         }
     }
 
+    kharray_setSize(&buffer, size);
+
     return buffer;
 }
 
-static inline khstring kh_decodeUtf8(khbuffer* buffer) {
-    khstring string = khstring_new(U"");
-    kharray_reserve(&string, kharray_size(buffer)); // Can't use khbuffer_size
-
-    uint8_t* cursor = *buffer;
-    while (cursor != *buffer + kharray_size(buffer)) {
-        khstring_append(&string, kh_utf8(&cursor));
+// Decodes into the output, which has room for a character for each byte, giving back how many it wrote.
+// Invalid sequences are decoded as U+FFFD, the replacement character
+static inline size_t _kh_decodeUtf8Into(char32_t* output, const uint8_t* memory, size_t size) {
+    char32_t* begin = output;
+    uint8_t* cursor = (uint8_t*)memory;
+    const uint8_t* end = memory + size;
+
+    while (cursor < end) {
+        // ASCII runs are widened in blocks
+        size_t ascii = kh_asciiPrefix(cursor, end - cursor);
+        kh_widenAscii(output, cursor, ascii);
+        cursor += ascii;
+        output += ascii;
+
+        while (cursor < end && *cursor > 0x7F) {
+            char32_t chr = _kh_utf8(&cursor, end);
+            *output++ = chr == (char32_t)-1 ? 0xFFFD : chr;
+        }
     }
 
+    return output - begin;
+}
+
+// Decodes memory which isn't necessarily null-terminated, e.g. a mapped file. Invalid sequences are
+// decoded as U+FFFD, the replacement character
+static inline khstring kh_decodeUtf8Memory(const uint8_t* memory, size_t size) {
+    khstring string = khstring_new(U"");
+    kharray_reserve(&string, size); // At most a character for each byte
+    kharray_setSize(&string, _kh_decodeUtf8Into(string, memory, size));
     return string;
 }
 
-static inline khstring kh_escapeChar(char32_t chr) {
+static inline khstring kh_decodeUtf8(khbuffer* buffer) {
+    return kh_decodeUtf8Memory(*buffer, kharray_size(buffer)); // Can't use khbuffer_size
+}
+
+// Appends the character escaped, written straight into the string
+static inline void khstring_appendEscaped(khstring* string, char32_t chr) {
+    const char32_t* escape = NULL;
+
     switch (chr) {
         // Regular single character escapes
         case U'\0':
-            return khstring_new(U"\\0");
+            escape = U"\\0";
+            break;
         case U'\n':
-            return khstring_new(U"\\n");
+            escape = U"\\n";
+            break;
         case U'\r':
-            return khstring_new(U"\\r");
+            escape = U"\\r";
+            break;
         case U'\t':
-            return khstring_new(U"\\t");
+            escape = U"\\t";
+            break;
         case U'\v':
-            return khstring_new(U"\\v");
+            escape = U"\\v";
+            break;
         case U'\b':
-            return khstring_new(U"\\b");
+            escape = U"\\b";
+            break;
         case U'\a':
-            return khstring_new(U"\\a");
+            escape = U"\\a";
+            break;
         case U'\f':
-            return khstring_new(U"\\f");
+            escape = U"\\f";
+            break;
         case U'\\':
-            return khstring_new(U"\\\\");
+            escape = U"\\\\";
+            break;
         case U'\'':
-            return khstring_new(U"\\\'");
+            escape = U"\\\'";
+            break;
         case U'\"':
-            return khstring_new(U"\\\"");
+            escape = U"\\\"";
+            break;
 
         default: {
-            khstring string = khstring_new(U"");
-
-            if (iswprint(chr)) {
-                khstring_append(&string, chr);
-                return string;
+            // Printable ASCII doesn't need to ask the locale
+            if ((chr >= 0x20 && chr < 0x7F) || iswprint(chr)) {
+                khstring_append(string, chr);
+                return;
             }
 
-            uint8_t chars;
-            if (chr < 0x100) {
-                khstring_concatenateCstring(&string, U"\\x");
-                chars = 2;
-            }
-            else if (chr < 0x10000) {
-                khstring_concatenateCstring(&string, U"\\u");
-                chars = 4;
-            }
-            else {
-                khstring_concatenateCstring(&string, U"\\U");
-                chars = 8;
-            }
+            // The hex digits aren't padded, written from the back after the escape
+            char32_t digits[2 + 8];
+            char32_t* digit = digits + 10;
 
-            // Fills the placeholder zeroes \x0AAA
-            khstring hex = kh_uintToString(chr, 16);
-            for (uint8_t i = 0; i < (uint8_t)khstring_size(&hex) - chars; i++) {
-                khstring_append(&string, U'0');
-            }
+            char32_t value = chr;
+            do {
+                uint8_t value_digit = value % 16;
+                *--digit = value_digit < 10 ? U'0' + value_digit : U'A' + value_digit - 10;
+                value /= 16;
+            } while (value > 0);
 
-            khstring_concatenate(&string, &hex);
-            khstring_delete(&hex);
+            *--digit = chr < 0x100 ? U'x' : chr < 0x10000 ? U'u' : U'U';
+            *--digit = U'\\';
 
-            return string;
+            kharray_memory(string, digit, digits + 10 - digit, NULL);
+            return;
         }
     }
+
+    khstring_concatenateCstring(string, escape);
+}
+
+static inline khstring kh_escapeChar(char32_t chr) {
+    khstring string = khstring_new(U"");
+    khstring_appendEscaped(&string, chr);
+    return string;
 }
 
 static inline khstring khstring_quote(khstring* string) {
     khstring quoted_string = khstring_new(U"\"");
+    // At least a character for each, and the quotes
+    khstring_reserve(&quoted_string, khstring_size(string) + 2);
 
-    for (char32_t* chr = *string; chr < *string + khstring_size(string); chr++) {
-        if (*chr == U'\'') {
-            khstring_append(&quoted_string, U'\'');
-        }
-        else {
-            khstring escaped = kh_escapeChar(*chr);
-            khstring_concatenate(&quoted_string, &escaped);
-            khstring_delete(&escaped);
+    char32_t* chr = *string;
+    char32_t* end = *string + khstring_size(string);
+
+    while (chr < end) {
+        // Runs needing no escapes are copied in blocks, single quotes too as they're in double ones
+        size_t plain = kh_printablePrefix32(chr, end - chr);
+        kharray_memory(&quoted_string, chr, plain, NULL);
+        chr += plain;
+
+        if (chr < end) {
+            khstring_appendEscaped(&quoted_string, *chr++);
         }
     }
 
@@ -417,7 +444,6 @@ static inline khstring khstring_quote(khstring* string) {
     return quoted_string;
 }
 
-
 #ifdef __cplusplus
 }
 #endif
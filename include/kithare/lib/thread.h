@@ -0,0 +1,142 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "array.h"
+#include "buffer.h"
+
+
+// How many threads can run at once
+static inline size_t kh_threadCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count : 1;
+#endif
+}
+
+
+typedef void (*khJob)(void* context, size_t index);
+
+typedef struct {
+    khJob job;
+    void* context;
+    size_t count;
+    atomic_size_t next;
+} _khParallel;
+
+static inline void* _kh_parallelWorker(void* parallel_v) {
+    _khParallel* parallel = (_khParallel*)parallel_v;
+
+    // Whoever is done first takes the next index, so slow jobs don't hold back the others
+    size_t index;
+    while ((index = atomic_fetch_add(&parallel->next, 1)) < parallel->count) {
+        parallel->job(parallel->context, index);
+    }
+
+    return NULL;
+}
+
+// Runs the job for every index below the count, on up to that many threads including the calling one,
+// and returns once they're all done. Jobs are started in the order of their indices
+static inline void kh_parallelFor(size_t count, size_t threads, khJob job, void* context) {
+    _khParallel parallel = {.job = job, .context = context, .count = count};
+    atomic_init(&parallel.next, 0);
+
+    if (threads > count) {
+        threads = count;
+    }
+
+    pthread_t* workers = NULL;
+    size_t started = 0;
+    if (threads > 1) {
+        workers = (pthread_t*)malloc((threads - 1) * sizeof(pthread_t));
+
+        // Whatever can't be started is left to the ones which were
+        while (started < threads - 1 &&
+               pthread_create(&workers[started], NULL, _kh_parallelWorker, &parallel) == 0) {
+            started++;
+        }
+    }
+
+    _kh_parallelWorker(&parallel);
+
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+}
+
+
+// Outputs of jobs which are written into a stream in the order of their indices, each as soon as those
+// before it are, so only the outputs finished out of order are kept around
+typedef struct {
+    FILE* stream;
+    pthread_mutex_t mutex;
+    size_t next;
+    size_t count;
+    khbuffer* outputs; // NULL until they're done
+} khOrderedOutput;
+
+static inline khOrderedOutput khOrderedOutput_new(FILE* stream, size_t count) {
+    khOrderedOutput output = {.stream = stream,
+                              .next = 0,
+                              .count = count,
+                              .outputs = (khbuffer*)calloc(count > 0 ? count : 1, sizeof(khbuffer))};
+    pthread_mutex_init(&output.mutex, NULL);
+    return output;
+}
+
+static inline void khOrderedOutput_delete(khOrderedOutput* output) {
+    for (size_t i = output->next; i < output->count; i++) {
+        if (output->outputs[i] != NULL) {
+            khbuffer_delete(&output->outputs[i]);
+        }
+    }
+
+    free(output->outputs);
+    pthread_mutex_destroy(&output->mutex);
+}
+
+// Takes the buffer, which is written along with any others that were waiting for it
+static inline void khOrderedOutput_submit(khOrderedOutput* output, size_t index, khbuffer buffer) {
+    pthread_mutex_lock(&output->mutex);
+
+    output->outputs[index] = buffer;
+    while (output->next < output->count && output->outputs[output->next] != NULL) {
+        khbuffer* next = &output->outputs[output->next++];
+        fwrite(*next, 1, khbuffer_size(next), output->stream);
+        khbuffer_delete(next);
+    }
+
+    pthread_mutex_unlock(&output->mutex);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,332 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <wctype.h>
+
+#include "array.h"
+#include "buffer.h"
+#include "string.h"
+
+
+// Bytes buffered before they're flushed into the stream
+#define _khWriter_CAPACITY 65536
+
+// An output sink of UTF-8, which is buffered and written into the stream in large blocks. Without a
+// stream, everything stays in the buffer, see `khWriter_take`
+typedef struct {
+    FILE* stream;
+    khbuffer buffer;
+} khWriter;
+
+
+static inline khWriter khWriter_new(FILE* stream) {
+    return (khWriter){.stream = stream, .buffer = khbuffer_new("")};
+}
+
+static inline void khWriter_flush(khWriter* writer) {
+    if (writer->stream != NULL && khbuffer_size(&writer->buffer) > 0) {
+        fwrite(writer->buffer, 1, khbuffer_size(&writer->buffer), writer->stream);
+        kharray_setSize(&writer->buffer, 0);
+    }
+}
+
+static inline void khWriter_delete(khWriter* writer) {
+    khWriter_flush(writer);
+    khbuffer_delete(&writer->buffer);
+}
+
+// Everything written so far, decoded; the writer is left empty
+static inline khstring khWriter_take(khWriter* writer) {
+    khstring string = kh_decodeUtf8(&writer->buffer);
+    khbuffer_delete(&writer->buffer);
+    writer->buffer = khbuffer_new("");
+    return string;
+}
+
+static inline void khWriter_utf8(khWriter* writer, const uint8_t* memory, size_t size) {
+    if (writer->stream != NULL && khbuffer_size(&writer->buffer) + size > _khWriter_CAPACITY) {
+        khWriter_flush(writer);
+
+        // Too big to be buffered at all
+        if (size > _khWriter_CAPACITY) {
+            fwrite(memory, 1, size, writer->stream);
+            return;
+        }
+    }
+
+    if (khbuffer_reserved(&writer->buffer) < _khWriter_CAPACITY && writer->stream != NULL) {
+        khbuffer_reserve(&writer->buffer, _khWriter_CAPACITY);
+    }
+
+    kharray_memory(&writer->buffer, (uint8_t*)memory, size, NULL);
+}
+
+static inline void khWriter_byte(khWriter* writer, uint8_t byte) {
+    khWriter_utf8(writer, &byte, 1);
+}
+
+// A null-terminated UTF-8 string
+static inline void khWriter_cstring(khWriter* writer, const char* cstring) {
+    khWriter_utf8(writer, (const uint8_t*)cstring, strlen(cstring));
+}
+
+// Invalid code points are written as U+FFFD, like `kh_encodeUtf8` does
+static inline void khWriter_char(khWriter* writer, char32_t chr) {
+    if (chr > 0x10FFFF || (chr >= 0xD800 && chr <= 0xDFFF)) {
+        chr = 0xFFFD;
+    }
+
+    uint8_t bytes[4];
+    if (chr < 0x80) {
+        bytes[0] = chr;
+        khWriter_utf8(writer, bytes, 1);
+    }
+    else if (chr < 0x800) {
+        bytes[0] = 0b11000000 | (uint8_t)(0b00011111 & (chr >> 6));
+        bytes[1] = 0b10000000 | (uint8_t)(0b00111111 & chr);
+        khWriter_utf8(writer, bytes, 2);
+    }
+    else if (chr < 0x10000) {
+        bytes[0] = 0b11100000 | (uint8_t)(0b00001111 & (chr >> 12));
+        bytes[1] = 0b10000000 | (uint8_t)(0b00111111 & (chr >> 6));
+        bytes[2] = 0b10000000 | (uint8_t)(0b00111111 & chr);
+        khWriter_utf8(writer, bytes, 3);
+    }
+    else {
+        bytes[0] = 0b11110000 | (uint8_t)(0b00000111 & (chr >> 18));
+        bytes[1] = 0b10000000 | (uint8_t)(0b00111111 & (chr >> 12));
+        bytes[2] = 0b10000000 | (uint8_t)(0b00111111 & (chr >> 6));
+        bytes[3] = 0b10000000 | (uint8_t)(0b00111111 & chr);
+        khWriter_utf8(writer, bytes, 4);
+    }
+}
+
+static inline void khWriter_string(khWriter* writer, khstring* string) {
+    for (char32_t* chr = *string; chr < *string + khstring_size(string); chr++) {
+        khWriter_char(writer, *chr);
+    }
+}
+
+static inline void khWriter_uint(khWriter* writer, uint64_t uint_v, uint8_t base) {
+    // Enough for 64 bits in base 2, written from the back
+    uint8_t digits[64];
+    uint8_t* digit = digits + sizeof(digits);
+
+    do {
+        uint8_t value = uint_v % base;
+        *--digit = value < 10 ? '0' + value : 'A' + value - 10;
+        uint_v /= base;
+    } while (uint_v > 0);
+
+    khWriter_utf8(writer, digit, digits + sizeof(digits) - digit);
+}
+
+static inline void khWriter_int(khWriter* writer, int64_t int_v, uint8_t base) {
+    if (int_v < 0) {
+        khWriter_byte(writer, '-');
+        // Negated unsigned, as the least int doesn't have a positive one
+        khWriter_uint(writer, 0 - (uint64_t)int_v, base);
+        return;
+    }
+
+    khWriter_uint(writer, int_v, base);
+}
+
+// Same digits as `kh_floatToString`
+static inline void khWriter_float(khWriter* writer, double floating, uint8_t precision, uint8_t base) {
+    if (floating < 0) {
+        khWriter_byte(writer, '-');
+        floating *= -1;
+    }
+
+    if (isinf(floating)) {
+        khWriter_cstring(writer, "inf");
+        return;
+    }
+    else if (isnan(floating)) {
+        khWriter_cstring(writer, "nan");
+        return;
+    }
+
+    // Up to DBL_MAX in base 2, then the fraction digits
+    uint8_t digits[1024 + 1 + UINT8_MAX];
+    uint8_t* digit = digits + 1024;
+    uint8_t* end = digit;
+
+    double value = floating;
+    while (value >= 1) {
+        uint8_t value_digit = (uint8_t)fmod(value, base);
+        *--digit = value_digit < 10 ? '0' + value_digit : 'A' + value_digit - 10;
+        value /= base;
+    }
+
+    if (digit == end) {
+        *--digit = '0';
+    }
+
+    if (precision > 0) {
+        *end++ = '.';
+
+        value = floating;
+        for (uint8_t i = 0; i < precision; i++) {
+            value *= base;
+            uint8_t value_digit = (uint8_t)fmod(value, base);
+            *end++ = value_digit < 10 ? '0' + value_digit : 'A' + value_digit - 10;
+        }
+    }
+
+    khWriter_utf8(writer, digit, end - digit);
+}
+
+// Same escapes as `kh_escapeChar`
+static inline void khWriter_escapeChar(khWriter* writer, char32_t chr) {
+    switch (chr) {
+        // Regular single character escapes
+        case U'\0':
+            khWriter_cstring(writer, "\\0");
+            break;
+        case U'\n':
+            khWriter_cstring(writer, "\\n");
+            break;
+        case U'\r':
+            khWriter_cstring(writer, "\\r");
+            break;
+        case U'\t':
+            khWriter_cstring(writer, "\\t");
+            break;
+        case U'\v':
+            khWriter_cstring(writer, "\\v");
+            break;
+        case U'\b':
+            khWriter_cstring(writer, "\\b");
+            break;
+        case U'\a':
+            khWriter_cstring(writer, "\\a");
+            break;
+        case U'\f':
+            khWriter_cstring(writer, "\\f");
+            break;
+        case U'\\':
+            khWriter_cstring(writer, "\\\\");
+            break;
+        case U'\'':
+            khWriter_cstring(writer, "\\\'");
+            break;
+        case U'\"':
+            khWriter_cstring(writer, "\\\"");
+            break;
+
+        default:
+            // Printable ASCII doesn't need to ask the locale
+            if ((chr >= 0x20 && chr < 0x7F) || iswprint(chr)) {
+                khWriter_char(writer, chr);
+            }
+            // Like `kh_escapeChar`, the hex digits aren't padded
+            else if (chr < 0x100) {
+                khWriter_cstring(writer, "\\x");
+                khWriter_uint(writer, chr, 16);
+            }
+            else if (chr < 0x10000) {
+                khWriter_cstring(writer, "\\u");
+                khWriter_uint(writer, chr, 16);
+            }
+            else {
+                khWriter_cstring(writer, "\\U");
+                khWriter_uint(writer, chr, 16);
+            }
+            break;
+    }
+}
+
+// ASCII code points, narrowed into the buffer in blocks
+static inline void _khWriter_ascii32(khWriter* writer, const char32_t* string, size_t size) {
+    uint8_t block[256];
+
+    while (size > 0) {
+        size_t count = size < sizeof(block) ? size : sizeof(block);
+        kh_narrowAscii(block, string, count);
+        khWriter_utf8(writer, block, count);
+        string += count;
+        size -= count;
+    }
+}
+
+// Same as `khstring_quote`
+static inline void khWriter_quote(khWriter* writer, khstring* string) {
+    khWriter_byte(writer, '\"');
+
+    char32_t* chr = *string;
+    char32_t* end = *string + khstring_size(string);
+
+    while (chr < end) {
+        // Runs of plain ASCII go straight through in blocks
+        size_t plain = kh_printablePrefix32(chr, end - chr);
+        _khWriter_ascii32(writer, chr, plain);
+        chr += plain;
+
+        if (chr < end) {
+            khWriter_escapeChar(writer, *chr++);
+        }
+    }
+
+    khWriter_byte(writer, '\"');
+}
+
+// Same as `khbuffer_quote`
+static inline void khWriter_quoteBuffer(khWriter* writer, khbuffer* buffer) {
+    khWriter_byte(writer, '\"');
+
+    uint8_t* byte = *buffer;
+    uint8_t* end = *buffer + khbuffer_size(buffer);
+
+    while (byte < end) {
+        size_t plain = kh_printablePrefix(byte, end - byte);
+        khWriter_utf8(writer, byte, plain);
+        byte += plain;
+
+        if (byte < end) {
+            khWriter_escapeChar(writer, *byte++);
+        }
+    }
+
+    khWriter_byte(writer, '\"');
+}
+
+// Quotes a null-terminated UTF-8 string, like `khWriter_quote` does
+static inline void khWriter_quoteCstring(khWriter* writer, const char* cstring) {
+    khWriter_byte(writer, '\"');
+
+    uint8_t* cursor = (uint8_t*)cstring;
+    uint8_t* end = cursor + strlen(cstring);
+
+    while (cursor < end) {
+        // Plain ASCII is the same in UTF-8, so it's written as it is
+        size_t plain = kh_printablePrefix(cursor, end - cursor);
+        khWriter_utf8(writer, cursor, plain);
+        cursor += plain;
+
+        if (cursor < end) {
+            char32_t chr = _kh_utf8(&cursor, end);
+            khWriter_escapeChar(writer, chr == (char32_t)-1 ? 0xFFFD : chr);
+        }
+    }
+
+    khWriter_byte(writer, '\"');
+}
+
+#ifdef __cplusplus
+}
+#endif
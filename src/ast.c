@@ -6,56 +6,63 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <kithare/core/ast.h>
 #include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
 
 
-khstring khAstStatementType_string(khAstStatementType type) {
+const char* khAstStatementType_name(khAstStatementType type) {
     switch (type) {
         case khAstStatementType_INVALID:
-            return khstring_new(U"invalid");
+            return "invalid";
 
         case khAstStatementType_VARIABLE:
-            return khstring_new(U"variable");
+            return "variable";
         case khAstStatementType_EXPRESSION:
-            return khstring_new(U"expression");
+            return "expression";
 
         case khAstStatementType_IMPORT:
-            return khstring_new(U"import");
+            return "import";
         case khAstStatementType_INCLUDE:
-            return khstring_new(U"include");
+            return "include";
         case khAstStatementType_FUNCTION:
-            return khstring_new(U"function");
+            return "function";
         case khAstStatementType_CLASS:
-            return khstring_new(U"class");
+            return "class";
         case khAstStatementType_STRUCT:
-            return khstring_new(U"struct");
+            return "struct";
         case khAstStatementType_ENUM:
-            return khstring_new(U"enum");
+            return "enum";
         case khAstStatementType_ALIAS:
-            return khstring_new(U"alias");
+            return "alias";
 
         case khAstStatementType_IF_BRANCH:
-            return khstring_new(U"if_branch");
+            return "if_branch";
         case khAstStatementType_WHILE_LOOP:
-            return khstring_new(U"while_loop");
+            return "while_loop";
         case khAstStatementType_DO_WHILE_LOOP:
-            return khstring_new(U"do_while_loop");
+            return "do_while_loop";
         case khAstStatementType_FOR_LOOP:
-            return khstring_new(U"for_loop");
+            return "for_loop";
         case khAstStatementType_BREAK:
-            return khstring_new(U"break");
+            return "break";
         case khAstStatementType_CONTINUE:
-            return khstring_new(U"continue");
+            return "continue";
         case khAstStatementType_RETURN:
-            return khstring_new(U"return");
+            return "return";
 
         default:
-            return khstring_new(U"unknown");
+            return "unknown";
     }
 }
 
+khstring khAstStatementType_string(khAstStatementType type) {
+    const char* name = khAstStatementType_name(type);
+    return kh_decodeUtf8Memory((const uint8_t*)name, strlen(name));
+}
+
 
 khAstVariable khAstVariable_copy(khAstVariable* variable) {
     khAstExpression* opt_type = NULL;
@@ -90,117 +97,115 @@ void khAstVariable_delete(khAstVariable* variable) {
     }
 }
 
-khstring khAstVariable_string(khAstVariable* variable, char32_t* origin) {
-    khstring string = khstring_new(U"{\"is_static\": ");
-    khstring_concatenateCstring(&string, variable->is_static ? U"true" : U"false");
+void khAstVariable_write(khAstVariable* variable, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"is_static\": ");
+    khWriter_cstring(writer, variable->is_static ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"is_wild\": ");
-    khstring_concatenateCstring(&string, variable->is_wild ? U"true" : U"false");
+    khWriter_cstring(writer, ", \"is_wild\": ");
+    khWriter_cstring(writer, variable->is_wild ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"is_ref\": ");
-    khstring_concatenateCstring(&string, variable->is_ref ? U"true" : U"false");
+    khWriter_cstring(writer, ", \"is_ref\": ");
+    khWriter_cstring(writer, variable->is_ref ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"names\": [");
+    khWriter_cstring(writer, ", \"names\": [");
     for (size_t i = 0; i < kharray_size(&variable->names); i++) {
-        khstring quoted_name = khstring_quote(&variable->names[i]);
-        khstring_concatenate(&string, &quoted_name);
-        khstring_delete(&quoted_name);
+        khWriter_quote(writer, &variable->names[i]);
 
         if (i != kharray_size(&variable->names) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"opt_type\": ");
+    khWriter_cstring(writer, "], \"opt_type\": ");
     if (variable->opt_type != NULL) {
-        khstring opt_type_str = khAstExpression_string(variable->opt_type, origin);
-        khstring_concatenate(&string, &opt_type_str);
-        khstring_delete(&opt_type_str);
+        khAstExpression_write(variable->opt_type, origin, writer);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"opt_initializer\": ");
+    khWriter_cstring(writer, ", \"opt_initializer\": ");
     if (variable->opt_initializer != NULL) {
-        khstring opt_initializer_str = khAstExpression_string(variable->opt_initializer, origin);
-        khstring_concatenate(&string, &opt_initializer_str);
-        khstring_delete(&opt_initializer_str);
+        khAstExpression_write(variable->opt_initializer, origin, writer);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U"}");
-    return string;
+    khWriter_cstring(writer, "}");
 }
 
 
-khstring khAstExpressionType_string(khAstExpressionType type) {
+const char* khAstExpressionType_name(khAstExpressionType type) {
     switch (type) {
         case khAstExpressionType_INVALID:
-            return khstring_new(U"invalid");
+            return "invalid";
 
         case khAstExpressionType_IDENTIFIER:
-            return khstring_new(U"identifier");
+            return "identifier";
         case khAstExpressionType_CHAR:
-            return khstring_new(U"char");
+            return "char";
         case khAstExpressionType_STRING:
-            return khstring_new(U"string");
+            return "string";
         case khAstExpressionType_BUFFER:
-            return khstring_new(U"buffer");
+            return "buffer";
         case khAstExpressionType_BYTE:
-            return khstring_new(U"byte");
+            return "byte";
         case khAstExpressionType_INTEGER:
-            return khstring_new(U"integer");
+            return "integer";
         case khAstExpressionType_UINTEGER:
-            return khstring_new(U"uinteger");
+            return "uinteger";
         case khAstExpressionType_FLOAT:
-            return khstring_new(U"float");
+            return "float";
         case khAstExpressionType_DOUBLE:
-            return khstring_new(U"double");
+            return "double";
         case khAstExpressionType_IFLOAT:
-            return khstring_new(U"ifloat");
+            return "ifloat";
         case khAstExpressionType_IDOUBLE:
-            return khstring_new(U"idouble");
+            return "idouble";
 
         case khAstExpressionType_TUPLE:
-            return khstring_new(U"tuple");
+            return "tuple";
         case khAstExpressionType_ARRAY:
-            return khstring_new(U"array");
+            return "array";
         case khAstExpressionType_DICT:
-            return khstring_new(U"dict");
+            return "dict";
         case khAstExpressionType_ELLIPSIS:
-            return khstring_new(U"ellipsis");
+            return "ellipsis";
 
         case khAstExpressionType_SIGNATURE:
-            return khstring_new(U"signature");
+            return "signature";
         case khAstExpressionType_LAMBDA:
-            return khstring_new(U"lambda");
+            return "lambda";
 
         case khAstExpressionType_UNARY:
-            return khstring_new(U"unary");
+            return "unary";
         case khAstExpressionType_BINARY:
-            return khstring_new(U"binary");
+            return "binary";
         case khAstExpressionType_TERNARY:
-            return khstring_new(U"ternary");
+            return "ternary";
         case khAstExpressionType_COMPARISON:
-            return khstring_new(U"comparison");
+            return "comparison";
         case khAstExpressionType_CALL:
-            return khstring_new(U"call");
+            return "call";
         case khAstExpressionType_INDEX:
-            return khstring_new(U"index");
+            return "index";
 
         case khAstExpressionType_SCOPE:
-            return khstring_new(U"scope");
+            return "scope";
         case khAstExpressionType_TEMPLATIZE:
-            return khstring_new(U"templatize");
+            return "templatize";
 
         default:
-            return khstring_new(U"unknown");
+            return "unknown";
     }
 }
 
+khstring khAstExpressionType_string(khAstExpressionType type) {
+    const char* name = khAstExpressionType_name(type);
+    return kh_decodeUtf8Memory((const uint8_t*)name, strlen(name));
+}
+
 
 khAstTuple khAstTuple_copy(khAstTuple* tuple) {
     return (khAstTuple){.values = kharray_copy(&tuple->values, khAstExpression_copy)};
@@ -210,21 +215,18 @@ void khAstTuple_delete(khAstTuple* tuple) {
     kharray_delete(&tuple->values);
 }
 
-khstring khAstTuple_string(khAstTuple* tuple, char32_t* origin) {
-    khstring string = khstring_new(U"{\"values\": [");
+void khAstTuple_write(khAstTuple* tuple, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"values\": [");
 
     for (size_t i = 0; i < kharray_size(&tuple->values); i++) {
-        khstring expression_str = khAstExpression_string(&tuple->values[i], origin);
-        khstring_concatenate(&string, &expression_str);
-        khstring_delete(&expression_str);
+        khAstExpression_write(&tuple->values[i], origin, writer);
 
         if (i != kharray_size(&tuple->values) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -236,21 +238,18 @@ void khAstArray_delete(khAstArray* array) {
     kharray_delete(&array->values);
 }
 
-khstring khAstArray_string(khAstArray* array, char32_t* origin) {
-    khstring string = khstring_new(U"{\"values\": [");
+void khAstArray_write(khAstArray* array, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"values\": [");
 
     for (size_t i = 0; i < kharray_size(&array->values); i++) {
-        khstring expression_str = khAstExpression_string(&array->values[i], origin);
-        khstring_concatenate(&string, &expression_str);
-        khstring_delete(&expression_str);
+        khAstExpression_write(&array->values[i], origin, writer);
 
         if (i != kharray_size(&array->values) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -264,33 +263,28 @@ void khAstDict_delete(khAstDict* dict) {
     kharray_delete(&dict->values);
 }
 
-khstring khAstDict_string(khAstDict* dict, char32_t* origin) {
-    khstring string = khstring_new(U"{\"keys\": [");
+void khAstDict_write(khAstDict* dict, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"keys\": [");
 
     for (size_t i = 0; i < kharray_size(&dict->keys); i++) {
-        khstring expression_str = khAstExpression_string(&dict->keys[i], origin);
-        khstring_concatenate(&string, &expression_str);
-        khstring_delete(&expression_str);
+        khAstExpression_write(&dict->keys[i], origin, writer);
 
         if (i != kharray_size(&dict->keys) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"values\": [");
+    khWriter_cstring(writer, "], \"values\": [");
 
     for (size_t i = 0; i < kharray_size(&dict->values); i++) {
-        khstring expression_str = khAstExpression_string(&dict->values[i], origin);
-        khstring_concatenate(&string, &expression_str);
-        khstring_delete(&expression_str);
+        khAstExpression_write(&dict->values[i], origin, writer);
 
         if (i != kharray_size(&dict->values) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -318,37 +312,37 @@ void khAstSignature_delete(khAstSignature* signature) {
     }
 }
 
-khstring khAstSignature_string(khAstSignature* signature, char32_t* origin) {
-    khstring string = khstring_new(U"{\"are_arguments_refs\": [");
+void khAstSignature_write(khAstSignature* signature, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"are_arguments_refs\": [");
     for (size_t i = 0; i < kharray_size(&signature->are_arguments_refs); i++) {
-        khstring_concatenateCstring(&string, signature->are_arguments_refs[i] ? U"true" : U"false");
+        khWriter_cstring(writer, signature->are_arguments_refs[i] ? "true" : "false");
 
         if (i != kharray_size(&signature->are_arguments_refs) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"argument_types\": [");
+    khWriter_cstring(writer, "], \"argument_types\": [");
     for (size_t i = 0; i < kharray_size(&signature->argument_types); i++) {
-        khstring argument_type_str = khAstExpression_string(&signature->argument_types[i], origin);
-        khstring_concatenate(&string, &argument_type_str);
-        khstring_delete(&argument_type_str);
+        khAstExpression_write(&signature->argument_types[i], origin, writer);
 
         if (i != kharray_size(&signature->argument_types) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"is_return_type_ref\": ");
-    khstring_concatenateCstring(&string, signature->is_return_type_ref ? U"true" : U"false");
+    khWriter_cstring(writer, "], \"is_return_type_ref\": ");
+    khWriter_cstring(writer, signature->is_return_type_ref ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"opt_return_type\": ");
-    khstring return_type_str = khAstExpression_string(signature->opt_return_type, origin);
-    khstring_concatenate(&string, &return_type_str);
-    khstring_delete(&return_type_str);
+    khWriter_cstring(writer, ", \"opt_return_type\": ");
+    if (signature->opt_return_type != NULL) {
+        khAstExpression_write(signature->opt_return_type, origin, writer);
+    }
+    else {
+        khWriter_cstring(writer, "null");
+    }
 
-    khstring_concatenateCstring(&string, U"}");
-    return string;
+    khWriter_cstring(writer, "}");
 }
 
 
@@ -385,75 +379,70 @@ void khAstLambda_delete(khAstLambda* lambda) {
     kharray_delete(&lambda->block);
 }
 
-khstring khAstLambda_string(khAstLambda* lambda, char32_t* origin) {
-    khstring string = khstring_new(U"{\"arguments\": [");
+void khAstLambda_write(khAstLambda* lambda, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"arguments\": [");
     for (size_t i = 0; i < kharray_size(&lambda->arguments); i++) {
-        khstring argument_str = khAstVariable_string(&lambda->arguments[i], origin);
-        khstring_concatenate(&string, &argument_str);
-        khstring_delete(&argument_str);
+        khAstVariable_write(&lambda->arguments[i], origin, writer);
 
         if (i != kharray_size(&lambda->arguments) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"opt_variadic_argument\": ");
+    khWriter_cstring(writer, "], \"opt_variadic_argument\": ");
     if (lambda->opt_variadic_argument != NULL) {
-        khstring opt_variadic_argument_str =
-            khAstVariable_string(lambda->opt_variadic_argument, origin);
-        khstring_concatenate(&string, &opt_variadic_argument_str);
-        khstring_delete(&opt_variadic_argument_str);
+        khAstVariable_write(lambda->opt_variadic_argument, origin, writer);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"is_return_type_ref\": ");
-    khstring_concatenateCstring(&string, lambda->is_return_type_ref ? U"true" : U"false");
+    khWriter_cstring(writer, ", \"is_return_type_ref\": ");
+    khWriter_cstring(writer, lambda->is_return_type_ref ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"opt_return_type\": ");
+    khWriter_cstring(writer, ", \"opt_return_type\": ");
     if (lambda->opt_return_type != NULL) {
-        khstring opt_return_type_str = khAstExpression_string(lambda->opt_return_type, origin);
-        khstring_concatenate(&string, &opt_return_type_str);
-        khstring_delete(&opt_return_type_str);
+        khAstExpression_write(lambda->opt_return_type, origin, writer);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"block\": [");
+    khWriter_cstring(writer, ", \"block\": [");
     for (size_t i = 0; i < kharray_size(&lambda->block); i++) {
-        khstring statement_str = khAstStatement_string(&lambda->block[i], origin);
-        khstring_concatenate(&string, &statement_str);
-        khstring_delete(&statement_str);
+        khAstStatement_write(&lambda->block[i], origin, writer);
 
         if (i != kharray_size(&lambda->block) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
-khstring khAstUnaryExpressionType_string(khAstUnaryExpressionType type) {
+const char* khAstUnaryExpressionType_name(khAstUnaryExpressionType type) {
     switch (type) {
         case khAstUnaryExpressionType_POSITIVE:
-            return khstring_new(U"positive");
+            return "positive";
         case khAstUnaryExpressionType_NEGATIVE:
-            return khstring_new(U"negative");
+            return "negative";
 
         case khAstUnaryExpressionType_NOT:
-            return khstring_new(U"not");
+            return "not";
         case khAstUnaryExpressionType_BIT_NOT:
-            return khstring_new(U"bit_not");
+            return "bit_not";
 
         default:
-            return khstring_new(U"unknown");
+            return "unknown";
     }
 }
 
+khstring khAstUnaryExpressionType_string(khAstUnaryExpressionType type) {
+    const char* name = khAstUnaryExpressionType_name(type);
+    return kh_decodeUtf8Memory((const uint8_t*)name, strlen(name));
+}
+
 
 khAstUnaryExpression khAstUnaryExpression_copy(khAstUnaryExpression* unary_exp) {
     khAstExpression* operand = (khAstExpression*)malloc(sizeof(khAstExpression));
@@ -467,95 +456,93 @@ void khAstUnaryExpression_delete(khAstUnaryExpression* unary_exp) {
     free(unary_exp->operand);
 }
 
-khstring khAstUnaryExpression_string(khAstUnaryExpression* unary_exp, char32_t* origin) {
-    khstring string = khstring_new(U"{\"type\": ");
-    khstring type_str = khAstUnaryExpressionType_string(unary_exp->type);
-    khstring quoted_type = khstring_quote(&type_str);
-    khstring_concatenate(&string, &quoted_type);
-    khstring_delete(&type_str);
-    khstring_delete(&quoted_type);
+void khAstUnaryExpression_write(khAstUnaryExpression* unary_exp, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"type\": ");
+    khWriter_quoteCstring(writer, khAstUnaryExpressionType_name(unary_exp->type));
 
-    khstring_concatenateCstring(&string, U", \"operand\": ");
-    khstring operand_str = khAstExpression_string(unary_exp->operand, origin);
-    khstring_concatenate(&string, &operand_str);
-    khstring_delete(&operand_str);
+    khWriter_cstring(writer, ", \"operand\": ");
+    khAstExpression_write(unary_exp->operand, origin, writer);
 
-    khstring_concatenateCstring(&string, U"}");
-    return string;
+    khWriter_cstring(writer, "}");
 }
 
 
-khstring khAstBinaryExpressionType_string(khAstBinaryExpressionType type) {
+const char* khAstBinaryExpressionType_name(khAstBinaryExpressionType type) {
     switch (type) {
         case khAstBinaryExpressionType_ASSIGN:
-            return khstring_new(U"assign");
+            return "assign";
         case khAstBinaryExpressionType_RANGE:
-            return khstring_new(U"range");
+            return "range";
 
         case khAstBinaryExpressionType_ADD:
-            return khstring_new(U"add");
+            return "add";
         case khAstBinaryExpressionType_SUB:
-            return khstring_new(U"sub");
+            return "sub";
         case khAstBinaryExpressionType_MUL:
-            return khstring_new(U"mul");
+            return "mul";
         case khAstBinaryExpressionType_DIV:
-            return khstring_new(U"div");
+            return "div";
         case khAstBinaryExpressionType_MOD:
-            return khstring_new(U"mod");
+            return "mod";
         case khAstBinaryExpressionType_DOT:
-            return khstring_new(U"dot");
+            return "dot";
         case khAstBinaryExpressionType_POW:
-            return khstring_new(U"pow");
+            return "pow";
 
         case khAstBinaryExpressionType_IP_ADD:
-            return khstring_new(U"ip_add");
+            return "ip_add";
         case khAstBinaryExpressionType_IP_SUB:
-            return khstring_new(U"ip_sub");
+            return "ip_sub";
         case khAstBinaryExpressionType_IP_MUL:
-            return khstring_new(U"ip_mul");
+            return "ip_mul";
         case khAstBinaryExpressionType_IP_DIV:
-            return khstring_new(U"ip_div");
+            return "ip_div";
         case khAstBinaryExpressionType_IP_MOD:
-            return khstring_new(U"ip_mod");
+            return "ip_mod";
         case khAstBinaryExpressionType_IP_DOT:
-            return khstring_new(U"ip_dot");
+            return "ip_dot";
         case khAstBinaryExpressionType_IP_POW:
-            return khstring_new(U"ip_pow");
+            return "ip_pow";
 
         case khAstBinaryExpressionType_AND:
-            return khstring_new(U"and");
+            return "and";
         case khAstBinaryExpressionType_OR:
-            return khstring_new(U"or");
+            return "or";
         case khAstBinaryExpressionType_XOR:
-            return khstring_new(U"xor");
+            return "xor";
 
         case khAstBinaryExpressionType_BIT_AND:
-            return khstring_new(U"bit_and");
+            return "bit_and";
         case khAstBinaryExpressionType_BIT_OR:
-            return khstring_new(U"bit_or");
+            return "bit_or";
         case khAstBinaryExpressionType_BIT_XOR:
-            return khstring_new(U"bit_xor");
+            return "bit_xor";
         case khAstBinaryExpressionType_BIT_LSHIFT:
-            return khstring_new(U"bit_lshift");
+            return "bit_lshift";
         case khAstBinaryExpressionType_BIT_RSHIFT:
-            return khstring_new(U"bit_rshift");
+            return "bit_rshift";
 
         case khAstBinaryExpressionType_IP_BIT_AND:
-            return khstring_new(U"ip_bit_and");
+            return "ip_bit_and";
         case khAstBinaryExpressionType_IP_BIT_OR:
-            return khstring_new(U"ip_bit_or");
+            return "ip_bit_or";
         case khAstBinaryExpressionType_IP_BIT_XOR:
-            return khstring_new(U"ip_bit_xor");
+            return "ip_bit_xor";
         case khAstBinaryExpressionType_IP_BIT_LSHIFT:
-            return khstring_new(U"ip_bit_lshift");
+            return "ip_bit_lshift";
         case khAstBinaryExpressionType_IP_BIT_RSHIFT:
-            return khstring_new(U"ip_bit_rshift");
+            return "ip_bit_rshift";
 
         default:
-            return khstring_new(U"unknown");
+            return "unknown";
     }
 }
 
+khstring khAstBinaryExpressionType_string(khAstBinaryExpressionType type) {
+    const char* name = khAstBinaryExpressionType_name(type);
+    return kh_decodeUtf8Memory((const uint8_t*)name, strlen(name));
+}
+
 
 khAstBinaryExpression khAstBinaryExpression_copy(khAstBinaryExpression* binary_exp) {
     khAstExpression* left = (khAstExpression*)malloc(sizeof(khAstExpression));
@@ -574,26 +561,17 @@ void khAstBinaryExpression_delete(khAstBinaryExpression* binary_exp) {
     free(binary_exp->right);
 }
 
-khstring khAstBinaryExpression_string(khAstBinaryExpression* binary_exp, char32_t* origin) {
-    khstring string = khstring_new(U"{\"type\": ");
-    khstring type_str = khAstBinaryExpressionType_string(binary_exp->type);
-    khstring quoted_type = khstring_quote(&type_str);
-    khstring_concatenate(&string, &quoted_type);
-    khstring_delete(&type_str);
-    khstring_delete(&quoted_type);
+void khAstBinaryExpression_write(khAstBinaryExpression* binary_exp, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"type\": ");
+    khWriter_quoteCstring(writer, khAstBinaryExpressionType_name(binary_exp->type));
 
-    khstring_concatenateCstring(&string, U", \"left\": ");
-    khstring left_str = khAstExpression_string(binary_exp->left, origin);
-    khstring_concatenate(&string, &left_str);
-    khstring_delete(&left_str);
+    khWriter_cstring(writer, ", \"left\": ");
+    khAstExpression_write(binary_exp->left, origin, writer);
 
-    khstring_concatenateCstring(&string, U", \"right\": ");
-    khstring right_str = khAstExpression_string(binary_exp->right, origin);
-    khstring_concatenate(&string, &right_str);
-    khstring_delete(&right_str);
+    khWriter_cstring(writer, ", \"right\": ");
+    khAstExpression_write(binary_exp->right, origin, writer);
 
-    khstring_concatenateCstring(&string, U"}");
-    return string;
+    khWriter_cstring(writer, "}");
 }
 
 
@@ -618,47 +596,46 @@ void khAstTernaryExpression_delete(khAstTernaryExpression* ternary_exp) {
     free(ternary_exp->otherwise);
 }
 
-khstring khAstTernaryExpression_string(khAstTernaryExpression* ternary_exp, char32_t* origin) {
-    khstring string = khstring_new(U"{\"condition\": ");
-    khstring condition_str = khAstExpression_string(ternary_exp->condition, origin);
-    khstring_concatenate(&string, &condition_str);
-    khstring_delete(&condition_str);
+void khAstTernaryExpression_write(khAstTernaryExpression* ternary_exp, uint8_t* origin,
+                                  khWriter* writer) {
+    khWriter_cstring(writer, "{\"condition\": ");
+    khAstExpression_write(ternary_exp->condition, origin, writer);
 
-    khstring_concatenateCstring(&string, U", \"value\": ");
-    khstring value_str = khAstExpression_string(ternary_exp->value, origin);
-    khstring_concatenate(&string, &value_str);
-    khstring_delete(&value_str);
+    khWriter_cstring(writer, ", \"value\": ");
+    khAstExpression_write(ternary_exp->value, origin, writer);
 
-    khstring_concatenateCstring(&string, U", \"otherwise\": ");
-    khstring otherwise_str = khAstExpression_string(ternary_exp->otherwise, origin);
-    khstring_concatenate(&string, &otherwise_str);
-    khstring_delete(&otherwise_str);
+    khWriter_cstring(writer, ", \"otherwise\": ");
+    khAstExpression_write(ternary_exp->otherwise, origin, writer);
 
-    khstring_concatenateCstring(&string, U"}");
-    return string;
+    khWriter_cstring(writer, "}");
 }
 
 
-khstring khAstComparisonExpressionType_string(khAstComparisonExpressionType type) {
+const char* khAstComparisonExpressionType_name(khAstComparisonExpressionType type) {
     switch (type) {
         case khAstComparisonExpressionType_EQUAL:
-            return khstring_new(U"equal");
+            return "equal";
         case khAstComparisonExpressionType_UNEQUAL:
-            return khstring_new(U"unequal");
+            return "unequal";
         case khAstComparisonExpressionType_LESS:
-            return khstring_new(U"less");
+            return "less";
         case khAstComparisonExpressionType_GREATER:
-            return khstring_new(U"greater");
+            return "greater";
         case khAstComparisonExpressionType_LESS_EQUAL:
-            return khstring_new(U"less_equal");
+            return "less_equal";
         case khAstComparisonExpressionType_GREATER_EQUAL:
-            return khstring_new(U"greater_equal");
+            return "greater_equal";
 
         default:
-            return khstring_new(U"unknown");
+            return "unknown";
     }
 }
 
+khstring khAstComparisonExpressionType_string(khAstComparisonExpressionType type) {
+    const char* name = khAstComparisonExpressionType_name(type);
+    return kh_decodeUtf8Memory((const uint8_t*)name, strlen(name));
+}
+
 
 khAstComparisonExpression khAstComparisonExpression_copy(khAstComparisonExpression* comparison_exp) {
     return (khAstComparisonExpression){
@@ -671,33 +648,28 @@ void khAstComparisonExpression_delete(khAstComparisonExpression* comparison_exp)
     kharray_delete(&comparison_exp->operands);
 }
 
-khstring khAstComparisonExpression_string(khAstComparisonExpression* comparison_exp, char32_t* origin) {
-    khstring string = khstring_new(U"{\"operations\": [");
+void khAstComparisonExpression_write(khAstComparisonExpression* comparison_exp, uint8_t* origin,
+                                     khWriter* writer) {
+    khWriter_cstring(writer, "{\"operations\": [");
     for (size_t i = 0; i < kharray_size(&comparison_exp->operations); i++) {
-        khstring operation_str = khAstComparisonExpressionType_string(comparison_exp->operations[i]);
-        khstring quoted_operation = khstring_quote(&operation_str);
-        khstring_concatenate(&string, &quoted_operation);
-        khstring_delete(&operation_str);
-        khstring_delete(&quoted_operation);
+        khWriter_quoteCstring(writer,
+                              khAstComparisonExpressionType_name(comparison_exp->operations[i]));
 
         if (i != kharray_size(&comparison_exp->operations) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"operands\": [");
+    khWriter_cstring(writer, "], \"operands\": [");
     for (size_t i = 0; i < kharray_size(&comparison_exp->operands); i++) {
-        khstring operand_str = khAstExpression_string(&comparison_exp->operands[i], origin);
-        khstring_concatenate(&string, &operand_str);
-        khstring_delete(&operand_str);
+        khAstExpression_write(&comparison_exp->operands[i], origin, writer);
 
         if (i != kharray_size(&comparison_exp->operands) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -715,25 +687,20 @@ void khAstCallExpression_delete(khAstCallExpression* call_exp) {
     kharray_delete(&call_exp->arguments);
 }
 
-khstring khAstCallExpression_string(khAstCallExpression* call_exp, char32_t* origin) {
-    khstring string = khstring_new(U"{\"callee\": ");
-    khstring callee_str = khAstExpression_string(call_exp->callee, origin);
-    khstring_concatenate(&string, &callee_str);
-    khstring_delete(&callee_str);
+void khAstCallExpression_write(khAstCallExpression* call_exp, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"callee\": ");
+    khAstExpression_write(call_exp->callee, origin, writer);
 
-    khstring_concatenateCstring(&string, U", \"arguments\": [");
+    khWriter_cstring(writer, ", \"arguments\": [");
     for (size_t i = 0; i < kharray_size(&call_exp->arguments); i++) {
-        khstring argument_str = khAstExpression_string(&call_exp->arguments[i], origin);
-        khstring_concatenate(&string, &argument_str);
-        khstring_delete(&argument_str);
+        khAstExpression_write(&call_exp->arguments[i], origin, writer);
 
         if (i != kharray_size(&call_exp->arguments) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -751,25 +718,20 @@ void khAstIndexExpression_delete(khAstIndexExpression* index_exp) {
     kharray_delete(&index_exp->arguments);
 }
 
-khstring khAstIndexExpression_string(khAstIndexExpression* index_exp, char32_t* origin) {
-    khstring string = khstring_new(U"{\"indexee\": ");
-    khstring indexee_str = khAstExpression_string(index_exp->indexee, origin);
-    khstring_concatenate(&string, &indexee_str);
-    khstring_delete(&indexee_str);
+void khAstIndexExpression_write(khAstIndexExpression* index_exp, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"indexee\": ");
+    khAstExpression_write(index_exp->indexee, origin, writer);
 
-    khstring_concatenateCstring(&string, U", \"arguments\": [");
+    khWriter_cstring(writer, ", \"arguments\": [");
     for (size_t i = 0; i < kharray_size(&index_exp->arguments); i++) {
-        khstring argument_str = khAstExpression_string(&index_exp->arguments[i], origin);
-        khstring_concatenate(&string, &argument_str);
-        khstring_delete(&argument_str);
+        khAstExpression_write(&index_exp->arguments[i], origin, writer);
 
         if (i != kharray_size(&index_exp->arguments) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -791,25 +753,20 @@ void khAstScopeExpression_delete(khAstScopeExpression* scope_exp) {
     kharray_delete(&scope_exp->scope_names);
 }
 
-khstring khAstScopeExpression_string(khAstScopeExpression* scope_exp, char32_t* origin) {
-    khstring string = khstring_new(U"{\"value\": ");
-    khstring value_str = khAstExpression_string(scope_exp->value, origin);
-    khstring_concatenate(&string, &value_str);
-    khstring_delete(&value_str);
+void khAstScopeExpression_write(khAstScopeExpression* scope_exp, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"value\": ");
+    khAstExpression_write(scope_exp->value, origin, writer);
 
-    khstring_concatenateCstring(&string, U", \"scope_names\": [");
+    khWriter_cstring(writer, ", \"scope_names\": [");
     for (size_t i = 0; i < kharray_size(&scope_exp->scope_names); i++) {
-        khstring quoted_scope_name = khstring_quote(&scope_exp->scope_names[i]);
-        khstring_concatenate(&string, &quoted_scope_name);
-        khstring_delete(&quoted_scope_name);
+        khWriter_quote(writer, &scope_exp->scope_names[i]);
 
         if (i != kharray_size(&scope_exp->scope_names) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -828,26 +785,21 @@ void khAstTemplatizeExpression_delete(khAstTemplatizeExpression* templatize_exp)
     kharray_delete(&templatize_exp->template_arguments);
 }
 
-khstring khAstTemplatizeExpression_string(khAstTemplatizeExpression* templatize_exp, char32_t* origin) {
-    khstring string = khstring_new(U"{\"value\": ");
-    khstring value_str = khAstExpression_string(templatize_exp->value, origin);
-    khstring_concatenate(&string, &value_str);
-    khstring_delete(&value_str);
+void khAstTemplatizeExpression_write(khAstTemplatizeExpression* templatize_exp, uint8_t* origin,
+                                     khWriter* writer) {
+    khWriter_cstring(writer, "{\"value\": ");
+    khAstExpression_write(templatize_exp->value, origin, writer);
 
-    khstring_concatenateCstring(&string, U", \"template_arguments\": [");
+    khWriter_cstring(writer, ", \"template_arguments\": [");
     for (size_t i = 0; i < kharray_size(&templatize_exp->template_arguments); i++) {
-        khstring template_argument_str =
-            khAstExpression_string(&templatize_exp->template_arguments[i], origin);
-        khstring_concatenate(&string, &template_argument_str);
-        khstring_delete(&template_argument_str);
+        khAstExpression_write(&templatize_exp->template_arguments[i], origin, writer);
 
         if (i != kharray_size(&templatize_exp->template_arguments) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -978,174 +930,125 @@ void khAstExpression_delete(khAstExpression* expression) {
     }
 }
 
-khstring khAstExpression_string(khAstExpression* expression, char32_t* origin) {
-    khstring string = khstring_new(U"{\"type\": ");
-    khstring type_str = khAstExpressionType_string(expression->type);
-    khstring quoted_type = khstring_quote(&type_str);
-    khstring_concatenate(&string, &quoted_type);
-    khstring_delete(&type_str);
-    khstring_delete(&quoted_type);
+void khAstExpression_write(khAstExpression* expression, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"type\": ");
+    khWriter_quoteCstring(writer, khAstExpressionType_name(expression->type));
 
-    khstring_concatenateCstring(&string, U", \"begin\": ");
+    khWriter_cstring(writer, ", \"begin\": ");
     if (expression->begin != NULL) {
-        khstring begin_str = kh_uintToString(expression->begin - origin, 10);
-        khstring_concatenate(&string, &begin_str);
-        khstring_delete(&begin_str);
+        khWriter_uint(writer, expression->begin - origin, 10);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"end\": ");
+    khWriter_cstring(writer, ", \"end\": ");
     if (expression->end != NULL) {
-        khstring end_str = kh_uintToString(expression->end - origin, 10);
-        khstring_concatenate(&string, &end_str);
-        khstring_delete(&end_str);
+        khWriter_uint(writer, expression->end - origin, 10);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"value\": ");
+    khWriter_cstring(writer, ", \"value\": ");
     switch (expression->type) {
         case khAstExpressionType_IDENTIFIER: {
-            khstring quoted_identifier = khstring_quote(&expression->identifier);
-            khstring_concatenate(&string, &quoted_identifier);
-            khstring_delete(&quoted_identifier);
+            khWriter_quote(writer, &expression->identifier);
         } break;
         case khAstExpressionType_CHAR: {
-            khstring_append(&string, U'\"');
-            khstring escaped_char = kh_escapeChar(expression->char_v);
-            khstring_concatenate(&string, &escaped_char);
-            khstring_delete(&escaped_char);
-            khstring_append(&string, U'\"');
+            khWriter_byte(writer, '\"');
+            khWriter_escapeChar(writer, expression->char_v);
+            khWriter_byte(writer, '\"');
         } break;
         case khAstExpressionType_STRING: {
-            khstring quoted_string = khstring_quote(&expression->string);
-            khstring_concatenate(&string, &quoted_string);
-            khstring_delete(&quoted_string);
+            khWriter_quote(writer, &expression->string);
         } break;
         case khAstExpressionType_BUFFER: {
-            khstring quoted_buffer = khbuffer_quote(&expression->buffer);
-            khstring_concatenate(&string, &quoted_buffer);
-            khstring_delete(&quoted_buffer);
+            khWriter_quoteBuffer(writer, &expression->buffer);
         } break;
         case khAstExpressionType_BYTE: {
-            khstring_append(&string, U'\"');
-            khstring escaped_byte = kh_escapeChar(expression->byte);
-            khstring_concatenate(&string, &escaped_byte);
-            khstring_delete(&escaped_byte);
-            khstring_append(&string, U'\"');
+            khWriter_byte(writer, '\"');
+            khWriter_escapeChar(writer, expression->byte);
+            khWriter_byte(writer, '\"');
         } break;
         case khAstExpressionType_INTEGER: {
-            khstring integer_str = kh_intToString(expression->integer, 10);
-            khstring_concatenate(&string, &integer_str);
-            khstring_delete(&integer_str);
+            khWriter_int(writer, expression->integer, 10);
         } break;
         case khAstExpressionType_UINTEGER: {
-            khstring uinteger_str = kh_uintToString(expression->uinteger, 10);
-            khstring_concatenate(&string, &uinteger_str);
-            khstring_delete(&uinteger_str);
+            khWriter_uint(writer, expression->uinteger, 10);
         } break;
         case khAstExpressionType_FLOAT: {
-            khstring float_str = kh_floatToString(expression->float_v, 8, 10);
-            khstring_concatenate(&string, &float_str);
-            khstring_delete(&float_str);
+            khWriter_float(writer, expression->float_v, 8, 10);
         } break;
         case khAstExpressionType_DOUBLE: {
-            khstring double_str = kh_floatToString(expression->double_v, 16, 10);
-            khstring_concatenate(&string, &double_str);
-            khstring_delete(&double_str);
+            khWriter_float(writer, expression->double_v, 16, 10);
         } break;
         case khAstExpressionType_IFLOAT: {
-            khstring ifloat_str = kh_floatToString(expression->ifloat, 8, 10);
-            khstring_concatenate(&string, &ifloat_str);
-            khstring_delete(&ifloat_str);
+            khWriter_float(writer, expression->ifloat, 8, 10);
         } break;
         case khAstExpressionType_IDOUBLE: {
-            khstring idouble_str = kh_floatToString(expression->idouble, 16, 10);
-            khstring_concatenate(&string, &idouble_str);
-            khstring_delete(&idouble_str);
+            khWriter_float(writer, expression->idouble, 16, 10);
         } break;
 
         case khAstExpressionType_TUPLE: {
-            khstring tuple_str = khAstTuple_string(&expression->tuple, origin);
-            khstring_concatenate(&string, &tuple_str);
-            khstring_delete(&tuple_str);
+            khAstTuple_write(&expression->tuple, origin, writer);
         } break;
         case khAstExpressionType_ARRAY: {
-            khstring array_str = khAstArray_string(&expression->array, origin);
-            khstring_concatenate(&string, &array_str);
-            khstring_delete(&array_str);
+            khAstArray_write(&expression->array, origin, writer);
         } break;
         case khAstExpressionType_DICT: {
-            khstring dict_str = khAstDict_string(&expression->dict, origin);
-            khstring_concatenate(&string, &dict_str);
-            khstring_delete(&dict_str);
+            khAstDict_write(&expression->dict, origin, writer);
         } break;
         case khAstExpressionType_ELLIPSIS: {
-            khstring_concatenateCstring(&string, U"null");
+            khWriter_cstring(writer, "null");
         } break;
 
         case khAstExpressionType_SIGNATURE: {
-            khstring signature_str = khAstSignature_string(&expression->signature, origin);
-            khstring_concatenate(&string, &signature_str);
-            khstring_delete(&signature_str);
+            khAstSignature_write(&expression->signature, origin, writer);
         } break;
         case khAstExpressionType_LAMBDA: {
-            khstring lambda_str = khAstLambda_string(&expression->lambda, origin);
-            khstring_concatenate(&string, &lambda_str);
-            khstring_delete(&lambda_str);
+            khAstLambda_write(&expression->lambda, origin, writer);
         } break;
 
         case khAstExpressionType_UNARY: {
-            khstring unary_str = khAstUnaryExpression_string(&expression->unary, origin);
-            khstring_concatenate(&string, &unary_str);
-            khstring_delete(&unary_str);
+            khAstUnaryExpression_write(&expression->unary, origin, writer);
         } break;
         case khAstExpressionType_BINARY: {
-            khstring binary_str = khAstBinaryExpression_string(&expression->binary, origin);
-            khstring_concatenate(&string, &binary_str);
-            khstring_delete(&binary_str);
+            khAstBinaryExpression_write(&expression->binary, origin, writer);
         } break;
         case khAstExpressionType_TERNARY: {
-            khstring ternary_str = khAstTernaryExpression_string(&expression->ternary, origin);
-            khstring_concatenate(&string, &ternary_str);
-            khstring_delete(&ternary_str);
+            khAstTernaryExpression_write(&expression->ternary, origin, writer);
         } break;
         case khAstExpressionType_COMPARISON: {
-            khstring comparison_str = khAstComparisonExpression_string(&expression->comparison, origin);
-            khstring_concatenate(&string, &comparison_str);
-            khstring_delete(&comparison_str);
+            khAstComparisonExpression_write(&expression->comparison, origin, writer);
         } break;
         case khAstExpressionType_CALL: {
-            khstring call_str = khAstCallExpression_string(&expression->call, origin);
-            khstring_concatenate(&string, &call_str);
-            khstring_delete(&call_str);
+            khAstCallExpression_write(&expression->call, origin, writer);
         } break;
         case khAstExpressionType_INDEX: {
-            khstring index_str = khAstIndexExpression_string(&expression->index, origin);
-            khstring_concatenate(&string, &index_str);
-            khstring_delete(&index_str);
+            khAstIndexExpression_write(&expression->index, origin, writer);
         } break;
 
         case khAstExpressionType_SCOPE: {
-            khstring scope_str = khAstScopeExpression_string(&expression->scope, origin);
-            khstring_concatenate(&string, &scope_str);
-            khstring_delete(&scope_str);
+            khAstScopeExpression_write(&expression->scope, origin, writer);
         } break;
         case khAstExpressionType_TEMPLATIZE: {
-            khstring templatize_str = khAstTemplatizeExpression_string(&expression->templatize, origin);
-            khstring_concatenate(&string, &templatize_str);
-            khstring_delete(&templatize_str);
+            khAstTemplatizeExpression_write(&expression->templatize, origin, writer);
         } break;
 
         default:
-            khstring_concatenateCstring(&string, U"null");
+            khWriter_cstring(writer, "null");
             break;
     }
 
-    khstring_concatenateCstring(&string, U"}");
+    khWriter_cstring(writer, "}");
+}
+
+khstring khAstExpression_string(khAstExpression* expression, uint8_t* origin) {
+    khWriter writer = khWriter_new(NULL);
+    khAstExpression_write(expression, origin, &writer);
+    khstring string = khWriter_take(&writer);
+    khWriter_delete(&writer);
     return string;
 }
 
@@ -1173,33 +1076,28 @@ void khAstImport_delete(khAstImport* import_v) {
     }
 }
 
-khstring khAstImport_string(khAstImport* import_v, char32_t* origin) {
-    khstring string = khstring_new(U"{\"path\": [");
+void khAstImport_write(khAstImport* import_v, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"path\": [");
     for (size_t i = 0; i < kharray_size(&import_v->path); i++) {
-        khstring quoted_path = khstring_quote(&import_v->path[i]);
-        khstring_concatenate(&string, &quoted_path);
-        khstring_delete(&quoted_path);
+        khWriter_quote(writer, &import_v->path[i]);
 
         if (i != kharray_size(&import_v->path) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"relative\": ");
-    khstring_concatenateCstring(&string, import_v->relative ? U"true" : U"false");
+    khWriter_cstring(writer, "], \"relative\": ");
+    khWriter_cstring(writer, import_v->relative ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"opt_alias\": ");
+    khWriter_cstring(writer, ", \"opt_alias\": ");
     if (import_v->opt_alias != NULL) {
-        khstring quoted_alias = khstring_quote(import_v->opt_alias);
-        khstring_concatenate(&string, &quoted_alias);
-        khstring_delete(&quoted_alias);
+        khWriter_quote(writer, import_v->opt_alias);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U"}");
-    return string;
+    khWriter_cstring(writer, "}");
 }
 
 
@@ -1216,23 +1114,20 @@ void khAstInclude_delete(khAstInclude* include) {
     kharray_delete(&include->path);
 }
 
-khstring khAstInclude_string(khAstInclude* include, char32_t* origin) {
-    khstring string = khstring_new(U"{\"path\": [");
+void khAstInclude_write(khAstInclude* include, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"path\": [");
     for (size_t i = 0; i < kharray_size(&include->path); i++) {
-        khstring quoted_path = khstring_quote(&include->path[i]);
-        khstring_concatenate(&string, &quoted_path);
-        khstring_delete(&quoted_path);
+        khWriter_quote(writer, &include->path[i]);
 
         if (i != kharray_size(&include->path) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"relative\": ");
-    khstring_concatenateCstring(&string, include->relative ? U"true" : U"false");
+    khWriter_cstring(writer, "], \"relative\": ");
+    khWriter_cstring(writer, include->relative ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U"}");
-    return string;
+    khWriter_cstring(writer, "}");
 }
 
 
@@ -1276,82 +1171,69 @@ void khAstFunction_delete(khAstFunction* function) {
     kharray_delete(&function->block);
 }
 
-khstring khAstFunction_string(khAstFunction* function, char32_t* origin) {
-    khstring string = khstring_new(U"{\"is_incase\": ");
-    khstring_concatenateCstring(&string, function->is_incase ? U"true" : U"false");
+void khAstFunction_write(khAstFunction* function, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"is_incase\": ");
+    khWriter_cstring(writer, function->is_incase ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"is_static\": ");
-    khstring_concatenateCstring(&string, function->is_static ? U"true" : U"false");
+    khWriter_cstring(writer, ", \"is_static\": ");
+    khWriter_cstring(writer, function->is_static ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"identifiers\": [");
+    khWriter_cstring(writer, ", \"identifiers\": [");
     for (size_t i = 0; i < kharray_size(&function->identifiers); i++) {
-        khstring quoted_identifier = khstring_quote(&function->identifiers[i]);
-        khstring_concatenate(&string, &quoted_identifier);
-        khstring_delete(&quoted_identifier);
+        khWriter_quote(writer, &function->identifiers[i]);
 
         if (i != kharray_size(&function->identifiers) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"template_arguments\": [");
+    khWriter_cstring(writer, "], \"template_arguments\": [");
     for (size_t i = 0; i < kharray_size(&function->template_arguments); i++) {
-        khstring quoted_argument = khstring_quote(&function->template_arguments[i]);
-        khstring_concatenate(&string, &quoted_argument);
-        khstring_delete(&quoted_argument);
+        khWriter_quote(writer, &function->template_arguments[i]);
 
         if (i != kharray_size(&function->template_arguments) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"arguments\": [");
+    khWriter_cstring(writer, "], \"arguments\": [");
     for (size_t i = 0; i < kharray_size(&function->arguments); i++) {
-        khstring argument_str = khAstVariable_string(&function->arguments[i], origin);
-        khstring_concatenate(&string, &argument_str);
-        khstring_delete(&argument_str);
+        khAstVariable_write(&function->arguments[i], origin, writer);
 
         if (i != kharray_size(&function->arguments) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"opt_variadic_argument\": ");
+    khWriter_cstring(writer, "], \"opt_variadic_argument\": ");
     if (function->opt_variadic_argument != NULL) {
-        khstring argument_str = khAstVariable_string(function->opt_variadic_argument, origin);
-        khstring_concatenate(&string, &argument_str);
-        khstring_delete(&argument_str);
+        khAstVariable_write(function->opt_variadic_argument, origin, writer);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"is_return_type_ref\": ");
-    khstring_concatenateCstring(&string, function->is_return_type_ref ? U"true" : U"false");
+    khWriter_cstring(writer, ", \"is_return_type_ref\": ");
+    khWriter_cstring(writer, function->is_return_type_ref ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"opt_return_type\": ");
+    khWriter_cstring(writer, ", \"opt_return_type\": ");
     if (function->opt_return_type != NULL) {
-        khstring argument_str = khAstExpression_string(function->opt_return_type, origin);
-        khstring_concatenate(&string, &argument_str);
-        khstring_delete(&argument_str);
+        khAstExpression_write(function->opt_return_type, origin, writer);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"block\": [");
+    khWriter_cstring(writer, ", \"block\": [");
     for (size_t i = 0; i < kharray_size(&function->block); i++) {
-        khstring statement_str = khAstStatement_string(&function->block[i], origin);
-        khstring_concatenate(&string, &statement_str);
-        khstring_delete(&statement_str);
+        khAstStatement_write(&function->block[i], origin, writer);
 
         if (i != kharray_size(&function->block) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -1384,49 +1266,40 @@ void khAstClass_delete(khAstClass* class_v) {
     kharray_delete(&class_v->block);
 }
 
-khstring khAstClass_string(khAstClass* class_v, char32_t* origin) {
-    khstring string = khstring_new(U"{\"is_incase\": ");
-    khstring_concatenateCstring(&string, class_v->is_incase ? U"true" : U"false");
+void khAstClass_write(khAstClass* class_v, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"is_incase\": ");
+    khWriter_cstring(writer, class_v->is_incase ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"name\": ");
-    khstring quoted_name = khstring_quote(&class_v->name);
-    khstring_concatenate(&string, &quoted_name);
-    khstring_delete(&quoted_name);
+    khWriter_cstring(writer, ", \"name\": ");
+    khWriter_quote(writer, &class_v->name);
 
-    khstring_concatenateCstring(&string, U", \"template_arguments\": [");
+    khWriter_cstring(writer, ", \"template_arguments\": [");
     for (size_t i = 0; i < kharray_size(&class_v->template_arguments); i++) {
-        khstring quoted_argument = khstring_quote(&class_v->template_arguments[i]);
-        khstring_concatenate(&string, &quoted_argument);
-        khstring_delete(&quoted_argument);
+        khWriter_quote(writer, &class_v->template_arguments[i]);
 
         if (i != kharray_size(&class_v->template_arguments) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"opt_base_type\": ");
+    khWriter_cstring(writer, "], \"opt_base_type\": ");
     if (class_v->opt_base_type != NULL) {
-        khstring base_type_str = khAstExpression_string(class_v->opt_base_type, origin);
-        khstring_concatenate(&string, &base_type_str);
-        khstring_delete(&base_type_str);
+        khAstExpression_write(class_v->opt_base_type, origin, writer);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"block\": [");
+    khWriter_cstring(writer, ", \"block\": [");
     for (size_t i = 0; i < kharray_size(&class_v->block); i++) {
-        khstring statement_str = khAstStatement_string(&class_v->block[i], origin);
-        khstring_concatenate(&string, &statement_str);
-        khstring_delete(&statement_str);
+        khAstStatement_write(&class_v->block[i], origin, writer);
 
         if (i != kharray_size(&class_v->block) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -1448,39 +1321,32 @@ void khAstStruct_delete(khAstStruct* struct_v) {
     kharray_delete(&struct_v->block);
 }
 
-khstring khAstStruct_string(khAstStruct* struct_v, char32_t* origin) {
-    khstring string = khstring_new(U"{\"is_incase\": ");
-    khstring_concatenateCstring(&string, struct_v->is_incase ? U"true" : U"false");
+void khAstStruct_write(khAstStruct* struct_v, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"is_incase\": ");
+    khWriter_cstring(writer, struct_v->is_incase ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"name\": ");
-    khstring quoted_name = khstring_quote(&struct_v->name);
-    khstring_concatenate(&string, &quoted_name);
-    khstring_delete(&quoted_name);
+    khWriter_cstring(writer, ", \"name\": ");
+    khWriter_quote(writer, &struct_v->name);
 
-    khstring_concatenateCstring(&string, U", \"template_arguments\": [");
+    khWriter_cstring(writer, ", \"template_arguments\": [");
     for (size_t i = 0; i < kharray_size(&struct_v->template_arguments); i++) {
-        khstring quoted_argument = khstring_quote(&struct_v->template_arguments[i]);
-        khstring_concatenate(&string, &quoted_argument);
-        khstring_delete(&quoted_argument);
+        khWriter_quote(writer, &struct_v->template_arguments[i]);
 
         if (i != kharray_size(&struct_v->template_arguments) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"block\": [");
+    khWriter_cstring(writer, "], \"block\": [");
     for (size_t i = 0; i < kharray_size(&struct_v->block); i++) {
-        khstring statement_str = khAstStatement_string(&struct_v->block[i], origin);
-        khstring_concatenate(&string, &statement_str);
-        khstring_delete(&statement_str);
+        khAstStatement_write(&struct_v->block[i], origin, writer);
 
         if (i != kharray_size(&struct_v->block) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -1498,25 +1364,20 @@ void khAstEnum_delete(khAstEnum* enum_v) {
     kharray_delete(&enum_v->members);
 }
 
-khstring khAstEnum_string(khAstEnum* enum_v, char32_t* origin) {
-    khstring string = khstring_new(U"{\"name\": ");
-    khstring quoted_name = khstring_quote(&enum_v->name);
-    khstring_concatenate(&string, &quoted_name);
-    khstring_delete(&quoted_name);
+void khAstEnum_write(khAstEnum* enum_v, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"name\": ");
+    khWriter_quote(writer, &enum_v->name);
 
-    khstring_concatenateCstring(&string, U", \"members\": [");
+    khWriter_cstring(writer, ", \"members\": [");
     for (size_t i = 0; i < kharray_size(&enum_v->members); i++) {
-        khstring quoted_member = khstring_quote(&enum_v->members[i]);
-        khstring_concatenate(&string, &quoted_member);
-        khstring_delete(&quoted_member);
+        khWriter_quote(writer, &enum_v->members[i]);
 
         if (i != kharray_size(&enum_v->members) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -1531,22 +1392,17 @@ void khAstAlias_delete(khAstAlias* alias) {
     khAstExpression_delete(&alias->expression);
 }
 
-khstring khAstAlias_string(khAstAlias* alias, char32_t* origin) {
-    khstring string = khstring_new(U"{\"is_incase\": ");
-    khstring_concatenateCstring(&string, alias->is_incase ? U"true" : U"false");
+void khAstAlias_write(khAstAlias* alias, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"is_incase\": ");
+    khWriter_cstring(writer, alias->is_incase ? "true" : "false");
 
-    khstring_concatenateCstring(&string, U", \"name\": ");
-    khstring quoted_name = khstring_quote(&alias->name);
-    khstring_concatenate(&string, &quoted_name);
-    khstring_delete(&quoted_name);
+    khWriter_cstring(writer, ", \"name\": ");
+    khWriter_quote(writer, &alias->name);
 
-    khstring_concatenateCstring(&string, U", \"expression\": ");
-    khstring expression_str = khAstExpression_string(&alias->expression, origin);
-    khstring_concatenate(&string, &expression_str);
-    khstring_delete(&expression_str);
+    khWriter_cstring(writer, ", \"expression\": ");
+    khAstExpression_write(&alias->expression, origin, writer);
 
-    khstring_concatenateCstring(&string, U"}");
-    return string;
+    khWriter_cstring(writer, "}");
 }
 
 
@@ -1569,51 +1425,43 @@ void khAstIfBranch_delete(khAstIfBranch* if_branch) {
     kharray_delete(&if_branch->else_block);
 }
 
-khstring khAstIfBranch_string(khAstIfBranch* if_branch, char32_t* origin) {
-    khstring string = khstring_new(U"{\"branch_conditions\": [");
+void khAstIfBranch_write(khAstIfBranch* if_branch, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"branch_conditions\": [");
     for (size_t i = 0; i < kharray_size(&if_branch->branch_conditions); i++) {
-        khstring branch_condition_str =
-            khAstExpression_string(&if_branch->branch_conditions[i], origin);
-        khstring_concatenate(&string, &branch_condition_str);
-        khstring_delete(&branch_condition_str);
+        khAstExpression_write(&if_branch->branch_conditions[i], origin, writer);
 
         if (i != kharray_size(&if_branch->branch_conditions) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"branch_blocks\": [");
+    khWriter_cstring(writer, "], \"branch_blocks\": [");
     for (size_t i = 0; i < kharray_size(&if_branch->branch_blocks); i++) {
-        khstring_append(&string, U'[');
+        khWriter_byte(writer, '[');
         for (size_t j = 0; j < kharray_size(&if_branch->branch_blocks[i]); j++) {
-            khstring statement_str = khAstStatement_string(&if_branch->branch_blocks[i][j], origin);
-            khstring_concatenate(&string, &statement_str);
-            khstring_delete(&statement_str);
+            khAstStatement_write(&if_branch->branch_blocks[i][j], origin, writer);
 
             if (j < kharray_size(&if_branch->branch_blocks[i]) - 1) {
-                khstring_concatenateCstring(&string, U", ");
+                khWriter_cstring(writer, ", ");
             }
         }
-        khstring_append(&string, U']');
+        khWriter_byte(writer, ']');
 
         if (i != kharray_size(&if_branch->branch_blocks) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"else_block\": [");
+    khWriter_cstring(writer, "], \"else_block\": [");
     for (size_t i = 0; i < kharray_size(&if_branch->else_block); i++) {
-        khstring statement_str = khAstStatement_string(&if_branch->else_block[i], origin);
-        khstring_concatenate(&string, &statement_str);
-        khstring_delete(&statement_str);
+        khAstStatement_write(&if_branch->else_block[i], origin, writer);
 
         if (i != kharray_size(&if_branch->else_block) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -1627,25 +1475,20 @@ void khAstWhileLoop_delete(khAstWhileLoop* while_loop) {
     kharray_delete(&while_loop->block);
 }
 
-khstring khAstWhileLoop_string(khAstWhileLoop* while_loop, char32_t* origin) {
-    khstring string = khstring_new(U"{\"condition\": ");
-    khstring condition_str = khAstExpression_string(&while_loop->condition, origin);
-    khstring_concatenate(&string, &condition_str);
-    khstring_delete(&condition_str);
+void khAstWhileLoop_write(khAstWhileLoop* while_loop, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"condition\": ");
+    khAstExpression_write(&while_loop->condition, origin, writer);
 
-    khstring_concatenateCstring(&string, U", \"block\": [");
+    khWriter_cstring(writer, ", \"block\": [");
     for (size_t i = 0; i < kharray_size(&while_loop->block); i++) {
-        khstring statement_str = khAstStatement_string(&while_loop->block[i], origin);
-        khstring_concatenate(&string, &statement_str);
-        khstring_delete(&statement_str);
+        khAstStatement_write(&while_loop->block[i], origin, writer);
 
         if (i != kharray_size(&while_loop->block) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -1659,25 +1502,20 @@ void khAstDoWhileLoop_delete(khAstDoWhileLoop* do_while_loop) {
     kharray_delete(&do_while_loop->block);
 }
 
-khstring khAstDoWhileLoop_string(khAstDoWhileLoop* do_while_loop, char32_t* origin) {
-    khstring string = khstring_new(U"{\"condition\": ");
-    khstring condition_str = khAstExpression_string(&do_while_loop->condition, origin);
-    khstring_concatenate(&string, &condition_str);
-    khstring_delete(&condition_str);
+void khAstDoWhileLoop_write(khAstDoWhileLoop* do_while_loop, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"condition\": ");
+    khAstExpression_write(&do_while_loop->condition, origin, writer);
 
-    khstring_concatenateCstring(&string, U", \"block\": [");
+    khWriter_cstring(writer, ", \"block\": [");
     for (size_t i = 0; i < kharray_size(&do_while_loop->block); i++) {
-        khstring statement_str = khAstStatement_string(&do_while_loop->block[i], origin);
-        khstring_concatenate(&string, &statement_str);
-        khstring_delete(&statement_str);
+        khAstStatement_write(&do_while_loop->block[i], origin, writer);
 
         if (i != kharray_size(&do_while_loop->block) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -1693,36 +1531,29 @@ void khAstForLoop_delete(khAstForLoop* for_loop) {
     kharray_delete(&for_loop->block);
 }
 
-khstring khAstForLoop_string(khAstForLoop* for_loop, char32_t* origin) {
-    khstring string = khstring_new(U"{\"iterators\": [");
+void khAstForLoop_write(khAstForLoop* for_loop, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"iterators\": [");
     for (size_t i = 0; i < kharray_size(&for_loop->iterators); i++) {
-        khstring quoted_iterator = khstring_quote(&for_loop->iterators[i]);
-        khstring_concatenate(&string, &quoted_iterator);
-        khstring_delete(&quoted_iterator);
+        khWriter_quote(writer, &for_loop->iterators[i]);
 
         if (i != kharray_size(&for_loop->iterators) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"], \"iteratee\": ");
-    khstring iteratee_str = khAstExpression_string(&for_loop->iteratee, origin);
-    khstring_concatenate(&string, &iteratee_str);
-    khstring_delete(&iteratee_str);
+    khWriter_cstring(writer, "], \"iteratee\": ");
+    khAstExpression_write(&for_loop->iteratee, origin, writer);
 
-    khstring_concatenateCstring(&string, U", \"block\": [");
+    khWriter_cstring(writer, ", \"block\": [");
     for (size_t i = 0; i < kharray_size(&for_loop->block); i++) {
-        khstring statement_str = khAstStatement_string(&for_loop->block[i], origin);
-        khstring_concatenate(&string, &statement_str);
-        khstring_delete(&statement_str);
+        khAstStatement_write(&for_loop->block[i], origin, writer);
 
         if (i != kharray_size(&for_loop->block) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -1734,20 +1565,17 @@ void khAstReturn_delete(khAstReturn* return_v) {
     kharray_delete(&return_v->values);
 }
 
-khstring khAstReturn_string(khAstReturn* return_v, char32_t* origin) {
-    khstring string = khstring_new(U"{\"values\": [");
+void khAstReturn_write(khAstReturn* return_v, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"values\": [");
     for (size_t i = 0; i < kharray_size(&return_v->values); i++) {
-        khstring value_str = khAstExpression_string(&return_v->values[i], origin);
-        khstring_concatenate(&string, &value_str);
-        khstring_delete(&value_str);
+        khAstExpression_write(&return_v->values[i], origin, writer);
 
         if (i != kharray_size(&return_v->values) - 1) {
-            khstring_concatenateCstring(&string, U", ");
+            khWriter_cstring(writer, ", ");
         }
     }
 
-    khstring_concatenateCstring(&string, U"]}");
-    return string;
+    khWriter_cstring(writer, "]}");
 }
 
 
@@ -1859,114 +1687,273 @@ void khAstStatement_delete(khAstStatement* statement) {
     }
 }
 
-khstring khAstStatement_string(khAstStatement* statement, char32_t* origin) {
-    khstring string = khstring_new(U"{\"type\": ");
-    khstring type_str = khAstStatementType_string(statement->type);
-    khstring quoted_type = khstring_quote(&type_str);
-    khstring_concatenate(&string, &quoted_type);
-    khstring_delete(&type_str);
-    khstring_delete(&quoted_type);
+void khAstStatement_write(khAstStatement* statement, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"type\": ");
+    khWriter_quoteCstring(writer, khAstStatementType_name(statement->type));
 
-    khstring_concatenateCstring(&string, U", \"begin\": ");
+    khWriter_cstring(writer, ", \"begin\": ");
     if (statement->begin != NULL) {
-        khstring begin_str = kh_uintToString(statement->begin - origin, 10);
-        khstring_concatenate(&string, &begin_str);
-        khstring_delete(&begin_str);
+        khWriter_uint(writer, statement->begin - origin, 10);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"end\": ");
+    khWriter_cstring(writer, ", \"end\": ");
     if (statement->end != NULL) {
-        khstring end_str = kh_uintToString(statement->end - origin, 10);
-        khstring_concatenate(&string, &end_str);
-        khstring_delete(&end_str);
+        khWriter_uint(writer, statement->end - origin, 10);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"value\": ");
+    khWriter_cstring(writer, ", \"value\": ");
     switch (statement->type) {
         case khAstStatementType_VARIABLE: {
-            khstring variable_str = khAstVariable_string(&statement->variable, origin);
-            khstring_concatenate(&string, &variable_str);
-            khstring_delete(&variable_str);
+            khAstVariable_write(&statement->variable, origin, writer);
         } break;
 
         case khAstStatementType_EXPRESSION: {
-            khstring expression_str = khAstExpression_string(&statement->expression, origin);
-            khstring_concatenate(&string, &expression_str);
-            khstring_delete(&expression_str);
+            khAstExpression_write(&statement->expression, origin, writer);
         } break;
 
         case khAstStatementType_IMPORT: {
-            khstring import_str = khAstImport_string(&statement->import_v, origin);
-            khstring_concatenate(&string, &import_str);
-            khstring_delete(&import_str);
+            khAstImport_write(&statement->import_v, origin, writer);
         } break;
         case khAstStatementType_INCLUDE: {
-            khstring include_str = khAstInclude_string(&statement->include, origin);
-            khstring_concatenate(&string, &include_str);
-            khstring_delete(&include_str);
+            khAstInclude_write(&statement->include, origin, writer);
         } break;
         case khAstStatementType_FUNCTION: {
-            khstring function_str = khAstFunction_string(&statement->function, origin);
-            khstring_concatenate(&string, &function_str);
-            khstring_delete(&function_str);
+            khAstFunction_write(&statement->function, origin, writer);
         } break;
         case khAstStatementType_CLASS: {
-            khstring class_str = khAstClass_string(&statement->class_v, origin);
-            khstring_concatenate(&string, &class_str);
-            khstring_delete(&class_str);
+            khAstClass_write(&statement->class_v, origin, writer);
         } break;
         case khAstStatementType_STRUCT: {
-            khstring struct_str = khAstStruct_string(&statement->struct_v, origin);
-            khstring_concatenate(&string, &struct_str);
-            khstring_delete(&struct_str);
+            khAstStruct_write(&statement->struct_v, origin, writer);
         } break;
         case khAstStatementType_ENUM: {
-            khstring enum_str = khAstEnum_string(&statement->enum_v, origin);
-            khstring_concatenate(&string, &enum_str);
-            khstring_delete(&enum_str);
+            khAstEnum_write(&statement->enum_v, origin, writer);
         } break;
         case khAstStatementType_ALIAS: {
-            khstring alias_str = khAstAlias_string(&statement->alias, origin);
-            khstring_concatenate(&string, &alias_str);
-            khstring_delete(&alias_str);
+            khAstAlias_write(&statement->alias, origin, writer);
         } break;
 
         case khAstStatementType_IF_BRANCH: {
-            khstring if_branch_str = khAstIfBranch_string(&statement->if_branch, origin);
-            khstring_concatenate(&string, &if_branch_str);
-            khstring_delete(&if_branch_str);
+            khAstIfBranch_write(&statement->if_branch, origin, writer);
         } break;
         case khAstStatementType_WHILE_LOOP: {
-            khstring while_loop_str = khAstWhileLoop_string(&statement->while_loop, origin);
-            khstring_concatenate(&string, &while_loop_str);
-            khstring_delete(&while_loop_str);
+            khAstWhileLoop_write(&statement->while_loop, origin, writer);
         } break;
         case khAstStatementType_DO_WHILE_LOOP: {
-            khstring do_while_loop_str = khAstDoWhileLoop_string(&statement->do_while_loop, origin);
-            khstring_concatenate(&string, &do_while_loop_str);
-            khstring_delete(&do_while_loop_str);
+            khAstDoWhileLoop_write(&statement->do_while_loop, origin, writer);
         } break;
         case khAstStatementType_FOR_LOOP: {
-            khstring for_loop_str = khAstForLoop_string(&statement->for_loop, origin);
-            khstring_concatenate(&string, &for_loop_str);
-            khstring_delete(&for_loop_str);
+            khAstForLoop_write(&statement->for_loop, origin, writer);
         } break;
         case khAstStatementType_RETURN: {
-            khstring return_str = khAstReturn_string(&statement->return_v, origin);
-            khstring_concatenate(&string, &return_str);
-            khstring_delete(&return_str);
+            khAstReturn_write(&statement->return_v, origin, writer);
         } break;
 
         default:
-            khstring_concatenateCstring(&string, U"null");
+            khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U"}");
+    khWriter_cstring(writer, "}");
+}
+
+khstring khAstStatement_string(khAstStatement* statement, uint8_t* origin) {
+    khWriter writer = khWriter_new(NULL);
+    khAstStatement_write(statement, origin, &writer);
+    khstring string = khWriter_take(&writer);
+    khWriter_delete(&writer);
     return string;
 }
+
+
+// Visiting walks the same nodes as the `_delete` functions
+static void visitExpressions(kharray(khAstExpression) * expressions, khAstVisitor* visitor) {
+    for (size_t i = 0; i < kharray_size(expressions); i++) {
+        khAstExpression_visit(&(*expressions)[i], visitor);
+    }
+}
+
+static void visitStatements(kharray(khAstStatement) * block, khAstVisitor* visitor) {
+    for (size_t i = 0; i < kharray_size(block); i++) {
+        khAstStatement_visit(&(*block)[i], visitor);
+    }
+}
+
+static void visitOptional(khAstExpression* opt_expression, khAstVisitor* visitor) {
+    if (opt_expression != NULL) {
+        khAstExpression_visit(opt_expression, visitor);
+    }
+}
+
+static void visitVariable(khAstVariable* variable, khAstVisitor* visitor) {
+    visitOptional(variable->opt_type, visitor);
+    visitOptional(variable->opt_initializer, visitor);
+}
+
+static void visitVariables(kharray(khAstVariable) * variables, khAstVisitor* visitor) {
+    for (size_t i = 0; i < kharray_size(variables); i++) {
+        visitVariable(&(*variables)[i], visitor);
+    }
+}
+
+void khAstExpression_visit(khAstExpression* expression, khAstVisitor* visitor) {
+    if (visitor->expression != NULL) {
+        visitor->expression(expression, visitor->data);
+    }
+
+    switch (expression->type) {
+        case khAstExpressionType_TUPLE:
+            visitExpressions(&expression->tuple.values, visitor);
+            break;
+        case khAstExpressionType_ARRAY:
+            visitExpressions(&expression->array.values, visitor);
+            break;
+        case khAstExpressionType_DICT:
+            visitExpressions(&expression->dict.keys, visitor);
+            visitExpressions(&expression->dict.values, visitor);
+            break;
+
+        case khAstExpressionType_SIGNATURE:
+            visitExpressions(&expression->signature.argument_types, visitor);
+            visitOptional(expression->signature.opt_return_type, visitor);
+            break;
+        case khAstExpressionType_LAMBDA:
+            visitVariables(&expression->lambda.arguments, visitor);
+            if (expression->lambda.opt_variadic_argument != NULL) {
+                visitVariable(expression->lambda.opt_variadic_argument, visitor);
+            }
+            visitOptional(expression->lambda.opt_return_type, visitor);
+            visitStatements(&expression->lambda.block, visitor);
+            break;
+
+        case khAstExpressionType_UNARY:
+            khAstExpression_visit(expression->unary.operand, visitor);
+            break;
+        case khAstExpressionType_BINARY:
+            khAstExpression_visit(expression->binary.left, visitor);
+            khAstExpression_visit(expression->binary.right, visitor);
+            break;
+        case khAstExpressionType_TERNARY:
+            khAstExpression_visit(expression->ternary.condition, visitor);
+            khAstExpression_visit(expression->ternary.value, visitor);
+            khAstExpression_visit(expression->ternary.otherwise, visitor);
+            break;
+        case khAstExpressionType_COMPARISON:
+            visitExpressions(&expression->comparison.operands, visitor);
+            break;
+        case khAstExpressionType_CALL:
+            khAstExpression_visit(expression->call.callee, visitor);
+            visitExpressions(&expression->call.arguments, visitor);
+            break;
+        case khAstExpressionType_INDEX:
+            khAstExpression_visit(expression->index.indexee, visitor);
+            visitExpressions(&expression->index.arguments, visitor);
+            break;
+
+        case khAstExpressionType_SCOPE:
+            khAstExpression_visit(expression->scope.value, visitor);
+            break;
+        case khAstExpressionType_TEMPLATIZE:
+            khAstExpression_visit(expression->templatize.value, visitor);
+            visitExpressions(&expression->templatize.template_arguments, visitor);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void khAstStatement_visit(khAstStatement* statement, khAstVisitor* visitor) {
+    if (visitor->statement != NULL) {
+        visitor->statement(statement, visitor->data);
+    }
+
+    switch (statement->type) {
+        case khAstStatementType_VARIABLE:
+            visitVariable(&statement->variable, visitor);
+            break;
+        case khAstStatementType_EXPRESSION:
+            khAstExpression_visit(&statement->expression, visitor);
+            break;
+
+        case khAstStatementType_FUNCTION:
+            visitVariables(&statement->function.arguments, visitor);
+            if (statement->function.opt_variadic_argument != NULL) {
+                visitVariable(statement->function.opt_variadic_argument, visitor);
+            }
+            visitOptional(statement->function.opt_return_type, visitor);
+            visitStatements(&statement->function.block, visitor);
+            break;
+        case khAstStatementType_CLASS:
+            visitOptional(statement->class_v.opt_base_type, visitor);
+            visitStatements(&statement->class_v.block, visitor);
+            break;
+        case khAstStatementType_STRUCT:
+            visitStatements(&statement->struct_v.block, visitor);
+            break;
+        case khAstStatementType_ALIAS:
+            khAstExpression_visit(&statement->alias.expression, visitor);
+            break;
+
+        case khAstStatementType_IF_BRANCH:
+            visitExpressions(&statement->if_branch.branch_conditions, visitor);
+            for (size_t i = 0; i < kharray_size(&statement->if_branch.branch_blocks); i++) {
+                visitStatements(&statement->if_branch.branch_blocks[i], visitor);
+            }
+            visitStatements(&statement->if_branch.else_block, visitor);
+            break;
+        case khAstStatementType_WHILE_LOOP:
+            khAstExpression_visit(&statement->while_loop.condition, visitor);
+            visitStatements(&statement->while_loop.block, visitor);
+            break;
+        case khAstStatementType_DO_WHILE_LOOP:
+            khAstExpression_visit(&statement->do_while_loop.condition, visitor);
+            visitStatements(&statement->do_while_loop.block, visitor);
+            break;
+        case khAstStatementType_FOR_LOOP:
+            khAstExpression_visit(&statement->for_loop.iteratee, visitor);
+            visitStatements(&statement->for_loop.block, visitor);
+            break;
+        case khAstStatementType_RETURN:
+            visitExpressions(&statement->return_v.values, visitor);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+// Relocation only touches the positions; invalid expressions have none
+static inline void relocatePosition(uint8_t** position, ptrdiff_t offset) {
+    if (*position != NULL) {
+        *position = (uint8_t*)((uintptr_t)*position + offset);
+    }
+}
+
+static void relocateExpression(khAstExpression* expression, void* offset) {
+    relocatePosition(&expression->begin, *(ptrdiff_t*)offset);
+    relocatePosition(&expression->end, *(ptrdiff_t*)offset);
+}
+
+static void relocateStatement(khAstStatement* statement, void* offset) {
+    relocatePosition(&statement->begin, *(ptrdiff_t*)offset);
+    relocatePosition(&statement->end, *(ptrdiff_t*)offset);
+}
+
+void khAstExpression_relocate(khAstExpression* expression, ptrdiff_t offset) {
+    khAstVisitor visitor = {
+        .expression = relocateExpression, .statement = relocateStatement, .data = &offset};
+    khAstExpression_visit(expression, &visitor);
+}
+
+void khAstStatement_relocate(khAstStatement* statement, ptrdiff_t offset) {
+    khAstVisitor visitor = {
+        .expression = relocateExpression, .statement = relocateStatement, .data = &offset};
+    khAstStatement_visit(statement, &visitor);
+}
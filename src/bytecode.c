@@ -0,0 +1,267 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <string.h>
+
+#include <kithare/core/bytecode.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
+
+
+const char* khOpcode_name(khOpcode opcode) {
+    switch (opcode) {
+        case khOpcode_MOVE:
+            return "move";
+        case khOpcode_LOAD_INT:
+            return "load_int";
+        case khOpcode_LOAD_CONSTANT:
+            return "load_constant";
+        case khOpcode_LOAD_STRING:
+            return "load_string";
+
+        case khOpcode_INT_TO_FLOAT:
+            return "int_to_float";
+        case khOpcode_FLOAT_TO_INT:
+            return "float_to_int";
+        case khOpcode_TO_BOOL:
+            return "to_bool";
+
+        case khOpcode_ADD_INT:
+            return "add_int";
+        case khOpcode_ADD_INT_IMMEDIATE:
+            return "add_int_immediate";
+        case khOpcode_SUB_INT:
+            return "sub_int";
+        case khOpcode_MUL_INT:
+            return "mul_int";
+        case khOpcode_DIV_INT:
+            return "div_int";
+        case khOpcode_MOD_INT:
+            return "mod_int";
+        case khOpcode_POW_INT:
+            return "pow_int";
+        case khOpcode_NEGATE_INT:
+            return "negate_int";
+        case khOpcode_BIT_AND:
+            return "bit_and";
+        case khOpcode_BIT_OR:
+            return "bit_or";
+        case khOpcode_BIT_XOR:
+            return "bit_xor";
+        case khOpcode_BIT_NOT:
+            return "bit_not";
+        case khOpcode_BIT_LSHIFT:
+            return "bit_lshift";
+        case khOpcode_BIT_RSHIFT:
+            return "bit_rshift";
+
+        case khOpcode_ADD_FLOAT:
+            return "add_float";
+        case khOpcode_SUB_FLOAT:
+            return "sub_float";
+        case khOpcode_MUL_FLOAT:
+            return "mul_float";
+        case khOpcode_DIV_FLOAT:
+            return "div_float";
+        case khOpcode_MOD_FLOAT:
+            return "mod_float";
+        case khOpcode_POW_FLOAT:
+            return "pow_float";
+        case khOpcode_NEGATE_FLOAT:
+            return "negate_float";
+
+        case khOpcode_EQUAL_INT:
+            return "equal_int";
+        case khOpcode_UNEQUAL_INT:
+            return "unequal_int";
+        case khOpcode_LESS_INT:
+            return "less_int";
+        case khOpcode_LESS_EQUAL_INT:
+            return "less_equal_int";
+        case khOpcode_EQUAL_FLOAT:
+            return "equal_float";
+        case khOpcode_UNEQUAL_FLOAT:
+            return "unequal_float";
+        case khOpcode_LESS_FLOAT:
+            return "less_float";
+        case khOpcode_LESS_EQUAL_FLOAT:
+            return "less_equal_float";
+        case khOpcode_NOT:
+            return "not";
+
+        case khOpcode_JUMP:
+            return "jump";
+        case khOpcode_JUMP_IF:
+            return "jump_if";
+        case khOpcode_JUMP_UNLESS:
+            return "jump_unless";
+
+        case khOpcode_CALL:
+            return "call";
+        case khOpcode_RETURN:
+            return "return";
+        case khOpcode_RETURN_NONE:
+            return "return_none";
+        case khOpcode_MISSING_RETURN:
+            return "missing_return";
+
+        case khOpcode_PRINT_INT:
+            return "print_int";
+        case khOpcode_PRINT_FLOAT:
+            return "print_float";
+        case khOpcode_PRINT_BOOL:
+            return "print_bool";
+        case khOpcode_PRINT_STRING:
+            return "print_string";
+        case khOpcode_PRINT_CHAR:
+            return "print_char";
+
+        default:
+            return "unknown";
+    }
+}
+
+khstring khOpcode_string(khOpcode opcode) {
+    const char* name = khOpcode_name(opcode);
+    return kh_decodeUtf8Memory((const uint8_t*)name, strlen(name));
+}
+
+
+void khBytecodeFunction_delete(khBytecodeFunction* function) {
+    khstring_delete(&function->name);
+    kharray_delete(&function->code);
+    kharray_delete(&function->positions);
+}
+
+void khBytecode_delete(khBytecode* bytecode) {
+    kharray_delete(&bytecode->functions);
+    kharray_delete(&bytecode->constants);
+    kharray_delete(&bytecode->strings);
+}
+
+
+// Which operands an instruction has, after its opcode
+typedef enum {
+    Operands_NONE,
+    Operands_A,
+    Operands_AB,
+    Operands_ABC,
+    Operands_B,
+    Operands_WIDE,
+    Operands_A_WIDE
+} Operands;
+
+static Operands operandsOf(khOpcode opcode) {
+    switch (opcode) {
+        case khOpcode_LOAD_INT:
+        case khOpcode_LOAD_CONSTANT:
+        case khOpcode_LOAD_STRING:
+        case khOpcode_JUMP_IF:
+        case khOpcode_JUMP_UNLESS:
+        case khOpcode_CALL:
+            return Operands_A_WIDE;
+        case khOpcode_JUMP:
+            return Operands_WIDE;
+
+        case khOpcode_MOVE:
+        case khOpcode_INT_TO_FLOAT:
+        case khOpcode_FLOAT_TO_INT:
+        case khOpcode_TO_BOOL:
+        case khOpcode_NEGATE_INT:
+        case khOpcode_BIT_NOT:
+        case khOpcode_NEGATE_FLOAT:
+        case khOpcode_NOT:
+        case khOpcode_PRINT_INT:
+        case khOpcode_PRINT_FLOAT:
+        case khOpcode_PRINT_BOOL:
+        case khOpcode_PRINT_STRING:
+            return Operands_AB;
+
+        case khOpcode_RETURN:
+            return Operands_A;
+        case khOpcode_PRINT_CHAR:
+            return Operands_B;
+        case khOpcode_RETURN_NONE:
+        case khOpcode_MISSING_RETURN:
+            return Operands_NONE;
+
+        default:
+            return Operands_ABC;
+    }
+}
+
+static void writeInstruction(khInstruction* instruction, khWriter* writer) {
+    khWriter_byte(writer, '"');
+    khWriter_cstring(writer, khOpcode_name(instruction->opcode));
+
+    Operands operands = operandsOf(instruction->opcode);
+    if (operands == Operands_A || operands == Operands_AB || operands == Operands_ABC ||
+        operands == Operands_A_WIDE) {
+        khWriter_byte(writer, ' ');
+        khWriter_uint(writer, instruction->a, 10);
+    }
+    if (operands == Operands_AB || operands == Operands_ABC || operands == Operands_B) {
+        khWriter_byte(writer, ' ');
+        khWriter_uint(writer, instruction->b, 10);
+    }
+    if (operands == Operands_ABC) {
+        khWriter_byte(writer, ' ');
+        if (instruction->opcode == khOpcode_ADD_INT_IMMEDIATE) {
+            khWriter_int(writer, (int16_t)instruction->c, 10);
+        }
+        else {
+            khWriter_uint(writer, instruction->c, 10);
+        }
+    }
+    if (operands == Operands_WIDE || operands == Operands_A_WIDE) {
+        khWriter_byte(writer, ' ');
+        khWriter_int(writer, instruction->wide, 10);
+    }
+
+    khWriter_byte(writer, '"');
+}
+
+void khBytecode_write(khBytecode* bytecode, khWriter* writer) {
+    khWriter_cstring(writer, "{\n\"functions\": [\n");
+    for (size_t i = 0; i < kharray_size(&bytecode->functions); i++) {
+        khBytecodeFunction* function = &bytecode->functions[i];
+
+        khWriter_cstring(writer, "{\"name\": ");
+        khWriter_quote(writer, &function->name);
+        khWriter_cstring(writer, ", \"arguments\": ");
+        khWriter_uint(writer, function->arguments, 10);
+        khWriter_cstring(writer, ", \"registers\": ");
+        khWriter_uint(writer, function->registers, 10);
+        khWriter_cstring(writer, ", \"code\": [\n");
+
+        for (size_t j = 0; j < kharray_size(&function->code); j++) {
+            khWriter_cstring(writer, "    ");
+            writeInstruction(&function->code[j], writer);
+            khWriter_cstring(writer, j < kharray_size(&function->code) - 1 ? ",\n" : "\n");
+        }
+
+        khWriter_cstring(writer, i < kharray_size(&bytecode->functions) - 1 ? "]},\n" : "]}\n");
+    }
+
+    // Constants are printed as both of what they could be, as they aren't typed
+    khWriter_cstring(writer, "],\n\"constants\": [");
+    for (size_t i = 0; i < kharray_size(&bytecode->constants); i++) {
+        khWriter_cstring(writer, "{\"int\": ");
+        khWriter_int(writer, bytecode->constants[i].integer, 10);
+        khWriter_cstring(writer, ", \"float\": ");
+        khWriter_float(writer, bytecode->constants[i].float_v, 16, 10);
+        khWriter_cstring(writer, i < kharray_size(&bytecode->constants) - 1 ? "}, " : "}");
+    }
+
+    khWriter_cstring(writer, "],\n\"strings\": [");
+    for (size_t i = 0; i < kharray_size(&bytecode->strings); i++) {
+        khWriter_quote(writer, &bytecode->strings[i]);
+        khWriter_cstring(writer, i < kharray_size(&bytecode->strings) - 1 ? ", " : "");
+    }
+    khWriter_cstring(writer, "]\n}\n");
+}
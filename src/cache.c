@@ -0,0 +1,538 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <kithare/core/cache.h>
+#include <kithare/core/error.h>
+#include <kithare/lib/hashmap.h>
+
+
+typedef enum { ImageKind_TOKENS, ImageKind_AST } ImageKind;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t endianness; // 0x01020304, as it was written
+    uint32_t layout[5];  // Sizes of pointers, array headers, tokens, statements and expressions
+    uint64_t source_hash;
+    uint64_t source_size;
+    uint64_t error_limit; // Which cut the errors short, see `kh_setErrorLimit`
+    uint64_t size;        // Of the whole image
+    uint64_t root;        // Offsets of the arrays of tokens or statements, and of the errors
+    uint64_t errors;
+    uint64_t source;   // Offset of a copy of the source, which it's only loaded with
+    uint64_t checksum; // Of everything after the header, so a damaged image isn't trusted
+} ImageHeader;
+
+#define IMAGE_MAGIC "KHCACHE"
+#define IMAGE_ALIGNMENT _Alignof(max_align_t)
+
+static ImageHeader newHeader(ImageKind kind, khbuffer* source);
+
+
+// An image is made and loaded by walking over everything in it, mirroring what the `_delete`
+// functions free. It's first measured, so that it can be encoded without ever being reallocated
+typedef enum { WalkMode_MEASURE, WalkMode_ENCODE, WalkMode_DECODE } WalkMode;
+
+typedef struct {
+    const void* key; // The string, by its address
+    size_t offset;
+} StringEntry;
+
+typedef struct {
+    WalkMode mode;
+    uint8_t* image;
+    size_t size; // Used so far, while measuring and encoding
+    uint8_t* origin;
+    khAllocator* allocator; // Of the decoded arrays
+
+    // Offsets of the strings already in the image, as strings (like identifiers) are shared; NULL while
+    // decoding
+    khhashmap(StringEntry) strings;
+} Walk;
+
+typedef void (*Walker)(Walk* walk, void* pointer);
+
+static inline size_t place(Walk* walk, size_t size) {
+    size_t offset = (walk->size + IMAGE_ALIGNMENT - 1) & ~(IMAGE_ALIGNMENT - 1);
+    walk->size = offset + size;
+    return offset;
+}
+
+static inline void walkOrigin(Walk* walk, uint8_t** pointer) {
+    // Plus one, so NULL stays distinct from the start of the source
+    if (walk->mode == WalkMode_ENCODE && *pointer != NULL) {
+        *pointer = (uint8_t*)(uintptr_t)(*pointer - walk->origin + 1);
+    }
+    else if (walk->mode == WalkMode_DECODE && *pointer != NULL) {
+        *pointer = walk->origin + (uintptr_t)*pointer - 1;
+    }
+}
+
+// A pointer to a single node, which the image gets a copy of
+static void walkNode(Walk* walk, void** pointer, size_t size, Walker walker) {
+    if (*pointer == NULL) {
+        return;
+    }
+
+    switch (walk->mode) {
+        case WalkMode_MEASURE:
+            place(walk, size);
+            break;
+        case WalkMode_ENCODE: {
+            size_t offset = place(walk, size);
+            memcpy(walk->image + offset, *pointer, size);
+            *pointer = (void*)(uintptr_t)offset;
+        } break;
+        case WalkMode_DECODE:
+            break;
+    }
+
+    if (walk->mode != WalkMode_MEASURE) {
+        *pointer = walk->image + (uintptr_t)*pointer;
+    }
+
+    walker(walk, *pointer);
+
+    if (walk->mode == WalkMode_ENCODE) {
+        *pointer = (void*)(uintptr_t)((uint8_t*)*pointer - walk->image);
+    }
+}
+
+static void walkArray(Walk* walk, void** array, Walker walker) {
+    if (*array == NULL) {
+        return;
+    }
+
+    uint8_t* elements = *array;
+
+    if (walk->mode == WalkMode_DECODE) {
+        elements = walk->image + (uintptr_t)*array;
+        *array = elements;
+
+        // Allocated by the cache's arena, which never frees them
+        kharray_allocator(array) = walk->allocator;
+    }
+    else {
+        size_t type_size = _kharray_typeSize(array);
+        size_t size = kharray_size(array);
+        size_t offset = place(walk, _kharray_memorySize(type_size, size));
+
+        if (walk->mode == WalkMode_ENCODE) {
+            // The null-terminator is already zeroed; deleters aren't kept, as they're meaningless in
+            // another process, and arena arrays don't call them anyway
+            _kharrayHeader* header = (_kharrayHeader*)(walk->image + offset);
+            *header = (_kharrayHeader){.type_size = type_size,
+                                       .is_static = false,
+                                       .deleter = NULL,
+                                       .size = size,
+                                       .reserved = size,
+                                       .allocator = NULL};
+            memcpy(header + 1, *array, type_size * size);
+
+            elements = (uint8_t*)(header + 1);
+            *array = (void*)(uintptr_t)(elements - walk->image);
+        }
+    }
+
+    if (walker != NULL) {
+        for (size_t i = 0; i < kharray_size(&elements) * _kharray_typeSize(&elements);
+             i += _kharray_typeSize(&elements)) {
+            walker(walk, elements + i);
+        }
+    }
+}
+
+static void walkString(Walk* walk, void* pointer) {
+    khstring* string = pointer;
+    if (walk->mode == WalkMode_DECODE) {
+        walkArray(walk, (void**)string, NULL); // Decoding each reference again is harmless
+        return;
+    }
+
+    StringEntry* entry = khhashmap_find(&walk->strings, *string);
+    if (entry != NULL) {
+        if (walk->mode == WalkMode_ENCODE) {
+            *string = (khstring)(uintptr_t)entry->offset;
+        }
+        return;
+    }
+
+    const void* key = *string;
+    walkArray(walk, (void**)string, NULL);
+    khhashmap_put(&walk->strings, ((StringEntry){.key = key, .offset = (uintptr_t)*string}));
+}
+
+static void walkExpression(Walk* walk, void* pointer);
+static void walkStatement(Walk* walk, void* pointer);
+
+static void walkExpressionNode(Walk* walk, khAstExpression** expression) {
+    walkNode(walk, (void**)expression, sizeof(khAstExpression), walkExpression);
+}
+
+static void walkVariable(Walk* walk, void* pointer) {
+    khAstVariable* variable = pointer;
+    walkArray(walk, (void**)&variable->names, walkString);
+    walkExpressionNode(walk, &variable->opt_type);
+    walkExpressionNode(walk, &variable->opt_initializer);
+}
+
+static void walkLambda(Walk* walk, khAstLambda* lambda) {
+    walkArray(walk, (void**)&lambda->arguments, walkVariable);
+    walkNode(walk, (void**)&lambda->opt_variadic_argument, sizeof(khAstVariable), walkVariable);
+    walkExpressionNode(walk, &lambda->opt_return_type);
+    walkArray(walk, (void**)&lambda->block, walkStatement);
+}
+
+static void walkExpression(Walk* walk, void* pointer) {
+    khAstExpression* expression = pointer;
+    walkOrigin(walk, &expression->begin);
+    walkOrigin(walk, &expression->end);
+
+    switch (expression->type) {
+        case khAstExpressionType_IDENTIFIER:
+            walkString(walk, &expression->identifier);
+            break;
+        case khAstExpressionType_STRING:
+            walkString(walk, &expression->string);
+            break;
+        case khAstExpressionType_BUFFER:
+            walkArray(walk, (void**)&expression->buffer, NULL);
+            break;
+
+        case khAstExpressionType_TUPLE:
+            walkArray(walk, (void**)&expression->tuple.values, walkExpression);
+            break;
+        case khAstExpressionType_ARRAY:
+            walkArray(walk, (void**)&expression->array.values, walkExpression);
+            break;
+        case khAstExpressionType_DICT:
+            walkArray(walk, (void**)&expression->dict.keys, walkExpression);
+            walkArray(walk, (void**)&expression->dict.values, walkExpression);
+            break;
+
+        case khAstExpressionType_SIGNATURE:
+            walkArray(walk, (void**)&expression->signature.are_arguments_refs, NULL);
+            walkArray(walk, (void**)&expression->signature.argument_types, walkExpression);
+            walkExpressionNode(walk, &expression->signature.opt_return_type);
+            break;
+        case khAstExpressionType_LAMBDA:
+            walkLambda(walk, &expression->lambda);
+            break;
+
+        case khAstExpressionType_UNARY:
+            walkExpressionNode(walk, &expression->unary.operand);
+            break;
+        case khAstExpressionType_BINARY:
+            walkExpressionNode(walk, &expression->binary.left);
+            walkExpressionNode(walk, &expression->binary.right);
+            break;
+        case khAstExpressionType_TERNARY:
+            walkExpressionNode(walk, &expression->ternary.condition);
+            walkExpressionNode(walk, &expression->ternary.value);
+            walkExpressionNode(walk, &expression->ternary.otherwise);
+            break;
+        case khAstExpressionType_COMPARISON:
+            walkArray(walk, (void**)&expression->comparison.operations, NULL);
+            walkArray(walk, (void**)&expression->comparison.operands, walkExpression);
+            break;
+        case khAstExpressionType_CALL:
+            walkExpressionNode(walk, &expression->call.callee);
+            walkArray(walk, (void**)&expression->call.arguments, walkExpression);
+            break;
+        case khAstExpressionType_INDEX:
+            walkExpressionNode(walk, &expression->index.indexee);
+            walkArray(walk, (void**)&expression->index.arguments, walkExpression);
+            break;
+
+        case khAstExpressionType_SCOPE:
+            walkExpressionNode(walk, &expression->scope.value);
+            walkArray(walk, (void**)&expression->scope.scope_names, walkString);
+            break;
+        case khAstExpressionType_TEMPLATIZE:
+            walkExpressionNode(walk, &expression->templatize.value);
+            walkArray(walk, (void**)&expression->templatize.template_arguments, walkExpression);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void walkBlock(Walk* walk, void* pointer) {
+    walkArray(walk, pointer, walkStatement);
+}
+
+static void walkStatement(Walk* walk, void* pointer) {
+    khAstStatement* statement = pointer;
+    walkOrigin(walk, &statement->begin);
+    walkOrigin(walk, &statement->end);
+
+    switch (statement->type) {
+        case khAstStatementType_VARIABLE:
+            walkVariable(walk, &statement->variable);
+            break;
+        case khAstStatementType_EXPRESSION:
+            walkExpression(walk, &statement->expression);
+            break;
+
+        case khAstStatementType_IMPORT:
+            walkArray(walk, (void**)&statement->import_v.path, walkString);
+            walkNode(walk, (void**)&statement->import_v.opt_alias, sizeof(khstring), walkString);
+            break;
+        case khAstStatementType_INCLUDE:
+            walkArray(walk, (void**)&statement->include.path, walkString);
+            break;
+        case khAstStatementType_FUNCTION: {
+            khAstFunction* function = &statement->function;
+            walkArray(walk, (void**)&function->identifiers, walkString);
+            walkArray(walk, (void**)&function->template_arguments, walkString);
+            walkArray(walk, (void**)&function->arguments, walkVariable);
+            walkNode(walk, (void**)&function->opt_variadic_argument, sizeof(khAstVariable),
+                     walkVariable);
+            walkExpressionNode(walk, &function->opt_return_type);
+            walkBlock(walk, &function->block);
+        } break;
+        case khAstStatementType_CLASS:
+            walkString(walk, &statement->class_v.name);
+            walkArray(walk, (void**)&statement->class_v.template_arguments, walkString);
+            walkExpressionNode(walk, &statement->class_v.opt_base_type);
+            walkBlock(walk, &statement->class_v.block);
+            break;
+        case khAstStatementType_STRUCT:
+            walkString(walk, &statement->struct_v.name);
+            walkArray(walk, (void**)&statement->struct_v.template_arguments, walkString);
+            walkBlock(walk, &statement->struct_v.block);
+            break;
+        case khAstStatementType_ENUM:
+            walkString(walk, &statement->enum_v.name);
+            walkArray(walk, (void**)&statement->enum_v.members, walkString);
+            break;
+        case khAstStatementType_ALIAS:
+            walkString(walk, &statement->alias.name);
+            walkExpression(walk, &statement->alias.expression);
+            break;
+
+        case khAstStatementType_IF_BRANCH:
+            walkArray(walk, (void**)&statement->if_branch.branch_conditions, walkExpression);
+            walkArray(walk, (void**)&statement->if_branch.branch_blocks, walkBlock);
+            walkBlock(walk, &statement->if_branch.else_block);
+            break;
+        case khAstStatementType_WHILE_LOOP:
+            walkExpression(walk, &statement->while_loop.condition);
+            walkBlock(walk, &statement->while_loop.block);
+            break;
+        case khAstStatementType_DO_WHILE_LOOP:
+            walkExpression(walk, &statement->do_while_loop.condition);
+            walkBlock(walk, &statement->do_while_loop.block);
+            break;
+        case khAstStatementType_FOR_LOOP:
+            walkArray(walk, (void**)&statement->for_loop.iterators, walkString);
+            walkExpression(walk, &statement->for_loop.iteratee);
+            walkBlock(walk, &statement->for_loop.block);
+            break;
+        case khAstStatementType_RETURN:
+            walkArray(walk, (void**)&statement->return_v.values, walkExpression);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void walkToken(Walk* walk, void* pointer) {
+    khToken* token = pointer;
+    walkOrigin(walk, &token->begin);
+
+    // Strings and buffers are decoded from the source, which the image is only loaded with
+    if (token->type == khTokenType_IDENTIFIER) {
+        walkString(walk, &token->identifier);
+    }
+}
+
+static void walkError(Walk* walk, void* pointer) {
+    khError* error = pointer;
+    walkString(walk, &error->message);
+    walkOrigin(walk, (uint8_t**)&error->data);
+}
+
+// Both arrays are walked in the order the image is laid out
+static void walkImage(Walk* walk, void** root, kharray(khError) * errors, Walker walker) {
+    walkArray(walk, root, walker);
+    walkArray(walk, (void**)errors, walkError);
+}
+
+
+static uint64_t hashSource(khbuffer* source) {
+    return kh_hash(*source, khbuffer_size(source));
+}
+
+static ImageHeader newHeader(ImageKind kind, khbuffer* source) {
+    ImageHeader header = {.magic = IMAGE_MAGIC,
+                          .version = kh_CACHE_VERSION,
+                          .kind = kind,
+                          .endianness = 0x01020304,
+                          .layout = {sizeof(void*), sizeof(_kharrayHeader), sizeof(khToken),
+                                     sizeof(khAstStatement), sizeof(khAstExpression)},
+                          .source_hash = hashSource(source),
+                          .source_size = khbuffer_size(source),
+                          .error_limit = kh_getErrorLimit(),
+                          .size = 0,
+                          .root = 0,
+                          .errors = 0,
+                          .source = 0,
+                          .checksum = 0};
+    return header;
+}
+
+khstring kh_cachePath(khstring* directory, khbuffer* source, const char32_t* extension) {
+    khstring path = khstring_copy(directory);
+    if (khstring_size(&path) > 0 && path[khstring_size(&path) - 1] != U'/' &&
+        path[khstring_size(&path) - 1] != U'\\') {
+        khstring_append(&path, U'/');
+    }
+
+    // All 16 digits, so the names all have the same length
+    uint64_t hash = hashSource(source);
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        uint8_t digit = (hash >> shift) & 0xF;
+        khstring_append(&path, digit < 10 ? U'0' + digit : U'A' + digit - 10);
+    }
+
+    khstring_append(&path, U'.');
+    khstring_concatenateCstring(&path, extension);
+    return path;
+}
+
+static bool store(khstring* file_name, khbuffer* source, ImageKind kind, void* root, Walker walker) {
+    Walk walk = {.mode = WalkMode_MEASURE,
+                 .image = NULL,
+                 .size = sizeof(ImageHeader),
+                 .origin = *source,
+                 .allocator = NULL,
+                 .strings = khhashmap_new(StringEntry, khhashmap_hashPointer, khhashmap_equalPointer,
+                                          NULL)};
+
+    // Copies of the arrays' pointers, which the walk turns into offsets
+    void* image_root = root;
+    kharray(khError) image_errors = *kh_getErrors();
+    walkImage(&walk, &image_root, &image_errors, walker);
+    size_t source_offset = place(&walk, khbuffer_size(source));
+
+    size_t size = walk.size;
+    uint8_t* image = (uint8_t*)calloc(size, 1);
+
+    khhashmap_delete(&walk.strings);
+    walk = (Walk){.mode = WalkMode_ENCODE,
+                  .image = image,
+                  .size = sizeof(ImageHeader),
+                  .origin = *source,
+                  .allocator = NULL,
+                  .strings = khhashmap_new(StringEntry, khhashmap_hashPointer, khhashmap_equalPointer,
+                                           NULL)};
+    walkImage(&walk, &image_root, &image_errors, walker);
+    place(&walk, khbuffer_size(source));
+    memcpy(image + source_offset, *source, khbuffer_size(source));
+    khhashmap_delete(&walk.strings);
+
+    ImageHeader header = newHeader(kind, source);
+    header.size = walk.size;
+    header.root = (uintptr_t)image_root;
+    header.errors = (uintptr_t)image_errors;
+    header.source = source_offset;
+    header.checksum = kh_hash(image + sizeof(ImageHeader), walk.size - sizeof(ImageHeader));
+    memcpy(image, &header, sizeof(ImageHeader));
+
+    bool success = kh_writeFile(file_name, image, walk.size);
+    free(image);
+    return success;
+}
+
+static void* load(khstring* file_name, khbuffer* source, khCache* cache, ImageKind kind,
+                  Walker walker) {
+    *cache = khCache_new();
+
+    bool success;
+    khMappedFile file = kh_mapFilePrivate(file_name, &success);
+    if (!success) {
+        return NULL;
+    }
+
+    // Checking everything but the size against the header this build would write
+    ImageHeader expected = newHeader(kind, source);
+    ImageHeader* header = (ImageHeader*)file.data;
+    if (file.size < sizeof(ImageHeader) || header->size != file.size) {
+        khMappedFile_delete(&file);
+        return NULL;
+    }
+
+    expected.size = header->size;
+    expected.root = header->root;
+    expected.errors = header->errors;
+    expected.source = header->source;
+    expected.checksum = header->checksum;
+    if (memcmp(header, &expected, sizeof(ImageHeader)) != 0) {
+        khMappedFile_delete(&file);
+        return NULL;
+    }
+
+    // The offsets in it are only trusted as they were written, so anything damaged is a miss
+    if (kh_hash(file.data + sizeof(ImageHeader), file.size - sizeof(ImageHeader)) != header->checksum) {
+        khMappedFile_delete(&file);
+        return NULL;
+    }
+
+    // The hash names the image, but only the source itself tells it apart from one of another source
+    // with the same hash
+    if (header->source > file.size || file.size - header->source < khbuffer_size(source) ||
+        memcmp(file.data + header->source, *source, khbuffer_size(source)) != 0) {
+        khMappedFile_delete(&file);
+        return NULL;
+    }
+
+    cache->file = file;
+    Walk walk = {.mode = WalkMode_DECODE,
+                 .image = (uint8_t*)file.data,
+                 .size = file.size,
+                 .origin = *source,
+                 .allocator = khArena_allocator(&cache->arena),
+                 .strings = NULL};
+
+    void* root = (void*)(uintptr_t)header->root;
+    kharray(khError) errors = (kharray(khError))(uintptr_t)header->errors;
+    walkImage(&walk, &root, &errors, walker);
+
+    // Raised like they were when it was stored, though their messages are on the heap
+    for (size_t i = 0; i < kharray_size(&errors); i++) {
+        kh_raiseError((khError){.type = errors[i].type,
+                                .message = khstring_copy(&errors[i].message),
+                                .data = errors[i].data});
+    }
+
+    return root;
+}
+
+
+bool kh_storeTokens(khstring* file_name, khbuffer* source, kharray(khToken) * tokens) {
+    return store(file_name, source, ImageKind_TOKENS, *tokens, walkToken);
+}
+
+kharray(khToken) kh_loadTokens(khstring* file_name, khbuffer* source, khCache* cache) {
+    return load(file_name, source, cache, ImageKind_TOKENS, walkToken);
+}
+
+bool kh_storeAst(khstring* file_name, khbuffer* source, kharray(khAstStatement) * ast) {
+    return store(file_name, source, ImageKind_AST, *ast, walkStatement);
+}
+
+kharray(khAstStatement) kh_loadAst(khstring* file_name, khbuffer* source, khCache* cache) {
+    return load(file_name, source, cache, ImageKind_AST, walkStatement);
+}
@@ -6,29 +6,324 @@
  */
 
 #include <locale.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <wchar.h>
 
 #ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
 #include <windows.h>
 #endif
 
 #include <kithare/core/ast.h>
+#include <kithare/core/cache.h>
+#include <kithare/core/compiler.h>
+#include <kithare/core/flat.h>
 #include <kithare/core/info.h>
 #include <kithare/core/lexer.h>
+#include <kithare/core/module.h>
+#include <kithare/core/optimizer.h>
 #include <kithare/core/parser.h>
+#include <kithare/core/semantic.h>
+#include <kithare/core/server.h>
+#include <kithare/core/stats.h>
+#include <kithare/core/vm.h>
 
 #include <kithare/lib/ansi.h>
+#include <kithare/lib/arena.h>
 #include <kithare/lib/array.h>
 #include <kithare/lib/buffer.h>
 #include <kithare/lib/io.h>
+#include <kithare/lib/lines.h>
 #include <kithare/lib/string.h>
+#include <kithare/lib/thread.h>
+#include <kithare/lib/writer.h>
 
 
 static int argi = 1;
 static kharray(khstring) args = NULL;
+static bool is_optimizing = false; // With `--optimize`, for `parse`
+static bool is_streaming = false;  // With `--stream`, for `parse`
+static bool is_flattening = false; // With `--flat`, for `parse`
+
+
+// Prints errors raised in the source, along with their lines and columns
+static void writeErrorList(khWriter* writer, kharray(khError) * errors, khbuffer content) {
+    if (kharray_size(errors) == 0) {
+        return;
+    }
+
+    khLineTable lines = khLineTable_new(&content);
+    kh_writeErrorList(writer, errors, &content, &lines);
+    khLineTable_delete(&lines);
+}
+
+// Prints the errors of the source, then flushes them
+static size_t writeErrors(khWriter* writer, khbuffer content) {
+    size_t errors = kh_hasErrors();
+    writeErrorList(writer, kh_getErrors(), content);
+
+    kh_flushErrors();
+    return errors;
+}
+
+
+// Compares code points, so sources of a directory always come in the same order
+static int compareNames(const void* a, const void* b) {
+    khstring* a_name = (khstring*)a;
+    khstring* b_name = (khstring*)b;
+
+    size_t size = khstring_size(a_name) < khstring_size(b_name) ? khstring_size(a_name)
+                                                                : khstring_size(b_name);
+    for (size_t i = 0; i < size; i++) {
+        if ((*a_name)[i] != (*b_name)[i]) {
+            return (*a_name)[i] < (*b_name)[i] ? -1 : 1;
+        }
+    }
+
+    return (khstring_size(a_name) > size) - (khstring_size(b_name) > size);
+}
+
+// Every `.kh` file in the directory and the ones within it
+static void findSources(khstring* directory, kharray(khstring) * files) {
+    bool success;
+    kharray(khstring) names = kh_readDirectory(directory, &success);
+    qsort(names, kharray_size(&names), sizeof(khstring), compareNames);
+
+    for (size_t i = 0; i < kharray_size(&names); i++) {
+        khstring path = khstring_copy(directory);
+        if (khstring_size(&path) > 0 && path[khstring_size(&path) - 1] != U'/' &&
+            path[khstring_size(&path) - 1] != U'\\') {
+            khstring_append(&path, U'/');
+        }
+        khstring_concatenate(&path, &names[i]);
+
+        if (kh_isDirectory(&path)) {
+            findSources(&path, files);
+            khstring_delete(&path);
+        }
+        else if (khstring_endsWithCstring(&path, U".kh")) {
+            kharray_append(files, path);
+        }
+        else {
+            khstring_delete(&path);
+        }
+    }
+
+    kharray_delete(&names);
+}
+
+
+// `--max-errors <count>`, the argument at `argi` being the count
+static bool readErrorLimit(const char* command) {
+    khstring* count = &args[argi];
+    size_t limit = 0;
+
+    bool is_valid = khstring_size(count) > 0;
+    for (size_t i = 0; i < khstring_size(count) && is_valid; i++) {
+        is_valid = (*count)[i] >= U'0' && (*count)[i] <= U'9' && limit <= (SIZE_MAX - 9) / 10;
+        limit = limit * 10 + ((*count)[i] - U'0');
+    }
+
+    if (!is_valid) {
+        fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "invalid error count to " kh_ANSI_RESET kh_ANSI_BOLD, stderr);
+        fputs(command, stderr);
+        fputs(kh_ANSI_RESET ": ", stderr);
+        kh_putln(count, stderr);
+        return false;
+    }
+
+    kh_setErrorLimit(limit);
+    return true;
+}
+
+
+// What `lexicate` and `parse` are run over
+typedef struct {
+    kharray(khstring) files;
+    khstring* cache_directory;
+    bool listed; // From more than one argument or a directory, for which a list of outputs is printed
+    bool stats;  // Printed to the standard error once they're done, with `--stats`
+} Sources;
+
+// The files and directories, then options, `--cache-dir <directory>`, `--max-errors <count>`,
+// `--optimize`, `--stream` and `--flat` for `parse` and `--stats`, which needs a build with `kh_STATS`
+// defined
+static bool readSources(const char* command, Sources* sources) {
+    *sources = (Sources){.files = kharray_new(khstring, khstring_delete),
+                         .cache_directory = NULL,
+                         .listed = false,
+                         .stats = false};
+
+    size_t arguments = 0;
+    for (; argi < kharray_size(&args); argi++) {
+        if (khstring_equalCstring(&args[argi], U"--cache-dir") && argi + 1 < kharray_size(&args)) {
+            sources->cache_directory = &args[++argi];
+        }
+        else if (khstring_equalCstring(&args[argi], U"--max-errors") &&
+                 argi + 1 < kharray_size(&args)) {
+            argi++;
+            if (!readErrorLimit(command)) {
+                kharray_delete(&sources->files);
+                return false;
+            }
+        }
+        else if (khstring_equalCstring(&args[argi], U"--optimize")) {
+            is_optimizing = true;
+        }
+        else if (khstring_equalCstring(&args[argi], U"--stream") && strcmp(command, "parse") == 0) {
+            is_streaming = true;
+        }
+        else if (khstring_equalCstring(&args[argi], U"--flat") && strcmp(command, "parse") == 0) {
+            is_flattening = true;
+        }
+        else if (khstring_equalCstring(&args[argi], U"--stats")) {
+#ifdef kh_STATS
+            sources->stats = true;
+#else
+            fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "built without kh_STATS: " kh_ANSI_RESET "--stats\n",
+                  stderr);
+            kharray_delete(&sources->files);
+            return false;
+#endif
+        }
+        else if (khstring_startsWithCstring(&args[argi], U"--")) {
+            fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "unknown argument to " kh_ANSI_RESET kh_ANSI_BOLD,
+                  stderr);
+            fputs(command, stderr);
+            fputs(kh_ANSI_RESET ": ", stderr);
+            kh_putln(&args[argi], stderr);
+
+            kharray_delete(&sources->files);
+            return false;
+        }
+        else if (kh_isDirectory(&args[argi])) {
+            findSources(&args[argi], &sources->files);
+            sources->listed = true;
+            arguments++;
+        }
+        else {
+            kharray_append(&sources->files, khstring_copy(&args[argi]));
+            arguments++;
+        }
+    }
+
+    if (arguments == 0) {
+        fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "missing required argument: " kh_ANSI_RESET "file\n", stderr);
+        kharray_delete(&sources->files);
+        return false;
+    }
+
+    sources->listed |= arguments > 1;
+    return true;
+}
+
+
+// Writes the output of a single file as an object, which is named after it when it's listed
+typedef size_t (*FrontEnd)(khstring* file_name, khstring* cache_directory, bool listed,
+                           khWriter* writer, bool* file_exists);
+
+typedef struct {
+    Sources* sources;
+    FrontEnd front_end;
+    khOrderedOutput output;
+    atomic_size_t errors;
+} Batch;
+
+static void runBatch(void* batch_v, size_t index) {
+    Batch* batch = (Batch*)batch_v;
+    size_t count = kharray_size(&batch->sources->files);
+
+    // Each file has its own writer and errors, which the thread collects
+    khWriter writer = khWriter_new(NULL);
+    if (index == 0) {
+        khWriter_cstring(&writer, "[\n");
+    }
+
+    bool file_exists;
+    size_t errors = batch->front_end(&batch->sources->files[index], batch->sources->cache_directory,
+                                     true, &writer, &file_exists);
+    khWriter_cstring(&writer, index < count - 1 ? ",\n" : "\n]\n");
+
+    atomic_fetch_add(&batch->errors, file_exists ? errors : 1);
+    khOrderedOutput_submit(&batch->output, index, writer.buffer);
+}
+
+// Runs the front end over each file; listed files are spread over as many threads as there are cores,
+// and their outputs are printed in the order of the files
+static int runFrontEnd(const char* command, FrontEnd front_end) {
+    Sources sources;
+    if (!readSources(command, &sources)) {
+        return 1;
+    }
+
+    // Files run one at a time can have their lexing split on the threads, unlike the ones of a batch
+    if (is_streaming || !sources.listed) {
+        kh_setLexerThreads(kh_threadCount());
+    }
+
+    size_t errors;
+    if (is_streaming) {
+        // Each file after the other, as the lines of one aren't kept to be printed after another's
+        khWriter writer = khWriter_new(stdout);
+        errors = 0;
+
+        for (size_t i = 0; i < kharray_size(&sources.files); i++) {
+            bool file_exists;
+            errors += front_end(&sources.files[i], sources.cache_directory, sources.listed, &writer,
+                                &file_exists);
+            errors += !file_exists;
+        }
+
+        khWriter_delete(&writer);
+    }
+    else if (!sources.listed) {
+        // Streamed straight into the standard output
+        khWriter writer = khWriter_new(stdout);
+        bool file_exists;
+
+        errors = front_end(&sources.files[0], sources.cache_directory, false, &writer, &file_exists);
+        if (file_exists) {
+            khWriter_cstring(&writer, "\n");
+        }
+        else {
+            errors = 1;
+        }
+
+        khWriter_delete(&writer);
+    }
+    else if (kharray_size(&sources.files) == 0) {
+        fputs("[\n]\n", stdout);
+        errors = 0;
+    }
+    else {
+        Batch batch = {.sources = &sources,
+                       .front_end = front_end,
+                       .output = khOrderedOutput_new(stdout, kharray_size(&sources.files))};
+        atomic_init(&batch.errors, 0);
+
+        kh_parallelFor(kharray_size(&sources.files), kh_threadCount(), runBatch, &batch);
+
+        khOrderedOutput_delete(&batch.output);
+        errors = atomic_load(&batch.errors);
+    }
+
+#ifdef kh_STATS
+    if (sources.stats) {
+        khWriter writer = khWriter_new(stderr);
+        kh_writeStats(&writer);
+        khWriter_delete(&writer);
+    }
+#endif
+
+    kharray_delete(&sources.files);
+    return errors;
+}
 
 
 static int help(void) {
@@ -43,14 +338,43 @@ static int help(void) {
          " : builds and runs source file.");
     puts("    " kh_ANSI_BOLD "kcr debug <file.kh> [... arguments]" kh_ANSI_RESET
          " : builds and runs source file on debug mode for debugging.");
+    puts("        Its bytecode is printed to the standard error first, on debug mode. Only ints, "
+         "floats, bools, strings, their operators and functions at the top-level are run for now.");
     puts("    " kh_ANSI_BOLD "kcr build <file.kh> [executable.exe]" kh_ANSI_RESET
          " : builds source file.");
-    puts("    " kh_ANSI_BOLD "kcr lexicate <file.kh>" kh_ANSI_RESET
-         " : lexicates source file into tokens.");
-    puts("    " kh_ANSI_BOLD "kcr parse <file.kh>" kh_ANSI_RESET
+    puts("    " kh_ANSI_BOLD "kcr lexicate <file.kh> [... files] [--cache-dir <directory>]"
+         kh_ANSI_RESET " : lexicates source file into tokens.");
+    puts("    " kh_ANSI_BOLD "kcr parse <file.kh> [... files] [--cache-dir <directory>]" kh_ANSI_RESET
          " : parses source file into an AST tree.");
-    puts("    " kh_ANSI_BOLD "kcr semantic <file.kh>" kh_ANSI_RESET
-         " : semantically analyze source file into a semantic graph.");
+    puts("        Given more files, or directories of them, they're all done in parallel and a list of "
+         "their outputs is printed.");
+    puts("        With " kh_ANSI_BOLD "--cache-dir" kh_ANSI_RESET ", the tokens or AST are kept in the "
+         "directory, and loaded again while the source is unchanged.");
+    puts("        With " kh_ANSI_BOLD "--optimize" kh_ANSI_RESET ", constants are folded and dead "
+         "branches and statements are removed from the AST, as they are before running.");
+    puts("        With " kh_ANSI_BOLD "--stream" kh_ANSI_RESET ", each statement and error is printed "
+         "as a line of JSON as soon as it's parsed, and isn't kept after; files are done one after "
+         "another, each after a line of its name if there are more, and the cache isn't used.");
+    puts("        With " kh_ANSI_BOLD "--flat" kh_ANSI_RESET ", the AST is flattened into a single "
+         "array of nodes first, and printed from that without recursion.");
+    puts("        With " kh_ANSI_BOLD "--stats" kh_ANSI_RESET ", times of each phase and counts of "
+         "tokens, AST nodes and allocations are printed to the standard error, if built with "
+         "kh_STATS.");
+    puts("    " kh_ANSI_BOLD "kcr modules <file.kh> [--search-dir <directory> ...]" kh_ANSI_RESET
+         " : loads source file and the modules it imports or includes into a dependency graph.");
+    puts("        With " kh_ANSI_BOLD "--max-errors <count>" kh_ANSI_RESET ", also taken by "
+         kh_ANSI_BOLD "modules" kh_ANSI_RESET ", lexing and parsing a file stop once it has that many "
+         "errors.");
+    puts("    " kh_ANSI_BOLD "kcr semantic <file.kh> [... files] [--cache-dir <directory>]"
+         kh_ANSI_RESET " : resolves the names of source file into a table of its symbols, scopes and "
+         "references to them.");
+    puts("        It takes the same options as " kh_ANSI_BOLD "parse" kh_ANSI_RESET
+         ", and names which aren't declared or are redeclared are errors.");
+    puts("    " kh_ANSI_BOLD "kcr serve [--search-dir <directory> ...]" kh_ANSI_RESET
+         " : serves requests for diagnostics, ASTs and modules of files over the standard input and "
+         "output.");
+    puts("        Sources and everything made of them are kept in memory, so an edit only parses "
+         "again the statements it touches, and the modules which weren't edited aren't redone.");
 
     puts("\n`" kh_ANSI_BOLD "[...]" kh_ANSI_RESET "` arguments are optional. `" kh_ANSI_BOLD
          "<...>" kh_ANSI_RESET "` arguments are required input arguments.");
@@ -63,14 +387,96 @@ static int version(void) {
     return 0;
 }
 
+// Prints each error as `file:line:column: message`, like compilers do, then flushes them
+static size_t printErrors(khstring* file_name, khbuffer content) {
+    size_t count = kh_hasErrors();
+    kharray(khError)* errors = kh_getErrors();
+    if (count == 0) {
+        return 0;
+    }
+
+    khWriter writer = khWriter_new(stderr);
+    khLineTable lines = khLineTable_new(&content);
+    for (size_t i = 0; i < kharray_size(errors); i++) {
+        khError* error = &(*errors)[i];
+        khLocation location = kh_locate(&lines, &content, (uint8_t*)error->data - content);
+
+        khWriter_string(&writer, file_name);
+        khWriter_byte(&writer, ':');
+        khWriter_uint(&writer, location.line, 10);
+        khWriter_byte(&writer, ':');
+        khWriter_uint(&writer, location.column, 10);
+        khWriter_cstring(&writer, ": " kh_ANSI_BOLD kh_ANSI_FG_RED "error: " kh_ANSI_RESET);
+        khWriter_string(&writer, &error->message);
+        khWriter_byte(&writer, '\n');
+    }
+
+    khLineTable_delete(&lines);
+    khWriter_delete(&writer);
+    kh_flushErrors();
+    return count;
+}
+
+// Parses, compiles then runs the file, stopping at the first of them with errors; on debug mode, the
+// bytecode is printed to the standard error before it's run
+static int runFile(bool is_debug) {
+    if (argi >= kharray_size(&args)) {
+        fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "missing required argument: " kh_ANSI_RESET "file\n", stderr);
+        return 1;
+    }
+
+    khstring* file_name = &args[argi++];
+    bool file_exists;
+    khbuffer content = kh_readFile(file_name, &file_exists);
+    if (!file_exists) {
+        fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "file not found: " kh_ANSI_RESET, stderr);
+        kh_putln(file_name, stderr);
+
+        khbuffer_delete(&content);
+        return 1;
+    }
+
+    khArena arena = khArena_new();
+    kharray(khAstStatement) ast = kh_parseArena(&content, &arena);
+    size_t errors = printErrors(file_name, content);
+
+    if (errors == 0) {
+        kh_optimize(&ast, khAstPass_ALL, &arena);
+        khBytecode bytecode = kh_compile(&ast);
+        errors = printErrors(file_name, content);
+
+        if (errors == 0) {
+            if (is_debug) {
+                khWriter writer = khWriter_new(stderr);
+                khBytecode_write(&bytecode, &writer);
+                khWriter_byte(&writer, '\n');
+                khWriter_delete(&writer);
+            }
+
+            // Output is flushed before any runtime error is printed after it
+            khWriter output = khWriter_new(stdout);
+            kh_execute(&bytecode, &output);
+            khWriter_delete(&output);
+            fflush(stdout);
+            errors = printErrors(file_name, content);
+        }
+
+        khBytecode_delete(&bytecode);
+    }
+
+    khbuffer_delete(&content);
+    khArena_delete(&arena);
+    kh_flushIdentifiers();
+
+    return errors > 0;
+}
+
 static int run(void) {
-    fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "unimplemented command: " kh_ANSI_RESET "run\n", stderr);
-    return 1;
+    return runFile(false);
 }
 
 static int debug(void) {
-    fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "unimplemented command: " kh_ANSI_RESET "debug\n", stderr);
-    return 1;
+    return runFile(true);
 }
 
 static int build(void) {
@@ -78,166 +484,422 @@ static int build(void) {
     return 1;
 }
 
-static int lexicate(void) {
-    if (argi >= kharray_size(&args)) {
-        fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "missing required argument: " kh_ANSI_RESET "file\n", stderr);
-        return 1;
+// Checks for the file, and starts its object
+static khbuffer readObject(khstring* file_name, bool listed, khWriter* writer, bool* file_exists) {
+    kh_startTimer(timer);
+    khbuffer content = kh_readFile(file_name, file_exists);
+    kh_stopTimer(timer, khStatsPhase_READ);
+
+    if (!*file_exists) {
+        fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "file not found: " kh_ANSI_RESET, stderr);
+        kh_putln(file_name, stderr);
     }
-    else if (kharray_size(&args) > 3) {
-        fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "too many arguments; " kh_ANSI_RESET kh_ANSI_BOLD
-                                          "lexicate" kh_ANSI_RESET
-                                          " only requires exactly 1 argument.\n",
-              stderr);
-        return 1;
+
+    if (listed) {
+        khWriter_cstring(writer, "{\n\"file\": ");
+        khWriter_quote(writer, file_name);
+        khWriter_cstring(writer, *file_exists ? ",\n" : ",\n\"error\": \"file not found\"\n}");
+    }
+    else if (*file_exists) {
+        khWriter_cstring(writer, "{\n");
     }
 
-    // Read file provided by argument
-    bool file_exists;
-    khbuffer content_buf = kh_readFile(&args[argi], &file_exists);
-    khstring content = kh_decodeUtf8(&content_buf);
-    khbuffer_delete(&content_buf);
-    argi++;
+    return content;
+}
 
-    if (!file_exists) {
-        fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "file not found: " kh_ANSI_RESET, stderr);
-        kh_putln(&args[argi - 1], stderr);
+static size_t lexicateFile(khstring* file_name, khstring* cache_directory, bool listed,
+                           khWriter* writer, bool* file_exists) {
+    khbuffer content = readObject(file_name, listed, writer, file_exists);
+    if (!*file_exists) {
+        khbuffer_delete(&content);
+        return 0;
+    }
 
-        khstring_delete(&content);
-        return 1;
+    khWriter_cstring(writer, "\"tokens\": [\n");
+
+    // Print tokens, loaded from the cache when there's an image of the same source
+    khCache cache = khCache_new();
+    kharray(khToken) tokens = NULL;
+    khstring cache_path = NULL;
+
+    if (cache_directory != NULL) {
+        cache_path = kh_cachePath(cache_directory, &content, U"khtokens");
+        tokens = kh_loadTokens(&cache_path, &content, &cache);
     }
 
-    puts("{");
-    puts("\"tokens\": [");
+    if (tokens == NULL) {
+        tokens = kh_lexicate(&content);
+        if (cache_directory != NULL && kh_makeDirectory(cache_directory)) {
+            kh_storeTokens(&cache_path, &content, &tokens);
+        }
+    }
 
-    // Print tokens
-    kharray(khToken) tokens = kh_lexicate(&content);
+    kh_startTimer(serialize_timer);
     for (size_t i = 0; i < kharray_size(&tokens); i++) {
-        khstring token_str = khToken_string(&(tokens[i]), content);
-        kh_put(&token_str, stdout);
-        khstring_delete(&token_str);
+        khToken_write(&tokens[i], content, writer);
+        khWriter_cstring(writer, i < kharray_size(&tokens) - 1 ? ",\n" : "\n");
+    }
+
+    khWriter_cstring(writer, "],\n\"errors\": [\n");
+    size_t errors = writeErrors(writer, content);
+    khWriter_cstring(writer, "]\n}");
+    kh_stopTimer(serialize_timer, khStatsPhase_SERIALIZE);
+
+    khbuffer_delete(&content);
+    kharray_delete(&tokens);
+    khCache_delete(&cache);
+    if (cache_path != NULL) {
+        khstring_delete(&cache_path);
+    }
+    kh_flushIdentifiers();
+
+    return errors;
+}
+
+// What `parse --stream` writes each line of JSON with
+typedef struct {
+    khWriter* writer;
+    khbuffer* source;
+    khArena* arena;
+    khLineTable lines; // Made once there's an error
+    size_t errors;     // Written so far
+} Stream;
+
+// Errors raised since the last ones written, each as a line of `{"error": {...}}`
+static void writeStreamErrors(Stream* stream) {
+    kharray(khError)* errors = kh_getErrors();
+    if (stream->errors < kharray_size(errors) && stream->lines.starts == NULL) {
+        stream->lines = khLineTable_new(stream->source);
+    }
+
+    for (; stream->errors < kharray_size(errors); stream->errors++) {
+        khWriter_cstring(stream->writer, "{\"error\": ");
+        khError_write(&(*errors)[stream->errors], stream->source, &stream->lines, stream->writer);
+        khWriter_cstring(stream->writer, "}\n");
+    }
+}
+
+// Each as a line of `{"statement": {...}}`, optimized on its own with `--optimize`
+static bool writeStreamStatement(khAstStatement* statement, void* stream_v) {
+    Stream* stream = (Stream*)stream_v;
+    writeStreamErrors(stream);
+
+    kharray(khAstStatement) ast = kharray_arenaNew(khAstStatement, NULL, stream->arena);
+    kharray_append(&ast, *statement);
+    if (is_optimizing) {
+        kh_optimize(&ast, khAstPass_ALL, stream->arena);
+    }
 
-        if (i < kharray_size(&tokens) - 1) {
-            printf(",\n");
+    kh_startTimer(serialize_timer);
+    if (is_flattening) {
+        khFlatAst flat = kh_flattenAst(&ast, *stream->source);
+        for (uint32_t node = 1; node < flat.nodes[0].next; node = flat.nodes[node].next) {
+            khWriter_cstring(stream->writer, "{\"statement\": ");
+            khFlatAst_write(&flat, node, stream->writer);
+            khWriter_cstring(stream->writer, "}\n");
         }
-        else {
-            printf("\n");
+        khFlatAst_delete(&flat);
+    }
+    else {
+        for (size_t i = 0; i < kharray_size(&ast); i++) {
+            khWriter_cstring(stream->writer, "{\"statement\": ");
+            khAstStatement_write(&ast[i], *stream->source, stream->writer);
+            khWriter_cstring(stream->writer, "}\n");
         }
     }
+    kh_stopTimer(serialize_timer, khStatsPhase_SERIALIZE);
+
+    return true;
+}
+
+// `parse --stream`, with newline-delimited JSON instead of an object, led by a line of the file's name
+// when it's listed
+static size_t streamFile(khstring* file_name, bool listed, khWriter* writer, bool* file_exists) {
+    kh_startTimer(timer);
+    khbuffer content = kh_readFile(file_name, file_exists);
+    kh_stopTimer(timer, khStatsPhase_READ);
+
+    if (listed) {
+        khWriter_cstring(writer, "{\"file\": ");
+        khWriter_quote(writer, file_name);
+        khWriter_cstring(writer, *file_exists ? "}\n" : ", \"error\": \"file not found\"}\n");
+    }
+    if (!*file_exists) {
+        fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "file not found: " kh_ANSI_RESET, stderr);
+        kh_putln(file_name, stderr);
+
+        khbuffer_delete(&content);
+        return 0;
+    }
 
-    puts("],");
-    puts("\"errors\": [");
+    khArena arena = khArena_new();
+    Stream stream = {.writer = writer,
+                     .source = &content,
+                     .arena = &arena,
+                     .lines = {.starts = NULL},
+                     .errors = 0};
 
-    // Print errors
+    kh_parseStream(&content, &arena, writeStreamStatement, &stream);
+    writeStreamErrors(&stream);
     size_t errors = kh_hasErrors();
-    for (size_t i = 0; i < errors; i++) {
-        khError* error = &(*kh_getErrors())[i];
-        khstring message = khstring_quote(&error->message);
+    kh_flushErrors();
+
+    if (stream.lines.starts != NULL) {
+        khLineTable_delete(&stream.lines);
+    }
+    khbuffer_delete(&content);
+    khArena_delete(&arena);
+    kh_flushIdentifiers();
+
+    return errors;
+}
 
-        printf("{\"index\": %lu, \"message\": ", (unsigned long)((char32_t*)error->data - content));
-        kh_put(&message, stdout);
-        printf("}");
+static size_t parseFile(khstring* file_name, khstring* cache_directory, bool listed, khWriter* writer,
+                        bool* file_exists) {
+    if (is_streaming) {
+        return streamFile(file_name, listed, writer, file_exists);
+    }
 
-        khstring_delete(&message);
+    khbuffer content = readObject(file_name, listed, writer, file_exists);
+    if (!*file_exists) {
+        khbuffer_delete(&content);
+        return 0;
+    }
 
-        if (i < errors - 1) {
-            printf(",\n");
+    khWriter_cstring(writer, "\"ast\": [\n");
+
+    // Print statements, which are all freed along with the arena or the cache
+    khArena arena = khArena_new();
+    khCache cache = khCache_new();
+    kharray(khAstStatement) ast = NULL;
+    khstring cache_path = NULL;
+
+    if (cache_directory != NULL) {
+        cache_path = kh_cachePath(cache_directory, &content, U"khast");
+        ast = kh_loadAst(&cache_path, &content, &cache);
+    }
+
+    // What's cached is what's parsed, the optimizations are done again on load
+    bool is_cached = ast != NULL;
+    if (!is_cached) {
+        ast = kh_parseArena(&content, &arena);
+        if (cache_directory != NULL && kh_makeDirectory(cache_directory)) {
+            kh_storeAst(&cache_path, &content, &ast);
         }
-        else {
-            printf("\n");
+    }
+
+    if (is_optimizing) {
+        kh_optimize(&ast, khAstPass_ALL, is_cached ? &cache.arena : &arena);
+    }
+
+    kh_startTimer(serialize_timer);
+    if (is_flattening) {
+        // Statements are the children of the first node, each followed by its subtree
+        khFlatAst flat = kh_flattenAst(&ast, content);
+        for (uint32_t node = 1; node < flat.nodes[0].next; node = flat.nodes[node].next) {
+            khFlatAst_write(&flat, node, writer);
+            khWriter_cstring(writer, flat.nodes[node].next < flat.nodes[0].next ? ",\n" : "\n");
+        }
+        khFlatAst_delete(&flat);
+    }
+    else {
+        for (size_t i = 0; i < kharray_size(&ast); i++) {
+            khAstStatement_write(&ast[i], content, writer);
+            khWriter_cstring(writer, i < kharray_size(&ast) - 1 ? ",\n" : "\n");
         }
     }
 
-    kh_flushErrors();
-    puts("]");
-    puts("}");
+    khWriter_cstring(writer, "],\n\"errors\": [\n");
+    size_t errors = writeErrors(writer, content);
+    khWriter_cstring(writer, "]\n}");
+    kh_stopTimer(serialize_timer, khStatsPhase_SERIALIZE);
 
-    khstring_delete(&content);
-    kharray_delete(&tokens);
+    khbuffer_delete(&content);
+    khArena_delete(&arena);
+    khCache_delete(&cache);
+    if (cache_path != NULL) {
+        khstring_delete(&cache_path);
+    }
+    kh_flushIdentifiers();
 
     return errors;
 }
 
+static int lexicate(void) {
+    return runFrontEnd("lexicate", lexicateFile);
+}
+
 static int parse(void) {
+    return runFrontEnd("parse", parseFile);
+}
+
+static int modules(void) {
     if (argi >= kharray_size(&args)) {
         fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "missing required argument: " kh_ANSI_RESET "file\n", stderr);
         return 1;
     }
-    else if (kharray_size(&args) > 3) {
-        fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "too many arguments; " kh_ANSI_RESET kh_ANSI_BOLD
-                                          "parse" kh_ANSI_RESET " only requires exactly 1 argument.\n",
-              stderr);
-        return 1;
+
+    khstring* file_name = &args[argi++];
+    kharray(khstring) search_directories = kharray_new(khstring, khstring_delete);
+
+    for (; argi < kharray_size(&args); argi++) {
+        if (khstring_equalCstring(&args[argi], U"--search-dir") && argi + 1 < kharray_size(&args)) {
+            kharray_append(&search_directories, khstring_copy(&args[++argi]));
+        }
+        else if (khstring_equalCstring(&args[argi], U"--max-errors") &&
+                 argi + 1 < kharray_size(&args)) {
+            argi++;
+            if (!readErrorLimit("modules")) {
+                kharray_delete(&search_directories);
+                return 1;
+            }
+        }
+        else {
+            fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "unknown argument to " kh_ANSI_RESET kh_ANSI_BOLD
+                                              "modules" kh_ANSI_RESET ": ",
+                  stderr);
+            kh_putln(&args[argi], stderr);
+
+            kharray_delete(&search_directories);
+            return 1;
+        }
     }
 
-    // Read file provided by argument
-    bool file_exists;
-    khbuffer content_buf = kh_readFile(&args[argi], &file_exists);
-    khstring content = kh_decodeUtf8(&content_buf);
-    khbuffer_delete(&content_buf);
-    argi++;
+    khModuleGraph graph = kh_loadModules(file_name, &search_directories, kh_threadCount());
+    kharray_delete(&search_directories);
 
-    if (!file_exists) {
+    if (graph.entry == NULL) {
         fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "file not found: " kh_ANSI_RESET, stderr);
-        kh_putln(&args[argi - 1], stderr);
+        kh_putln(file_name, stderr);
 
-        khstring_delete(&content);
+        khModuleGraph_delete(&graph);
         return 1;
     }
 
-    puts("{");
-    puts("\"ast\": [");
+    // Print the modules, each after those it depends on
+    khWriter writer = khWriter_new(stdout);
+    khWriter_cstring(&writer, "{\n\"modules\": [\n");
+
+    size_t errors = 0;
+    for (size_t i = 0; i < kharray_size(&graph.modules); i++) {
+        khModule* module = graph.modules[i];
+
+        khWriter_cstring(&writer, "{\n\"file\": ");
+        khWriter_quote(&writer, &module->path);
+        khWriter_cstring(&writer, ",\n\"dependencies\": [");
+
+        for (size_t j = 0; j < kharray_size(&module->dependencies); j++) {
+            khModule* dependency = module->dependencies[j].module;
+            if (dependency != NULL) {
+                khWriter_quote(&writer, &dependency->path);
+            }
+            else {
+                khWriter_cstring(&writer, "null");
+            }
+
+            if (j < kharray_size(&module->dependencies) - 1) {
+                khWriter_cstring(&writer, ", ");
+            }
+        }
 
-    // Print statements
-    kharray(khAstStatement) ast = kh_parse(&content);
-    for (size_t i = 0; i < kharray_size(&ast); i++) {
-        khstring statement_str = khAstStatement_string(&ast[i], content);
-        kh_put(&statement_str, stdout);
-        khstring_delete(&statement_str);
+        khWriter_cstring(&writer, "],\n\"errors\": [\n");
+        writeErrorList(&writer, &module->errors, module->source);
+        khWriter_cstring(&writer, i < kharray_size(&graph.modules) - 1 ? "]\n},\n" : "]\n}\n");
 
-        if (i < kharray_size(&ast) - 1) {
-            printf(",\n");
-        }
-        else {
-            printf("\n");
-        }
+        errors += kharray_size(&module->errors);
     }
 
-    puts("],");
-    puts("\"errors\": [");
+    khWriter_cstring(&writer, "]\n}\n");
+    khWriter_delete(&writer);
 
-    // Print errors
-    size_t errors = kh_hasErrors();
-    for (size_t i = 0; i < errors; i++) {
-        khError* error = &(*kh_getErrors())[i];
-        khstring message = khstring_quote(&error->message);
+    khModuleGraph_delete(&graph);
+    return errors;
+}
 
-        printf("{\"index\": %lu, \"message\": ", (unsigned long)((char32_t*)error->data - content));
-        kh_put(&message, stdout);
-        printf("}");
+static size_t semanticFile(khstring* file_name, khstring* cache_directory, bool listed,
+                           khWriter* writer, bool* file_exists) {
+    khbuffer content = readObject(file_name, listed, writer, file_exists);
+    if (!*file_exists) {
+        khbuffer_delete(&content);
+        return 0;
+    }
 
-        khstring_delete(&message);
+    // Names of a cached AST are shared like they're interned, so they're resolved the same
+    khArena arena = khArena_new();
+    khCache cache = khCache_new();
+    kharray(khAstStatement) ast = NULL;
+    khstring cache_path = NULL;
 
-        if (i < errors - 1) {
-            printf(",\n");
-        }
-        else {
-            printf("\n");
+    if (cache_directory != NULL) {
+        cache_path = kh_cachePath(cache_directory, &content, U"khast");
+        ast = kh_loadAst(&cache_path, &content, &cache);
+    }
+
+    if (ast == NULL) {
+        ast = kh_parseArena(&content, &arena);
+        if (cache_directory != NULL && kh_makeDirectory(cache_directory)) {
+            kh_storeAst(&cache_path, &content, &ast);
         }
     }
 
-    kh_flushErrors();
-    puts("]");
-    puts("}");
+    khSymbolTable table = kh_resolve(&ast);
+
+    kh_startTimer(serialize_timer);
+    khWriter_cstring(writer, "\"table\": ");
+    khSymbolTable_write(&table, content, writer);
 
-    khstring_delete(&content);
-    kharray_delete(&ast);
+    khWriter_cstring(writer, ",\n\"errors\": [\n");
+    size_t errors = writeErrors(writer, content);
+    khWriter_cstring(writer, "]\n}");
+    kh_stopTimer(serialize_timer, khStatsPhase_SERIALIZE);
+
+    khSymbolTable_delete(&table);
+    khbuffer_delete(&content);
+    khArena_delete(&arena);
+    khCache_delete(&cache);
+    if (cache_path != NULL) {
+        khstring_delete(&cache_path);
+    }
+    kh_flushIdentifiers();
 
     return errors;
 }
 
 static int semantic(void) {
-    fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "unimplemented command: " kh_ANSI_RESET "semantic\n", stderr);
-    return 1;
+    return runFrontEnd("semantic", semanticFile);
+}
+
+// Takes the same search directories as `modules`
+static int serve(void) {
+    kharray(khstring) search_directories = kharray_new(khstring, khstring_delete);
+
+    for (; argi < kharray_size(&args); argi++) {
+        if (khstring_equalCstring(&args[argi], U"--search-dir") && argi + 1 < kharray_size(&args)) {
+            kharray_append(&search_directories, khstring_copy(&args[++argi]));
+        }
+        else {
+            fputs(kh_ANSI_BOLD kh_ANSI_FG_RED "unknown argument to " kh_ANSI_RESET kh_ANSI_BOLD
+                                              "serve" kh_ANSI_RESET ": ",
+                  stderr);
+            kh_putln(&args[argi], stderr);
+
+            kharray_delete(&search_directories);
+            return 1;
+        }
+    }
+
+#ifdef _WIN32
+    // Sizes of requests and responses are in bytes, which mustn't be translated
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    khServer server = khServer_new(search_directories, kh_threadCount());
+    khServer_serve(&server, stdin, stdout);
+    khServer_delete(&server);
+    kh_flushIdentifiers();
+
+    return 0;
 }
 
 
@@ -307,10 +969,18 @@ int main(int argc, char* argv[])
         argi++;
         code = parse();
     }
+    else if (khstring_equalCstring(&args[1], U"modules")) {
+        argi++;
+        code = modules();
+    }
     else if (khstring_equalCstring(&args[1], U"semantic")) {
         argi++;
         code = semantic();
     }
+    else if (khstring_equalCstring(&args[1], U"serve")) {
+        argi++;
+        code = serve();
+    }
     else if (khstring_endsWithCstring(&args[1], U".kh")) {
         code = run();
     }
@@ -0,0 +1,1279 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <kithare/core/ast.h>
+#include <kithare/core/bytecode.h>
+#include <kithare/core/compiler.h>
+#include <kithare/core/error.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/hashmap.h>
+#include <kithare/lib/string.h>
+
+
+// What a register holds; invalid ones come from what already raised an error, so nothing else is raised
+// about them
+typedef enum { Type_INVALID, Type_NONE, Type_INT, Type_FLOAT, Type_BOOL, Type_STRING } Type;
+
+static const char32_t* type_names[] = {U"an invalid value", U"none",  U"an int",
+                                       U"a float",          U"a bool", U"a string"};
+
+typedef struct {
+    khstring* name;
+    kharray(Type) arguments;
+    Type return_type;
+} Signature;
+
+// Of the signatures, by the functions' names
+typedef struct {
+    khstring key;
+    size_t index;
+} FunctionEntry;
+
+static void Signature_delete(Signature* signature) {
+    kharray_delete(&signature->arguments);
+}
+
+typedef struct {
+    khstring* name; // NULL for the hidden ones, like the end of a for loop's range
+    uint16_t reg;
+    Type type;
+} Local;
+
+// Jumps out of a loop, patched once where they're going is known
+typedef struct {
+    kharray(size_t) breaks;
+    kharray(size_t) continues;
+} Loop;
+
+static void Loop_delete(Loop* loop) {
+    kharray_delete(&loop->breaks);
+    kharray_delete(&loop->continues);
+}
+
+typedef struct {
+    uint16_t reg;
+    Type type;
+} Operand;
+
+typedef struct {
+    khBytecode* bytecode;
+    kharray(Signature) signatures; // Of every function after the top-level, in the same order
+    khhashmap(FunctionEntry) functions;
+
+    size_t function; // What's being compiled
+    Type return_type;
+    size_t depth; // Of blocks
+    kharray(Local) locals;
+    size_t top; // The first free register
+    kharray(Loop) loops;
+
+    uint8_t* position; // Given to each instruction, for runtime errors
+} Compiler;
+
+
+static inline void raiseError(uint8_t* ptr, const char32_t* message) {
+    kh_raiseError(
+        (khError){.type = khErrorType_COMPILER, .message = khstring_new(message), .data = ptr});
+}
+
+// Like "unknown variable `x`"
+static inline void raiseNameError(uint8_t* ptr, const char32_t* message, khstring* name) {
+    khstring string = khstring_new(message);
+    khstring_concatenateCstring(&string, U" `");
+    khstring_concatenate(&string, name);
+    khstring_append(&string, U'`');
+    kh_raiseError((khError){.type = khErrorType_COMPILER, .message = string, .data = ptr});
+}
+
+// Like "expecting an int, not a float"
+static inline void raiseTypeError(uint8_t* ptr, const char32_t* expected, Type type) {
+    khstring string = khstring_new(U"expecting ");
+    khstring_concatenateCstring(&string, expected);
+    khstring_concatenateCstring(&string, U", not ");
+    khstring_concatenateCstring(&string, type_names[type]);
+    kh_raiseError((khError){.type = khErrorType_COMPILER, .message = string, .data = ptr});
+}
+
+
+static inline khBytecodeFunction* currentFunction(Compiler* compiler) {
+    return &compiler->bytecode->functions[compiler->function];
+}
+
+static inline size_t here(Compiler* compiler) {
+    return kharray_size(&currentFunction(compiler)->code);
+}
+
+static inline size_t emit(Compiler* compiler, khInstruction instruction) {
+    khBytecodeFunction* function = currentFunction(compiler);
+    kharray_append(&function->code, instruction);
+    kharray_append(&function->positions, compiler->position);
+    return kharray_size(&function->code) - 1;
+}
+
+static inline size_t emitRegisters(Compiler* compiler, khOpcode opcode, uint16_t a, uint16_t b,
+                                   uint16_t c) {
+    return emit(compiler, (khInstruction){.opcode = opcode, .a = a, .b = b, .c = c});
+}
+
+static inline size_t emitWide(Compiler* compiler, khOpcode opcode, uint16_t a, int32_t wide) {
+    return emit(compiler, (khInstruction){.opcode = opcode, .a = a, .wide = wide});
+}
+
+// Jumps are relative to the instruction after them
+static inline void patchJump(Compiler* compiler, size_t jump, size_t target) {
+    currentFunction(compiler)->code[jump].wide = (int32_t)target - (int32_t)jump - 1;
+}
+
+static inline void emitJump(Compiler* compiler, khOpcode opcode, uint16_t a, size_t target) {
+    patchJump(compiler, emitWide(compiler, opcode, a, 0), target);
+}
+
+static inline void patchJumps(Compiler* compiler, kharray(size_t) * jumps, size_t target) {
+    for (size_t i = 0; i < kharray_size(jumps); i++) {
+        patchJump(compiler, (*jumps)[i], target);
+    }
+}
+
+
+static inline uint16_t allocate(Compiler* compiler) {
+    if (compiler->top >= UINT16_MAX) {
+        // Raised only once, by when it's reached; the registers after are all the last one
+        if (compiler->top++ == UINT16_MAX) {
+            raiseError(compiler->position, U"too many registers are needed for this function");
+        }
+        return UINT16_MAX - 1;
+    }
+
+    khBytecodeFunction* function = currentFunction(compiler);
+    if (compiler->top + 1 > function->registers) {
+        function->registers = compiler->top + 1;
+    }
+    return compiler->top++;
+}
+
+// The destination, or a new temporary register for any
+static inline uint16_t target(Compiler* compiler, int32_t dest) {
+    return dest >= 0 ? (uint16_t)dest : allocate(compiler);
+}
+
+// Registers of temporaries are freed back down to where the locals end, between statements
+static inline size_t localsTop(Compiler* compiler) {
+    size_t size = kharray_size(&compiler->locals);
+    return size > 0 ? compiler->locals[size - 1].reg + 1 : 0;
+}
+
+static inline Local* findLocal(Compiler* compiler, khstring* name) {
+    for (size_t i = kharray_size(&compiler->locals); i > 0; i--) {
+        Local* local = &compiler->locals[i - 1];
+        if (local->name != NULL && khstring_equal(local->name, name)) {
+            return local;
+        }
+    }
+    return NULL;
+}
+
+static inline void declareLocal(Compiler* compiler, khstring* name, uint16_t reg, Type type) {
+    kharray_append(&compiler->locals, ((Local){.name = name, .reg = reg, .type = type}));
+}
+
+static inline size_t findFunction(Compiler* compiler, khstring* name) {
+    FunctionEntry* entry = khhashmap_find(&compiler->functions, *name);
+    return entry != NULL ? entry->index : SIZE_MAX;
+}
+
+static inline bool isBuiltin(khstring* name) {
+    return khstring_equalCstring(name, U"print") || khstring_equalCstring(name, U"int") ||
+           khstring_equalCstring(name, U"float");
+}
+
+
+static Type compileType(khAstExpression* type) {
+    if (type->type == khAstExpressionType_IDENTIFIER) {
+        if (khstring_equalCstring(&type->identifier, U"int")) {
+            return Type_INT;
+        }
+        else if (khstring_equalCstring(&type->identifier, U"float") ||
+                 khstring_equalCstring(&type->identifier, U"double")) {
+            return Type_FLOAT;
+        }
+        else if (khstring_equalCstring(&type->identifier, U"bool")) {
+            return Type_BOOL;
+        }
+    }
+
+    raiseError(type->begin, U"unsupported type, only int, float, double and bool are for now");
+    return Type_INVALID;
+}
+
+// Into the destination, or any register, only implicitly converting ints to floats
+static Operand coerce(Compiler* compiler, Operand operand, Type type, int32_t dest) {
+    if (operand.type == Type_INVALID || type == Type_INVALID) {
+        return (Operand){.reg = dest >= 0 ? (uint16_t)dest : operand.reg, .type = type};
+    }
+    else if (operand.type == type) {
+        if (dest >= 0 && operand.reg != dest) {
+            emitRegisters(compiler, khOpcode_MOVE, dest, operand.reg, 0);
+            operand.reg = dest;
+        }
+        return operand;
+    }
+    else if (operand.type == Type_INT && type == Type_FLOAT) {
+        uint16_t reg = target(compiler, dest);
+        emitRegisters(compiler, khOpcode_INT_TO_FLOAT, reg, operand.reg, 0);
+        return (Operand){.reg = reg, .type = Type_FLOAT};
+    }
+    else {
+        raiseTypeError(compiler->position, type_names[type], operand.type);
+        return (Operand){.reg = dest >= 0 ? (uint16_t)dest : operand.reg, .type = Type_INVALID};
+    }
+}
+
+// Conditions are bools, or ints which aren't 0
+static Operand toCondition(Compiler* compiler, Operand operand) {
+    if (operand.type != Type_INVALID && operand.type != Type_BOOL && operand.type != Type_INT) {
+        raiseTypeError(compiler->position, U"a bool or an int", operand.type);
+    }
+    return operand;
+}
+
+static Operand toBool(Compiler* compiler, Operand operand, int32_t dest) {
+    if (toCondition(compiler, operand).type == Type_INT) {
+        uint16_t reg = target(compiler, dest);
+        emitRegisters(compiler, khOpcode_TO_BOOL, reg, operand.reg, 0);
+        return (Operand){.reg = reg, .type = Type_BOOL};
+    }
+    return coerce(compiler, operand, operand.type == Type_INVALID ? Type_INVALID : Type_BOOL, dest);
+}
+
+
+static Operand compileExpression(Compiler* compiler, khAstExpression* expression, int32_t dest);
+
+static inline Operand compileOperand(Compiler* compiler, khAstExpression* expression) {
+    return compileExpression(compiler, expression, -1);
+}
+
+static Operand loadInt(Compiler* compiler, int64_t value, int32_t dest) {
+    uint16_t reg = target(compiler, dest);
+    if (value >= INT32_MIN && value <= INT32_MAX) {
+        emitWide(compiler, khOpcode_LOAD_INT, reg, (int32_t)value);
+    }
+    else {
+        emitWide(compiler, khOpcode_LOAD_CONSTANT, reg, kharray_size(&compiler->bytecode->constants));
+        kharray_append(&compiler->bytecode->constants, ((khValue){.integer = value}));
+    }
+    return (Operand){.reg = reg, .type = Type_INT};
+}
+
+static Operand loadFloat(Compiler* compiler, double value, int32_t dest) {
+    uint16_t reg = target(compiler, dest);
+    emitWide(compiler, khOpcode_LOAD_CONSTANT, reg, kharray_size(&compiler->bytecode->constants));
+    kharray_append(&compiler->bytecode->constants, ((khValue){.float_v = value}));
+    return (Operand){.reg = reg, .type = Type_FLOAT};
+}
+
+static Operand compileIdentifier(Compiler* compiler, khstring* name, int32_t dest) {
+    Local* local = findLocal(compiler, name);
+    if (local != NULL) {
+        return coerce(compiler, (Operand){.reg = local->reg, .type = local->type}, local->type, dest);
+    }
+    else if (khstring_equalCstring(name, U"true") || khstring_equalCstring(name, U"false")) {
+        Operand operand = loadInt(compiler, khstring_equalCstring(name, U"true"), dest);
+        operand.type = Type_BOOL;
+        return operand;
+    }
+
+    raiseNameError(compiler->position, U"unknown variable", name);
+    return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+}
+
+static Operand compileUnary(Compiler* compiler, khAstUnaryExpression* unary_exp, int32_t dest) {
+    size_t top = compiler->top;
+    Operand operand = compileOperand(compiler, unary_exp->operand);
+    compiler->top = top;
+    uint16_t reg = target(compiler, dest);
+
+    if (operand.type == Type_INVALID) {
+        return (Operand){.reg = reg, .type = Type_INVALID};
+    }
+
+    switch (unary_exp->type) {
+        case khAstUnaryExpressionType_POSITIVE:
+        case khAstUnaryExpressionType_NEGATIVE:
+            if (operand.type != Type_INT && operand.type != Type_FLOAT) {
+                raiseTypeError(compiler->position, U"an int or a float", operand.type);
+                return (Operand){.reg = reg, .type = Type_INVALID};
+            }
+
+            if (unary_exp->type == khAstUnaryExpressionType_POSITIVE) {
+                return coerce(compiler, operand, operand.type, reg);
+            }
+            emitRegisters(compiler,
+                          operand.type == Type_INT ? khOpcode_NEGATE_INT : khOpcode_NEGATE_FLOAT, reg,
+                          operand.reg, 0);
+            return (Operand){.reg = reg, .type = operand.type};
+
+        case khAstUnaryExpressionType_NOT:
+            if (toCondition(compiler, operand).type == Type_INVALID) {
+                return (Operand){.reg = reg, .type = Type_INVALID};
+            }
+            emitRegisters(compiler, khOpcode_NOT, reg, operand.reg, 0);
+            return (Operand){.reg = reg, .type = Type_BOOL};
+
+        case khAstUnaryExpressionType_BIT_NOT:
+            if (operand.type != Type_INT) {
+                raiseTypeError(compiler->position, U"an int", operand.type);
+                return (Operand){.reg = reg, .type = Type_INVALID};
+            }
+            emitRegisters(compiler, khOpcode_BIT_NOT, reg, operand.reg, 0);
+            return (Operand){.reg = reg, .type = Type_INT};
+
+        default:
+            return (Operand){.reg = reg, .type = Type_INVALID};
+    }
+}
+
+// Opcodes of an arithmetic or bitwise operation, for ints and floats; bitwise ones don't have any for
+// floats, being `khOpcode_COUNT`. In-place operations have the same ones as what they're in place of
+static bool arithmeticOpcodes(khAstBinaryExpressionType type, khOpcode* int_opcode,
+                              khOpcode* float_opcode) {
+    *float_opcode = khOpcode_COUNT;
+
+    switch (type) {
+        case khAstBinaryExpressionType_ADD:
+        case khAstBinaryExpressionType_IP_ADD:
+            *int_opcode = khOpcode_ADD_INT;
+            *float_opcode = khOpcode_ADD_FLOAT;
+            return true;
+        case khAstBinaryExpressionType_SUB:
+        case khAstBinaryExpressionType_IP_SUB:
+            *int_opcode = khOpcode_SUB_INT;
+            *float_opcode = khOpcode_SUB_FLOAT;
+            return true;
+        case khAstBinaryExpressionType_MUL:
+        case khAstBinaryExpressionType_IP_MUL:
+            *int_opcode = khOpcode_MUL_INT;
+            *float_opcode = khOpcode_MUL_FLOAT;
+            return true;
+        case khAstBinaryExpressionType_DIV:
+        case khAstBinaryExpressionType_IP_DIV:
+            *int_opcode = khOpcode_DIV_INT;
+            *float_opcode = khOpcode_DIV_FLOAT;
+            return true;
+        case khAstBinaryExpressionType_MOD:
+        case khAstBinaryExpressionType_IP_MOD:
+            *int_opcode = khOpcode_MOD_INT;
+            *float_opcode = khOpcode_MOD_FLOAT;
+            return true;
+        case khAstBinaryExpressionType_POW:
+        case khAstBinaryExpressionType_IP_POW:
+            *int_opcode = khOpcode_POW_INT;
+            *float_opcode = khOpcode_POW_FLOAT;
+            return true;
+
+        case khAstBinaryExpressionType_BIT_AND:
+        case khAstBinaryExpressionType_IP_BIT_AND:
+            *int_opcode = khOpcode_BIT_AND;
+            return true;
+        case khAstBinaryExpressionType_BIT_OR:
+        case khAstBinaryExpressionType_IP_BIT_OR:
+            *int_opcode = khOpcode_BIT_OR;
+            return true;
+        case khAstBinaryExpressionType_BIT_XOR:
+        case khAstBinaryExpressionType_IP_BIT_XOR:
+            *int_opcode = khOpcode_BIT_XOR;
+            return true;
+        case khAstBinaryExpressionType_BIT_LSHIFT:
+        case khAstBinaryExpressionType_IP_BIT_LSHIFT:
+            *int_opcode = khOpcode_BIT_LSHIFT;
+            return true;
+        case khAstBinaryExpressionType_BIT_RSHIFT:
+        case khAstBinaryExpressionType_IP_BIT_RSHIFT:
+            *int_opcode = khOpcode_BIT_RSHIFT;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// Both ints, or floats with an int converted if there's one; `top` is of before the operands, given
+// back once they're used
+static Operand emitArithmetic(Compiler* compiler, khOpcode int_opcode, khOpcode float_opcode,
+                              Operand left, Operand right, size_t top, int32_t dest) {
+    if (left.type == Type_INVALID || right.type == Type_INVALID) {
+        compiler->top = top;
+        return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+    }
+
+    bool is_float = float_opcode != khOpcode_COUNT;
+    if (left.type != Type_INT && (!is_float || left.type != Type_FLOAT)) {
+        raiseTypeError(compiler->position, is_float ? U"an int or a float" : U"an int", left.type);
+        compiler->top = top;
+        return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+    }
+    else if (right.type != Type_INT && (!is_float || right.type != Type_FLOAT)) {
+        raiseTypeError(compiler->position, is_float ? U"an int or a float" : U"an int", right.type);
+        compiler->top = top;
+        return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+    }
+
+    Type type = left.type == Type_FLOAT || right.type == Type_FLOAT ? Type_FLOAT : Type_INT;
+    left = coerce(compiler, left, type, -1);
+    right = coerce(compiler, right, type, -1);
+
+    compiler->top = top;
+    uint16_t reg = target(compiler, dest);
+    emitRegisters(compiler, type == Type_INT ? int_opcode : float_opcode, reg, left.reg, right.reg);
+    return (Operand){.reg = reg, .type = type};
+}
+
+// Anything assigned is to a variable, for now
+static Local* findAssignee(Compiler* compiler, khAstExpression* assignee) {
+    if (assignee->type != khAstExpressionType_IDENTIFIER) {
+        raiseError(assignee->begin, U"only variables can be assigned to for now");
+        return NULL;
+    }
+
+    Local* local = findLocal(compiler, &assignee->identifier);
+    if (local == NULL) {
+        raiseNameError(assignee->begin, U"unknown variable", &assignee->identifier);
+    }
+    return local;
+}
+
+// Whether an expression only writes its destination with its last instruction, so what it assigns to
+// can be its destination even if it reads it
+static bool writesOnceAtEnd(khAstExpression* expression) {
+    switch (expression->type) {
+        case khAstExpressionType_TERNARY:
+            return false;
+        case khAstExpressionType_COMPARISON:
+            return kharray_size(&expression->comparison.operations) == 1;
+        case khAstExpressionType_BINARY:
+            return expression->binary.type != khAstBinaryExpressionType_AND &&
+                   expression->binary.type != khAstBinaryExpressionType_OR;
+        default:
+            return true;
+    }
+}
+
+static Operand compileAssignment(Compiler* compiler, khAstBinaryExpression* binary_exp, int32_t dest) {
+    Local* local = findAssignee(compiler, binary_exp->left);
+    if (local == NULL) {
+        compileOperand(compiler, binary_exp->right);
+        return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+    }
+    Operand assignee = {.reg = local->reg, .type = local->type};
+
+    size_t top = compiler->top;
+    if (writesOnceAtEnd(binary_exp->right)) {
+        coerce(compiler, compileExpression(compiler, binary_exp->right, assignee.reg), assignee.type,
+               assignee.reg);
+    }
+    else {
+        coerce(compiler, compileOperand(compiler, binary_exp->right), assignee.type, assignee.reg);
+    }
+    compiler->top = top;
+
+    return coerce(compiler, assignee, assignee.type, dest);
+}
+
+static Operand compileInPlace(Compiler* compiler, khAstBinaryExpression* binary_exp, int32_t dest) {
+    khOpcode int_opcode, float_opcode;
+    arithmeticOpcodes(binary_exp->type, &int_opcode, &float_opcode);
+
+    Local* local = findAssignee(compiler, binary_exp->left);
+    size_t top = compiler->top;
+    Operand value = compileOperand(compiler, binary_exp->right);
+    if (local == NULL) {
+        compiler->top = top;
+        return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+    }
+
+    Operand assignee = {.reg = local->reg, .type = local->type};
+    if (assignee.type == Type_INT && value.type == Type_FLOAT) {
+        raiseTypeError(compiler->position, type_names[Type_INT], Type_FLOAT);
+        compiler->top = top;
+        return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+    }
+
+    emitArithmetic(compiler, int_opcode, float_opcode, assignee, value, top, assignee.reg);
+    return coerce(compiler, assignee, assignee.type, dest);
+}
+
+// Short-circuiting, both sides into the same register
+static Operand compileLogical(Compiler* compiler, khAstBinaryExpression* binary_exp, int32_t dest) {
+    uint16_t reg = target(compiler, dest);
+    size_t top = compiler->top;
+
+    Operand left = toBool(compiler, compileExpression(compiler, binary_exp->left, reg), reg);
+    size_t jump = emitWide(compiler,
+                           binary_exp->type == khAstBinaryExpressionType_AND ? khOpcode_JUMP_UNLESS
+                                                                            : khOpcode_JUMP_IF,
+                           reg, 0);
+    compiler->top = top;
+
+    Operand right = toBool(compiler, compileExpression(compiler, binary_exp->right, reg), reg);
+    patchJump(compiler, jump, here(compiler));
+    compiler->top = top;
+
+    bool is_invalid = left.type == Type_INVALID || right.type == Type_INVALID;
+    return (Operand){.reg = reg, .type = is_invalid ? Type_INVALID : Type_BOOL};
+}
+
+static Operand compileBinary(Compiler* compiler, khAstBinaryExpression* binary_exp, int32_t dest) {
+    khOpcode int_opcode, float_opcode;
+
+    switch (binary_exp->type) {
+        case khAstBinaryExpressionType_ASSIGN:
+            return compileAssignment(compiler, binary_exp, dest);
+
+        case khAstBinaryExpressionType_IP_ADD:
+        case khAstBinaryExpressionType_IP_SUB:
+        case khAstBinaryExpressionType_IP_MUL:
+        case khAstBinaryExpressionType_IP_DIV:
+        case khAstBinaryExpressionType_IP_MOD:
+        case khAstBinaryExpressionType_IP_POW:
+        case khAstBinaryExpressionType_IP_BIT_AND:
+        case khAstBinaryExpressionType_IP_BIT_OR:
+        case khAstBinaryExpressionType_IP_BIT_XOR:
+        case khAstBinaryExpressionType_IP_BIT_LSHIFT:
+        case khAstBinaryExpressionType_IP_BIT_RSHIFT:
+            return compileInPlace(compiler, binary_exp, dest);
+
+        case khAstBinaryExpressionType_AND:
+        case khAstBinaryExpressionType_OR:
+            return compileLogical(compiler, binary_exp, dest);
+
+        case khAstBinaryExpressionType_XOR: {
+            size_t top = compiler->top;
+            Operand left = toBool(compiler, compileOperand(compiler, binary_exp->left), -1);
+            Operand right = toBool(compiler, compileOperand(compiler, binary_exp->right), -1);
+            compiler->top = top;
+
+            uint16_t reg = target(compiler, dest);
+            if (left.type == Type_INVALID || right.type == Type_INVALID) {
+                return (Operand){.reg = reg, .type = Type_INVALID};
+            }
+            emitRegisters(compiler, khOpcode_UNEQUAL_INT, reg, left.reg, right.reg);
+            return (Operand){.reg = reg, .type = Type_BOOL};
+        }
+
+        case khAstBinaryExpressionType_RANGE:
+            raiseError(compiler->position, U"ranges are only iterated over by for loops for now");
+            return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+
+        default:
+            if (!arithmeticOpcodes(binary_exp->type, &int_opcode, &float_opcode)) {
+                raiseError(compiler->position, U"unsupported operator for now");
+                return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+            }
+
+            size_t top = compiler->top;
+            Operand left = compileOperand(compiler, binary_exp->left);
+            Operand right = compileOperand(compiler, binary_exp->right);
+            return emitArithmetic(compiler, int_opcode, float_opcode, left, right, top, dest);
+    }
+}
+
+// The values must be of the same type, as the other one isn't known while either is compiled
+static Operand compileTernary(Compiler* compiler, khAstTernaryExpression* ternary_exp, int32_t dest) {
+    uint16_t reg = target(compiler, dest);
+    size_t top = compiler->top;
+
+    Operand condition = toCondition(compiler, compileOperand(compiler, ternary_exp->condition));
+    size_t to_otherwise = emitWide(compiler, khOpcode_JUMP_UNLESS, condition.reg, 0);
+    compiler->top = top;
+
+    Operand value = compileExpression(compiler, ternary_exp->value, reg);
+    size_t to_end = emitWide(compiler, khOpcode_JUMP, 0, 0);
+    compiler->top = top;
+
+    patchJump(compiler, to_otherwise, here(compiler));
+    Operand otherwise = compileExpression(compiler, ternary_exp->otherwise, reg);
+    patchJump(compiler, to_end, here(compiler));
+    compiler->top = top;
+
+    if (condition.type == Type_INVALID || value.type == Type_INVALID ||
+        otherwise.type == Type_INVALID) {
+        return (Operand){.reg = reg, .type = Type_INVALID};
+    }
+    else if (value.type != otherwise.type) {
+        raiseTypeError(ternary_exp->otherwise->begin, type_names[value.type], otherwise.type);
+        return (Operand){.reg = reg, .type = Type_INVALID};
+    }
+    return (Operand){.reg = reg, .type = value.type};
+}
+
+static Type emitComparison(Compiler* compiler, khAstComparisonExpressionType operation, Operand left,
+                           Operand right, uint16_t reg) {
+    if (left.type == Type_INVALID || right.type == Type_INVALID) {
+        return Type_INVALID;
+    }
+
+    bool is_equality = operation == khAstComparisonExpressionType_EQUAL ||
+                       operation == khAstComparisonExpressionType_UNEQUAL;
+    bool is_number = (left.type == Type_INT || left.type == Type_FLOAT) &&
+                     (right.type == Type_INT || right.type == Type_FLOAT);
+    bool are_bools = left.type == Type_BOOL && right.type == Type_BOOL;
+
+    if (!is_number && !(is_equality && are_bools)) {
+        raiseTypeError(compiler->position, is_equality ? U"ints, floats or bools" : U"ints or floats",
+                       left.type == Type_INT || left.type == Type_FLOAT || left.type == Type_BOOL
+                           ? right.type
+                           : left.type);
+        return Type_INVALID;
+    }
+
+    bool is_float = left.type == Type_FLOAT || right.type == Type_FLOAT;
+    if (is_float) {
+        left = coerce(compiler, left, Type_FLOAT, -1);
+        right = coerce(compiler, right, Type_FLOAT, -1);
+    }
+
+    // Greater ones are less ones, the other way around
+    if (operation == khAstComparisonExpressionType_GREATER ||
+        operation == khAstComparisonExpressionType_GREATER_EQUAL) {
+        Operand swap = left;
+        left = right;
+        right = swap;
+    }
+
+    khOpcode opcode;
+    switch (operation) {
+        case khAstComparisonExpressionType_EQUAL:
+            opcode = is_float ? khOpcode_EQUAL_FLOAT : khOpcode_EQUAL_INT;
+            break;
+        case khAstComparisonExpressionType_UNEQUAL:
+            opcode = is_float ? khOpcode_UNEQUAL_FLOAT : khOpcode_UNEQUAL_INT;
+            break;
+        case khAstComparisonExpressionType_LESS:
+        case khAstComparisonExpressionType_GREATER:
+            opcode = is_float ? khOpcode_LESS_FLOAT : khOpcode_LESS_INT;
+            break;
+        default:
+            opcode = is_float ? khOpcode_LESS_EQUAL_FLOAT : khOpcode_LESS_EQUAL_INT;
+            break;
+    }
+
+    emitRegisters(compiler, opcode, reg, left.reg, right.reg);
+    return Type_BOOL;
+}
+
+// Chained ones stop at the first false one, each operand being compiled once
+static Operand compileComparison(Compiler* compiler, khAstComparisonExpression* comparison_exp,
+                                 int32_t dest) {
+    uint16_t reg = target(compiler, dest);
+    size_t top = compiler->top;
+
+    kharray(size_t) exits = kharray_new(size_t, NULL);
+    Type type = Type_BOOL;
+
+    Operand left = compileOperand(compiler, &comparison_exp->operands[0]);
+    for (size_t i = 0; i < kharray_size(&comparison_exp->operations); i++) {
+        Operand right = compileOperand(compiler, &comparison_exp->operands[i + 1]);
+        if (emitComparison(compiler, comparison_exp->operations[i], left, right, reg) == Type_INVALID) {
+            type = Type_INVALID;
+        }
+
+        if (i + 1 < kharray_size(&comparison_exp->operations)) {
+            kharray_append(&exits, emitWide(compiler, khOpcode_JUMP_UNLESS, reg, 0));
+        }
+        left = right;
+    }
+
+    patchJumps(compiler, &exits, here(compiler));
+    kharray_delete(&exits);
+    compiler->top = top;
+
+    return (Operand){.reg = reg, .type = type};
+}
+
+// Each argument on a line, separated by spaces
+static Operand compilePrint(Compiler* compiler, khAstCallExpression* call_exp, int32_t dest) {
+    size_t top = compiler->top;
+    size_t count = kharray_size(&call_exp->arguments);
+
+    if (count == 0) {
+        emitRegisters(compiler, khOpcode_PRINT_CHAR, 0, U'\n', 0);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        Operand operand = compileOperand(compiler, &call_exp->arguments[i]);
+        uint16_t separator = i + 1 < count ? U' ' : U'\n';
+
+        switch (operand.type) {
+            case Type_INT:
+                emitRegisters(compiler, khOpcode_PRINT_INT, operand.reg, separator, 0);
+                break;
+            case Type_FLOAT:
+                emitRegisters(compiler, khOpcode_PRINT_FLOAT, operand.reg, separator, 0);
+                break;
+            case Type_BOOL:
+                emitRegisters(compiler, khOpcode_PRINT_BOOL, operand.reg, separator, 0);
+                break;
+            case Type_STRING:
+                emitRegisters(compiler, khOpcode_PRINT_STRING, operand.reg, separator, 0);
+                break;
+            case Type_NONE:
+                raiseError(call_exp->arguments[i].begin, U"none can't be printed");
+                break;
+            default:
+                break;
+        }
+        compiler->top = top;
+    }
+
+    return (Operand){.reg = target(compiler, dest), .type = Type_NONE};
+}
+
+// `int(x)` and `float(x)`, from ints, floats or bools
+static Operand compileConversion(Compiler* compiler, khAstCallExpression* call_exp, Type type,
+                                 int32_t dest) {
+    if (kharray_size(&call_exp->arguments) != 1) {
+        raiseError(compiler->position, U"expecting a single argument to convert");
+        return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+    }
+
+    size_t top = compiler->top;
+    Operand operand = compileOperand(compiler, &call_exp->arguments[0]);
+    compiler->top = top;
+    uint16_t reg = target(compiler, dest);
+
+    switch (operand.type) {
+        case Type_INT:
+        case Type_BOOL:
+            if (type == Type_FLOAT) {
+                emitRegisters(compiler, khOpcode_INT_TO_FLOAT, reg, operand.reg, 0);
+                return (Operand){.reg = reg, .type = type};
+            }
+            operand.type = Type_INT;
+            return coerce(compiler, operand, type, reg);
+
+        case Type_FLOAT:
+            if (type == Type_INT) {
+                emitRegisters(compiler, khOpcode_FLOAT_TO_INT, reg, operand.reg, 0);
+                return (Operand){.reg = reg, .type = type};
+            }
+            return coerce(compiler, operand, type, reg);
+
+        case Type_INVALID:
+            return (Operand){.reg = reg, .type = Type_INVALID};
+
+        default:
+            raiseTypeError(call_exp->arguments[0].begin, U"an int, a float or a bool", operand.type);
+            return (Operand){.reg = reg, .type = Type_INVALID};
+    }
+}
+
+// Arguments are put in the registers the callee's frame starts at, its return value being in the first
+static Operand compileCall(Compiler* compiler, khAstCallExpression* call_exp, int32_t dest) {
+    if (call_exp->callee->type != khAstExpressionType_IDENTIFIER) {
+        raiseError(call_exp->callee->begin, U"only functions can be called by their names for now");
+        return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+    }
+
+    khstring* name = &call_exp->callee->identifier;
+    if (khstring_equalCstring(name, U"print")) {
+        return compilePrint(compiler, call_exp, dest);
+    }
+    else if (khstring_equalCstring(name, U"int")) {
+        return compileConversion(compiler, call_exp, Type_INT, dest);
+    }
+    else if (khstring_equalCstring(name, U"float")) {
+        return compileConversion(compiler, call_exp, Type_FLOAT, dest);
+    }
+
+    size_t index = findFunction(compiler, name);
+    if (index == SIZE_MAX) {
+        raiseNameError(call_exp->callee->begin, U"unknown function", name);
+        return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+    }
+
+    Signature* signature = &compiler->signatures[index];
+    size_t count = kharray_size(&call_exp->arguments);
+    if (count != kharray_size(&signature->arguments)) {
+        raiseNameError(compiler->position, U"wrong number of arguments to", name);
+        return (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+    }
+
+    // Even without any arguments, its frame starts with a register for what it returns
+    size_t top = compiler->top;
+    uint16_t base = allocate(compiler);
+    for (size_t i = 0; i < count; i++) {
+        uint16_t reg = i == 0 ? base : allocate(compiler);
+        Operand argument = compileExpression(compiler, &call_exp->arguments[i], reg);
+        coerce(compiler, argument, signature->arguments[i], reg);
+        compiler->top = reg + 1;
+    }
+
+    emitWide(compiler, khOpcode_CALL, base, index + 1);
+    compiler->top = top;
+
+    Type type = signature->return_type;
+    if (dest >= 0) {
+        if (type != Type_NONE) {
+            emitRegisters(compiler, khOpcode_MOVE, dest, base, 0);
+        }
+        return (Operand){.reg = dest, .type = type};
+    }
+    compiler->top = base + 1;
+    return (Operand){.reg = base, .type = type};
+}
+
+static Operand compileExpression(Compiler* compiler, khAstExpression* expression, int32_t dest) {
+    uint8_t* position = compiler->position;
+    compiler->position = expression->begin;
+    Operand operand;
+
+    switch (expression->type) {
+        case khAstExpressionType_IDENTIFIER:
+            operand = compileIdentifier(compiler, &expression->identifier, dest);
+            break;
+
+        case khAstExpressionType_CHAR:
+            operand = loadInt(compiler, expression->char_v, dest);
+            break;
+        case khAstExpressionType_BYTE:
+            operand = loadInt(compiler, expression->byte, dest);
+            break;
+        case khAstExpressionType_INTEGER:
+            operand = loadInt(compiler, expression->integer, dest);
+            break;
+        case khAstExpressionType_UINTEGER:
+            if (expression->uinteger > INT64_MAX) {
+                raiseError(expression->begin, U"this integer is too large for an int");
+            }
+            operand = loadInt(compiler, (int64_t)expression->uinteger, dest);
+            break;
+        case khAstExpressionType_FLOAT:
+            operand = loadFloat(compiler, expression->float_v, dest);
+            break;
+        case khAstExpressionType_DOUBLE:
+            operand = loadFloat(compiler, expression->double_v, dest);
+            break;
+
+        case khAstExpressionType_STRING:
+            operand = (Operand){.reg = target(compiler, dest), .type = Type_STRING};
+            emitWide(compiler, khOpcode_LOAD_STRING, operand.reg,
+                     kharray_size(&compiler->bytecode->strings));
+            kharray_append(&compiler->bytecode->strings, khstring_copy(&expression->string));
+            break;
+
+        case khAstExpressionType_UNARY:
+            operand = compileUnary(compiler, &expression->unary, dest);
+            break;
+        case khAstExpressionType_BINARY:
+            operand = compileBinary(compiler, &expression->binary, dest);
+            break;
+        case khAstExpressionType_TERNARY:
+            operand = compileTernary(compiler, &expression->ternary, dest);
+            break;
+        case khAstExpressionType_COMPARISON:
+            operand = compileComparison(compiler, &expression->comparison, dest);
+            break;
+        case khAstExpressionType_CALL:
+            operand = compileCall(compiler, &expression->call, dest);
+            break;
+
+        case khAstExpressionType_INVALID:
+            operand = (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+            break;
+
+        default:
+            raiseError(expression->begin, U"unsupported expression for now");
+            operand = (Operand){.reg = target(compiler, dest), .type = Type_INVALID};
+            break;
+    }
+
+    compiler->position = position;
+    return operand;
+}
+
+
+static void compileStatement(Compiler* compiler, khAstStatement* statement);
+
+// Its variables and temporaries are gone after it
+static void compileBlock(Compiler* compiler, kharray(khAstStatement) * block) {
+    size_t locals = kharray_size(&compiler->locals);
+    size_t top = compiler->top;
+    compiler->depth++;
+
+    for (size_t i = 0; i < kharray_size(block); i++) {
+        compileStatement(compiler, &(*block)[i]);
+    }
+
+    compiler->depth--;
+    kharray_pop(&compiler->locals, kharray_size(&compiler->locals) - locals);
+    compiler->top = top;
+}
+
+static void compileVariable(Compiler* compiler, khAstVariable* variable, uint8_t* position) {
+    if (kharray_size(&variable->names) != 1) {
+        raiseError(position, U"only a single variable can be declared at once for now");
+        return;
+    }
+    else if (variable->is_static || variable->is_wild || variable->is_ref) {
+        raiseError(position, U"static, wild and ref variables are unsupported for now");
+    }
+
+    Type type = variable->opt_type != NULL ? compileType(variable->opt_type) : Type_INVALID;
+    uint16_t reg = allocate(compiler);
+
+    // The initializer doesn't see the variable yet
+    if (variable->opt_initializer != NULL) {
+        Operand operand = compileExpression(compiler, variable->opt_initializer, reg);
+        if (variable->opt_type != NULL) {
+            coerce(compiler, operand, type, reg);
+        }
+        else if (operand.type == Type_NONE) {
+            raiseError(variable->opt_initializer->begin, U"a variable can't be of none");
+            type = Type_INVALID;
+        }
+        else {
+            type = operand.type;
+        }
+    }
+    else if (variable->opt_type != NULL) {
+        emitWide(compiler, type == Type_FLOAT ? khOpcode_LOAD_CONSTANT : khOpcode_LOAD_INT, reg,
+                 type == Type_FLOAT ? (int32_t)kharray_size(&compiler->bytecode->constants) : 0);
+        if (type == Type_FLOAT) {
+            kharray_append(&compiler->bytecode->constants, ((khValue){.float_v = 0}));
+        }
+    }
+    else {
+        raiseError(position, U"expecting either a type or an initializer for the variable");
+    }
+
+    compiler->top = reg + 1;
+    declareLocal(compiler, &variable->names[0], reg, type);
+}
+
+static void compileIfBranch(Compiler* compiler, khAstIfBranch* if_branch) {
+    kharray(size_t) exits = kharray_new(size_t, NULL);
+    size_t count = kharray_size(&if_branch->branch_conditions);
+
+    for (size_t i = 0; i < count; i++) {
+        size_t top = compiler->top;
+        Operand condition =
+            toCondition(compiler, compileOperand(compiler, &if_branch->branch_conditions[i]));
+        size_t to_next = emitWide(compiler, khOpcode_JUMP_UNLESS, condition.reg, 0);
+        compiler->top = top;
+
+        compileBlock(compiler, &if_branch->branch_blocks[i]);
+        if (i + 1 < count || kharray_size(&if_branch->else_block) > 0) {
+            kharray_append(&exits, emitWide(compiler, khOpcode_JUMP, 0, 0));
+        }
+        patchJump(compiler, to_next, here(compiler));
+    }
+
+    compileBlock(compiler, &if_branch->else_block);
+    patchJumps(compiler, &exits, here(compiler));
+    kharray_delete(&exits);
+}
+
+static inline void pushLoop(Compiler* compiler) {
+    Loop loop = {.breaks = kharray_new(size_t, NULL), .continues = kharray_new(size_t, NULL)};
+    kharray_append(&compiler->loops, loop);
+}
+
+static inline void popLoop(Compiler* compiler, size_t continue_target, size_t break_target) {
+    Loop* loop = &compiler->loops[kharray_size(&compiler->loops) - 1];
+    patchJumps(compiler, &loop->continues, continue_target);
+    patchJumps(compiler, &loop->breaks, break_target);
+    kharray_pop(&compiler->loops, 1);
+}
+
+// Conditions are at the bottom of loops, so each iteration only jumps once
+static void compileWhileLoop(Compiler* compiler, khAstWhileLoop* while_loop) {
+    size_t to_condition = emitWide(compiler, khOpcode_JUMP, 0, 0);
+    size_t body = here(compiler);
+    pushLoop(compiler);
+    compileBlock(compiler, &while_loop->block);
+
+    size_t condition_start = here(compiler);
+    patchJump(compiler, to_condition, condition_start);
+
+    size_t top = compiler->top;
+    Operand condition = toCondition(compiler, compileOperand(compiler, &while_loop->condition));
+    emitJump(compiler, khOpcode_JUMP_IF, condition.reg, body);
+    compiler->top = top;
+
+    popLoop(compiler, condition_start, here(compiler));
+}
+
+static void compileDoWhileLoop(Compiler* compiler, khAstDoWhileLoop* do_while_loop) {
+    size_t body = here(compiler);
+    pushLoop(compiler);
+    compileBlock(compiler, &do_while_loop->block);
+
+    size_t condition_start = here(compiler);
+    size_t top = compiler->top;
+    Operand condition = toCondition(compiler, compileOperand(compiler, &do_while_loop->condition));
+    emitJump(compiler, khOpcode_JUMP_IF, condition.reg, body);
+    compiler->top = top;
+
+    popLoop(compiler, condition_start, here(compiler));
+}
+
+// Only over ranges of ints, excluding their ends, which are only evaluated once
+static void compileForLoop(Compiler* compiler, khAstForLoop* for_loop, uint8_t* position) {
+    if (kharray_size(&for_loop->iterators) != 1) {
+        raiseError(position, U"expecting a single iterator for now");
+        return;
+    }
+    else if (for_loop->iteratee.type != khAstExpressionType_BINARY ||
+             for_loop->iteratee.binary.type != khAstBinaryExpressionType_RANGE) {
+        raiseError(for_loop->iteratee.begin, U"only ranges can be iterated over for now");
+        return;
+    }
+
+    size_t locals = kharray_size(&compiler->locals);
+    size_t top = compiler->top;
+
+    uint16_t iterator = allocate(compiler);
+    coerce(compiler, compileExpression(compiler, for_loop->iteratee.binary.left, iterator), Type_INT,
+           iterator);
+    compiler->top = iterator + 1;
+    uint16_t end = allocate(compiler);
+    coerce(compiler, compileExpression(compiler, for_loop->iteratee.binary.right, end), Type_INT, end);
+    compiler->top = end + 1;
+
+    declareLocal(compiler, &for_loop->iterators[0], iterator, Type_INT);
+    declareLocal(compiler, NULL, end, Type_INT);
+
+    size_t to_condition = emitWide(compiler, khOpcode_JUMP, 0, 0);
+    size_t body = here(compiler);
+    pushLoop(compiler);
+    compileBlock(compiler, &for_loop->block);
+
+    size_t step = here(compiler);
+    emitRegisters(compiler, khOpcode_ADD_INT_IMMEDIATE, iterator, iterator, 1);
+    patchJump(compiler, to_condition, here(compiler));
+
+    uint16_t condition = allocate(compiler);
+    emitRegisters(compiler, khOpcode_LESS_INT, condition, iterator, end);
+    emitJump(compiler, khOpcode_JUMP_IF, condition, body);
+    popLoop(compiler, step, here(compiler));
+
+    kharray_pop(&compiler->locals, kharray_size(&compiler->locals) - locals);
+    compiler->top = top;
+}
+
+static void compileJump(Compiler* compiler, bool is_break, uint8_t* position) {
+    if (kharray_size(&compiler->loops) == 0) {
+        raiseError(position, is_break ? U"break outside of a loop" : U"continue outside of a loop");
+        return;
+    }
+
+    Loop* loop = &compiler->loops[kharray_size(&compiler->loops) - 1];
+    size_t jump = emitWide(compiler, khOpcode_JUMP, 0, 0);
+    kharray_append(is_break ? &loop->breaks : &loop->continues, jump);
+}
+
+static void compileReturn(Compiler* compiler, khAstReturn* return_v, uint8_t* position) {
+    size_t count = kharray_size(&return_v->values);
+    if (count > 1) {
+        raiseError(position, U"only a single value can be returned for now");
+    }
+    else if (compiler->return_type == Type_NONE) {
+        if (count > 0) {
+            raiseError(return_v->values[0].begin, compiler->function == 0
+                                                      ? U"the top-level can't return a value"
+                                                      : U"this function doesn't return a value");
+        }
+        emitRegisters(compiler, khOpcode_RETURN_NONE, 0, 0, 0);
+    }
+    else if (count == 0) {
+        raiseError(position, U"expecting a value to return");
+    }
+    else {
+        size_t top = compiler->top;
+        Operand value = coerce(compiler, compileOperand(compiler, &return_v->values[0]),
+                               compiler->return_type, -1);
+        emitRegisters(compiler, khOpcode_RETURN, value.reg, 0, 0);
+        compiler->top = top;
+    }
+}
+
+static void compileStatement(Compiler* compiler, khAstStatement* statement) {
+    compiler->position = statement->begin;
+
+    switch (statement->type) {
+        case khAstStatementType_VARIABLE:
+            compileVariable(compiler, &statement->variable, statement->begin);
+            break;
+        case khAstStatementType_EXPRESSION:
+            compileOperand(compiler, &statement->expression);
+            break;
+
+        case khAstStatementType_FUNCTION:
+            // Compiled on their own, after the top-level
+            if (compiler->function != 0 || compiler->depth > 0) {
+                raiseError(statement->begin, U"functions are only declared at the top-level for now");
+            }
+            break;
+
+        case khAstStatementType_IF_BRANCH:
+            compileIfBranch(compiler, &statement->if_branch);
+            break;
+        case khAstStatementType_WHILE_LOOP:
+            compileWhileLoop(compiler, &statement->while_loop);
+            break;
+        case khAstStatementType_DO_WHILE_LOOP:
+            compileDoWhileLoop(compiler, &statement->do_while_loop);
+            break;
+        case khAstStatementType_FOR_LOOP:
+            compileForLoop(compiler, &statement->for_loop, statement->begin);
+            break;
+        case khAstStatementType_BREAK:
+            compileJump(compiler, true, statement->begin);
+            break;
+        case khAstStatementType_CONTINUE:
+            compileJump(compiler, false, statement->begin);
+            break;
+        case khAstStatementType_RETURN:
+            compileReturn(compiler, &statement->return_v, statement->begin);
+            break;
+
+        case khAstStatementType_INVALID:
+            break;
+
+        default:
+            raiseError(statement->begin, U"unsupported statement for now");
+            break;
+    }
+
+    compiler->top = localsTop(compiler);
+}
+
+
+static void newFunction(Compiler* compiler, khstring name, size_t arguments) {
+    kharray_append(&compiler->bytecode->functions,
+                   ((khBytecodeFunction){.name = name,
+                                         .arguments = arguments,
+                                         .registers = arguments,
+                                         .code = kharray_new(khInstruction, NULL),
+                                         .positions = kharray_new(uint8_t*, NULL)}));
+}
+
+// Every function has a signature, even with errors, so calls to it don't raise more
+static void declareFunction(Compiler* compiler, khAstStatement* statement) {
+    khAstFunction* function = &statement->function;
+    khstring* name = &function->identifiers[0];
+
+    if (kharray_size(&function->identifiers) != 1) {
+        raiseError(statement->begin, U"only functions with single names are supported for now");
+    }
+    else if (isBuiltin(name) || findFunction(compiler, name) != SIZE_MAX) {
+        raiseNameError(statement->begin, U"redeclared function", name);
+    }
+
+    if (kharray_size(&function->template_arguments) > 0 || function->opt_variadic_argument != NULL ||
+        function->is_return_type_ref || function->is_incase || function->is_static) {
+        raiseError(statement->begin, U"only plain functions are supported for now");
+    }
+
+    Signature signature = {.name = name,
+                           .arguments = kharray_new(Type, NULL),
+                           .return_type = function->opt_return_type != NULL
+                                              ? compileType(function->opt_return_type)
+                                              : Type_NONE};
+
+    for (size_t i = 0; i < kharray_size(&function->arguments); i++) {
+        khAstVariable* argument = &function->arguments[i];
+        Type type = Type_INVALID;
+
+        if (argument->opt_type == NULL || argument->opt_initializer != NULL || argument->is_ref ||
+            argument->is_wild || argument->is_static) {
+            raiseError(statement->begin, U"arguments are only of plain types for now");
+        }
+        else {
+            type = compileType(argument->opt_type);
+        }
+        kharray_append(&signature.arguments, type);
+    }
+
+    // Redeclared ones keep the first's name, for the calls
+    if (findFunction(compiler, name) == SIZE_MAX) {
+        khhashmap_put(&compiler->functions,
+                      ((FunctionEntry){.key = *name, .index = kharray_size(&compiler->signatures)}));
+    }
+
+    newFunction(compiler, khstring_copy(name), kharray_size(&signature.arguments));
+    kharray_append(&compiler->signatures, signature);
+}
+
+static void compileFunction(Compiler* compiler, size_t index, khAstStatement* statement) {
+    Signature* signature = &compiler->signatures[index];
+    khAstFunction* function = &statement->function;
+
+    compiler->function = index + 1;
+    compiler->return_type = signature->return_type;
+    compiler->position = statement->begin;
+    compiler->top = 0;
+    kharray_pop(&compiler->locals, kharray_size(&compiler->locals));
+
+    for (size_t i = 0; i < kharray_size(&signature->arguments); i++) {
+        khstring* name = &function->arguments[i].names[0];
+        declareLocal(compiler, name, allocate(compiler), signature->arguments[i]);
+    }
+
+    compileBlock(compiler, &function->block);
+    compiler->position = statement->end - 1;
+
+    // Falling off the end of one which returns a value is an error, but only if it happens
+    bool is_none = compiler->return_type == Type_NONE;
+    emitRegisters(compiler, is_none ? khOpcode_RETURN_NONE : khOpcode_MISSING_RETURN, 0, 0, 0);
+}
+
+khBytecode kh_compile(kharray(khAstStatement) * ast) {
+    khBytecode bytecode = {.functions = kharray_new(khBytecodeFunction, khBytecodeFunction_delete),
+                           .constants = kharray_new(khValue, NULL),
+                           .strings = kharray_new(khstring, khstring_delete)};
+
+    Compiler compiler = {.bytecode = &bytecode,
+                         .signatures = kharray_new(Signature, Signature_delete),
+                         .functions = khhashmap_new(FunctionEntry, khhashmap_hashString,
+                                                    khhashmap_equalString, NULL),
+                         .function = 0,
+                         .return_type = Type_NONE,
+                         .depth = 0,
+                         .locals = kharray_new(Local, NULL),
+                         .top = 0,
+                         .loops = kharray_new(Loop, Loop_delete),
+                         .position = kharray_size(ast) > 0 ? (*ast)[0].begin : NULL};
+
+    newFunction(&compiler, khstring_new(U"<top-level>"), 0);
+
+    // Declared first, so they can be called from before where they are
+    for (size_t i = 0; i < kharray_size(ast); i++) {
+        if ((*ast)[i].type == khAstStatementType_FUNCTION) {
+            declareFunction(&compiler, &(*ast)[i]);
+        }
+    }
+
+    for (size_t i = 0; i < kharray_size(ast); i++) {
+        compileStatement(&compiler, &(*ast)[i]);
+    }
+    emitRegisters(&compiler, khOpcode_RETURN_NONE, 0, 0, 0);
+
+    for (size_t i = 0, function = 0; i < kharray_size(ast); i++) {
+        if ((*ast)[i].type == khAstStatementType_FUNCTION) {
+            compileFunction(&compiler, function++, &(*ast)[i]);
+        }
+    }
+
+    kharray_delete(&compiler.signatures);
+    khhashmap_delete(&compiler.functions);
+    kharray_delete(&compiler.locals);
+    kharray_delete(&compiler.loops);
+    return bytecode;
+}
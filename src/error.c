@@ -5,13 +5,72 @@
  * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
  */
 
-#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
 
 #include <kithare/core/error.h>
 #include <kithare/lib/array.h>
+#include <kithare/lib/hashmap.h>
+#include <kithare/lib/lines.h>
+#include <kithare/lib/writer.h>
 
 
 static _Thread_local kharray(khError) error_stack = NULL;
+static size_t error_limit = 0;
+
+
+// The errors on the stack by where they are on it, hashed on their type, data and message, so a
+// duplicate is found without comparing against every error. It's built again once the stack is swapped
+// out for another, and kept as it is when the stack is truncated
+typedef struct {
+    size_t key; // Of the error on the stack
+} ErrorEntry;
+
+typedef struct {
+    khhashmap(ErrorEntry) errors; // NULL until it's first built
+    khError* stack;               // Which it was built from
+    size_t count;                 // Errors of the stack in it
+} ErrorIndex;
+
+static _Thread_local ErrorIndex error_index = {.errors = NULL, .stack = NULL, .count = 0};
+
+static uint64_t hashError(const void* key) {
+    khError* error = &error_stack[*(size_t*)key];
+    uint64_t fields[3] = {kh_hash(error->message, khstring_size(&error->message) * sizeof(char32_t)),
+                          (uint64_t)error->type, (uint64_t)(uintptr_t)error->data};
+    return kh_hash(fields, sizeof(fields));
+}
+
+static bool equalErrors(const void* a, const void* b) {
+    khError* a_error = &error_stack[*(size_t*)a];
+    khError* b_error = &error_stack[*(size_t*)b];
+    return a_error->type == b_error->type && a_error->data == b_error->data &&
+           khstring_equal(&a_error->message, &b_error->message);
+}
+
+static void clearIndex(void) {
+    if (error_index.errors != NULL) {
+        khhashmap_delete(&error_index.errors);
+    }
+
+    error_index = (ErrorIndex){.errors = NULL, .stack = NULL, .count = 0};
+}
+
+// Brings the index up to date with the stack, which might have been swapped or grown by others
+static void updateIndex(void) {
+    if (error_index.stack != error_stack || error_index.count > kharray_size(&error_stack)) {
+        clearIndex();
+        error_index.stack = error_stack;
+    }
+
+    if (error_index.errors == NULL) {
+        error_index.errors = khhashmap_new(ErrorEntry, hashError, equalErrors, NULL);
+    }
+
+    for (; error_index.count < kharray_size(&error_stack); error_index.count++) {
+        khhashmap_put(&error_index.errors, ((ErrorEntry){.key = error_index.count}));
+    }
+}
 
 
 void kh_raiseError(khError error) {
@@ -19,23 +78,25 @@ void kh_raiseError(khError error) {
         error_stack = kharray_new(khError, khError_delete);
     }
 
-    bool is_duplicate = false;
-    for (size_t i = 0; i < kharray_size(&error_stack); i++) {
-        khError* err = &error_stack[i];
-
-        if (err->type == error.type && khstring_equal(&err->message, &error.message) &&
-            err->data == error.data) {
-            is_duplicate = true;
-            break;
-        }
+    if (kh_isErrorLimitReached()) {
+        khError_delete(&error);
+        return;
     }
 
-    if (is_duplicate) {
-        khError_delete(&error);
+    // Looked up once it's on the stack, as the index only knows errors by where they are on it
+    updateIndex();
+    kharray_append(&error_stack, error);
+    size_t index = kharray_size(&error_stack) - 1;
+
+    if (khhashmap_find(&error_index.errors, index) != NULL) {
+        kharray_pop(&error_stack, 1);
     }
     else {
-        kharray_append(&error_stack, error);
+        khhashmap_put(&error_index.errors, ((ErrorEntry){.key = index}));
+        error_index.count++;
     }
+
+    error_index.stack = error_stack;
 }
 
 size_t kh_hasErrors(void) {
@@ -55,9 +116,72 @@ kharray(khError) * kh_getErrors(void) {
     return &error_stack;
 }
 
+void kh_truncateErrors(size_t size) {
+    if (error_stack == NULL || size >= kharray_size(&error_stack)) {
+        return;
+    }
+
+    // Taken out of the index while they're still on the stack, which they're hashed from
+    updateIndex();
+    for (size_t i = size; i < kharray_size(&error_stack); i++) {
+        khhashmap_remove(&error_index.errors, i);
+    }
+
+    kharray_pop(&error_stack, kharray_size(&error_stack) - size);
+    error_index.count = size;
+}
+
+kharray(khError) kh_swapErrors(kharray(khError) errors) {
+    kharray(khError) previous = *kh_getErrors();
+    error_stack = errors;
+
+    // Even for the same array, as it might have been popped and grown back to where the index was
+    clearIndex();
+    return previous;
+}
+
 void kh_flushErrors(void) {
     if (error_stack != NULL) {
         kharray_delete(&error_stack);
         error_stack = NULL;
     }
+
+    clearIndex();
+}
+
+
+void kh_setErrorLimit(size_t limit) {
+    error_limit = limit;
+}
+
+size_t kh_getErrorLimit(void) {
+    return error_limit;
+}
+
+bool kh_isErrorLimitReached(void) {
+    return error_limit > 0 && error_stack != NULL && kharray_size(&error_stack) >= error_limit;
+}
+
+
+void khError_write(khError* error, khbuffer* source, khLineTable* lines, khWriter* writer) {
+    size_t index = (uint8_t*)error->data - *source;
+    khLocation location = kh_locate(lines, source, index);
+
+    khWriter_cstring(writer, "{\"index\": ");
+    khWriter_uint(writer, index, 10);
+    khWriter_cstring(writer, ", \"line\": ");
+    khWriter_uint(writer, location.line, 10);
+    khWriter_cstring(writer, ", \"column\": ");
+    khWriter_uint(writer, location.column, 10);
+    khWriter_cstring(writer, ", \"message\": ");
+    khWriter_quote(writer, &error->message);
+    khWriter_byte(writer, '}');
+}
+
+void kh_writeErrorList(khWriter* writer, kharray(khError) * errors, khbuffer* source,
+                       khLineTable* lines) {
+    for (size_t i = 0; i < kharray_size(errors); i++) {
+        khError_write(&(*errors)[i], source, lines, writer);
+        khWriter_cstring(writer, i < kharray_size(errors) - 1 ? ",\n" : "\n");
+    }
 }
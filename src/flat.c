@@ -0,0 +1,845 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <kithare/core/ast.h>
+#include <kithare/core/flat.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/buffer.h>
+#include <kithare/lib/hashmap.h>
+#include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
+
+
+// What's left to flatten, on a stack instead of the call stack; a node's children are pushed in reverse
+// after a task to close it, so they're flattened in order before its subtree is ended
+typedef enum {
+    TaskType_STATEMENT,
+    TaskType_EXPRESSION,    // Or `NONE` for NULL, as for variables
+    TaskType_ARGUMENT_TYPE, // Of a signature, with `node` being 1 for references
+    TaskType_VARIABLE,
+    TaskType_STATEMENTS,
+    TaskType_EXPRESSIONS,
+    TaskType_VARIABLES,
+    TaskType_BLOCKS,
+    TaskType_ARGUMENT_TYPES,
+    TaskType_NAMES,
+    TaskType_CLOSE
+} TaskType;
+
+typedef struct {
+    TaskType type;
+    void* item;
+    uint32_t node; // To close
+} Task;
+
+typedef struct {
+    khstring key; // The one in the flat AST's strings
+    uint32_t index;
+} StringEntry;
+
+typedef struct {
+    khFlatAst* flat;
+    uint8_t* origin;
+    kharray(Task) tasks;
+    khhashmap(StringEntry) strings;
+} Flattener;
+
+
+static uint32_t addString(Flattener* flattener, khstring* string) {
+    StringEntry* entry = khhashmap_find(&flattener->strings, *string);
+    if (entry != NULL) {
+        return entry->index;
+    }
+
+    uint32_t index = kharray_size(&flattener->flat->strings);
+    kharray_append(&flattener->flat->strings, khstring_copy(string));
+    khhashmap_put(&flattener->strings,
+                  ((StringEntry){.key = flattener->flat->strings[index], .index = index}));
+    return index;
+}
+
+static inline uint32_t offsetOf(Flattener* flattener, uint8_t* position) {
+    return position != NULL ? (uint32_t)(position - flattener->origin) : kh_FLAT_NONE;
+}
+
+static uint32_t addNode(Flattener* flattener, khFlatKind kind) {
+    kharray_append(&flattener->flat->nodes, ((khFlatNode){.kind = kind,
+                                                           .type = 0,
+                                                           .operation = 0,
+                                                           .flags = 0,
+                                                           .begin = kh_FLAT_NONE,
+                                                           .end = kh_FLAT_NONE,
+                                                           .next = 0,
+                                                           .uinteger = 0}));
+    return kharray_size(&flattener->flat->nodes) - 1;
+}
+
+// Ends the node right away if there are no children, otherwise queues them
+static void addChildren(Flattener* flattener, uint32_t node, Task* children, size_t count) {
+    if (count == 0) {
+        flattener->flat->nodes[node].next = node + 1;
+        return;
+    }
+
+    kharray_append(&flattener->tasks, ((Task){.type = TaskType_CLOSE, .item = NULL, .node = node}));
+    for (size_t i = count; i > 0; i--) {
+        kharray_append(&flattener->tasks, children[i - 1]);
+    }
+}
+
+#define task(TYPE, ITEM) ((Task){.type = TaskType_##TYPE, .item = (void*)(ITEM), .node = 0})
+
+static void flattenNames(Flattener* flattener, kharray(khstring) * names) {
+    uint32_t node = addNode(flattener, khFlatKind_NAMES);
+    uint32_t first = kharray_size(&flattener->flat->names);
+
+    for (size_t i = 0; i < kharray_size(names); i++) {
+        uint32_t string = addString(flattener, &(*names)[i]);
+        kharray_append(&flattener->flat->names, string);
+    }
+
+    khFlatNode* flat_node = &flattener->flat->nodes[node];
+    flat_node->range.first = first;
+    flat_node->range.count = kharray_size(names);
+    flat_node->next = node + 1;
+}
+
+static void flattenList(Flattener* flattener, void* array, size_t item_size, TaskType type) {
+    uint32_t node = addNode(flattener, khFlatKind_LIST);
+    size_t count = kharray_size((void**)array);
+
+    if (count == 0) {
+        flattener->flat->nodes[node].next = node + 1;
+        return;
+    }
+
+    kharray_append(&flattener->tasks, ((Task){.type = TaskType_CLOSE, .item = NULL, .node = node}));
+    uint8_t* items = *(uint8_t**)array;
+    for (size_t i = count; i > 0; i--) {
+        kharray_append(&flattener->tasks,
+                       ((Task){.type = type, .item = items + (i - 1) * item_size, .node = 0}));
+    }
+}
+
+// Each argument type carries whether it's a reference
+static void flattenArgumentTypes(Flattener* flattener, khAstSignature* signature) {
+    uint32_t node = addNode(flattener, khFlatKind_LIST);
+    size_t count = kharray_size(&signature->argument_types);
+
+    if (count == 0) {
+        flattener->flat->nodes[node].next = node + 1;
+        return;
+    }
+
+    kharray_append(&flattener->tasks, ((Task){.type = TaskType_CLOSE, .item = NULL, .node = node}));
+    for (size_t i = count; i > 0; i--) {
+        bool is_ref = i - 1 < kharray_size(&signature->are_arguments_refs) &&
+                      signature->are_arguments_refs[i - 1];
+        kharray_append(&flattener->tasks, ((Task){.type = TaskType_ARGUMENT_TYPE,
+                                                  .item = &signature->argument_types[i - 1],
+                                                  .node = is_ref}));
+    }
+}
+
+static void flattenVariable(Flattener* flattener, khAstVariable* variable) {
+    if (variable == NULL) {
+        uint32_t node = addNode(flattener, khFlatKind_NONE);
+        flattener->flat->nodes[node].next = node + 1;
+        return;
+    }
+
+    uint32_t node = addNode(flattener, khFlatKind_VARIABLE);
+    flattener->flat->nodes[node].flags = (variable->is_static ? khFlatFlag_STATIC : 0) |
+                                         (variable->is_wild ? khFlatFlag_WILD : 0) |
+                                         (variable->is_ref ? khFlatFlag_REF : 0);
+
+    Task children[] = {task(NAMES, &variable->names), task(EXPRESSION, variable->opt_type),
+                       task(EXPRESSION, variable->opt_initializer)};
+    addChildren(flattener, node, children, 3);
+}
+
+static void flattenExpression(Flattener* flattener, khAstExpression* expression, uint8_t flags) {
+    if (expression == NULL) {
+        uint32_t node = addNode(flattener, khFlatKind_NONE);
+        flattener->flat->nodes[node].next = node + 1;
+        return;
+    }
+
+    uint32_t node = addNode(flattener, khFlatKind_EXPRESSION);
+    khFlatNode* flat_node = &flattener->flat->nodes[node];
+    flat_node->type = expression->type;
+    flat_node->flags = flags;
+    flat_node->begin = offsetOf(flattener, expression->begin);
+    flat_node->end = offsetOf(flattener, expression->end);
+
+    Task children[4];
+    size_t count = 0;
+
+    switch (expression->type) {
+        case khAstExpressionType_IDENTIFIER: {
+            uint32_t string = addString(flattener, &expression->identifier);
+            flattener->flat->nodes[node].string = string;
+        } break;
+        case khAstExpressionType_CHAR:
+            flat_node->char_v = expression->char_v;
+            break;
+        case khAstExpressionType_STRING: {
+            uint32_t string = addString(flattener, &expression->string);
+            flattener->flat->nodes[node].string = string;
+        } break;
+        case khAstExpressionType_BUFFER:
+            flat_node->buffer = kharray_size(&flattener->flat->buffers);
+            kharray_append(&flattener->flat->buffers, khbuffer_copy(&expression->buffer));
+            break;
+        case khAstExpressionType_BYTE:
+            flat_node->byte = expression->byte;
+            break;
+        case khAstExpressionType_INTEGER:
+            flat_node->integer = expression->integer;
+            break;
+        case khAstExpressionType_UINTEGER:
+            flat_node->uinteger = expression->uinteger;
+            break;
+        case khAstExpressionType_FLOAT:
+            flat_node->float_v = expression->float_v;
+            break;
+        case khAstExpressionType_DOUBLE:
+            flat_node->double_v = expression->double_v;
+            break;
+        case khAstExpressionType_IFLOAT:
+            flat_node->ifloat = expression->ifloat;
+            break;
+        case khAstExpressionType_IDOUBLE:
+            flat_node->idouble = expression->idouble;
+            break;
+
+        case khAstExpressionType_TUPLE:
+            children[count++] = task(EXPRESSIONS, &expression->tuple.values);
+            break;
+        case khAstExpressionType_ARRAY:
+            children[count++] = task(EXPRESSIONS, &expression->array.values);
+            break;
+        case khAstExpressionType_DICT:
+            children[count++] = task(EXPRESSIONS, &expression->dict.keys);
+            children[count++] = task(EXPRESSIONS, &expression->dict.values);
+            break;
+
+        case khAstExpressionType_SIGNATURE:
+            flat_node->flags |= expression->signature.is_return_type_ref ? khFlatFlag_RETURN_REF : 0;
+            children[count++] = task(ARGUMENT_TYPES, &expression->signature);
+            children[count++] = task(EXPRESSION, expression->signature.opt_return_type);
+            break;
+        case khAstExpressionType_LAMBDA:
+            flat_node->flags |= expression->lambda.is_return_type_ref ? khFlatFlag_RETURN_REF : 0;
+            children[count++] = task(VARIABLES, &expression->lambda.arguments);
+            children[count++] = task(VARIABLE, expression->lambda.opt_variadic_argument);
+            children[count++] = task(EXPRESSION, expression->lambda.opt_return_type);
+            children[count++] = task(STATEMENTS, &expression->lambda.block);
+            break;
+
+        case khAstExpressionType_UNARY:
+            flat_node->operation = expression->unary.type;
+            children[count++] = task(EXPRESSION, expression->unary.operand);
+            break;
+        case khAstExpressionType_BINARY:
+            flat_node->operation = expression->binary.type;
+            children[count++] = task(EXPRESSION, expression->binary.left);
+            children[count++] = task(EXPRESSION, expression->binary.right);
+            break;
+        case khAstExpressionType_TERNARY:
+            children[count++] = task(EXPRESSION, expression->ternary.condition);
+            children[count++] = task(EXPRESSION, expression->ternary.value);
+            children[count++] = task(EXPRESSION, expression->ternary.otherwise);
+            break;
+        case khAstExpressionType_COMPARISON: {
+            kharray(khAstComparisonExpressionType)* operations = &expression->comparison.operations;
+            flat_node->range.first = kharray_size(&flattener->flat->operations);
+            flat_node->range.count = kharray_size(operations);
+            for (size_t i = 0; i < kharray_size(operations); i++) {
+                kharray_append(&flattener->flat->operations, (uint8_t)(*operations)[i]);
+            }
+
+            children[count++] = task(EXPRESSIONS, &expression->comparison.operands);
+        } break;
+        case khAstExpressionType_CALL:
+            children[count++] = task(EXPRESSION, expression->call.callee);
+            children[count++] = task(EXPRESSIONS, &expression->call.arguments);
+            break;
+        case khAstExpressionType_INDEX:
+            children[count++] = task(EXPRESSION, expression->index.indexee);
+            children[count++] = task(EXPRESSIONS, &expression->index.arguments);
+            break;
+
+        case khAstExpressionType_SCOPE:
+            children[count++] = task(EXPRESSION, expression->scope.value);
+            children[count++] = task(NAMES, &expression->scope.scope_names);
+            break;
+        case khAstExpressionType_TEMPLATIZE:
+            children[count++] = task(EXPRESSION, expression->templatize.value);
+            children[count++] = task(EXPRESSIONS, &expression->templatize.template_arguments);
+            break;
+
+        default:
+            break;
+    }
+
+    addChildren(flattener, node, children, count);
+}
+
+static void flattenStatement(Flattener* flattener, khAstStatement* statement) {
+    uint32_t node = addNode(flattener, khFlatKind_STATEMENT);
+    khFlatNode* flat_node = &flattener->flat->nodes[node];
+    flat_node->type = statement->type;
+    flat_node->begin = offsetOf(flattener, statement->begin);
+    flat_node->end = offsetOf(flattener, statement->end);
+
+    Task children[6];
+    size_t count = 0;
+    uint32_t string = kh_FLAT_NONE;
+
+    switch (statement->type) {
+        case khAstStatementType_VARIABLE:
+            children[count++] = task(VARIABLE, &statement->variable);
+            break;
+        case khAstStatementType_EXPRESSION:
+            children[count++] = task(EXPRESSION, &statement->expression);
+            break;
+
+        case khAstStatementType_IMPORT:
+            flat_node->flags = statement->import_v.relative ? khFlatFlag_RELATIVE : 0;
+            if (statement->import_v.opt_alias != NULL) {
+                string = addString(flattener, statement->import_v.opt_alias);
+            }
+            children[count++] = task(NAMES, &statement->import_v.path);
+            break;
+        case khAstStatementType_INCLUDE:
+            flat_node->flags = statement->include.relative ? khFlatFlag_RELATIVE : 0;
+            children[count++] = task(NAMES, &statement->include.path);
+            break;
+        case khAstStatementType_FUNCTION: {
+            khAstFunction* function = &statement->function;
+            flat_node->flags = (function->is_incase ? khFlatFlag_INCASE : 0) |
+                               (function->is_static ? khFlatFlag_STATIC : 0) |
+                               (function->is_return_type_ref ? khFlatFlag_RETURN_REF : 0);
+
+            children[count++] = task(NAMES, &function->identifiers);
+            children[count++] = task(NAMES, &function->template_arguments);
+            children[count++] = task(VARIABLES, &function->arguments);
+            children[count++] = task(VARIABLE, function->opt_variadic_argument);
+            children[count++] = task(EXPRESSION, function->opt_return_type);
+            children[count++] = task(STATEMENTS, &function->block);
+        } break;
+        case khAstStatementType_CLASS:
+            flat_node->flags = statement->class_v.is_incase ? khFlatFlag_INCASE : 0;
+            string = addString(flattener, &statement->class_v.name);
+            children[count++] = task(NAMES, &statement->class_v.template_arguments);
+            children[count++] = task(EXPRESSION, statement->class_v.opt_base_type);
+            children[count++] = task(STATEMENTS, &statement->class_v.block);
+            break;
+        case khAstStatementType_STRUCT:
+            flat_node->flags = statement->struct_v.is_incase ? khFlatFlag_INCASE : 0;
+            string = addString(flattener, &statement->struct_v.name);
+            children[count++] = task(NAMES, &statement->struct_v.template_arguments);
+            children[count++] = task(STATEMENTS, &statement->struct_v.block);
+            break;
+        case khAstStatementType_ENUM:
+            string = addString(flattener, &statement->enum_v.name);
+            children[count++] = task(NAMES, &statement->enum_v.members);
+            break;
+        case khAstStatementType_ALIAS:
+            flat_node->flags = statement->alias.is_incase ? khFlatFlag_INCASE : 0;
+            string = addString(flattener, &statement->alias.name);
+            children[count++] = task(EXPRESSION, &statement->alias.expression);
+            break;
+
+        case khAstStatementType_IF_BRANCH:
+            children[count++] = task(EXPRESSIONS, &statement->if_branch.branch_conditions);
+            children[count++] = task(BLOCKS, &statement->if_branch.branch_blocks);
+            children[count++] = task(STATEMENTS, &statement->if_branch.else_block);
+            break;
+        case khAstStatementType_WHILE_LOOP:
+            children[count++] = task(EXPRESSION, &statement->while_loop.condition);
+            children[count++] = task(STATEMENTS, &statement->while_loop.block);
+            break;
+        case khAstStatementType_DO_WHILE_LOOP:
+            children[count++] = task(EXPRESSION, &statement->do_while_loop.condition);
+            children[count++] = task(STATEMENTS, &statement->do_while_loop.block);
+            break;
+        case khAstStatementType_FOR_LOOP:
+            children[count++] = task(NAMES, &statement->for_loop.iterators);
+            children[count++] = task(EXPRESSION, &statement->for_loop.iteratee);
+            children[count++] = task(STATEMENTS, &statement->for_loop.block);
+            break;
+        case khAstStatementType_RETURN:
+            children[count++] = task(EXPRESSIONS, &statement->return_v.values);
+            break;
+
+        default:
+            break;
+    }
+
+    // Strings may have moved the nodes while they were added
+    flattener->flat->nodes[node].string = string;
+    addChildren(flattener, node, children, count);
+}
+
+#undef task
+
+
+khFlatAst kh_flattenAst(kharray(khAstStatement) * ast, uint8_t* origin) {
+    khFlatAst flat = {.nodes = kharray_new(khFlatNode, NULL),
+                      .strings = kharray_new(khstring, khstring_delete),
+                      .buffers = kharray_new(khbuffer, khbuffer_delete),
+                      .names = kharray_new(uint32_t, NULL),
+                      .operations = kharray_new(uint8_t, NULL)};
+
+    Flattener flattener = {
+        .flat = &flat,
+        .origin = origin,
+        .tasks = kharray_new(Task, NULL),
+        .strings = khhashmap_new(StringEntry, khhashmap_hashString, khhashmap_equalString, NULL)};
+
+    kharray_append(&flattener.tasks, ((Task){.type = TaskType_STATEMENTS, .item = ast, .node = 0}));
+
+    while (kharray_size(&flattener.tasks) > 0) {
+        Task current = flattener.tasks[kharray_size(&flattener.tasks) - 1];
+        kharray_pop(&flattener.tasks, 1);
+
+        switch (current.type) {
+            case TaskType_STATEMENT:
+                flattenStatement(&flattener, (khAstStatement*)current.item);
+                break;
+            case TaskType_EXPRESSION:
+                flattenExpression(&flattener, (khAstExpression*)current.item, 0);
+                break;
+            case TaskType_ARGUMENT_TYPE:
+                flattenExpression(&flattener, (khAstExpression*)current.item,
+                                  current.node ? khFlatFlag_REF : 0);
+                break;
+            case TaskType_VARIABLE:
+                flattenVariable(&flattener, (khAstVariable*)current.item);
+                break;
+
+            case TaskType_STATEMENTS:
+                flattenList(&flattener, current.item, sizeof(khAstStatement), TaskType_STATEMENT);
+                break;
+            case TaskType_EXPRESSIONS:
+                flattenList(&flattener, current.item, sizeof(khAstExpression), TaskType_EXPRESSION);
+                break;
+            case TaskType_VARIABLES:
+                flattenList(&flattener, current.item, sizeof(khAstVariable), TaskType_VARIABLE);
+                break;
+            case TaskType_BLOCKS:
+                flattenList(&flattener, current.item, sizeof(kharray(khAstStatement)),
+                            TaskType_STATEMENTS);
+                break;
+            case TaskType_ARGUMENT_TYPES:
+                flattenArgumentTypes(&flattener, (khAstSignature*)current.item);
+                break;
+            case TaskType_NAMES:
+                flattenNames(&flattener, (kharray(khstring)*)current.item);
+                break;
+
+            case TaskType_CLOSE:
+                flat.nodes[current.node].next = kharray_size(&flat.nodes);
+                break;
+        }
+    }
+
+    kharray_delete(&flattener.tasks);
+    khhashmap_delete(&flattener.strings);
+    return flat;
+}
+
+void khFlatAst_delete(khFlatAst* flat) {
+    kharray_delete(&flat->nodes);
+    kharray_delete(&flat->strings);
+    kharray_delete(&flat->buffers);
+    kharray_delete(&flat->names);
+    kharray_delete(&flat->operations);
+}
+
+
+typedef struct {
+    uint32_t node;
+    uint32_t children; // Visited so far
+} Frame;
+
+void khFlatAst_visit(khFlatAst* flat, uint32_t node, khFlatVisitor* visitor) {
+    kharray(Frame) frames = kharray_new(Frame, NULL);
+    uint32_t end = flat->nodes[node].next;
+
+    for (uint32_t current = node; current < end;) {
+        // Leaving every node whose subtree was passed
+        while (kharray_size(&frames) > 0 &&
+               current >= flat->nodes[frames[kharray_size(&frames) - 1].node].next) {
+            if (visitor->leave != NULL) {
+                visitor->leave(flat, frames[kharray_size(&frames) - 1].node, visitor->data);
+            }
+            kharray_pop(&frames, 1);
+        }
+
+        uint32_t parent = kh_FLAT_NONE;
+        uint32_t slot = 0;
+        if (kharray_size(&frames) > 0) {
+            Frame* frame = &frames[kharray_size(&frames) - 1];
+            parent = frame->node;
+            slot = frame->children++;
+        }
+
+        if (visitor->enter == NULL || visitor->enter(flat, current, parent, slot, visitor->data)) {
+            kharray_append(&frames, ((Frame){.node = current, .children = 0}));
+            current++;
+        }
+        else {
+            current = flat->nodes[current].next;
+        }
+    }
+
+    while (kharray_size(&frames) > 0) {
+        if (visitor->leave != NULL) {
+            visitor->leave(flat, frames[kharray_size(&frames) - 1].node, visitor->data);
+        }
+        kharray_pop(&frames, 1);
+    }
+
+    kharray_delete(&frames);
+}
+
+
+// Written before each child of a node, after the ones of the fields before it, by its type
+static const char* const expression_keys[][4] = {
+    [khAstExpressionType_TUPLE] = {"\"values\": "},
+    [khAstExpressionType_ARRAY] = {"\"values\": "},
+    [khAstExpressionType_DICT] = {"\"keys\": ", ", \"values\": "},
+    [khAstExpressionType_SIGNATURE] = {", \"argument_types\": ", ", \"opt_return_type\": "},
+    [khAstExpressionType_LAMBDA] = {"\"arguments\": ", ", \"opt_variadic_argument\": ",
+                                    ", \"opt_return_type\": ", ", \"block\": "},
+    [khAstExpressionType_UNARY] = {", \"operand\": "},
+    [khAstExpressionType_BINARY] = {", \"left\": ", ", \"right\": "},
+    [khAstExpressionType_TERNARY] = {"\"condition\": ", ", \"value\": ", ", \"otherwise\": "},
+    [khAstExpressionType_COMPARISON] = {", \"operands\": "},
+    [khAstExpressionType_CALL] = {"\"callee\": ", ", \"arguments\": "},
+    [khAstExpressionType_INDEX] = {"\"indexee\": ", ", \"arguments\": "},
+    [khAstExpressionType_SCOPE] = {"\"value\": ", ", \"scope_names\": "},
+    [khAstExpressionType_TEMPLATIZE] = {"\"value\": ", ", \"template_arguments\": "}};
+
+static const char* const statement_keys[][6] = {
+    [khAstStatementType_IMPORT] = {"\"path\": "},
+    [khAstStatementType_INCLUDE] = {"\"path\": "},
+    [khAstStatementType_FUNCTION] = {", \"identifiers\": ", ", \"template_arguments\": ",
+                                     ", \"arguments\": ", ", \"opt_variadic_argument\": ",
+                                     ", \"opt_return_type\": ", ", \"block\": "},
+    [khAstStatementType_CLASS] = {", \"template_arguments\": ", ", \"opt_base_type\": ",
+                                  ", \"block\": "},
+    [khAstStatementType_STRUCT] = {", \"template_arguments\": ", ", \"block\": "},
+    [khAstStatementType_ENUM] = {", \"members\": "},
+    [khAstStatementType_ALIAS] = {", \"expression\": "},
+    [khAstStatementType_IF_BRANCH] = {"\"branch_conditions\": ", ", \"branch_blocks\": ",
+                                      ", \"else_block\": "},
+    [khAstStatementType_WHILE_LOOP] = {"\"condition\": ", ", \"block\": "},
+    [khAstStatementType_DO_WHILE_LOOP] = {"\"condition\": ", ", \"block\": "},
+    [khAstStatementType_FOR_LOOP] = {"\"iterators\": ", ", \"iteratee\": ", ", \"block\": "},
+    [khAstStatementType_RETURN] = {"\"values\": "}};
+
+static const char* const variable_keys[] = {", \"names\": ", ", \"opt_type\": ",
+                                            ", \"opt_initializer\": "};
+
+static inline void writeBool(khWriter* writer, bool value) {
+    khWriter_cstring(writer, value ? "true" : "false");
+}
+
+static inline void writeOffset(khWriter* writer, uint32_t offset) {
+    if (offset != kh_FLAT_NONE) {
+        khWriter_uint(writer, offset, 10);
+    }
+    else {
+        khWriter_cstring(writer, "null");
+    }
+}
+
+// Whether the value of the expression or statement is an object of its own fields, closed on leaving
+static bool hasFields(khFlatNode* node) {
+    if (node->kind == khFlatKind_EXPRESSION) {
+        return node->type < sizeof(expression_keys) / sizeof(*expression_keys) &&
+               expression_keys[node->type][0] != NULL;
+    }
+    else {
+        return node->type < sizeof(statement_keys) / sizeof(*statement_keys) &&
+               statement_keys[node->type][0] != NULL;
+    }
+}
+
+static void writeKey(khFlatAst* flat, uint32_t parent, uint32_t slot, khWriter* writer) {
+    khFlatNode* node = &flat->nodes[parent];
+
+    switch (node->kind) {
+        case khFlatKind_LIST:
+            if (slot > 0) {
+                khWriter_cstring(writer, ", ");
+            }
+            break;
+
+        case khFlatKind_VARIABLE:
+            khWriter_cstring(writer, variable_keys[slot]);
+            break;
+
+        case khFlatKind_EXPRESSION:
+            if ((node->type == khAstExpressionType_SIGNATURE && slot == 1) ||
+                (node->type == khAstExpressionType_LAMBDA && slot == 2)) {
+                khWriter_cstring(writer, ", \"is_return_type_ref\": ");
+                writeBool(writer, node->flags & khFlatFlag_RETURN_REF);
+            }
+            khWriter_cstring(writer, expression_keys[node->type][slot]);
+            break;
+
+        case khFlatKind_STATEMENT:
+            // Variable and expression statements have their child as their value
+            if (node->type == khAstStatementType_VARIABLE ||
+                node->type == khAstStatementType_EXPRESSION) {
+                break;
+            }
+
+            if (node->type == khAstStatementType_FUNCTION && slot == 4) {
+                khWriter_cstring(writer, ", \"is_return_type_ref\": ");
+                writeBool(writer, node->flags & khFlatFlag_RETURN_REF);
+            }
+            khWriter_cstring(writer, statement_keys[node->type][slot]);
+            break;
+    }
+}
+
+static void writeExpression(khFlatAst* flat, uint32_t index, khWriter* writer) {
+    khFlatNode* node = &flat->nodes[index];
+
+    khWriter_cstring(writer, "{\"type\": ");
+    khWriter_quoteCstring(writer, khAstExpressionType_name(node->type));
+    khWriter_cstring(writer, ", \"begin\": ");
+    writeOffset(writer, node->begin);
+    khWriter_cstring(writer, ", \"end\": ");
+    writeOffset(writer, node->end);
+    khWriter_cstring(writer, ", \"value\": ");
+
+    switch (node->type) {
+        case khAstExpressionType_IDENTIFIER:
+        case khAstExpressionType_STRING:
+            khWriter_quote(writer, &flat->strings[node->string]);
+            break;
+        case khAstExpressionType_CHAR:
+            khWriter_byte(writer, '\"');
+            khWriter_escapeChar(writer, node->char_v);
+            khWriter_byte(writer, '\"');
+            break;
+        case khAstExpressionType_BUFFER:
+            khWriter_quoteBuffer(writer, &flat->buffers[node->buffer]);
+            break;
+        case khAstExpressionType_BYTE:
+            khWriter_byte(writer, '\"');
+            khWriter_escapeChar(writer, node->byte);
+            khWriter_byte(writer, '\"');
+            break;
+        case khAstExpressionType_INTEGER:
+            khWriter_int(writer, node->integer, 10);
+            break;
+        case khAstExpressionType_UINTEGER:
+            khWriter_uint(writer, node->uinteger, 10);
+            break;
+        case khAstExpressionType_FLOAT:
+            khWriter_float(writer, node->float_v, 8, 10);
+            break;
+        case khAstExpressionType_DOUBLE:
+            khWriter_float(writer, node->double_v, 16, 10);
+            break;
+        case khAstExpressionType_IFLOAT:
+            khWriter_float(writer, node->ifloat, 8, 10);
+            break;
+        case khAstExpressionType_IDOUBLE:
+            khWriter_float(writer, node->idouble, 16, 10);
+            break;
+
+        case khAstExpressionType_SIGNATURE: {
+            khWriter_cstring(writer, "{\"are_arguments_refs\": [");
+            uint32_t list = index + 1;
+            for (uint32_t child = list + 1; child < flat->nodes[list].next;
+                 child = flat->nodes[child].next) {
+                writeBool(writer, flat->nodes[child].flags & khFlatFlag_REF);
+                if (flat->nodes[child].next < flat->nodes[list].next) {
+                    khWriter_cstring(writer, ", ");
+                }
+            }
+            khWriter_byte(writer, ']');
+        } break;
+        case khAstExpressionType_UNARY:
+            khWriter_cstring(writer, "{\"type\": ");
+            khWriter_quoteCstring(writer, khAstUnaryExpressionType_name(node->operation));
+            break;
+        case khAstExpressionType_BINARY:
+            khWriter_cstring(writer, "{\"type\": ");
+            khWriter_quoteCstring(writer, khAstBinaryExpressionType_name(node->operation));
+            break;
+        case khAstExpressionType_COMPARISON:
+            khWriter_cstring(writer, "{\"operations\": [");
+            for (uint32_t i = 0; i < node->range.count; i++) {
+                khWriter_quoteCstring(writer, khAstComparisonExpressionType_name(
+                                                  flat->operations[node->range.first + i]));
+                if (i != node->range.count - 1) {
+                    khWriter_cstring(writer, ", ");
+                }
+            }
+            khWriter_byte(writer, ']');
+            break;
+
+        default:
+            if (hasFields(node)) {
+                khWriter_byte(writer, '{');
+            }
+            else {
+                khWriter_cstring(writer, "null");
+            }
+            break;
+    }
+}
+
+static void writeStatement(khFlatAst* flat, uint32_t index, khWriter* writer) {
+    khFlatNode* node = &flat->nodes[index];
+
+    khWriter_cstring(writer, "{\"type\": ");
+    khWriter_quoteCstring(writer, khAstStatementType_name(node->type));
+    khWriter_cstring(writer, ", \"begin\": ");
+    writeOffset(writer, node->begin);
+    khWriter_cstring(writer, ", \"end\": ");
+    writeOffset(writer, node->end);
+    khWriter_cstring(writer, ", \"value\": ");
+
+    switch (node->type) {
+        case khAstStatementType_VARIABLE:
+        case khAstStatementType_EXPRESSION:
+            break;
+
+        case khAstStatementType_FUNCTION:
+            khWriter_cstring(writer, "{\"is_incase\": ");
+            writeBool(writer, node->flags & khFlatFlag_INCASE);
+            khWriter_cstring(writer, ", \"is_static\": ");
+            writeBool(writer, node->flags & khFlatFlag_STATIC);
+            break;
+        case khAstStatementType_CLASS:
+        case khAstStatementType_STRUCT:
+        case khAstStatementType_ALIAS:
+            khWriter_cstring(writer, "{\"is_incase\": ");
+            writeBool(writer, node->flags & khFlatFlag_INCASE);
+            khWriter_cstring(writer, ", \"name\": ");
+            khWriter_quote(writer, &flat->strings[node->string]);
+            break;
+        case khAstStatementType_ENUM:
+            khWriter_cstring(writer, "{\"name\": ");
+            khWriter_quote(writer, &flat->strings[node->string]);
+            break;
+
+        default:
+            if (hasFields(node)) {
+                khWriter_byte(writer, '{');
+            }
+            else {
+                khWriter_cstring(writer, "null");
+            }
+            break;
+    }
+}
+
+static bool enterWrite(khFlatAst* flat, uint32_t index, uint32_t parent, uint32_t slot,
+                       void* writer_v) {
+    khWriter* writer = (khWriter*)writer_v;
+    khFlatNode* node = &flat->nodes[index];
+
+    if (parent != kh_FLAT_NONE) {
+        writeKey(flat, parent, slot, writer);
+    }
+
+    switch (node->kind) {
+        case khFlatKind_LIST:
+            khWriter_byte(writer, '[');
+            break;
+        case khFlatKind_NAMES:
+            khWriter_byte(writer, '[');
+            for (uint32_t i = 0; i < node->range.count; i++) {
+                khWriter_quote(writer, &flat->strings[flat->names[node->range.first + i]]);
+                if (i != node->range.count - 1) {
+                    khWriter_cstring(writer, ", ");
+                }
+            }
+            khWriter_byte(writer, ']');
+            break;
+        case khFlatKind_NONE:
+            khWriter_cstring(writer, "null");
+            break;
+
+        case khFlatKind_VARIABLE:
+            khWriter_cstring(writer, "{\"is_static\": ");
+            writeBool(writer, node->flags & khFlatFlag_STATIC);
+            khWriter_cstring(writer, ", \"is_wild\": ");
+            writeBool(writer, node->flags & khFlatFlag_WILD);
+            khWriter_cstring(writer, ", \"is_ref\": ");
+            writeBool(writer, node->flags & khFlatFlag_REF);
+            break;
+        case khFlatKind_EXPRESSION:
+            writeExpression(flat, index, writer);
+            break;
+        case khFlatKind_STATEMENT:
+            writeStatement(flat, index, writer);
+            break;
+    }
+
+    return true;
+}
+
+static void leaveWrite(khFlatAst* flat, uint32_t index, void* writer_v) {
+    khWriter* writer = (khWriter*)writer_v;
+    khFlatNode* node = &flat->nodes[index];
+
+    switch (node->kind) {
+        case khFlatKind_LIST:
+            khWriter_byte(writer, ']');
+            break;
+        case khFlatKind_VARIABLE:
+            khWriter_byte(writer, '}');
+            break;
+
+        case khFlatKind_EXPRESSION:
+            khWriter_cstring(writer, hasFields(node) ? "}}" : "}");
+            break;
+        case khFlatKind_STATEMENT:
+            if (node->type == khAstStatementType_IMPORT) {
+                khWriter_cstring(writer, ", \"relative\": ");
+                writeBool(writer, node->flags & khFlatFlag_RELATIVE);
+                khWriter_cstring(writer, ", \"opt_alias\": ");
+                if (node->string != kh_FLAT_NONE) {
+                    khWriter_quote(writer, &flat->strings[node->string]);
+                }
+                else {
+                    khWriter_cstring(writer, "null");
+                }
+            }
+            else if (node->type == khAstStatementType_INCLUDE) {
+                khWriter_cstring(writer, ", \"relative\": ");
+                writeBool(writer, node->flags & khFlatFlag_RELATIVE);
+            }
+
+            khWriter_cstring(writer, hasFields(node) ? "}}" : "}");
+            break;
+
+        default:
+            break;
+    }
+}
+
+void khFlatAst_write(khFlatAst* flat, uint32_t node, khWriter* writer) {
+    khFlatVisitor visitor = {.enter = enterWrite, .leave = leaveWrite, .data = writer};
+    khFlatAst_visit(flat, node, &visitor);
+}
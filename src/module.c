@@ -0,0 +1,477 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include <kithare/core/lexer.h>
+#include <kithare/core/module.h>
+#include <kithare/core/parser.h>
+#include <kithare/lib/hashmap.h>
+#include <kithare/lib/io.h>
+#include <kithare/lib/thread.h>
+
+
+// Modules waiting to be loaded by a worker, which takes the last one it queued, while idle workers
+// steal the first ones, which tend to be the roots of the biggest subtrees left
+typedef struct {
+    pthread_mutex_t mutex;
+    kharray(khModule*) modules;
+    size_t front;
+} Deque;
+
+typedef struct {
+    khstring key; // The path of the module, which it owns
+    khModule* module;
+} RegistryEntry;
+
+typedef struct {
+    kharray(khstring) * search_directories;
+    size_t threads;
+    Deque* deques;
+
+    atomic_size_t queued;  // Modules in the deques
+    atomic_size_t pending; // Modules queued or being loaded
+    pthread_mutex_t idle_mutex;
+    pthread_cond_t idle;
+
+    // Each module by its path, so it's only loaded once
+    pthread_mutex_t registry_mutex;
+    khhashmap(RegistryEntry) registry;
+    kharray(khModule*) modules;
+} Loader;
+
+
+khstring kh_normalizePath(khstring* relative_path) {
+    khstring absolute_path = kh_absolutePath(relative_path);
+    khstring* path = &absolute_path;
+
+    khstring normalized = khstring_new(U"");
+    bool absolute = khstring_size(path) > 0 && ((*path)[0] == U'/' || (*path)[0] == U'\\');
+    if (absolute) {
+        khstring_append(&normalized, U'/');
+    }
+
+    // Where each part starts in the normalized path
+    kharray(size_t) parts = kharray_new(size_t, NULL);
+    size_t begin = 0;
+
+    for (size_t i = 0; i <= khstring_size(path); i++) {
+        if (i < khstring_size(path) && (*path)[i] != U'/' && (*path)[i] != U'\\') {
+            continue;
+        }
+
+        size_t size = i - begin;
+        char32_t* part = *path + begin;
+        begin = i + 1;
+
+        if (size == 0 || (size == 1 && part[0] == U'.')) {
+            continue;
+        }
+
+        if (size == 2 && part[0] == U'.' && part[1] == U'.' && kharray_size(&parts) > 0) {
+            size_t last = parts[kharray_size(&parts) - 1];
+            if (!(khstring_size(&normalized) - last == 2 && normalized[last] == U'.' &&
+                  normalized[last + 1] == U'.')) {
+                khstring_pop(&normalized, khstring_size(&normalized) - last);
+                kharray_pop(&parts, 1);
+
+                // The separator before it
+                if (khstring_size(&normalized) > (absolute ? 1 : 0)) {
+                    khstring_pop(&normalized, 1);
+                }
+                continue;
+            }
+        }
+
+        if (khstring_size(&normalized) > (absolute ? 1 : 0)) {
+            khstring_append(&normalized, U'/');
+        }
+
+        kharray_append(&parts, khstring_size(&normalized));
+        for (size_t j = 0; j < size; j++) {
+            khstring_append(&normalized, part[j]);
+        }
+    }
+
+    if (khstring_size(&normalized) == 0) {
+        khstring_append(&normalized, U'.');
+    }
+
+    kharray_delete(&parts);
+    khstring_delete(&absolute_path);
+    return normalized;
+}
+
+khstring kh_directoryOf(khstring* path) {
+    size_t size = khstring_size(path);
+    while (size > 0 && (*path)[size - 1] != U'/' && (*path)[size - 1] != U'\\') {
+        size--;
+    }
+
+    if (size == 0) {
+        return khstring_new(U".");
+    }
+
+    khstring directory = khstring_copy(path);
+    khstring_pop(&directory, khstring_size(&directory) - size);
+    return directory;
+}
+
+static kharray(khstring) * dependencyPath(khAstStatement* statement, bool* relative) {
+    if (statement->type == khAstStatementType_IMPORT) {
+        *relative = statement->import_v.relative;
+        return &statement->import_v.path;
+    }
+    else {
+        *relative = statement->include.relative;
+        return &statement->include.path;
+    }
+}
+
+khstring kh_dependencyName(khAstStatement* statement) {
+    bool relative;
+    kharray(khstring)* path = dependencyPath(statement, &relative);
+
+    khstring name = khstring_new(relative ? U"." : U"");
+    for (size_t i = 0; i < kharray_size(path); i++) {
+        if (i > 0) {
+            khstring_append(&name, U'.');
+        }
+        khstring_concatenate(&name, &(*path)[i]);
+    }
+
+    return name;
+}
+
+khstring kh_findDependency(khstring* module_path, khAstStatement* statement,
+                           kharray(khstring) * search_directories) {
+    bool relative;
+    kharray(khstring)* path = dependencyPath(statement, &relative);
+
+    khstring file = khstring_new(U"");
+    for (size_t i = 0; i < kharray_size(path); i++) {
+        khstring_append(&file, U'/');
+        khstring_concatenate(&file, &(*path)[i]);
+    }
+    khstring_concatenateCstring(&file, U".kh");
+
+    khstring found = NULL;
+    if (relative) {
+        khstring candidate = kh_directoryOf(module_path);
+        khstring_concatenate(&candidate, &file);
+
+        if (kh_isFile(&candidate)) {
+            found = kh_normalizePath(&candidate);
+        }
+        khstring_delete(&candidate);
+    }
+    else {
+        for (size_t i = 0; i < kharray_size(search_directories) && found == NULL; i++) {
+            khstring candidate = khstring_copy(&(*search_directories)[i]);
+            khstring_concatenate(&candidate, &file);
+
+            if (kh_isFile(&candidate)) {
+                found = kh_normalizePath(&candidate);
+            }
+            khstring_delete(&candidate);
+        }
+    }
+
+    khstring_delete(&file);
+    return found;
+}
+
+// Takes the path; gives the module already registered under it, if there's one
+static khModule* registerModule(Loader* loader, khstring path, bool* is_new) {
+    pthread_mutex_lock(&loader->registry_mutex);
+
+    RegistryEntry* entry = khhashmap_find(&loader->registry, path);
+    if (entry != NULL) {
+        khModule* module = entry->module;
+        pthread_mutex_unlock(&loader->registry_mutex);
+
+        khstring_delete(&path);
+        *is_new = false;
+        return module;
+    }
+
+    // The rest is filled in once it's loaded
+    khModule* module = (khModule*)calloc(1, sizeof(khModule));
+    module->path = path;
+    module->id = kharray_size(&loader->modules);
+
+    khhashmap_put(&loader->registry, ((RegistryEntry){.key = module->path, .module = module}));
+    kharray_append(&loader->modules, module);
+
+    pthread_mutex_unlock(&loader->registry_mutex);
+    *is_new = true;
+    return module;
+}
+
+static void push(Loader* loader, size_t worker, khModule* module) {
+    Deque* deque = &loader->deques[worker];
+
+    pthread_mutex_lock(&deque->mutex);
+    kharray_append(&deque->modules, module);
+    pthread_mutex_unlock(&deque->mutex);
+
+    atomic_fetch_add(&loader->pending, 1);
+    atomic_fetch_add(&loader->queued, 1);
+
+    pthread_mutex_lock(&loader->idle_mutex);
+    pthread_cond_signal(&loader->idle);
+    pthread_mutex_unlock(&loader->idle_mutex);
+}
+
+static khModule* pop(Loader* loader, size_t worker) {
+    // Its own newest module first, then the oldest of the others
+    for (size_t i = 0; i < loader->threads; i++) {
+        Deque* deque = &loader->deques[(worker + i) % loader->threads];
+        khModule* module = NULL;
+
+        pthread_mutex_lock(&deque->mutex);
+        if (kharray_size(&deque->modules) > deque->front) {
+            if (i == 0) {
+                module = deque->modules[kharray_size(&deque->modules) - 1];
+                kharray_setSize(&deque->modules, kharray_size(&deque->modules) - 1);
+            }
+            else {
+                module = deque->modules[deque->front++];
+            }
+
+            if (kharray_size(&deque->modules) == deque->front) {
+                kharray_setSize(&deque->modules, 0);
+                deque->front = 0;
+            }
+        }
+        pthread_mutex_unlock(&deque->mutex);
+
+        if (module != NULL) {
+            atomic_fetch_sub(&loader->queued, 1);
+            return module;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void load(Loader* loader, size_t worker, khModule* module) {
+    bool found;
+    module->source = kh_readFile(&module->path, &found);
+
+    // Everything the parser raises and interns is moved into the module
+    module->arena = khArena_new();
+    module->ast = kh_parseArena(&module->source, &module->arena);
+    module->identifiers = kh_takeIdentifiers();
+
+    module->errors = kh_swapErrors(NULL);
+
+    // It was there when it was resolved, but might have been removed since
+    if (!found) {
+        kharray_append(&module->errors, ((khError){.type = khErrorType_MODULE,
+                                                   .message = khstring_new(U"couldn't read the module"),
+                                                   .data = module->source}));
+    }
+
+    module->dependencies = kharray_new(khDependency, NULL);
+
+    // Only what it depends on at the top-level
+    for (size_t i = 0; i < kharray_size(&module->ast); i++) {
+        khAstStatement* statement = &module->ast[i];
+        if (statement->type != khAstStatementType_IMPORT &&
+            statement->type != khAstStatementType_INCLUDE) {
+            continue;
+        }
+
+        khDependency dependency = {.statement = statement, .module = NULL};
+        khstring path = kh_findDependency(&module->path, statement, loader->search_directories);
+
+        if (path != NULL) {
+            bool is_new;
+            dependency.module = registerModule(loader, path, &is_new);
+            if (is_new) {
+                push(loader, worker, dependency.module);
+            }
+        }
+        else {
+            khstring message = khstring_new(U"module not found: ");
+            khstring name = kh_dependencyName(statement);
+            khstring_concatenate(&message, &name);
+            khstring_delete(&name);
+
+            kharray_append(&module->errors, ((khError){.type = khErrorType_MODULE,
+                                                       .message = message,
+                                                       .data = statement->begin}));
+        }
+
+        kharray_append(&module->dependencies, dependency);
+    }
+}
+
+static void work(void* loader_v, size_t worker) {
+    Loader* loader = (Loader*)loader_v;
+
+    while (true) {
+        khModule* module = pop(loader, worker);
+        if (module != NULL) {
+            load(loader, worker, module);
+
+            // The last one wakes everyone up to leave
+            if (atomic_fetch_sub(&loader->pending, 1) == 1) {
+                pthread_mutex_lock(&loader->idle_mutex);
+                pthread_cond_broadcast(&loader->idle);
+                pthread_mutex_unlock(&loader->idle_mutex);
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&loader->idle_mutex);
+        while (atomic_load(&loader->pending) > 0 && atomic_load(&loader->queued) == 0) {
+            pthread_cond_wait(&loader->idle, &loader->idle_mutex);
+        }
+        pthread_mutex_unlock(&loader->idle_mutex);
+
+        if (atomic_load(&loader->pending) == 0) {
+            return;
+        }
+    }
+}
+
+
+// Depth-first, with the modules after everything they depend on
+static kharray(khModule*) order(Loader* loader, khModule* entry) {
+    typedef struct {
+        khModule* module;
+        size_t next; // Dependency to visit
+    } Visit;
+
+    // 0 for unvisited, 1 while its dependencies are visited, 2 once it's ordered
+    uint8_t* states = (uint8_t*)calloc(kharray_size(&loader->modules) + 1, 1);
+    kharray(khModule*) ordered = kharray_new(khModule*, NULL);
+    kharray(Visit) visits = kharray_new(Visit, NULL);
+
+    kharray_append(&visits, ((Visit){.module = entry, .next = 0}));
+    states[entry->id] = 1;
+
+    while (kharray_size(&visits) > 0) {
+        Visit* visit = &visits[kharray_size(&visits) - 1];
+        if (visit->next == kharray_size(&visit->module->dependencies)) {
+            states[visit->module->id] = 2;
+            kharray_append(&ordered, visit->module);
+            kharray_pop(&visits, 1);
+            continue;
+        }
+
+        khDependency* dependency = &visit->module->dependencies[visit->next++];
+        if (dependency->module == NULL) {
+            continue;
+        }
+
+        switch (states[dependency->module->id]) {
+            case 0:
+                states[dependency->module->id] = 1;
+                kharray_append(&visits, ((Visit){.module = dependency->module, .next = 0}));
+                break;
+
+            case 1: {
+                khstring message = khstring_new(U"circular dependency on ");
+                khstring name = kh_dependencyName(dependency->statement);
+                khstring_concatenate(&message, &name);
+                khstring_delete(&name);
+
+                kharray_append(&visit->module->errors,
+                               ((khError){.type = khErrorType_MODULE,
+                                          .message = message,
+                                          .data = dependency->statement->begin}));
+            } break;
+
+            default:
+                break;
+        }
+    }
+
+    kharray_delete(&visits);
+    free(states);
+    return ordered;
+}
+
+khModuleGraph kh_loadModules(khstring* file_name, kharray(khstring) * search_directories,
+                             size_t threads) {
+    khModuleGraph graph = {.entry = NULL, .modules = kharray_new(khModule*, NULL)};
+    if (!kh_isFile(file_name)) {
+        return graph;
+    }
+
+    kharray(khstring) default_directories = kharray_new(khstring, khstring_delete);
+    if (search_directories == NULL || kharray_size(search_directories) == 0) {
+        kharray_append(&default_directories, kh_directoryOf(file_name));
+        search_directories = &default_directories;
+    }
+
+    threads = threads > 0 ? threads : 1;
+    Loader loader = {.search_directories = search_directories,
+                     .threads = threads,
+                     .deques = (Deque*)calloc(threads, sizeof(Deque)),
+                     .registry = khhashmap_new(RegistryEntry, khhashmap_hashString,
+                                               khhashmap_equalString, NULL),
+                     .modules = kharray_new(khModule*, NULL)};
+    atomic_init(&loader.queued, 0);
+    atomic_init(&loader.pending, 0);
+    pthread_mutex_init(&loader.idle_mutex, NULL);
+    pthread_cond_init(&loader.idle, NULL);
+    pthread_mutex_init(&loader.registry_mutex, NULL);
+
+    for (size_t i = 0; i < threads; i++) {
+        pthread_mutex_init(&loader.deques[i].mutex, NULL);
+        loader.deques[i].modules = kharray_new(khModule*, NULL);
+        loader.deques[i].front = 0;
+    }
+
+    bool is_new;
+    graph.entry = registerModule(&loader, kh_normalizePath(file_name), &is_new);
+    push(&loader, 0, graph.entry);
+
+    // Each job is a worker, which only returns once there's nothing left to load
+    kh_parallelFor(threads, threads, work, &loader);
+
+    kharray_delete(&graph.modules);
+    graph.modules = order(&loader, graph.entry);
+
+    for (size_t i = 0; i < threads; i++) {
+        kharray_delete(&loader.deques[i].modules);
+        pthread_mutex_destroy(&loader.deques[i].mutex);
+    }
+    free(loader.deques);
+    khhashmap_delete(&loader.registry);
+    kharray_delete(&loader.modules);
+    pthread_mutex_destroy(&loader.registry_mutex);
+    pthread_cond_destroy(&loader.idle);
+    pthread_mutex_destroy(&loader.idle_mutex);
+    kharray_delete(&default_directories);
+
+    return graph;
+}
+
+void khModuleGraph_delete(khModuleGraph* graph) {
+    for (size_t i = 0; i < kharray_size(&graph->modules); i++) {
+        khModule* module = graph->modules[i];
+
+        khstring_delete(&module->path);
+        khbuffer_delete(&module->source);
+        khArena_delete(&module->arena);
+        khInterner_delete(&module->identifiers);
+        kharray_delete(&module->errors);
+        kharray_delete(&module->dependencies);
+        free(module);
+    }
+
+    kharray_delete(&graph->modules);
+    graph->entry = NULL;
+}
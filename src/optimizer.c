@@ -0,0 +1,679 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <kithare/core/ast.h>
+#include <kithare/core/optimizer.h>
+#include <kithare/core/vm.h>
+#include <kithare/lib/arena.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/string.h>
+
+
+// Where the AST is, NULL if it's on the heap, like the parser's
+static _Thread_local khArena* optimize_arena = NULL;
+
+// What's taken out of the AST is only deleted from the heap, the arena owns it otherwise
+static inline void discardExpression(khAstExpression* expression) {
+    if (optimize_arena == NULL) {
+        khAstExpression_delete(expression);
+    }
+}
+
+static inline void discardBlock(kharray(khAstStatement) * block) {
+    if (optimize_arena == NULL) {
+        kharray_delete(block);
+    }
+}
+
+// Takes items out of an array and closes the gap, discarding them unless they've been moved elsewhere
+#define removeItems(ARRAY, INDEX, COUNT, DISCARD) \
+    _removeItems((void**)_kharray_verify(ARRAY), INDEX, COUNT, DISCARD)
+static void _removeItems(void** array, size_t index, size_t count, bool discard) {
+    if (count == 0) {
+        return;
+    }
+
+    size_t type_size = _kharray_typeSize(array);
+    uint8_t* items = *array;
+    if (discard && optimize_arena == NULL && _kharray_deleter(array) != NULL) {
+        for (size_t i = index; i < index + count; i++) {
+            _kharray_deleter(array)(items + type_size * i);
+        }
+    }
+
+    memmove(items + type_size * index, items + type_size * (index + count),
+            type_size * (kharray_size(array) - index - count));
+    memset(items + type_size * (kharray_size(array) - count), 0, type_size * count);
+    _kharray_setSize(array, kharray_size(array) - count);
+}
+
+// In place of the expression, spanning what it did
+static inline void replaceExpression(khAstExpression* expression, khAstExpression replacement) {
+    replacement.begin = expression->begin;
+    replacement.end = expression->end;
+    discardExpression(expression);
+    *expression = replacement;
+}
+
+
+// Functions of a pass, on each expression after its children, and on each block after its statements;
+// either of them can be NULL
+typedef struct {
+    void (*expression)(khAstExpression* expression);
+    void (*block)(kharray(khAstStatement) * block);
+} Pass;
+
+static void walkExpression(Pass* pass, khAstExpression* expression);
+static void walkBlock(Pass* pass, kharray(khAstStatement) * block);
+
+static void walkExpressions(Pass* pass, kharray(khAstExpression) * expressions) {
+    for (size_t i = 0; i < kharray_size(expressions); i++) {
+        walkExpression(pass, &(*expressions)[i]);
+    }
+}
+
+static inline void walkOptionalExpression(Pass* pass, khAstExpression* expression) {
+    if (expression != NULL) {
+        walkExpression(pass, expression);
+    }
+}
+
+static void walkVariable(Pass* pass, khAstVariable* variable) {
+    walkOptionalExpression(pass, variable->opt_type);
+    walkOptionalExpression(pass, variable->opt_initializer);
+}
+
+static void walkVariables(Pass* pass, kharray(khAstVariable) * variables) {
+    for (size_t i = 0; i < kharray_size(variables); i++) {
+        walkVariable(pass, &(*variables)[i]);
+    }
+}
+
+static void walkExpression(Pass* pass, khAstExpression* expression) {
+    switch (expression->type) {
+        case khAstExpressionType_TUPLE:
+            walkExpressions(pass, &expression->tuple.values);
+            break;
+        case khAstExpressionType_ARRAY:
+            walkExpressions(pass, &expression->array.values);
+            break;
+        case khAstExpressionType_DICT:
+            walkExpressions(pass, &expression->dict.keys);
+            walkExpressions(pass, &expression->dict.values);
+            break;
+
+        case khAstExpressionType_SIGNATURE:
+            walkExpressions(pass, &expression->signature.argument_types);
+            walkOptionalExpression(pass, expression->signature.opt_return_type);
+            break;
+        case khAstExpressionType_LAMBDA:
+            walkVariables(pass, &expression->lambda.arguments);
+            if (expression->lambda.opt_variadic_argument != NULL) {
+                walkVariable(pass, expression->lambda.opt_variadic_argument);
+            }
+            walkOptionalExpression(pass, expression->lambda.opt_return_type);
+            walkBlock(pass, &expression->lambda.block);
+            break;
+
+        case khAstExpressionType_UNARY:
+            walkExpression(pass, expression->unary.operand);
+            break;
+        case khAstExpressionType_BINARY:
+            walkExpression(pass, expression->binary.left);
+            walkExpression(pass, expression->binary.right);
+            break;
+        case khAstExpressionType_TERNARY:
+            walkExpression(pass, expression->ternary.condition);
+            walkExpression(pass, expression->ternary.value);
+            walkExpression(pass, expression->ternary.otherwise);
+            break;
+        case khAstExpressionType_COMPARISON:
+            walkExpressions(pass, &expression->comparison.operands);
+            break;
+        case khAstExpressionType_CALL:
+            walkExpression(pass, expression->call.callee);
+            walkExpressions(pass, &expression->call.arguments);
+            break;
+        case khAstExpressionType_INDEX:
+            walkExpression(pass, expression->index.indexee);
+            walkExpressions(pass, &expression->index.arguments);
+            break;
+
+        case khAstExpressionType_SCOPE:
+            walkExpression(pass, expression->scope.value);
+            break;
+        case khAstExpressionType_TEMPLATIZE:
+            walkExpression(pass, expression->templatize.value);
+            walkExpressions(pass, &expression->templatize.template_arguments);
+            break;
+
+        default:
+            break;
+    }
+
+    if (pass->expression != NULL) {
+        pass->expression(expression);
+    }
+}
+
+static void walkStatement(Pass* pass, khAstStatement* statement) {
+    switch (statement->type) {
+        case khAstStatementType_VARIABLE:
+            walkVariable(pass, &statement->variable);
+            break;
+        case khAstStatementType_EXPRESSION:
+            walkExpression(pass, &statement->expression);
+            break;
+
+        case khAstStatementType_FUNCTION:
+            walkVariables(pass, &statement->function.arguments);
+            if (statement->function.opt_variadic_argument != NULL) {
+                walkVariable(pass, statement->function.opt_variadic_argument);
+            }
+            walkOptionalExpression(pass, statement->function.opt_return_type);
+            walkBlock(pass, &statement->function.block);
+            break;
+        case khAstStatementType_CLASS:
+            walkOptionalExpression(pass, statement->class_v.opt_base_type);
+            walkBlock(pass, &statement->class_v.block);
+            break;
+        case khAstStatementType_STRUCT:
+            walkBlock(pass, &statement->struct_v.block);
+            break;
+        case khAstStatementType_ALIAS:
+            walkExpression(pass, &statement->alias.expression);
+            break;
+
+        case khAstStatementType_IF_BRANCH:
+            walkExpressions(pass, &statement->if_branch.branch_conditions);
+            for (size_t i = 0; i < kharray_size(&statement->if_branch.branch_blocks); i++) {
+                walkBlock(pass, &statement->if_branch.branch_blocks[i]);
+            }
+            walkBlock(pass, &statement->if_branch.else_block);
+            break;
+        case khAstStatementType_WHILE_LOOP:
+            walkExpression(pass, &statement->while_loop.condition);
+            walkBlock(pass, &statement->while_loop.block);
+            break;
+        case khAstStatementType_DO_WHILE_LOOP:
+            walkBlock(pass, &statement->do_while_loop.block);
+            walkExpression(pass, &statement->do_while_loop.condition);
+            break;
+        case khAstStatementType_FOR_LOOP:
+            walkExpression(pass, &statement->for_loop.iteratee);
+            walkBlock(pass, &statement->for_loop.block);
+            break;
+        case khAstStatementType_RETURN:
+            walkExpressions(pass, &statement->return_v.values);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void walkBlock(Pass* pass, kharray(khAstStatement) * block) {
+    for (size_t i = 0; i < kharray_size(block); i++) {
+        walkStatement(pass, &(*block)[i]);
+    }
+
+    if (pass->block != NULL) {
+        pass->block(block);
+    }
+}
+
+
+static inline bool isIntegral(khAstExpression* expression) {
+    return expression->type == khAstExpressionType_INTEGER ||
+           expression->type == khAstExpressionType_UINTEGER;
+}
+
+// Uints are run as ints by the VM, and the compiler raises on those past the greatest int, so they're
+// only folded while they, and whatever they're folded into, stay within it
+static inline bool isInIntRange(khAstExpression* expression) {
+    return expression->type != khAstExpressionType_UINTEGER || expression->uinteger <= INT64_MAX;
+}
+
+static inline bool isFloating(khAstExpression* expression) {
+    return expression->type == khAstExpressionType_FLOAT ||
+           expression->type == khAstExpressionType_DOUBLE;
+}
+
+static inline double floatingOf(khAstExpression* expression) {
+    switch (expression->type) {
+        case khAstExpressionType_INTEGER:
+            return (double)expression->integer;
+        case khAstExpressionType_UINTEGER:
+            return (double)expression->uinteger;
+        case khAstExpressionType_FLOAT:
+            return expression->float_v;
+        default:
+            return expression->double_v;
+    }
+}
+
+// As the VM does it on ints, wrapping around
+static bool foldInteger(khAstBinaryExpressionType type, int64_t left, int64_t right, int64_t* result) {
+    switch (type) {
+        case khAstBinaryExpressionType_ADD:
+            *result = (int64_t)((uint64_t)left + (uint64_t)right);
+            return true;
+        case khAstBinaryExpressionType_SUB:
+            *result = (int64_t)((uint64_t)left - (uint64_t)right);
+            return true;
+        case khAstBinaryExpressionType_MUL:
+            *result = (int64_t)((uint64_t)left * (uint64_t)right);
+            return true;
+
+        // Left to raise at runtime when it's by zero, and -1 negates rather than overflowing
+        case khAstBinaryExpressionType_DIV:
+            if (right == 0) {
+                return false;
+            }
+            *result = right == -1 ? (int64_t)(0 - (uint64_t)left) : left / right;
+            return true;
+        case khAstBinaryExpressionType_MOD:
+            if (right == 0) {
+                return false;
+            }
+            *result = right == -1 ? 0 : left % right;
+            return true;
+        case khAstBinaryExpressionType_POW:
+            *result = kh_powInt(left, right);
+            return true;
+
+        case khAstBinaryExpressionType_BIT_AND:
+            *result = left & right;
+            return true;
+        case khAstBinaryExpressionType_BIT_OR:
+            *result = left | right;
+            return true;
+        case khAstBinaryExpressionType_BIT_XOR:
+            *result = left ^ right;
+            return true;
+        case khAstBinaryExpressionType_BIT_LSHIFT:
+            *result = (int64_t)((uint64_t)left << (right & 63));
+            return true;
+        case khAstBinaryExpressionType_BIT_RSHIFT:
+            *result = left >> (right & 63);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static bool foldFloating(khAstBinaryExpressionType type, double left, double right, double* result) {
+    switch (type) {
+        case khAstBinaryExpressionType_ADD:
+            *result = left + right;
+            break;
+        case khAstBinaryExpressionType_SUB:
+            *result = left - right;
+            break;
+        case khAstBinaryExpressionType_MUL:
+            *result = left * right;
+            break;
+        case khAstBinaryExpressionType_DIV:
+            *result = left / right;
+            break;
+        case khAstBinaryExpressionType_MOD:
+            *result = fmod(left, right);
+            break;
+        case khAstBinaryExpressionType_POW:
+            *result = pow(left, right);
+            break;
+        default:
+            return false;
+    }
+
+    // Infinities and NaNs are left to runtime, as literals can't be of them
+    return isfinite(*result);
+}
+
+static void foldUnary(khAstExpression* expression) {
+    khAstExpression* operand = expression->unary.operand;
+    khAstExpression result = *operand;
+
+    switch (expression->unary.type) {
+        case khAstUnaryExpressionType_POSITIVE:
+            if ((!isIntegral(operand) && !isFloating(operand)) || !isInIntRange(operand)) {
+                return;
+            }
+            break;
+
+        case khAstUnaryExpressionType_NEGATIVE:
+            if (operand->type == khAstExpressionType_INTEGER) {
+                result.integer = (int64_t)(0 - (uint64_t)operand->integer);
+            }
+            // The least int is lexed as a uint, being one more than the greatest
+            else if (operand->type == khAstExpressionType_UINTEGER &&
+                     operand->uinteger == (uint64_t)INT64_MAX + 1) {
+                result.type = khAstExpressionType_INTEGER;
+                result.integer = INT64_MIN;
+            }
+            else if (operand->type == khAstExpressionType_UINTEGER) {
+                // Any other negated uint but 0 is below it, which is left to the VM
+                if (operand->uinteger != 0) {
+                    return;
+                }
+            }
+            else if (operand->type == khAstExpressionType_FLOAT) {
+                result.float_v = -operand->float_v;
+            }
+            else if (operand->type == khAstExpressionType_DOUBLE) {
+                result.double_v = -operand->double_v;
+            }
+            else {
+                return;
+            }
+            break;
+
+        // Only of ints, as it's negative for any uint within an int
+        case khAstUnaryExpressionType_BIT_NOT:
+            if (operand->type != khAstExpressionType_INTEGER) {
+                return;
+            }
+            result.integer = ~operand->integer;
+            break;
+
+        // Results of not are bools, which don't have literals
+        default:
+            return;
+    }
+
+    replaceExpression(expression, result);
+}
+
+static void foldBinary(khAstExpression* expression) {
+    khAstBinaryExpressionType type = expression->binary.type;
+    khAstExpression* left = expression->binary.left;
+    khAstExpression* right = expression->binary.right;
+    khAstExpression result = {.type = khAstExpressionType_INVALID};
+
+    if (left->type == khAstExpressionType_STRING && right->type == khAstExpressionType_STRING) {
+        if (type != khAstBinaryExpressionType_ADD) {
+            return;
+        }
+
+        result.type = khAstExpressionType_STRING;
+        result.string = kharray_arenaCopy(&left->string, NULL, optimize_arena);
+        khstring_concatenate(&result.string, &right->string);
+    }
+    else if (!isInIntRange(left) || !isInIntRange(right)) {
+        return;
+    }
+    // Ints with uints aren't folded, as which one they'd be isn't known here
+    else if (isIntegral(left) && left->type == right->type) {
+        result.type = left->type;
+        if (!foldInteger(type, left->integer, right->integer, &result.integer) ||
+            (result.type == khAstExpressionType_UINTEGER && result.integer < 0)) {
+            return;
+        }
+    }
+    // Ints are promoted to either, floats stay floats with each other and doubles with any
+    else if ((isFloating(left) || isFloating(right)) && (isIntegral(left) || isFloating(left)) &&
+             (isIntegral(right) || isFloating(right))) {
+        bool is_double = left->type == khAstExpressionType_DOUBLE ||
+                         right->type == khAstExpressionType_DOUBLE;
+
+        double value;
+        if (!foldFloating(type, floatingOf(left), floatingOf(right), &value)) {
+            return;
+        }
+
+        if (is_double) {
+            result.type = khAstExpressionType_DOUBLE;
+            result.double_v = value;
+        }
+        else {
+            result.type = khAstExpressionType_FLOAT;
+            result.float_v = (float)value;
+        }
+    }
+    else {
+        return;
+    }
+
+    replaceExpression(expression, result);
+}
+
+// A chosen branch takes its ternary's place
+static void foldTernary(khAstExpression* expression) {
+    khAstExpression* condition = expression->ternary.condition;
+    if (!isIntegral(condition) || !isInIntRange(condition)) {
+        return;
+    }
+
+    khAstExpression* chosen =
+        condition->uinteger != 0 ? expression->ternary.value : expression->ternary.otherwise;
+    replaceExpression(expression, khAstExpression_move(chosen));
+}
+
+static void foldExpression(khAstExpression* expression) {
+    switch (expression->type) {
+        case khAstExpressionType_UNARY:
+            foldUnary(expression);
+            break;
+        case khAstExpressionType_BINARY:
+            foldBinary(expression);
+            break;
+        case khAstExpressionType_TERNARY:
+            foldTernary(expression);
+            break;
+        default:
+            break;
+    }
+}
+
+
+// Whether the condition is known, being of literals; floats aren't conditions, so they aren't either
+static bool constantCondition(khAstExpression* expression, bool* value) {
+    switch (expression->type) {
+        case khAstExpressionType_INTEGER:
+        case khAstExpressionType_UINTEGER:
+            *value = expression->uinteger != 0;
+            return true;
+        case khAstExpressionType_CHAR:
+            *value = expression->char_v != 0;
+            return true;
+        case khAstExpressionType_BYTE:
+            *value = expression->byte != 0;
+            return true;
+
+        case khAstExpressionType_UNARY:
+            if (expression->unary.type != khAstUnaryExpressionType_NOT ||
+                !constantCondition(expression->unary.operand, value)) {
+                return false;
+            }
+            *value = !*value;
+            return true;
+
+        // Short-circuiting, so the right side doesn't have to be known if the left one decides
+        case khAstExpressionType_BINARY: {
+            khAstBinaryExpressionType type = expression->binary.type;
+            if (type != khAstBinaryExpressionType_AND && type != khAstBinaryExpressionType_OR) {
+                return false;
+            }
+
+            bool left;
+            if (!constantCondition(expression->binary.left, &left)) {
+                return false;
+            }
+            else if (left == (type == khAstBinaryExpressionType_OR)) {
+                *value = left;
+                return true;
+            }
+            return constantCondition(expression->binary.right, value);
+        }
+
+        case khAstExpressionType_COMPARISON: {
+            khAstComparisonExpression* comparison = &expression->comparison;
+            for (size_t i = 0; i < kharray_size(&comparison->operands); i++) {
+                khAstExpression* operand = &comparison->operands[i];
+                if (!isIntegral(operand) && !isFloating(operand)) {
+                    return false;
+                }
+                // Again, ints with uints aren't known
+                else if (isIntegral(operand) && operand->type != comparison->operands[0].type &&
+                         isIntegral(&comparison->operands[0])) {
+                    return false;
+                }
+            }
+
+            *value = true;
+            for (size_t i = 0; i < kharray_size(&comparison->operations) && *value; i++) {
+                khAstExpression* a = &comparison->operands[i];
+                khAstExpression* b = &comparison->operands[i + 1];
+                int order;
+
+                if (a->type == khAstExpressionType_INTEGER && b->type == khAstExpressionType_INTEGER) {
+                    order = (a->integer > b->integer) - (a->integer < b->integer);
+                }
+                else if (isIntegral(a) && isIntegral(b)) {
+                    order = (a->uinteger > b->uinteger) - (a->uinteger < b->uinteger);
+                }
+                else {
+                    double x = floatingOf(a), y = floatingOf(b);
+                    order = (x > y) - (x < y);
+                }
+
+                switch (comparison->operations[i]) {
+                    case khAstComparisonExpressionType_EQUAL:
+                        *value = order == 0;
+                        break;
+                    case khAstComparisonExpressionType_UNEQUAL:
+                        *value = order != 0;
+                        break;
+                    case khAstComparisonExpressionType_LESS:
+                        *value = order < 0;
+                        break;
+                    case khAstComparisonExpressionType_GREATER:
+                        *value = order > 0;
+                        break;
+                    case khAstComparisonExpressionType_LESS_EQUAL:
+                        *value = order <= 0;
+                        break;
+                    case khAstComparisonExpressionType_GREATER_EQUAL:
+                        *value = order >= 0;
+                        break;
+                }
+            }
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+// Arms which are never taken are removed, and one which always is becomes the else block, with what's
+// after it removed; whether anything of it is left is returned
+static bool pruneIfBranch(khAstIfBranch* if_branch) {
+    for (size_t i = 0; i < kharray_size(&if_branch->branch_conditions);) {
+        bool value;
+        if (!constantCondition(&if_branch->branch_conditions[i], &value)) {
+            i++;
+        }
+        else if (!value) {
+            removeItems(&if_branch->branch_conditions, i, 1, true);
+            removeItems(&if_branch->branch_blocks, i, 1, true);
+        }
+        else {
+            discardBlock(&if_branch->else_block);
+            if_branch->else_block = if_branch->branch_blocks[i];
+
+            size_t count = kharray_size(&if_branch->branch_conditions) - i;
+            removeItems(&if_branch->branch_conditions, i, count, true);
+            removeItems(&if_branch->branch_blocks, i, 1, false);
+            removeItems(&if_branch->branch_blocks, i, count - 1, true);
+            break;
+        }
+    }
+
+    return kharray_size(&if_branch->branch_conditions) > 0 || kharray_size(&if_branch->else_block) > 0;
+}
+
+// Declarations stay, even if they're never reached, as they're declared wherever they are
+static inline bool isDeclaration(khAstStatement* statement, bool is_top_level) {
+    switch (statement->type) {
+        case khAstStatementType_IMPORT:
+        case khAstStatementType_INCLUDE:
+        case khAstStatementType_FUNCTION:
+        case khAstStatementType_CLASS:
+        case khAstStatementType_STRUCT:
+        case khAstStatementType_ENUM:
+        case khAstStatementType_ALIAS:
+            return true;
+        case khAstStatementType_VARIABLE:
+            return is_top_level;
+        default:
+            return false;
+    }
+}
+
+static void pruneStatements(kharray(khAstStatement) * block, bool is_top_level) {
+    bool is_reached = true;
+
+    for (size_t i = 0; i < kharray_size(block);) {
+        khAstStatement* statement = &(*block)[i];
+        bool is_kept = is_reached || isDeclaration(statement, is_top_level);
+
+        if (is_kept && statement->type == khAstStatementType_IF_BRANCH) {
+            is_kept = pruneIfBranch(&statement->if_branch);
+        }
+        else if (is_kept && statement->type == khAstStatementType_WHILE_LOOP) {
+            bool value;
+            is_kept = !constantCondition(&statement->while_loop.condition, &value) || value;
+        }
+        else if (statement->type == khAstStatementType_RETURN ||
+                 statement->type == khAstStatementType_BREAK ||
+                 statement->type == khAstStatementType_CONTINUE) {
+            is_reached = false;
+        }
+
+        if (is_kept) {
+            i++;
+        }
+        else {
+            removeItems(block, i, 1, true);
+        }
+    }
+}
+
+static void pruneBlock(kharray(khAstStatement) * block) {
+    pruneStatements(block, false);
+}
+
+
+void kh_optimize(kharray(khAstStatement) * ast, khAstPass passes, khArena* arena) {
+    khArena* previous_arena = optimize_arena;
+    optimize_arena = arena;
+
+    if (passes & khAstPass_FOLD) {
+        Pass fold = {.expression = foldExpression, .block = NULL};
+        for (size_t i = 0; i < kharray_size(ast); i++) {
+            walkStatement(&fold, &(*ast)[i]);
+        }
+    }
+
+    // The top-level is pruned on its own, as its variables are declarations too
+    if (passes & khAstPass_PRUNE) {
+        Pass prune = {.expression = NULL, .block = pruneBlock};
+        for (size_t i = 0; i < kharray_size(ast); i++) {
+            walkStatement(&prune, &(*ast)[i]);
+        }
+        pruneStatements(ast, true);
+    }
+
+    optimize_arena = previous_arena;
+}
@@ -5,145 +5,559 @@
  * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
  */
 
+#include <string.h>
+
 #include <kithare/core/error.h>
 #include <kithare/core/lexer.h>
 #include <kithare/core/parser.h>
+#include <kithare/core/stats.h>
 #include <kithare/core/token.h>
 
 
-static inline void raiseError(char32_t* ptr, const char32_t* message) {
+// The arena which `kh_parseArena` is placing the AST in, NULL when it's on the heap
+static _Thread_local khArena* parse_arena = NULL;
+
+// Allocators for the AST nodes, arrays and strings
+static inline void* allocate(size_t size) {
+    kh_countAllocation(size);
+    return parse_arena != NULL ? khArena_allocate(parse_arena, size) : malloc(size);
+}
+
+static inline void deallocate(void* memory) {
+    if (parse_arena == NULL) {
+        free(memory);
+    }
+}
+
+#define newArray(TYPE, DELETER) kharray_arenaNew(TYPE, DELETER, parse_arena)
+#define copyArray(ARRAY) kharray_arenaCopy(ARRAY, NULL, parse_arena)
+
+static inline void raiseError(uint8_t* ptr, const char32_t* message) {
     kh_raiseError((khError){.type = khErrorType_PARSER, .message = khstring_new(message), .data = ptr});
 }
 
 // Token getter function
-static inline khToken currentToken(char32_t** cursor, bool ignore_newline) {
-    char32_t* cursor_copy = *cursor;
-    khToken token = kh_lexToken(&cursor_copy);
-
-    // Ignoring newlines means that it would lex the next token if a newline token was encountered
-    while (token.type == khTokenType_COMMENT || (token.type == khTokenType_NEWLINE && ignore_newline)) {
-        khToken_delete(&token);
-        *cursor = cursor_copy;
-        token = kh_lexToken(&cursor_copy);
+static inline khToken* currentToken(khToken** cursor, bool ignore_newline) {
+    // Ignoring newlines means that it would pass through the newline tokens that were encountered
+    while ((*cursor)->type == khTokenType_COMMENT ||
+           ((*cursor)->type == khTokenType_NEWLINE && ignore_newline)) {
+        (*cursor)++;
     }
 
-    return token;
+    return *cursor;
 }
 
 // Basically, a sort of `next` function
-static inline void skipToken(char32_t** cursor) {
-    char32_t* origin = *cursor;
-    khToken token = kh_lexToken(cursor);
-
-    // Ignoring comments, lex the next token
-    while (token.type == khTokenType_COMMENT) {
-        khToken_delete(&token);
-        token = kh_lexToken(cursor);
+static inline void skipToken(khToken** cursor) {
+    // Ignoring comments, pass to the next token
+    while ((*cursor)->type == khTokenType_COMMENT) {
+        (*cursor)++;
     }
 
-    khToken_delete(&token);
-
-    // To avoid being stuck at the same token
-    if (origin == *cursor && **cursor != U'\0') {
+    // The EOF token is the last one in the stream, never go past it
+    if ((*cursor)->type != khTokenType_EOF) {
         (*cursor)++;
     }
 }
 
-static inline bool isEnd(char32_t** cursor) {
-    char32_t* cursor_copy = *cursor;
-    khToken token = kh_lexToken(&cursor_copy);
+static inline bool isEnd(khToken** cursor) {
+    khToken* token = *cursor;
 
     // Ignoring newlines and comments
-    while (token.type == khTokenType_COMMENT || token.type == khTokenType_NEWLINE) {
-        khToken_delete(&token);
-        token = kh_lexToken(&cursor_copy);
+    while (token->type == khTokenType_COMMENT || token->type == khTokenType_NEWLINE) {
+        token++;
     }
 
-    if (token.type == khTokenType_EOF) {
-        khToken_delete(&token);
-        return true;
-    }
-    else {
-        khToken_delete(&token);
-        return false;
-    }
+    return token->type == khTokenType_EOF;
+}
+
+// Where the previously passed token ends, used for the end of an AST node. Only call this after a token
+// has been passed
+static inline uint8_t* previousEnd(khToken** cursor) {
+    return khToken_end(&(*cursor)[-1]);
+}
+
+
+kharray(khAstStatement) kh_parse(khbuffer* buffer) {
+    return kh_parseArena(buffer, NULL);
 }
 
+kharray(khAstStatement) kh_parseArena(khbuffer* buffer, khArena* arena) {
+    khArena* previous_arena = parse_arena;
+    parse_arena = arena;
+
+    kharray(khAstStatement) statements = newArray(khAstStatement, khAstStatement_delete);
 
-kharray(khAstStatement) kh_parse(khstring* string) {
-    kharray(khAstStatement) statements = kharray_new(khAstStatement, khAstStatement_delete);
-    char32_t* cursor = *string;
+    // Lexicates the whole source once, keeping the EOF token at the end of the stream. Both stop early
+    // once there are too many errors, see `kh_setErrorLimit`, with the EOF token where lexing stopped
+    kharray(khToken) tokens = kh_lexicate(buffer);
+    size_t count = kharray_size(&tokens);
+    uint8_t* end = count > 0 ? khToken_end(&tokens[count - 1]) : *buffer;
+    kharray_append(&tokens, kh_isErrorLimitReached() ? khToken_fromEof(end, end) : kh_lexToken(&end));
 
-    while (!isEnd(&cursor)) {
+    kh_startTimer(parse_timer);
+    khToken* cursor = tokens;
+    while (!isEnd(&cursor) && !kh_isErrorLimitReached()) {
         kharray_append(&statements, kh_parseStatement(&cursor));
     }
+    kh_stopTimer(parse_timer, khStatsPhase_PARSE);
 
+    kh_countAst(&statements);
+
+    kharray_delete(&tokens);
+    parse_arena = previous_arena;
     return statements;
 }
 
 
+// Where the old statement begins in the edited source
+static inline uint8_t* movedBegin(khSyntaxTree* tree, uint8_t* old_source, size_t index,
+                                  ptrdiff_t delta) {
+    return tree->source + (tree->ast[index].begin - old_source) + delta;
+}
+
+// Lexes on until a token begins at the limit or after it, which is held back while an EOF token stands
+// in for it. Without a limit, it lexes until the actual end. Errors are kept with the token they're in,
+// as they might point to where it ends
+static bool lexUntil(uint8_t** cursor, uint8_t* limit, kharray(khToken) * tokens, khToken* held,
+                     bool is_holding, kharray(khError) * errors, kharray(uint8_t*) * error_tokens) {
+    if (is_holding) {
+        if (limit != NULL && held->begin >= limit) {
+            kharray_append(tokens, khToken_fromEof(held->begin, held->begin));
+            return true;
+        }
+        kharray_append(tokens, *held);
+    }
+
+    while (true) {
+        kharray(khError) previous_errors = kh_swapErrors(*errors);
+        khToken token = kh_lexToken(cursor);
+        *errors = kh_swapErrors(previous_errors);
+        while (kharray_size(error_tokens) < kharray_size(errors)) {
+            kharray_append(error_tokens, token.begin);
+        }
+
+        if (token.type != khTokenType_EOF && limit != NULL && token.begin >= limit) {
+            *held = token;
+            kharray_append(tokens, khToken_fromEof(token.begin, token.begin));
+            return true;
+        }
+
+        kharray_append(tokens, token);
+        if (token.type == khTokenType_EOF) {
+            return false;
+        }
+    }
+}
+
+// Parses the statements from the `first` one again in the new source, until one begins right where an
+// old one after the edit does; that one and the others after it are kept, as they see the same tokens.
+// A statement only sees the tokens up to where the next one begins, so the source is lexed until a
+// later old statement, and the last statement before it is parsed again if it went on to there. The
+// old source is only there for the old positions, it might be overwritten or freed already
+static void reparse(khSyntaxTree* tree, uint8_t* old_source, size_t old_size, size_t first,
+                    size_t edit_end, ptrdiff_t delta) {
+    uint8_t* source = tree->source;
+    size_t statements = kharray_size(&tree->ast);
+    size_t region_begin = first > 0 ? tree->ast[first].begin - old_source : 0;
+
+    size_t resume = first + 1;
+    while (resume < statements && (size_t)(tree->ast[resume].begin - old_source) < edit_end) {
+        resume++;
+    }
+    size_t target = resume + 1;
+
+    // Errors and identifiers of a tree are kept apart from the thread's, which are swapped out while
+    // it's being parsed
+    khInterner previous_identifiers = kh_swapIdentifiers(tree->identifiers);
+    khArena* previous_arena = parse_arena;
+    parse_arena = &tree->arena;
+
+    kharray(khToken) tokens = kharray_new(khToken, NULL);
+    kharray(khError) lexer_errors = kharray_new(khError, khError_delete);
+    kharray(uint8_t*) error_tokens = kharray_new(uint8_t*, NULL);
+    uint8_t* lexer_cursor = source + region_begin;
+    khToken held;
+    uint8_t* limit = target < statements ? movedBegin(tree, old_source, target, delta) : NULL;
+    bool is_holding = lexUntil(&lexer_cursor, limit, &tokens, &held, false, &lexer_errors,
+                               &error_tokens);
+
+    // The statements parsed again, with where their tokens and their errors start
+    kharray(khAstStatement) region = kharray_arenaNew(khAstStatement, NULL, &tree->arena);
+    kharray(khError) region_errors = kharray_new(khError, khError_delete);
+    kharray(size_t) token_starts = kharray_new(size_t, NULL);
+    kharray(size_t) region_error_starts = kharray_new(size_t, NULL);
+
+    size_t position = 0;
+    while (true) {
+        khToken* cursor = tokens + position;
+        if (isEnd(&cursor)) {
+            if (!is_holding) {
+                resume = statements;
+                break;
+            }
+
+            // The last statement could go on past where the tokens stop, it's tried again with twice as
+            // many old statements lexed
+            size_t last = kharray_size(&region);
+            if (last > 0) {
+                position = token_starts[last - 1];
+                tree->stale += region[last - 1].end - region[last - 1].begin;
+                size_t raised = kharray_size(&region_errors) - region_error_starts[last - 1];
+                kharray_pop(&region_errors, raised);
+                kharray_pop(&region, 1);
+                kharray_pop(&token_starts, 1);
+                kharray_pop(&region_error_starts, 1);
+            }
+
+            kharray_pop(&tokens, 1);
+            target += target - first;
+            limit = target < statements ? movedBegin(tree, old_source, target, delta) : NULL;
+            is_holding = lexUntil(&lexer_cursor, limit, &tokens, &held, true, &lexer_errors,
+                                  &error_tokens);
+            continue;
+        }
+
+        uint8_t* begin = currentToken(&cursor, true)->begin;
+        while (resume < statements && movedBegin(tree, old_source, resume, delta) < begin) {
+            resume++;
+        }
+        if (resume < statements && movedBegin(tree, old_source, resume, delta) == begin) {
+            break;
+        }
+
+        kharray_append(&token_starts, (size_t)(cursor - tokens));
+        kharray_append(&region_error_starts, kharray_size(&region_errors));
+
+        kharray(khError) previous_errors = kh_swapErrors(kharray_new(khError, khError_delete));
+        kharray_append(&region, kh_parseStatement(&cursor));
+        kharray(khError) raised = kh_swapErrors(previous_errors);
+
+        kharray_move(&region_errors, &raised);
+        position = cursor - tokens;
+    }
+
+    parse_arena = previous_arena;
+    tree->identifiers = kh_swapIdentifiers(previous_identifiers);
+    kharray_delete(&tokens);
+    kharray_delete(&token_starts);
+
+    // Then the statements and errors before and after the parsed region are moved along with the source
+    size_t region_end =
+        resume < statements ? (size_t)(tree->ast[resume].begin - old_source) : old_size;
+    uint8_t* cut = resume < statements ? movedBegin(tree, old_source, resume, delta) : NULL;
+    ptrdiff_t prefix_offset = (ptrdiff_t)((uintptr_t)source - (uintptr_t)old_source);
+    ptrdiff_t suffix_offset = prefix_offset + delta;
+
+    size_t prefix_errors = first > 0 ? tree->error_starts[first] : 0;
+    size_t suffix_errors =
+        resume < statements ? tree->error_starts[resume] : kharray_size(&tree->errors);
+
+    kharray(khAstStatement) ast = kharray_arenaNew(khAstStatement, NULL, &tree->arena);
+    kharray(khError) errors = kharray_new(khError, khError_delete);
+    kharray(size_t) error_starts = kharray_new(size_t, NULL);
+    kharray_reserve(&ast, first + kharray_size(&region) + statements - resume);
+    kharray_reserve(&error_starts, first + kharray_size(&region) + statements - resume);
+
+    for (size_t i = 0; i < first; i++) {
+        if (prefix_offset != 0) {
+            khAstStatement_relocate(&tree->ast[i], prefix_offset);
+        }
+        kharray_append(&ast, tree->ast[i]);
+        kharray_append(&error_starts, tree->error_starts[i]);
+    }
+    for (size_t i = 0; i < prefix_errors; i++) {
+        tree->errors[i].data = (void*)((uintptr_t)tree->errors[i].data + prefix_offset);
+        kharray_append(&errors, tree->errors[i]);
+    }
+
+    // Lexer errors from before the first statement parsed again belong to the one before it
+    size_t lexer_error = 0;
+    for (size_t i = 0; i <= kharray_size(&region); i++) {
+        uint8_t* next = i < kharray_size(&region) ? region[i].begin : cut;
+        while (lexer_error < kharray_size(&lexer_errors) &&
+               (next == NULL || error_tokens[lexer_error] < next)) {
+            kharray_append(&errors, lexer_errors[lexer_error++]);
+        }
+
+        if (i < kharray_size(&region)) {
+            size_t errors_end = i + 1 < kharray_size(&region) ? region_error_starts[i + 1]
+                                                              : kharray_size(&region_errors);
+            kharray_append(&ast, region[i]);
+            kharray_append(&error_starts, kharray_size(&errors));
+            size_t errors_begin = region_error_starts[i];
+            kharray_memory(&errors, region_errors + errors_begin, errors_end - errors_begin, NULL);
+        }
+    }
+
+    for (size_t i = resume; i < statements; i++) {
+        if (suffix_offset != 0) {
+            khAstStatement_relocate(&tree->ast[i], suffix_offset);
+        }
+        kharray_append(&ast, tree->ast[i]);
+        kharray_append(&error_starts, tree->error_starts[i] - suffix_errors + kharray_size(&errors));
+    }
+    for (size_t i = suffix_errors; i < kharray_size(&tree->errors); i++) {
+        tree->errors[i].data = (void*)((uintptr_t)tree->errors[i].data + suffix_offset);
+        kharray_append(&errors, tree->errors[i]);
+    }
+
+    // The first statement has every error before it too
+    if (kharray_size(&error_starts) > 0) {
+        error_starts[0] = 0;
+    }
+
+    // Moved into the new array, so they mustn't be deleted again; the ones left behind are
+    for (size_t i = prefix_errors; i < suffix_errors; i++) {
+        khError_delete(&tree->errors[i]);
+    }
+    for (size_t i = lexer_error; i < kharray_size(&lexer_errors); i++) {
+        khError_delete(&lexer_errors[i]);
+    }
+
+    kharray(khError)* moved[] = {&tree->errors, &lexer_errors, &region_errors};
+    for (size_t i = 0; i < sizeof(moved) / sizeof(moved[0]); i++) {
+        kharray_forget(moved[i]);
+        kharray_delete(moved[i]);
+    }
+    kharray_delete(&tree->error_starts);
+    kharray_delete(&region_error_starts);
+    kharray_delete(&error_tokens);
+
+    tree->stale += region_end - region_begin;
+    tree->ast = ast;
+    tree->errors = errors;
+    tree->error_starts = error_starts;
+}
+
+khSyntaxTree khSyntaxTree_new(khbuffer source) {
+    khSyntaxTree tree = {.source = source,
+                         .errors = kharray_new(khError, khError_delete),
+                         .error_starts = kharray_new(size_t, NULL),
+                         .arena = khArena_new(),
+                         .identifiers = khInterner_new(),
+                         .stale = 0};
+    tree.ast = kharray_arenaNew(khAstStatement, NULL, &tree.arena);
+
+    reparse(&tree, source, khbuffer_size(&source), 0, 0, 0);
+    tree.stale = 0;
+    return tree;
+}
+
+void khSyntaxTree_delete(khSyntaxTree* tree) {
+    khbuffer_delete(&tree->source);
+    kharray_delete(&tree->errors);
+    kharray_delete(&tree->error_starts);
+    khArena_delete(&tree->arena);
+    khInterner_delete(&tree->identifiers);
+}
+
+void khSyntaxTree_edit(khSyntaxTree* tree, size_t begin, size_t end, const uint8_t* replacement,
+                       size_t size) {
+    uint8_t* old_source = tree->source;
+    size_t old_size = khbuffer_size(&tree->source);
+    end = end < old_size ? end : old_size;
+    begin = begin < end ? begin : end;
+    ptrdiff_t delta = (ptrdiff_t)size - (ptrdiff_t)(end - begin);
+    size_t new_size = old_size + delta;
+
+    // From the statement before the one where the edit begins, as the start of the latter could decide
+    // where the former ends, like an `else` would
+    size_t first = 0;
+    while (first + 1 < kharray_size(&tree->ast) &&
+           (size_t)(tree->ast[first + 1].begin - old_source) < begin) {
+        first++;
+    }
+    first = first > 0 ? first - 1 : 0;
+
+    // Edited in place, so the statements before it don't move unless the source has to grow; the bytes
+    // left after the end are zeroed, as sources end with a null
+    if (new_size > khbuffer_reserved(&tree->source)) {
+        size_t reserved = khbuffer_reserved(&tree->source) * 2;
+        khbuffer_reserve(&tree->source, new_size > reserved ? new_size : reserved);
+    }
+    if (new_size != old_size) {
+        memmove(tree->source + begin + size, tree->source + end, old_size - end);
+        kharray_setSize(&tree->source, new_size);
+    }
+    if (size > 0) {
+        memcpy(tree->source + begin, replacement, size);
+    }
+    if (new_size < old_size) {
+        memset(tree->source + new_size, 0, old_size - new_size);
+    }
+
+    // Parsed all again once the arena has as much stale as there's source, so it doesn't keep growing
+    if (tree->stale > new_size) {
+        khbuffer source = tree->source;
+        tree->source = khbuffer_new("");
+        khSyntaxTree_delete(tree);
+        *tree = khSyntaxTree_new(source);
+        return;
+    }
+
+    reparse(tree, old_source, old_size, first, end, delta);
+}
+
+
+// Lexes on by as many tokens as there already are, or to the actual end; an EOF token stands in for
+// the rest of the source until then. Returns whether the actual end was reached
+static bool lexMore(uint8_t** cursor, kharray(khToken) * tokens, bool is_holding) {
+    if (is_holding) {
+        kharray_pop(tokens, 1);
+    }
+
+    size_t count = kharray_size(tokens) > 256 ? kharray_size(tokens) : 256;
+    for (size_t i = 0; i < count; i++) {
+        kharray_append(tokens, kh_lexToken(cursor));
+        if ((*tokens)[kharray_size(tokens) - 1].type == khTokenType_EOF) {
+            return true;
+        }
+
+        if (kh_isErrorLimitReached()) {
+            kharray_append(tokens, khToken_fromEof(*cursor, *cursor));
+            return true;
+        }
+    }
+
+    kharray_append(tokens, khToken_fromEof(*cursor, *cursor));
+    return false;
+}
+
+void kh_parseStream(khbuffer* buffer, khArena* arena, khStatementCallback callback, void* context) {
+    khArena* previous_arena = parse_arena;
+    parse_arena = arena;
+
+    kharray(khToken) tokens = kharray_new(khToken, NULL);
+    uint8_t* lexer_cursor = *buffer;
+    bool is_lexed = lexMore(&lexer_cursor, &tokens, false);
+    size_t position = 0;
+
+    while (!kh_isErrorLimitReached()) {
+        khToken* cursor = tokens + position;
+        if (isEnd(&cursor)) {
+            if (is_lexed) {
+                break;
+            }
+
+            is_lexed = lexMore(&lexer_cursor, &tokens, true);
+            continue;
+        }
+
+        size_t previous_errors = kh_hasErrors();
+        khAstStatement statement = kh_parseStatement(&cursor);
+
+        // It might go on past where the tokens stop, so it's parsed again with twice as many of them,
+        // as `reparse` does, without what it raised
+        if (!is_lexed && isEnd(&cursor)) {
+            if (arena != NULL) {
+                khArena_reset(arena);
+            }
+            else {
+                khAstStatement_delete(&statement);
+            }
+            kh_truncateErrors(previous_errors);
+
+            is_lexed = lexMore(&lexer_cursor, &tokens, true);
+            continue;
+        }
+
+        position = cursor - tokens;
+        bool is_going_on = callback(&statement, context);
+        if (arena != NULL) {
+            khArena_reset(arena);
+        }
+        if (!is_going_on) {
+            break;
+        }
+
+        // The tokens of the statements given already are dropped once they're most of them
+        if (position * 2 > kharray_size(&tokens)) {
+            memmove(tokens, tokens + position, (kharray_size(&tokens) - position) * sizeof(khToken));
+            kharray_setSize(&tokens, kharray_size(&tokens) - position);
+            position = 0;
+        }
+    }
+
+    kharray_delete(&tokens);
+    parse_arena = previous_arena;
+}
+
+
 // Sub-level parsing levels
-static kharray(khAstStatement) sparseBlock(char32_t** cursor);
-static void sparseSpecifiers(char32_t** cursor, bool allow_incase, bool* is_incase, bool allow_static,
+static kharray(khAstStatement) sparseBlock(khToken** cursor);
+static void sparseSpecifiers(khToken** cursor, bool allow_incase, bool* is_incase, bool allow_static,
                              bool* is_static, bool ignore_newline);
-static khAstVariable sparseVariable(char32_t** cursor, bool no_static, bool no_unpacking,
+static khAstVariable sparseVariable(khToken** cursor, bool no_static, bool no_unpacking,
                                     bool ignore_newline);
-static khAstImport sparseImport(char32_t** cursor);
-static khAstInclude sparseInclude(char32_t** cursor);
-static khAstFunction sparseFunction(char32_t** cursor);
-static khAstClass sparseClass(char32_t** cursor);
-static khAstStruct sparseStruct(char32_t** cursor);
-static khAstEnum sparseEnum(char32_t** cursor);
-static khAstAlias sparseAlias(char32_t** cursor);
-static khAstIfBranch sparseIfBranch(char32_t** cursor);
-static khAstWhileLoop sparseWhileLoop(char32_t** cursor);
-static khAstDoWhileLoop sparseDoWhileLoop(char32_t** cursor);
-static khAstForLoop sparseForLoop(char32_t** cursor);
-static void sparseBreak(char32_t** cursor);
-static void sparseContinue(char32_t** cursor);
-static khAstReturn sparseReturn(char32_t** cursor);
-
-// Sub-level expression parsing levels, by lowest to highest precedence
+static khAstImport sparseImport(khToken** cursor);
+static khAstInclude sparseInclude(khToken** cursor);
+static khAstFunction sparseFunction(khToken** cursor);
+static khAstClass sparseClass(khToken** cursor);
+static khAstStruct sparseStruct(khToken** cursor);
+static khAstEnum sparseEnum(khToken** cursor);
+static khAstAlias sparseAlias(khToken** cursor);
+static khAstIfBranch sparseIfBranch(khToken** cursor);
+static khAstWhileLoop sparseWhileLoop(khToken** cursor);
+static khAstDoWhileLoop sparseDoWhileLoop(khToken** cursor);
+static khAstForLoop sparseForLoop(khToken** cursor);
+static void sparseBreak(khToken** cursor);
+static void sparseContinue(khToken** cursor);
+static khAstReturn sparseReturn(khToken** cursor);
+
+// How tightly the operators bind, from the loosest to the tightest
+typedef enum {
+    Precedence_NONE, // Not a binary operator
+    Precedence_ASSIGNMENT,
+    Precedence_TERNARY,
+    Precedence_OR,
+    Precedence_XOR,
+    Precedence_AND,
+    Precedence_NOT,
+    Precedence_COMPARISON,
+    Precedence_RANGE,
+    Precedence_BIT_OR,
+    Precedence_BIT_XOR,
+    Precedence_BIT_AND,
+    Precedence_SHIFT,
+    Precedence_ADD,
+    Precedence_MUL,
+    Precedence_UNARY,
+    Precedence_POW,
+    Precedence_POSTFIX // Only what `exparseReverseUnary` parses, the operands of `^`
+} Precedence;
+
+// Binary operators are parsed by precedence climbing, see `exparseBinary`
 #define EXPARSE_ARGS bool ignore_newline, bool filter_type
-static khAstExpression exparseIpAssignmentOperators(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseTernary(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseLogicalOr(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseLogicalXor(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseLogicalAnd(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseLogicalNot(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseComparisonOperators(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseRange(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseBitwiseOr(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseBitwiseXor(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseBitwiseAnd(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseBitwiseShifts(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseAddSub(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseMulDivModDot(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseUnary(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparsePow(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseReverseUnary(char32_t** cursor, EXPARSE_ARGS);
-static khAstExpression exparseOther(char32_t** cursor, EXPARSE_ARGS);
-
-static khAstExpression exparseSignature(char32_t** cursor, bool ignore_newline);
-static khAstExpression exparseLambda(char32_t** cursor, bool ignore_newline);
-static khAstExpression exparseDict(char32_t** cursor, bool ignore_newline);
-static kharray(khAstExpression) exparseList(char32_t** cursor, khDelimiterToken opening_delimiter,
+static khAstExpression exparseBinary(khToken** cursor, Precedence precedence, EXPARSE_ARGS);
+static khAstExpression exparseTernary(khToken** cursor, uint8_t* origin, khAstExpression value,
+                                      EXPARSE_ARGS);
+static khAstExpression exparseComparison(khToken** cursor, uint8_t* origin, khAstExpression first,
+                                         EXPARSE_ARGS);
+static khAstExpression exparseUnary(khToken** cursor, Precedence precedence, EXPARSE_ARGS);
+static khAstExpression exparseReverseUnary(khToken** cursor, EXPARSE_ARGS);
+static khAstExpression exparseOther(khToken** cursor, EXPARSE_ARGS);
+
+static khAstExpression exparseSignature(khToken** cursor, bool ignore_newline);
+static khAstExpression exparseLambda(khToken** cursor, bool ignore_newline);
+static khAstExpression exparseDict(khToken** cursor, bool ignore_newline);
+static kharray(khAstExpression) exparseList(khToken** cursor, khDelimiterToken opening_delimiter,
                                             khDelimiterToken closing_delimiter, EXPARSE_ARGS);
 
 
-khAstStatement kh_parseStatement(char32_t** cursor) {
-    khToken token = currentToken(cursor, true);
-    char32_t* origin = token.begin;
+khAstStatement kh_parseStatement(khToken** cursor) {
+    khToken* token = currentToken(cursor, true);
+    khToken* origin_token = token;
+    uint8_t* origin = token->begin;
     khAstStatement statement =
-        (khAstStatement){.begin = origin, .end = *cursor, .type = khAstStatementType_INVALID};
+        (khAstStatement){.begin = origin, .end = origin, .type = khAstStatementType_INVALID};
 
-    if (token.type == khTokenType_KEYWORD) {
-        switch (token.keyword) {
+    if (token->type == khTokenType_KEYWORD) {
+        switch (token->keyword) {
             case khKeywordToken_IMPORT: {
                 khAstImport import_v = sparseImport(cursor);
-                khToken_delete(&token);
                 statement = (khAstStatement){.begin = origin,
-                                             .end = *cursor,
+                                             .end = previousEnd(cursor),
                                              .type = khAstStatementType_IMPORT,
                                              .import_v = import_v};
                 goto end;
@@ -151,25 +565,22 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
 
             case khKeywordToken_INCLUDE: {
                 khAstInclude include = sparseInclude(cursor);
-                khToken_delete(&token);
                 statement = (khAstStatement){.begin = origin,
-                                             .end = *cursor,
+                                             .end = previousEnd(cursor),
                                              .type = khAstStatementType_INCLUDE,
                                              .include = include};
                 goto end;
             }
 
             case khKeywordToken_AS:
-                raiseError(token.begin, U"unexpected keyword");
+                raiseError(token->begin, U"unexpected keyword");
                 skipToken(cursor);
-                khToken_delete(&token);
                 goto end;
 
             case khKeywordToken_DEF: {
                 khAstFunction function = sparseFunction(cursor);
-                khToken_delete(&token);
                 statement = (khAstStatement){.begin = origin,
-                                             .end = *cursor,
+                                             .end = previousEnd(cursor),
                                              .type = khAstStatementType_FUNCTION,
                                              .function = function};
                 goto end;
@@ -177,9 +588,8 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
 
             case khKeywordToken_CLASS: {
                 khAstClass class_v = sparseClass(cursor);
-                khToken_delete(&token);
                 statement = (khAstStatement){.begin = origin,
-                                             .end = *cursor,
+                                             .end = previousEnd(cursor),
                                              .type = khAstStatementType_CLASS,
                                              .class_v = class_v};
                 goto end;
@@ -187,9 +597,8 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
 
             case khKeywordToken_STRUCT: {
                 khAstStruct struct_v = sparseStruct(cursor);
-                khToken_delete(&token);
                 statement = (khAstStatement){.begin = origin,
-                                             .end = *cursor,
+                                             .end = previousEnd(cursor),
                                              .type = khAstStatementType_STRUCT,
                                              .struct_v = struct_v};
                 goto end;
@@ -197,17 +606,19 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
 
             case khKeywordToken_ENUM: {
                 khAstEnum enum_v = sparseEnum(cursor);
-                khToken_delete(&token);
-                statement = (khAstStatement){
-                    .begin = origin, .end = *cursor, .type = khAstStatementType_ENUM, .enum_v = enum_v};
+                statement = (khAstStatement){.begin = origin,
+                                             .end = previousEnd(cursor),
+                                             .type = khAstStatementType_ENUM,
+                                             .enum_v = enum_v};
                 goto end;
             }
 
             case khKeywordToken_ALIAS: {
                 khAstAlias alias = sparseAlias(cursor);
-                khToken_delete(&token);
-                statement = (khAstStatement){
-                    .begin = origin, .end = *cursor, .type = khAstStatementType_ALIAS, .alias = alias};
+                statement = (khAstStatement){.begin = origin,
+                                             .end = previousEnd(cursor),
+                                             .type = khAstStatementType_ALIAS,
+                                             .alias = alias};
                 goto end;
             }
 
@@ -220,19 +631,17 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
             // Handling `incase` and `static` modifiers
             case khKeywordToken_INCASE:
             case khKeywordToken_STATIC: {
-                char32_t* previous = *cursor;
+                khToken* previous = *cursor;
                 sparseSpecifiers(cursor, true, NULL, true, NULL, true);
-                khToken_delete(&token);
                 token = currentToken(cursor, true);
                 *cursor = previous;
 
-                if (token.type == khTokenType_KEYWORD) {
-                    switch (token.keyword) {
+                if (token->type == khTokenType_KEYWORD) {
+                    switch (token->keyword) {
                         case khKeywordToken_DEF: {
                             khAstFunction function = sparseFunction(cursor);
-                            khToken_delete(&token);
                             statement = (khAstStatement){.begin = origin,
-                                                         .end = *cursor,
+                                                         .end = previousEnd(cursor),
                                                          .type = khAstStatementType_FUNCTION,
                                                          .function = function};
                             goto end;
@@ -240,9 +649,8 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
 
                         case khKeywordToken_CLASS: {
                             khAstClass class_v = sparseClass(cursor);
-                            khToken_delete(&token);
                             statement = (khAstStatement){.begin = origin,
-                                                         .end = *cursor,
+                                                         .end = previousEnd(cursor),
                                                          .type = khAstStatementType_CLASS,
                                                          .class_v = class_v};
                             goto end;
@@ -250,9 +658,8 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
 
                         case khKeywordToken_STRUCT: {
                             khAstStruct struct_v = sparseStruct(cursor);
-                            khToken_delete(&token);
                             statement = (khAstStatement){.begin = origin,
-                                                         .end = *cursor,
+                                                         .end = previousEnd(cursor),
                                                          .type = khAstStatementType_STRUCT,
                                                          .struct_v = struct_v};
                             goto end;
@@ -260,9 +667,8 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
 
                         case khKeywordToken_ALIAS: {
                             khAstAlias alias = sparseAlias(cursor);
-                            khToken_delete(&token);
                             statement = (khAstStatement){.begin = origin,
-                                                         .end = *cursor,
+                                                         .end = previousEnd(cursor),
                                                          .type = khAstStatementType_ALIAS,
                                                          .alias = alias};
                             goto end;
@@ -272,7 +678,6 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
                         case khKeywordToken_WILD:
                         case khKeywordToken_REF:
                         default: {
-                            khToken_delete(&token);
                             token = currentToken(cursor, true);
                             goto out;
                         }
@@ -280,7 +685,6 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
                 }
                 // Same goes with above
                 else {
-                    khToken_delete(&token);
                     token = currentToken(cursor, true);
                     goto out;
                 }
@@ -288,31 +692,27 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
 
             case khKeywordToken_IF: {
                 khAstIfBranch if_branch = sparseIfBranch(cursor);
-                khToken_delete(&token);
                 statement = (khAstStatement){.begin = origin,
-                                             .end = *cursor,
+                                             .end = previousEnd(cursor),
                                              .type = khAstStatementType_IF_BRANCH,
                                              .if_branch = if_branch};
                 goto end;
             }
 
             case khKeywordToken_ELIF:
-                raiseError(token.begin, U"no following if statement to have an elif statement");
+                raiseError(token->begin, U"no following if statement to have an elif statement");
                 skipToken(cursor);
-                khToken_delete(&token);
                 goto end;
 
             case khKeywordToken_ELSE:
-                raiseError(token.begin, U"no following if statement to have an else statement");
+                raiseError(token->begin, U"no following if statement to have an else statement");
                 skipToken(cursor);
-                khToken_delete(&token);
                 goto end;
 
             case khKeywordToken_FOR: {
                 khAstForLoop for_loop = sparseForLoop(cursor);
-                khToken_delete(&token);
                 statement = (khAstStatement){.begin = origin,
-                                             .end = *cursor,
+                                             .end = previousEnd(cursor),
                                              .type = khAstStatementType_FOR_LOOP,
                                              .for_loop = for_loop};
                 goto end;
@@ -320,9 +720,8 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
 
             case khKeywordToken_WHILE: {
                 khAstWhileLoop while_loop = sparseWhileLoop(cursor);
-                khToken_delete(&token);
                 statement = (khAstStatement){.begin = origin,
-                                             .end = *cursor,
+                                             .end = previousEnd(cursor),
                                              .type = khAstStatementType_WHILE_LOOP,
                                              .while_loop = while_loop};
                 goto end;
@@ -330,9 +729,8 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
 
             case khKeywordToken_DO: {
                 khAstDoWhileLoop do_while_loop = sparseDoWhileLoop(cursor);
-                khToken_delete(&token);
                 statement = (khAstStatement){.begin = origin,
-                                             .end = *cursor,
+                                             .end = previousEnd(cursor),
                                              .type = khAstStatementType_DO_WHILE_LOOP,
                                              .do_while_loop = do_while_loop};
                 goto end;
@@ -340,25 +738,22 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
 
             case khKeywordToken_BREAK: {
                 sparseBreak(cursor);
-                khToken_delete(&token);
-                statement =
-                    (khAstStatement){.begin = origin, .end = *cursor, .type = khAstStatementType_BREAK};
+                statement = (khAstStatement){
+                    .begin = origin, .end = previousEnd(cursor), .type = khAstStatementType_BREAK};
                 goto end;
             }
 
             case khKeywordToken_CONTINUE: {
                 sparseContinue(cursor);
-                khToken_delete(&token);
                 statement = (khAstStatement){
-                    .begin = origin, .end = *cursor, .type = khAstStatementType_CONTINUE};
+                    .begin = origin, .end = previousEnd(cursor), .type = khAstStatementType_CONTINUE};
                 goto end;
             }
 
             case khKeywordToken_RETURN: {
                 khAstReturn return_v = sparseReturn(cursor);
-                khToken_delete(&token);
                 statement = (khAstStatement){.begin = origin,
-                                             .end = *cursor,
+                                             .end = previousEnd(cursor),
                                              .type = khAstStatementType_RETURN,
                                              .return_v = return_v};
                 goto end;
@@ -368,122 +763,115 @@ khAstStatement kh_parseStatement(char32_t** cursor) {
                 goto out;
         }
     }
-    else if (token.type == khTokenType_EOF) {
-        raiseError(token.begin, U"expecting a statement, met with a dead end");
-        khToken_delete(&token);
+    else if (token->type == khTokenType_EOF) {
+        raiseError(token->begin, U"expecting a statement, met with a dead end");
         goto end;
     }
 out:
     // These keywords except `incase` indicate a variable declaration
-    if (token.type == khTokenType_KEYWORD &&
-        (token.keyword == khKeywordToken_REF || token.keyword == khKeywordToken_WILD ||
-         token.keyword == khKeywordToken_INCASE || token.keyword == khKeywordToken_STATIC)) {
+    if (token->type == khTokenType_KEYWORD &&
+        (token->keyword == khKeywordToken_REF || token->keyword == khKeywordToken_WILD ||
+         token->keyword == khKeywordToken_INCASE || token->keyword == khKeywordToken_STATIC)) {
         khAstVariable variable = sparseVariable(cursor, false, false, false);
-        statement = (khAstStatement){
-            .begin = origin, .end = *cursor, .type = khAstStatementType_VARIABLE, .variable = variable};
+        statement = (khAstStatement){.begin = origin,
+                                     .end = previousEnd(cursor),
+                                     .type = khAstStatementType_VARIABLE,
+                                     .variable = variable};
 
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     // Tests out whether this might be a specifierless variable declaration
-    else if (token.type == khTokenType_IDENTIFIER) {
+    else if (token->type == khTokenType_IDENTIFIER) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
 
-        if (token.type == khTokenType_DELIMITER &&
-            (token.delimiter == khDelimiterToken_COMMA || token.delimiter == khDelimiterToken_COLON)) {
-            *cursor = origin;
+        if (token->type == khTokenType_DELIMITER &&
+            (token->delimiter == khDelimiterToken_COMMA ||
+             token->delimiter == khDelimiterToken_COLON)) {
+            *cursor = origin_token;
             khAstVariable variable = sparseVariable(cursor, false, false, false);
             statement = (khAstStatement){.begin = origin,
-                                         .end = *cursor,
+                                         .end = previousEnd(cursor),
                                          .type = khAstStatementType_VARIABLE,
                                          .variable = variable};
         }
         else {
-            *cursor = origin;
+            *cursor = origin_token;
             khAstExpression expression = kh_parseExpression(cursor, false, false);
             statement = (khAstStatement){.begin = origin,
-                                         .end = *cursor,
+                                         .end = previousEnd(cursor),
                                          .type = khAstStatementType_EXPRESSION,
                                          .expression = expression};
         }
 
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     // Parses expression in the body if none of the keywords above are found
     else {
         khAstExpression expression = kh_parseExpression(cursor, false, false);
         statement = (khAstStatement){.begin = origin,
-                                     .end = *cursor,
+                                     .end = previousEnd(cursor),
                                      .type = khAstStatementType_EXPRESSION,
                                      .expression = expression};
 
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
 
     // Ensures EOF, newline, or semicolon
-    if (token.type == khTokenType_EOF || token.type == khTokenType_NEWLINE ||
-        (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_SEMICOLON)) {
+    if (token->type == khTokenType_EOF || token->type == khTokenType_NEWLINE ||
+        (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_SEMICOLON)) {
         skipToken(cursor);
     }
-    else if (token.type == khTokenType_DELIMITER &&
-             token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
+    else if (token->type == khTokenType_DELIMITER &&
+             token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
         // Do nothing
     }
     else {
         // Still skips a token, to prevent other being stuck at the same token
         skipToken(cursor);
-        raiseError(token.begin, U"expecting a newline or a semicolon");
+        raiseError(token->begin, U"expecting a newline or a semicolon");
     }
 
-    khToken_delete(&token);
-
 end:
     return statement;
 }
 
-static kharray(khAstStatement) sparseBlock(char32_t** cursor) {
-    kharray(khAstStatement) block = kharray_new(khAstStatement, khAstStatement_delete);
-    khToken token = currentToken(cursor, true);
+static kharray(khAstStatement) sparseBlock(khToken** cursor) {
+    kharray(khAstStatement) block = newArray(khAstStatement, khAstStatement_delete);
+    khToken* token = currentToken(cursor, true);
 
     // Ensures opening bracket
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_CURLY_BRACKET_OPEN) {
+    if (token->type == khTokenType_DELIMITER &&
+        token->delimiter == khDelimiterToken_CURLY_BRACKET_OPEN) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, true);
     }
     else {
-        raiseError(token.begin, U"expecting an opening curly bracket");
+        raiseError(token->begin, U"expecting an opening curly bracket");
     }
 
     // Gets the next statement until closing bracket
-    while (!(token.type == khTokenType_DELIMITER &&
-             token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE)) {
+    while (!(token->type == khTokenType_DELIMITER &&
+             token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE)) {
         // To make sure it won't get into an infinite loop
-        if (token.type == khTokenType_EOF) {
-            raiseError(token.begin, U"expecting a statement, met with a dead end");
-            khToken_delete(&token);
+        if (token->type == khTokenType_EOF) {
+            raiseError(token->begin, U"expecting a statement, met with a dead end");
             goto end;
         }
 
         kharray_append(&block, kh_parseStatement(cursor));
-        khToken_delete(&token);
         token = currentToken(cursor, true);
     }
 
     skipToken(cursor);
-    khToken_delete(&token);
 
 end:
     return block;
 }
 
-static void sparseSpecifiers(char32_t** cursor, bool allow_incase, bool* is_incase, bool allow_static,
+static void sparseSpecifiers(khToken** cursor, bool allow_incase, bool* is_incase, bool allow_static,
                              bool* is_static, bool ignore_newline) {
-    khToken token = currentToken(cursor, ignore_newline);
+    khToken* token = currentToken(cursor, ignore_newline);
 
     if (is_incase) {
         *is_incase = false;
@@ -492,31 +880,29 @@ static void sparseSpecifiers(char32_t** cursor, bool allow_incase, bool* is_inca
         *is_static = false;
     }
 
-    while (token.type == khTokenType_KEYWORD) {
-        switch (token.keyword) {
+    while (token->type == khTokenType_KEYWORD) {
+        switch (token->keyword) {
             case khKeywordToken_INCASE:
                 if (!allow_incase) {
-                    raiseError(token.begin, U"the `incase` keyword is not allowed here");
+                    raiseError(token->begin, U"the `incase` keyword is not allowed here");
                 }
                 else if (is_incase) {
                     *is_incase = true;
                 }
 
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, ignore_newline);
                 break;
 
             case khKeywordToken_STATIC:
                 if (!allow_static) {
-                    raiseError(token.begin, U"the `static` keyword is not allowed here");
+                    raiseError(token->begin, U"the `static` keyword is not allowed here");
                 }
                 else if (is_static) {
                     *is_static = true;
                 }
 
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, ignore_newline);
                 break;
 
@@ -526,16 +912,15 @@ static void sparseSpecifiers(char32_t** cursor, bool allow_incase, bool* is_inca
     }
 out:
 
-    khToken_delete(&token);
 }
 
-static khAstVariable sparseVariable(char32_t** cursor, bool no_static, bool no_unpacking,
+static khAstVariable sparseVariable(khToken** cursor, bool no_static, bool no_unpacking,
                                     bool ignore_newline) {
-    khToken token = currentToken(cursor, ignore_newline);
+    khToken* token = currentToken(cursor, ignore_newline);
     khAstVariable variable = {.is_static = false,
                               .is_wild = false,
                               .is_ref = false,
-                              .names = kharray_new(khstring, khstring_delete),
+                              .names = newArray(khstring, khstring_delete),
                               .opt_type = NULL,
                               .opt_initializer = NULL};
 
@@ -543,140 +928,127 @@ static khAstVariable sparseVariable(char32_t** cursor, bool no_static, bool no_u
     if (!no_static) {
         // `static` specifier
         sparseSpecifiers(cursor, false, NULL, true, &variable.is_static, ignore_newline);
-        khToken_delete(&token);
         token = currentToken(cursor, ignore_newline);
     }
 
     // `wild` specifier
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_WILD) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_WILD) {
         variable.is_wild = true;
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, ignore_newline);
     }
 
     // `ref` specifier
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_REF) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_REF) {
         variable.is_ref = true;
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, ignore_newline);
     }
 
     // Its name
-    if (token.type == khTokenType_IDENTIFIER) {
-        kharray_append(&variable.names, khstring_copy(&token.identifier));
+    if (token->type == khTokenType_IDENTIFIER) {
+        kharray_append(&variable.names, token->identifier);
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, ignore_newline);
     }
     else {
-        raiseError(token.begin, U"expecting a name for the variable in the declaration");
+        raiseError(token->begin, U"expecting a name for the variable in the declaration");
     }
 
     // Unpacking declaration
     // a, b := expression
-    if (!no_unpacking && token.type == khTokenType_DELIMITER &&
-        token.delimiter == khDelimiterToken_COMMA) {
+    if (!no_unpacking && token->type == khTokenType_DELIMITER &&
+        token->delimiter == khDelimiterToken_COMMA) {
         do {
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, ignore_newline);
 
-            if (token.type == khTokenType_IDENTIFIER) {
-                kharray_append(&variable.names, khstring_copy(&token.identifier));
+            if (token->type == khTokenType_IDENTIFIER) {
+                kharray_append(&variable.names, token->identifier);
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, ignore_newline);
             }
             else {
-                raiseError(token.begin,
+                raiseError(token->begin,
                            U"expecting another name after the comma in the unpacking declaration");
             }
-        } while (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COMMA);
+        } while (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_COMMA);
 
         // Mandatory `:=`
-        if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COLON) {
+        if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_COLON) {
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, ignore_newline);
         }
         else {
-            raiseError(token.begin, U"expecting a `:=` in the unpacking declaration");
+            raiseError(token->begin, U"expecting a `:=` in the unpacking declaration");
         }
 
-        if (token.type == khTokenType_OPERATOR && token.operator_v == khOperatorToken_ASSIGN) {
+        if (token->type == khTokenType_OPERATOR && token->operator_v == khOperatorToken_ASSIGN) {
             skipToken(cursor);
         }
         else {
-            raiseError(token.begin, U"expecting a `:=` in the unpacking declaration");
+            raiseError(token->begin, U"expecting a `:=` in the unpacking declaration");
         }
 
         // Mandatory initializer
-        variable.opt_initializer = malloc(sizeof(khAstExpression));
+        variable.opt_initializer = allocate(sizeof(khAstExpression));
         *variable.opt_initializer = kh_parseExpression(cursor, ignore_newline, false);
     }
     else {
         // Passes through the colon
-        if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COLON) {
+        if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_COLON) {
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, ignore_newline);
         }
         else {
-            raiseError(token.begin,
+            raiseError(token->begin,
                        U"expecting a colon to separate the name and the type of the variable");
         }
 
         // If there's no assign op at first, it's a type: `name: Type`
-        if (!(token.type == khTokenType_OPERATOR && token.operator_v == khOperatorToken_ASSIGN)) {
-            variable.opt_type = malloc(sizeof(khAstExpression));
+        if (!(token->type == khTokenType_OPERATOR && token->operator_v == khOperatorToken_ASSIGN)) {
+            variable.opt_type = allocate(sizeof(khAstExpression));
             *variable.opt_type = kh_parseExpression(cursor, ignore_newline, true);
 
-            khToken_delete(&token);
             token = currentToken(cursor, ignore_newline);
         }
 
         // Optional initializer
-        if (token.type == khTokenType_OPERATOR && token.operator_v == khOperatorToken_ASSIGN) {
+        if (token->type == khTokenType_OPERATOR && token->operator_v == khOperatorToken_ASSIGN) {
             skipToken(cursor);
-            variable.opt_initializer = malloc(sizeof(khAstExpression));
+            variable.opt_initializer = allocate(sizeof(khAstExpression));
             *variable.opt_initializer = kh_parseExpression(cursor, ignore_newline, false);
         }
     }
 
-    khToken_delete(&token);
     return variable;
 }
 
-static khAstImport sparseImport(char32_t** cursor) {
-    khToken token = currentToken(cursor, true);
+static khAstImport sparseImport(khToken** cursor) {
+    khToken* token = currentToken(cursor, true);
     khAstImport import_v = {
-        .path = kharray_new(khstring, khstring_delete), .relative = false, .opt_alias = NULL};
+        .path = newArray(khstring, khstring_delete), .relative = false, .opt_alias = NULL};
 
     // Ensures `import` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_IMPORT) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_IMPORT) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        raiseError(token.begin, U"expecting an `import` keyword");
+        raiseError(token->begin, U"expecting an `import` keyword");
     }
 
     // For relative imports, `import .a_script_file_in_the_same_folder`
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_DOT) {
+    if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_DOT) {
         skipToken(cursor);
         import_v.relative = true;
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
 
     // Minimum one identifier
-    if (token.type == khTokenType_IDENTIFIER) {
-        kharray_append(&import_v.path, khstring_copy(&token.identifier));
+    if (token->type == khTokenType_IDENTIFIER) {
+        kharray_append(&import_v.path, token->identifier);
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     // Directory import, `import .`
@@ -684,88 +1056,80 @@ static khAstImport sparseImport(char32_t** cursor) {
         goto finish;
     }
     else {
-        raiseError(token.begin, U"expecting something to import");
+        raiseError(token->begin, U"expecting something to import");
     }
 
     // Continues on
-    while (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_DOT) {
+    while (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_DOT) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
 
-        if (token.type == khTokenType_IDENTIFIER) {
-            kharray_append(&import_v.path, khstring_copy(&token.identifier));
+        if (token->type == khTokenType_IDENTIFIER) {
+            kharray_append(&import_v.path, token->identifier);
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, false);
         }
         else {
-            raiseError(token.begin, U"expecting another identifier");
+            raiseError(token->begin, U"expecting another identifier");
         }
     }
 
 finish:
     // `import something as another`
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_AS) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_AS) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
 
-        if (token.type == khTokenType_IDENTIFIER) {
-            import_v.opt_alias = malloc(sizeof(kharray(char)*));
-            *import_v.opt_alias = khstring_copy(&token.identifier);
+        if (token->type == khTokenType_IDENTIFIER) {
+            import_v.opt_alias = allocate(sizeof(kharray(char)*));
+            *import_v.opt_alias = token->identifier;
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, false);
         }
         else {
-            raiseError(token.begin, U"expecting an identifier to alias the imported module as");
+            raiseError(token->begin, U"expecting an identifier to alias the imported module as");
         }
     }
 
-    if (token.type == khTokenType_NEWLINE || token.type == khTokenType_EOF ||
-        (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_SEMICOLON)) {
+    if (token->type == khTokenType_NEWLINE || token->type == khTokenType_EOF ||
+        (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_SEMICOLON)) {
         skipToken(cursor);
     }
-    else if (token.type == khTokenType_DELIMITER &&
-             token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
+    else if (token->type == khTokenType_DELIMITER &&
+             token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
         // Do nothing
     }
     else {
-        raiseError(token.begin, U"expecting a newline or a semicolon");
+        raiseError(token->begin, U"expecting a newline or a semicolon");
     }
 
-    khToken_delete(&token);
     return import_v;
 }
 
-static khAstInclude sparseInclude(char32_t** cursor) {
-    khToken token = currentToken(cursor, true);
-    khAstInclude include = {.path = kharray_new(khstring, khstring_delete), .relative = false};
+static khAstInclude sparseInclude(khToken** cursor) {
+    khToken* token = currentToken(cursor, true);
+    khAstInclude include = {.path = newArray(khstring, khstring_delete), .relative = false};
 
     // Ensures `include` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_INCLUDE) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_INCLUDE) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        raiseError(token.begin, U"expecting an `include` keyword");
+        raiseError(token->begin, U"expecting an `include` keyword");
     }
 
     // For relative includes, `include .a_script_file_in_the_same_folder`
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_DOT) {
+    if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_DOT) {
         include.relative = true;
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
 
     // Minimum one identifier
-    if (token.type == khTokenType_IDENTIFIER) {
-        kharray_append(&include.path, khstring_copy(&token.identifier));
+    if (token->type == khTokenType_IDENTIFIER) {
+        kharray_append(&include.path, token->identifier);
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     // Directory include, `include .`
@@ -773,74 +1137,70 @@ static khAstInclude sparseInclude(char32_t** cursor) {
         goto finish;
     }
     else {
-        raiseError(token.begin, U"expecting something to include");
+        raiseError(token->begin, U"expecting something to include");
     }
 
     // Continues on
-    while (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_DOT) {
+    while (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_DOT) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
 
-        if (token.type == khTokenType_IDENTIFIER) {
-            kharray_append(&include.path, khstring_copy(&token.identifier));
+        if (token->type == khTokenType_IDENTIFIER) {
+            kharray_append(&include.path, token->identifier);
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, false);
         }
         else {
-            raiseError(token.begin, U"expecting another identifier");
+            raiseError(token->begin, U"expecting another identifier");
         }
     }
 
 finish:
-    if (token.type == khTokenType_NEWLINE || token.type == khTokenType_EOF ||
-        (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_SEMICOLON)) {
+    if (token->type == khTokenType_NEWLINE || token->type == khTokenType_EOF ||
+        (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_SEMICOLON)) {
         skipToken(cursor);
     }
-    else if (token.type == khTokenType_DELIMITER &&
-             token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
+    else if (token->type == khTokenType_DELIMITER &&
+             token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
         // Do nothing
     }
     else {
-        raiseError(token.begin, U"expecting a newline or a semicolon");
+        raiseError(token->begin, U"expecting a newline or a semicolon");
     }
 
-    khToken_delete(&token);
     return include;
 }
 
-static inline void sparseFunctionOrLambda(char32_t** cursor, kharray(khAstVariable) * arguments,
+static inline void sparseFunctionOrLambda(khToken** cursor, kharray(khAstVariable) * arguments,
                                           khAstVariable** opt_variadic_argument,
                                           bool* is_return_type_ref, khAstExpression** opt_return_type,
                                           kharray(khAstStatement) * block) {
-    khToken token = currentToken(cursor, false);
+    khToken* token = currentToken(cursor, false);
 
     // Starts out by parsing the argument
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_PARENTHESIS_OPEN) {
+    if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_PARENTHESIS_OPEN) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, true);
     }
     else {
-        raiseError(token.begin, U"expecting an opening parenthesis for the arguments");
+        raiseError(token->begin, U"expecting an opening parenthesis for the arguments");
     }
 
-    while (!(token.type == khTokenType_DELIMITER &&
-             token.delimiter == khDelimiterToken_PARENTHESIS_CLOSE)) {
+    while (!(token->type == khTokenType_DELIMITER &&
+             token->delimiter == khDelimiterToken_PARENTHESIS_CLOSE)) {
         // Variadic argument as the end
-        if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_ELLIPSIS) {
+        if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_ELLIPSIS) {
             skipToken(cursor);
 
-            *opt_variadic_argument = malloc(sizeof(khAstVariable));
+            *opt_variadic_argument = allocate(sizeof(khAstVariable));
             **opt_variadic_argument = sparseVariable(cursor, true, true, true);
 
-            khToken_delete(&token);
             token = currentToken(cursor, true);
 
-            if (!(token.type == khTokenType_DELIMITER &&
-                  token.delimiter == khDelimiterToken_PARENTHESIS_CLOSE)) {
-                raiseError(token.begin, U"expecting a closing parenthesis after the variadic argument");
+            if (!(token->type == khTokenType_DELIMITER &&
+                  token->delimiter == khDelimiterToken_PARENTHESIS_CLOSE)) {
+                raiseError(token->begin,
+                           U"expecting a closing parenthesis after the variadic argument");
             }
 
             break;
@@ -848,44 +1208,39 @@ static inline void sparseFunctionOrLambda(char32_t** cursor, kharray(khAstVariab
 
         // Parse argument
         kharray_append(arguments, sparseVariable(cursor, true, true, true));
-        khToken_delete(&token);
         token = currentToken(cursor, true);
 
-        if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COMMA) {
+        if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_COMMA) {
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, true);
         }
-        else if (token.type == khTokenType_DELIMITER &&
-                 token.delimiter == khDelimiterToken_PARENTHESIS_CLOSE) {
+        else if (token->type == khTokenType_DELIMITER &&
+                 token->delimiter == khDelimiterToken_PARENTHESIS_CLOSE) {
             // Do nothing
         }
-        else if (token.type == khTokenType_EOF) {
-            raiseError(token.begin,
+        else if (token->type == khTokenType_EOF) {
+            raiseError(token->begin,
                        U"expecting a comma with another argument or a closing parenthesis, "
                        U"met with a dead end");
             break;
         }
         else {
-            raiseError(token.begin,
+            raiseError(token->begin,
                        U"expecting a comma with another argument or a closing parenthesis");
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, true);
         }
     }
 
     skipToken(cursor);
-    khToken_delete(&token);
     token = currentToken(cursor, true);
 
     // Optional return type
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_ARROW) {
+    if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_ARROW) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, true);
 
-        if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_REF) {
+        if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_REF) {
             *is_return_type_ref = true;
             skipToken(cursor);
         }
@@ -893,25 +1248,23 @@ static inline void sparseFunctionOrLambda(char32_t** cursor, kharray(khAstVariab
             *is_return_type_ref = false;
         }
 
-        *opt_return_type = malloc(sizeof(khAstExpression));
+        *opt_return_type = allocate(sizeof(khAstExpression));
         **opt_return_type = kh_parseExpression(cursor, true, true);
 
-        khToken_delete(&token);
         token = currentToken(cursor, true);
     }
 
     // Body
     *block = sparseBlock(cursor);
 
-    khToken_delete(&token);
 }
 
-static khAstFunction sparseFunction(char32_t** cursor) {
+static khAstFunction sparseFunction(khToken** cursor) {
     khAstFunction function = {.is_incase = false,
                               .is_static = false,
-                              .identifiers = kharray_new(khstring, khstring_delete),
-                              .template_arguments = kharray_new(khstring, khstring_delete),
-                              .arguments = kharray_new(khAstVariable, khAstVariable_delete),
+                              .identifiers = newArray(khstring, khstring_delete),
+                              .template_arguments = newArray(khstring, khstring_delete),
+                              .arguments = newArray(khAstVariable, khAstVariable_delete),
                               .opt_variadic_argument = NULL,
                               .is_return_type_ref = false,
                               .opt_return_type = NULL,
@@ -920,81 +1273,74 @@ static khAstFunction sparseFunction(char32_t** cursor) {
     // Any specifiers: `incase static def function() { ... }`
     sparseSpecifiers(cursor, true, &function.is_incase, true, &function.is_static, true);
 
-    khToken token = currentToken(cursor, true);
+    khToken* token = currentToken(cursor, true);
 
     // Ensures `def` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_DEF) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_DEF) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        raiseError(token.begin, U"expecting a `def` keyword");
+        raiseError(token->begin, U"expecting a `def` keyword");
     }
 
     // Identifiers
     goto in;
-    while (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_DOT) {
+    while (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_DOT) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, true);
     in:
-        if (token.type == khTokenType_IDENTIFIER) {
-            kharray_append(&function.identifiers, khstring_copy(&token.identifier));
+        if (token->type == khTokenType_IDENTIFIER) {
+            kharray_append(&function.identifiers, token->identifier);
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, false);
         }
         else {
-            raiseError(token.begin, U"expecting an identifier or name of the function");
+            raiseError(token->begin, U"expecting an identifier or name of the function");
         }
     }
 
     // Any template args
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_EXCLAMATION) {
+    if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_EXCLAMATION) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
 
         // Single template argument: `def name!T`
-        if (token.type == khTokenType_IDENTIFIER) {
-            kharray_append(&function.template_arguments, khstring_copy(&token.identifier));
+        if (token->type == khTokenType_IDENTIFIER) {
+            kharray_append(&function.template_arguments, token->identifier);
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, false);
         }
         // Multiple template arguments in parentheses: `def name!(T, U)`
-        else if (token.type == khTokenType_DELIMITER &&
-                 token.delimiter == khDelimiterToken_PARENTHESIS_OPEN) {
+        else if (token->type == khTokenType_DELIMITER &&
+                 token->delimiter == khDelimiterToken_PARENTHESIS_OPEN) {
             do {
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, true);
 
-                if (token.type == khTokenType_IDENTIFIER) {
-                    kharray_append(&function.template_arguments, khstring_copy(&token.identifier));
+                if (token->type == khTokenType_IDENTIFIER) {
+                    kharray_append(&function.template_arguments, token->identifier);
                 }
                 else {
-                    raiseError(token.begin, U"expecting the name for a template argument");
+                    raiseError(token->begin, U"expecting the name for a template argument");
                 }
 
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, true);
-            } while (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COMMA);
+            } while (token->type == khTokenType_DELIMITER &&
+                     token->delimiter == khDelimiterToken_COMMA);
 
-            if (token.type == khTokenType_DELIMITER &&
-                token.delimiter == khDelimiterToken_PARENTHESIS_CLOSE) {
+            if (token->type == khTokenType_DELIMITER &&
+                token->delimiter == khDelimiterToken_PARENTHESIS_CLOSE) {
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, false);
             }
             else {
-                raiseError(token.begin, U"expecting a closing parenthesis");
+                raiseError(token->begin, U"expecting a closing parenthesis");
             }
         }
         else {
-            raiseError(token.begin, U"expecting template argument(s)");
+            raiseError(token->begin, U"expecting template argument(s)");
         }
     }
 
@@ -1002,212 +1348,198 @@ static khAstFunction sparseFunction(char32_t** cursor) {
     sparseFunctionOrLambda(cursor, &function.arguments, &function.opt_variadic_argument,
                            &function.is_return_type_ref, &function.opt_return_type, &function.block);
 
-    khToken_delete(&token);
     return function;
 }
 
-static inline void sparseClassOrStruct(char32_t** cursor, khstring* name,
+static inline void sparseClassOrStruct(khToken** cursor, khstring* name,
                                        kharray(khstring) * template_arguments,
                                        khAstExpression** opt_base_type,
                                        kharray(khAstStatement) * block) {
-    khToken token = currentToken(cursor, false);
+    khToken* token = currentToken(cursor, false);
 
     // Ensures the name identifier of the class or struct
-    if (token.type == khTokenType_IDENTIFIER) {
-        *name = khstring_copy(&token.identifier);
+    if (token->type == khTokenType_IDENTIFIER) {
+        *name = token->identifier;
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        *name = khstring_new(U"");
-        raiseError(token.begin, U"expecting a name for the type");
+        *name = kh_internIdentifier(NULL, 0);
+        raiseError(token->begin, U"expecting a name for the type");
     }
 
     // Any template args
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_EXCLAMATION) {
+    if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_EXCLAMATION) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
 
         // Single template argument: `class Name!T`
-        if (token.type == khTokenType_IDENTIFIER) {
-            kharray_append(template_arguments, khstring_copy(&token.identifier));
+        if (token->type == khTokenType_IDENTIFIER) {
+            kharray_append(template_arguments, token->identifier);
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, false);
         }
         // Multiple template arguments in parentheses: `class Name!(T, U)`
-        else if (token.type == khTokenType_DELIMITER &&
-                 token.delimiter == khDelimiterToken_PARENTHESIS_OPEN) {
+        else if (token->type == khTokenType_DELIMITER &&
+                 token->delimiter == khDelimiterToken_PARENTHESIS_OPEN) {
             do {
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, true);
 
-                if (token.type == khTokenType_IDENTIFIER) {
-                    kharray_append(template_arguments, khstring_copy(&token.identifier));
+                if (token->type == khTokenType_IDENTIFIER) {
+                    kharray_append(template_arguments, token->identifier);
                 }
                 else {
-                    raiseError(token.begin, U"expecting the name for a template argument");
+                    raiseError(token->begin, U"expecting the name for a template argument");
                 }
 
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, true);
-            } while (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COMMA);
+            } while (token->type == khTokenType_DELIMITER &&
+                     token->delimiter == khDelimiterToken_COMMA);
 
-            if (token.type == khTokenType_DELIMITER &&
-                token.delimiter == khDelimiterToken_PARENTHESIS_CLOSE) {
+            if (token->type == khTokenType_DELIMITER &&
+                token->delimiter == khDelimiterToken_PARENTHESIS_CLOSE) {
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, false);
             }
             else {
-                raiseError(token.begin, U"expecting a closing parenthesis");
+                raiseError(token->begin, U"expecting a closing parenthesis");
             }
         }
         else {
-            raiseError(token.begin, U"expecting template argument(s)");
+            raiseError(token->begin, U"expecting template argument(s)");
         }
     }
 
     // If a class is inheriting something: `class Name inherits Base`
-    if (opt_base_type != NULL && token.type == khTokenType_KEYWORD &&
-        token.keyword == khKeywordToken_INHERITS) {
+    if (opt_base_type != NULL && token->type == khTokenType_KEYWORD &&
+        token->keyword == khKeywordToken_INHERITS) {
         skipToken(cursor);
-        *opt_base_type = malloc(sizeof(khAstExpression));
+        *opt_base_type = allocate(sizeof(khAstExpression));
         **opt_base_type = kh_parseExpression(cursor, true, true);
 
-        khToken_delete(&token);
         token = currentToken(cursor, true);
     }
 
     // Parses its block
     *block = sparseBlock(cursor);
 
-    khToken_delete(&token);
 }
 
-static khAstClass sparseClass(char32_t** cursor) {
+static khAstClass sparseClass(khToken** cursor) {
     khAstClass class_v = {.is_incase = false,
                           .name = NULL,
-                          .template_arguments = kharray_new(khstring, khstring_delete),
+                          .template_arguments = newArray(khstring, khstring_delete),
                           .opt_base_type = NULL,
                           .block = NULL};
 
     // Any specifiers: `incase class E { ... }`
     sparseSpecifiers(cursor, true, &class_v.is_incase, false, NULL, true);
 
-    khToken token = currentToken(cursor, true);
+    khToken* token = currentToken(cursor, true);
 
     // Ensures `class` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_CLASS) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_CLASS) {
         skipToken(cursor);
     }
     else {
-        raiseError(token.begin, U"expecting a `class` keyword");
+        raiseError(token->begin, U"expecting a `class` keyword");
     }
 
     sparseClassOrStruct(cursor, &class_v.name, &class_v.template_arguments, &class_v.opt_base_type,
                         &class_v.block);
 
-    khToken_delete(&token);
     return class_v;
 }
 
-static khAstStruct sparseStruct(char32_t** cursor) {
+static khAstStruct sparseStruct(khToken** cursor) {
     khAstStruct struct_v = {.is_incase = false,
                             .name = NULL,
-                            .template_arguments = kharray_new(khstring, khstring_delete),
+                            .template_arguments = newArray(khstring, khstring_delete),
                             .block = NULL};
 
     // Any specifiers: `incase struct E { ... }`
     sparseSpecifiers(cursor, true, &struct_v.is_incase, false, NULL, true);
 
-    khToken token = currentToken(cursor, true);
+    khToken* token = currentToken(cursor, true);
 
     // Ensures `struct` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_STRUCT) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_STRUCT) {
         skipToken(cursor);
     }
     else {
-        raiseError(token.begin, U"expecting a `struct` keyword");
+        raiseError(token->begin, U"expecting a `struct` keyword");
     }
 
     sparseClassOrStruct(cursor, &struct_v.name, &struct_v.template_arguments, NULL, &struct_v.block);
 
-    khToken_delete(&token);
     return struct_v;
 }
 
-static khAstEnum sparseEnum(char32_t** cursor) {
-    khToken token = currentToken(cursor, true);
-    khAstEnum enum_v = {.name = NULL, .members = kharray_new(khstring, khstring_delete)};
+static khAstEnum sparseEnum(khToken** cursor) {
+    khToken* token = currentToken(cursor, true);
+    khAstEnum enum_v = {.name = NULL, .members = newArray(khstring, khstring_delete)};
 
     // No specifiers at all
     sparseSpecifiers(cursor, false, NULL, false, NULL, true);
 
     // Ensures `enum` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_ENUM) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_ENUM) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        raiseError(token.begin, U"expecting an `enum` keyword");
+        raiseError(token->begin, U"expecting an `enum` keyword");
     }
 
     // Its name
-    if (token.type == khTokenType_IDENTIFIER) {
-        enum_v.name = khstring_copy(&token.identifier);
+    if (token->type == khTokenType_IDENTIFIER) {
+        enum_v.name = token->identifier;
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        enum_v.name = khstring_new(U"");
-        raiseError(token.begin, U"expecting a name for the enum type");
+        enum_v.name = kh_internIdentifier(NULL, 0);
+        raiseError(token->begin, U"expecting a name for the enum type");
     }
 
     // Its members
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_CURLY_BRACKET_OPEN) {
-        skipToken(cursor);
-        khToken_delete(&token);
-        token = currentToken(cursor, true);
-
+    if (token->type == khTokenType_DELIMITER &&
+        token->delimiter == khDelimiterToken_CURLY_BRACKET_OPEN) {
         do {
-            if (token.type == khTokenType_IDENTIFIER) {
-                kharray_append(&enum_v.members, khstring_copy(&token.identifier));
+            // Skips the opening bracket, then each comma
+            skipToken(cursor);
+            token = currentToken(cursor, true);
+
+            if (token->type == khTokenType_IDENTIFIER) {
+                kharray_append(&enum_v.members, token->identifier);
+                skipToken(cursor);
+                token = currentToken(cursor, true);
             }
             else {
-                raiseError(token.begin, U"expecting a member name");
+                raiseError(token->begin, U"expecting a member name");
             }
-
-            skipToken(cursor);
-            khToken_delete(&token);
-            token = currentToken(cursor, true);
-        } while (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COMMA);
+        } while (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_COMMA);
 
         // Ensures closing bracket at the end
-        if (token.type == khTokenType_DELIMITER &&
-            token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
+        if (token->type == khTokenType_DELIMITER &&
+            token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
             skipToken(cursor);
         }
         else {
-            raiseError(token.begin,
+            raiseError(token->begin,
                        U"expecting a comma with another member or a closing curly bracket");
         }
     }
     else {
-        raiseError(token.begin, U"expecting a `class` keyword");
+        raiseError(token->begin, U"expecting a `class` keyword");
     }
 
-    khToken_delete(&token);
     return enum_v;
 }
 
-static khAstAlias sparseAlias(char32_t** cursor) {
+static khAstAlias sparseAlias(khToken** cursor) {
     khAstAlias alias = {.is_incase = false,
                         .name = NULL,
                         .expression = (khAstExpression){
@@ -1216,28 +1548,26 @@ static khAstAlias sparseAlias(char32_t** cursor) {
     // Any specifiers
     sparseSpecifiers(cursor, true, &alias.is_incase, false, NULL, true);
 
-    khToken token = currentToken(cursor, true);
+    khToken* token = currentToken(cursor, true);
 
     // Ensures `alias` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_ALIAS) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_ALIAS) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        raiseError(token.begin, U"expecting an `alias` keyword");
+        raiseError(token->begin, U"expecting an `alias` keyword");
     }
 
     // Its name
-    if (token.type == khTokenType_IDENTIFIER) {
-        alias.name = khstring_copy(&token.identifier);
+    if (token->type == khTokenType_IDENTIFIER) {
+        alias.name = token->identifier;
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, true);
     }
     else {
-        alias.name = khstring_new(U"");
-        raiseError(token.begin, U"expecting a name for the alias");
+        alias.name = kh_internIdentifier(NULL, 0);
+        raiseError(token->begin, U"expecting a name for the alias");
     }
 
     // Its alias expression
@@ -1245,756 +1575,501 @@ static khAstAlias sparseAlias(char32_t** cursor) {
     token = currentToken(cursor, false);
 
     // Ensures a newline or a semicolon at the end
-    if (token.type == khTokenType_NEWLINE || token.type == khTokenType_EOF ||
-        (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_SEMICOLON)) {
+    if (token->type == khTokenType_NEWLINE || token->type == khTokenType_EOF ||
+        (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_SEMICOLON)) {
         skipToken(cursor);
     }
-    else if (token.type == khTokenType_DELIMITER &&
-             token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
+    else if (token->type == khTokenType_DELIMITER &&
+             token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
         // Do nothing
     }
     else {
-        raiseError(token.begin, U"expecting a newline or a semicolon");
+        raiseError(token->begin, U"expecting a newline or a semicolon");
     }
 
-    khToken_delete(&token);
     return alias;
 }
 
 
-static khAstIfBranch sparseIfBranch(char32_t** cursor) {
-    khToken token = currentToken(cursor, true);
+static khAstIfBranch sparseIfBranch(khToken** cursor) {
+    khToken* token = currentToken(cursor, true);
     khAstIfBranch if_branch = (khAstIfBranch){
-        .branch_conditions = kharray_new(khAstExpression, khAstExpression_delete),
-        .branch_blocks = kharray_new(kharray(khAstStatement), kharray_arrayDeleter(khAstStatement)),
-        .else_block = kharray_new(khAstStatement, khAstStatement_delete)};
+        .branch_conditions = newArray(khAstExpression, khAstExpression_delete),
+        .branch_blocks = newArray(kharray(khAstStatement), kharray_arrayDeleter(khAstStatement)),
+        .else_block = newArray(khAstStatement, khAstStatement_delete)};
 
     // Ensures initial `if` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_IF) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_IF) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        raiseError(token.begin, U"expecting an `if` keyword");
+        raiseError(token->begin, U"expecting an `if` keyword");
     }
 
     goto in;
-    while (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_ELIF) {
+    while (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_ELIF) {
         skipToken(cursor);
     in:
         kharray_append(&if_branch.branch_conditions, kh_parseExpression(cursor, false, false));
         kharray_append(&if_branch.branch_blocks, sparseBlock(cursor));
 
-        khToken_delete(&token);
         token = currentToken(cursor, true);
 
         // Loop back again if there are any `elif` keywords
     }
 
     // End optional `else` block
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_ELSE) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_ELSE) {
         skipToken(cursor);
         if_branch.else_block = sparseBlock(cursor);
     }
 
-    khToken_delete(&token);
     return if_branch;
 }
 
-static khAstWhileLoop sparseWhileLoop(char32_t** cursor) {
-    khToken token = currentToken(cursor, true);
+static khAstWhileLoop sparseWhileLoop(khToken** cursor) {
+    khToken* token = currentToken(cursor, true);
     khAstWhileLoop while_loop = {
         .condition = (khAstExpression){.begin = NULL, .end = NULL, .type = khAstExpressionType_INVALID},
         .block = NULL};
 
     // Ensures `while` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_WHILE) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_WHILE) {
         skipToken(cursor);
     }
     else {
-        raiseError(token.begin, U"expecting a `while` keyword");
+        raiseError(token->begin, U"expecting a `while` keyword");
     }
 
     // Its condition and block block
     while_loop.condition = kh_parseExpression(cursor, false, false);
     while_loop.block = sparseBlock(cursor);
 
-    khToken_delete(&token);
     return while_loop;
 }
 
-static khAstDoWhileLoop sparseDoWhileLoop(char32_t** cursor) {
-    khToken token = currentToken(cursor, true);
+static khAstDoWhileLoop sparseDoWhileLoop(khToken** cursor) {
+    khToken* token = currentToken(cursor, true);
     khAstDoWhileLoop do_while_loop = {
         .condition = (khAstExpression){.begin = NULL, .end = NULL, .type = khAstExpressionType_INVALID},
         .block = NULL};
 
     // Ensures `do` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_DO) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_DO) {
         skipToken(cursor);
     }
     else {
-        raiseError(token.begin, U"expecting a `do` keyword");
+        raiseError(token->begin, U"expecting a `do` keyword");
     }
 
     // Its block
     do_while_loop.block = sparseBlock(cursor);
 
-    khToken_delete(&token);
     token = currentToken(cursor, true);
 
     // Ensures `while` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_WHILE) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_WHILE) {
         skipToken(cursor);
     }
     else {
-        raiseError(token.begin, U"expecting a `while` keyword");
+        raiseError(token->begin, U"expecting a `while` keyword");
     }
 
     // And its condition
     do_while_loop.condition = kh_parseExpression(cursor, false, false);
 
-    khToken_delete(&token);
     token = currentToken(cursor, false);
 
     // Ensures a newline or a semicolon at the end
-    if (token.type == khTokenType_NEWLINE || token.type == khTokenType_EOF ||
-        (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_SEMICOLON)) {
+    if (token->type == khTokenType_NEWLINE || token->type == khTokenType_EOF ||
+        (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_SEMICOLON)) {
         skipToken(cursor);
     }
-    else if (token.type == khTokenType_DELIMITER &&
-             token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
+    else if (token->type == khTokenType_DELIMITER &&
+             token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
         // Do nothing
     }
     else {
-        raiseError(token.begin, U"expecting a newline or a semicolon");
+        raiseError(token->begin, U"expecting a newline or a semicolon");
     }
 
-    khToken_delete(&token);
     return do_while_loop;
 }
 
-static khAstForLoop sparseForLoop(char32_t** cursor) {
-    khToken token = currentToken(cursor, true);
+static khAstForLoop sparseForLoop(khToken** cursor) {
+    khToken* token = currentToken(cursor, true);
     khAstForLoop for_loop = {
-        .iterators = kharray_new(khstring, khstring_delete),
+        .iterators = newArray(khstring, khstring_delete),
         .iteratee = (khAstExpression){.begin = NULL, .end = NULL, .type = khAstExpressionType_INVALID},
         .block = NULL};
 
     // Ensures `for` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_FOR) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_FOR) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        raiseError(token.begin, U"expecting a `for` keyword");
+        raiseError(token->begin, U"expecting a `for` keyword");
     }
 
     // Iterator variables
     goto in;
-    while (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COMMA) {
+    while (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_COMMA) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, true);
     in:
-        if (token.type == khTokenType_IDENTIFIER) {
-            kharray_append(&for_loop.iterators, khstring_copy(&token.identifier));
+        if (token->type == khTokenType_IDENTIFIER) {
+            kharray_append(&for_loop.iterators, token->identifier);
             skipToken(cursor);
-            khToken_delete(&token);
             token = currentToken(cursor, false);
         }
         else {
-            raiseError(token.begin, U"expecting an iterator variable name");
+            raiseError(token->begin, U"expecting an iterator variable name");
         }
     }
 
     // Ensures `in` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_IN) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_IN) {
         skipToken(cursor);
     }
     else {
-        raiseError(token.begin, U"expecting an `in` keyword");
+        raiseError(token->begin, U"expecting an `in` keyword");
     }
 
     // Iteratee expression and block block
     for_loop.iteratee = kh_parseExpression(cursor, false, false);
     for_loop.block = sparseBlock(cursor);
 
-    khToken_delete(&token);
     return for_loop;
 }
 
-static void sparseBreak(char32_t** cursor) {
-    khToken token = currentToken(cursor, true);
+static void sparseBreak(khToken** cursor) {
+    khToken* token = currentToken(cursor, true);
 
     // Ensures `break` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_BREAK) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_BREAK) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        raiseError(token.begin, U"expecting a `break` keyword");
+        raiseError(token->begin, U"expecting a `break` keyword");
     }
 
     // Ensure it ends with a newline or a semicolon
-    if (token.type == khTokenType_NEWLINE || token.type == khTokenType_EOF ||
-        (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_SEMICOLON)) {
+    if (token->type == khTokenType_NEWLINE || token->type == khTokenType_EOF ||
+        (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_SEMICOLON)) {
         skipToken(cursor);
     }
-    else if (token.type == khTokenType_DELIMITER &&
-             token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
+    else if (token->type == khTokenType_DELIMITER &&
+             token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
         // Do nothing
     }
     else {
-        raiseError(token.begin, U"expecting a newline or a semicolon");
+        raiseError(token->begin, U"expecting a newline or a semicolon");
     }
 
-    khToken_delete(&token);
 }
 
-static void sparseContinue(char32_t** cursor) {
-    khToken token = currentToken(cursor, true);
+static void sparseContinue(khToken** cursor) {
+    khToken* token = currentToken(cursor, true);
 
     // Ensures `continue` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_CONTINUE) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_CONTINUE) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        raiseError(token.begin, U"expecting a `continue` keyword");
+        raiseError(token->begin, U"expecting a `continue` keyword");
     }
 
     // Ensure it ends with a newline or a semicolon
-    if (token.type == khTokenType_NEWLINE || token.type == khTokenType_EOF ||
-        (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_SEMICOLON)) {
+    if (token->type == khTokenType_NEWLINE || token->type == khTokenType_EOF ||
+        (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_SEMICOLON)) {
         skipToken(cursor);
     }
-    else if (token.type == khTokenType_DELIMITER &&
-             token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
+    else if (token->type == khTokenType_DELIMITER &&
+             token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
         // Do nothing
     }
     else {
-        raiseError(token.begin, U"expecting a newline or a semicolon");
+        raiseError(token->begin, U"expecting a newline or a semicolon");
     }
 
-    khToken_delete(&token);
 }
 
-static khAstReturn sparseReturn(char32_t** cursor) {
-    khToken token = currentToken(cursor, true);
+static khAstReturn sparseReturn(khToken** cursor) {
+    khToken* token = currentToken(cursor, true);
 
     // Ensures `return` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_RETURN) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_RETURN) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, false);
     }
     else {
-        raiseError(token.begin, U"expecting a `return` keyword");
+        raiseError(token->begin, U"expecting a `return` keyword");
     }
 
     // Instant return in a non-returning function
-    if (token.type == khTokenType_NEWLINE || token.type == khTokenType_EOF ||
-        (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_SEMICOLON)) {
+    if (token->type == khTokenType_NEWLINE || token->type == khTokenType_EOF ||
+        (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_SEMICOLON)) {
         skipToken(cursor);
 
-        khToken_delete(&token);
-        return (khAstReturn){.values = kharray_new(khAstExpression, khAstExpression_delete)};
+        return (khAstReturn){.values = newArray(khAstExpression, khAstExpression_delete)};
     }
 
-    kharray(khAstExpression) values = kharray_new(khAstExpression, khAstExpression_delete);
+    kharray(khAstExpression) values = newArray(khAstExpression, khAstExpression_delete);
 
     // Its return values
     goto skip;
-    while (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COMMA) {
+    while (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_COMMA) {
         skipToken(cursor);
     skip:
-        khToken_delete(&token);
         kharray_append(&values, kh_parseExpression(cursor, false, false));
         token = currentToken(cursor, false);
     };
 
     // Ensure it ends with a newline or a semicolon
-    if (token.type == khTokenType_NEWLINE || token.type == khTokenType_EOF ||
-        (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_SEMICOLON)) {
+    if (token->type == khTokenType_NEWLINE || token->type == khTokenType_EOF ||
+        (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_SEMICOLON)) {
         skipToken(cursor);
     }
-    else if (token.type == khTokenType_DELIMITER &&
-             token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
+    else if (token->type == khTokenType_DELIMITER &&
+             token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
         // Do nothing
     }
     else {
-        raiseError(token.begin, U"expecting a newline or a semicolon");
+        raiseError(token->begin, U"expecting a newline or a semicolon");
     }
 
-    khToken_delete(&token);
     return (khAstReturn){.values = values};
 }
 
 
-// Macro to do recursive descent for a single binary operator as the whole function block
-#define RCD_BINARY(LOWER, TOKEN_OPERATOR, OPERATOR)                                                 \
-    khToken token = currentToken(cursor, ignore_newline);                                           \
-    char32_t* origin = token.begin;                                                                 \
-    khToken_delete(&token);                                                                         \
-                                                                                                    \
-    khAstExpression expression = LOWER(cursor, ignore_newline, filter_type);                        \
-                                                                                                    \
-    if (filter_type) {                                                                              \
-        return expression;                                                                          \
-    }                                                                                               \
-                                                                                                    \
-    token = currentToken(cursor, ignore_newline);                                                   \
-                                                                                                    \
-    while (token.type == khTokenType_OPERATOR && token.operator_v == TOKEN_OPERATOR) {              \
-        skipToken(cursor);                                                                          \
-                                                                                                    \
-        khAstExpression* left = malloc(sizeof(khAstExpression));                                    \
-        *left = expression;                                                                         \
-                                                                                                    \
-        khAstExpression* right = malloc(sizeof(khAstExpression));                                   \
-        *right = LOWER(cursor, ignore_newline, filter_type);                                        \
-                                                                                                    \
-        expression = (khAstExpression){.begin = origin,                                             \
-                                       .end = *cursor,                                              \
-                                       .type = khAstExpressionType_BINARY,                          \
-                                       .binary = {.type = OPERATOR, .left = left, .right = right}}; \
-                                                                                                    \
-        khToken_delete(&token);                                                                     \
-        token = currentToken(cursor, ignore_newline);                                               \
-    }                                                                                               \
-                                                                                                    \
-    khToken_delete(&token);                                                                         \
-    return expression;
-
-
-// Macro to do recursive descent for binary operators in a switch statement
-#define RCD_BINARY_CASE(LOWER, OPERATOR)                                                            \
-    {                                                                                               \
-        skipToken(cursor);                                                                          \
-                                                                                                    \
-        khAstExpression* left = malloc(sizeof(khAstExpression));                                    \
-        *left = expression;                                                                         \
-                                                                                                    \
-        khAstExpression* right = malloc(sizeof(khAstExpression));                                   \
-        *right = LOWER(cursor, ignore_newline, filter_type);                                        \
-                                                                                                    \
-        expression = (khAstExpression){.begin = origin,                                             \
-                                       .end = *cursor,                                              \
-                                       .type = khAstExpressionType_BINARY,                          \
-                                       .binary = {.type = OPERATOR, .left = left, .right = right}}; \
-                                                                                                    \
-        khToken_delete(&token);                                                                     \
-        token = currentToken(cursor, ignore_newline);                                               \
-    }                                                                                               \
-    break;
-
-
-khAstExpression kh_parseExpression(char32_t** cursor, EXPARSE_ARGS) {
-    return exparseIpAssignmentOperators(cursor, ignore_newline, filter_type);
+typedef struct {
+    uint8_t precedence;
+    uint8_t type; // A `khAstComparisonExpressionType` for comparisons, otherwise a binary one
+} BinaryOperator;
+
+// By `khOperatorToken`; `~` is both BIT_NOT and BIT_XOR, and a binary operator is the latter
+static const BinaryOperator binary_operators[khOperatorToken_IP_BIT_RSHIFT + 1] = {
+    [khOperatorToken_ASSIGN] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_ASSIGN},
+    [khOperatorToken_IP_ADD] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_ADD},
+    [khOperatorToken_IP_SUB] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_SUB},
+    [khOperatorToken_IP_MUL] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_MUL},
+    [khOperatorToken_IP_DIV] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_DIV},
+    [khOperatorToken_IP_MOD] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_MOD},
+    [khOperatorToken_IP_POW] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_POW},
+    [khOperatorToken_IP_DOT] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_DOT},
+    [khOperatorToken_IP_BIT_AND] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_BIT_AND},
+    [khOperatorToken_IP_BIT_OR] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_BIT_OR},
+    [khOperatorToken_IP_BIT_XOR] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_BIT_XOR},
+    [khOperatorToken_IP_BIT_LSHIFT] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_BIT_LSHIFT},
+    [khOperatorToken_IP_BIT_RSHIFT] = {Precedence_ASSIGNMENT, khAstBinaryExpressionType_IP_BIT_RSHIFT},
+
+    [khOperatorToken_OR] = {Precedence_OR, khAstBinaryExpressionType_OR},
+    [khOperatorToken_XOR] = {Precedence_XOR, khAstBinaryExpressionType_XOR},
+    [khOperatorToken_AND] = {Precedence_AND, khAstBinaryExpressionType_AND},
+
+    [khOperatorToken_EQUAL] = {Precedence_COMPARISON, khAstComparisonExpressionType_EQUAL},
+    [khOperatorToken_UNEQUAL] = {Precedence_COMPARISON, khAstComparisonExpressionType_UNEQUAL},
+    [khOperatorToken_LESS] = {Precedence_COMPARISON, khAstComparisonExpressionType_LESS},
+    [khOperatorToken_GREATER] = {Precedence_COMPARISON, khAstComparisonExpressionType_GREATER},
+    [khOperatorToken_LESS_EQUAL] = {Precedence_COMPARISON, khAstComparisonExpressionType_LESS_EQUAL},
+    [khOperatorToken_GREATER_EQUAL] = {Precedence_COMPARISON,
+                                       khAstComparisonExpressionType_GREATER_EQUAL},
+
+    [khOperatorToken_RANGE] = {Precedence_RANGE, khAstBinaryExpressionType_RANGE},
+    [khOperatorToken_BIT_OR] = {Precedence_BIT_OR, khAstBinaryExpressionType_BIT_OR},
+    [khOperatorToken_BIT_XOR] = {Precedence_BIT_XOR, khAstBinaryExpressionType_BIT_XOR},
+    [khOperatorToken_BIT_AND] = {Precedence_BIT_AND, khAstBinaryExpressionType_BIT_AND},
+    [khOperatorToken_BIT_LSHIFT] = {Precedence_SHIFT, khAstBinaryExpressionType_BIT_LSHIFT},
+    [khOperatorToken_BIT_RSHIFT] = {Precedence_SHIFT, khAstBinaryExpressionType_BIT_RSHIFT},
+
+    [khOperatorToken_ADD] = {Precedence_ADD, khAstBinaryExpressionType_ADD},
+    [khOperatorToken_SUB] = {Precedence_ADD, khAstBinaryExpressionType_SUB},
+
+    [khOperatorToken_MUL] = {Precedence_MUL, khAstBinaryExpressionType_MUL},
+    [khOperatorToken_DIV] = {Precedence_MUL, khAstBinaryExpressionType_DIV},
+    [khOperatorToken_MOD] = {Precedence_MUL, khAstBinaryExpressionType_MOD},
+    [khOperatorToken_DOT] = {Precedence_MUL, khAstBinaryExpressionType_DOT},
+
+    [khOperatorToken_POW] = {Precedence_POW, khAstBinaryExpressionType_POW}};
+
+static inline Precedence precedenceOf(khToken* token) {
+    return token->type == khTokenType_OPERATOR ? binary_operators[token->operator_v].precedence
+                                               : Precedence_NONE;
 }
 
-static khAstExpression exparseIpAssignmentOperators(char32_t** cursor, EXPARSE_ARGS) {
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = token.begin;
-    khToken_delete(&token);
 
-    khAstExpression expression = exparseTernary(cursor, ignore_newline, filter_type);
-
-    if (filter_type) {
-        return expression;
-    }
-
-    token = currentToken(cursor, ignore_newline);
-
-    // All inplace operators
-    while (token.type == khTokenType_OPERATOR) {
-        switch (token.operator_v) {
-            // These LOWER macro arguments are set to this very function itself,
-            // in order to parse inplace/assignment operators from right to left.
-            case khOperatorToken_ASSIGN:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_ASSIGN);
-
-            case khOperatorToken_IP_ADD:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_ADD);
-            case khOperatorToken_IP_SUB:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_SUB);
-            case khOperatorToken_IP_MUL:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_MUL);
-            case khOperatorToken_IP_DIV:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_DIV);
-            case khOperatorToken_IP_MOD:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_MOD);
-            case khOperatorToken_IP_POW:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_POW);
-            case khOperatorToken_IP_DOT:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_DOT);
-
-            case khOperatorToken_IP_BIT_AND:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_BIT_AND);
-            case khOperatorToken_IP_BIT_OR:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_BIT_OR);
-            case khOperatorToken_IP_BIT_XOR:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_BIT_XOR);
-            case khOperatorToken_IP_BIT_LSHIFT:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_BIT_LSHIFT);
-            case khOperatorToken_IP_BIT_RSHIFT:
-                RCD_BINARY_CASE(exparseIpAssignmentOperators, khAstBinaryExpressionType_IP_BIT_RSHIFT);
-
-            default:
-                goto out;
-        }
-    }
-out:
-
-    khToken_delete(&token);
-    return expression;
+khAstExpression kh_parseExpression(khToken** cursor, EXPARSE_ARGS) {
+    return exparseBinary(cursor, Precedence_ASSIGNMENT, ignore_newline, filter_type);
 }
 
-static khAstExpression exparseTernary(char32_t** cursor, EXPARSE_ARGS) {
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = token.begin;
-    khToken_delete(&token);
-
-    khAstExpression expression = exparseLogicalOr(cursor, ignore_newline, filter_type);
-
+// Precedence climbing: an operand, then each operator binding at least as tightly as the precedence,
+// whose right operands bind tighter still, as the operators group from left to right. Assignments group
+// from right to left instead, so theirs bind just as tightly. Types have no operators
+static khAstExpression exparseBinary(khToken** cursor, Precedence precedence, EXPARSE_ARGS) {
     if (filter_type) {
-        return expression;
+        return exparseReverseUnary(cursor, ignore_newline, filter_type);
     }
 
-    token = currentToken(cursor, ignore_newline);
-
-    // Hints that it's a ternary operation once `if` keyword is found after an expression
-    while (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_IF) {
-        skipToken(cursor);
+    khToken* token = currentToken(cursor, ignore_newline);
+    uint8_t* origin = token->begin;
 
-        // Its condition
-        khAstExpression* condition = malloc(sizeof(khAstExpression));
-        *condition = exparseLogicalOr(cursor, ignore_newline, filter_type);
+    khAstExpression expression = exparseUnary(cursor, precedence, ignore_newline, filter_type);
+    token = currentToken(cursor, ignore_newline);
 
-        khToken_delete(&token);
-        token = currentToken(cursor, ignore_newline);
+    while (true) {
+        Precedence token_precedence = precedenceOf(token);
 
-        // Ensures the `else` keyword before the otherwise value
-        if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_ELSE) {
-            skipToken(cursor);
+        // Hints that it's a ternary operation once `if` keyword is found after an expression
+        if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_IF &&
+            precedence <= Precedence_TERNARY) {
+            expression = exparseTernary(cursor, origin, expression, ignore_newline, filter_type);
         }
-        else {
-            raiseError(token.begin, U"expecting an `else` keyword after the condition");
+        else if (token_precedence == Precedence_NONE || token_precedence < precedence) {
+            break;
         }
+        else if (token_precedence == Precedence_COMPARISON) {
+            expression = exparseComparison(cursor, origin, expression, ignore_newline, filter_type);
+        }
+        else {
+            khAstBinaryExpressionType type = binary_operators[token->operator_v].type;
+            skipToken(cursor);
 
-        // Its otherwise value
-        khAstExpression* otherwise = malloc(sizeof(khAstExpression));
-        *otherwise = exparseLogicalOr(cursor, ignore_newline, filter_type);
+            khAstExpression* left = allocate(sizeof(khAstExpression));
+            *left = expression;
 
-        khAstExpression* value = malloc(sizeof(khAstExpression));
-        *value = expression;
+            khAstExpression* right = allocate(sizeof(khAstExpression));
+            *right = exparseBinary(cursor,
+                                   token_precedence == Precedence_ASSIGNMENT ? token_precedence
+                                                                             : token_precedence + 1,
+                                   ignore_newline, filter_type);
 
-        expression = (khAstExpression){
-            .begin = origin,
-            .end = *cursor,
-            .type = khAstExpressionType_TERNARY,
-            .ternary = {.value = value, .condition = condition, .otherwise = otherwise}};
+            expression = (khAstExpression){.begin = origin,
+                                           .end = previousEnd(cursor),
+                                           .type = khAstExpressionType_BINARY,
+                                           .binary = {.type = type, .left = left, .right = right}};
+        }
 
-        khToken_delete(&token);
         token = currentToken(cursor, ignore_newline);
     }
 
-    khToken_delete(&token);
     return expression;
 }
 
-static khAstExpression exparseLogicalOr(char32_t** cursor, EXPARSE_ARGS) {
-    RCD_BINARY(exparseLogicalXor, khOperatorToken_OR, khAstBinaryExpressionType_OR);
-}
-
-static khAstExpression exparseLogicalXor(char32_t** cursor, EXPARSE_ARGS) {
-    RCD_BINARY(exparseLogicalAnd, khOperatorToken_XOR, khAstBinaryExpressionType_XOR);
-}
-
-static khAstExpression exparseLogicalAnd(char32_t** cursor, EXPARSE_ARGS) {
-    RCD_BINARY(exparseLogicalNot, khOperatorToken_AND, khAstBinaryExpressionType_AND);
-}
+static khAstExpression exparseTernary(khToken** cursor, uint8_t* origin, khAstExpression value,
+                                      EXPARSE_ARGS) {
+    skipToken(cursor);
 
-static khAstExpression exparseLogicalNot(char32_t** cursor, EXPARSE_ARGS) {
-    if (filter_type) {
-        return exparseComparisonOperators(cursor, ignore_newline, filter_type);
-    }
+    // Its condition
+    khAstExpression* condition = allocate(sizeof(khAstExpression));
+    *condition = exparseBinary(cursor, Precedence_OR, ignore_newline, filter_type);
 
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = token.begin;
+    khToken* token = currentToken(cursor, ignore_newline);
 
-    // Self-explanatory
-    if (token.type == khTokenType_OPERATOR && token.operator_v == khOperatorToken_NOT) {
+    // Ensures the `else` keyword before the otherwise value
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_ELSE) {
         skipToken(cursor);
-
-        khAstExpression* expression = malloc(sizeof(khAstExpression));
-        *expression = exparseLogicalNot(cursor, ignore_newline, filter_type);
-
-        khToken_delete(&token);
-        return (khAstExpression){
-            .begin = origin,
-            .end = *cursor,
-            .type = khAstExpressionType_UNARY,
-            .unary = {.type = khAstUnaryExpressionType_NOT, .operand = expression}};
     }
     else {
-        khToken_delete(&token);
-        return exparseComparisonOperators(cursor, ignore_newline, filter_type);
-    }
-}
-
-static khAstExpression exparseComparisonOperators(char32_t** cursor, EXPARSE_ARGS) {
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = token.begin;
-    khToken_delete(&token);
-
-    khAstExpression expression = exparseRange(cursor, ignore_newline, filter_type);
-
-    if (filter_type) {
-        return expression;
+        raiseError(token->begin, U"expecting an `else` keyword after the condition");
     }
 
-    token = currentToken(cursor, ignore_newline);
-
-    // If any comparison operators found, start this mess
-    if (token.type == khTokenType_OPERATOR &&
-        (token.operator_v == khOperatorToken_EQUAL || token.operator_v == khOperatorToken_UNEQUAL ||
-         token.operator_v == khOperatorToken_LESS || token.operator_v == khOperatorToken_GREATER ||
-         token.operator_v == khOperatorToken_LESS_EQUAL ||
-         token.operator_v == khOperatorToken_GREATER_EQUAL)) {
-        kharray(khAstComparisonExpressionType) operations =
-            kharray_new(khAstComparisonExpressionType, NULL);
-        kharray(khAstExpression) operands = kharray_new(khAstExpression, khAstExpression_delete);
-        kharray_append(&operands, expression);
-
-        // Maps the khOperatorToken of the comparison operator to khAstComparisonExpressionType
-        while (token.type == khTokenType_OPERATOR) {
-            switch (token.operator_v) {
-                case khOperatorToken_EQUAL:
-                    kharray_append(&operations, khAstComparisonExpressionType_EQUAL);
-                    break;
-                case khOperatorToken_UNEQUAL:
-                    kharray_append(&operations, khAstComparisonExpressionType_UNEQUAL);
-                    break;
-                case khOperatorToken_LESS:
-                    kharray_append(&operations, khAstComparisonExpressionType_LESS);
-                    break;
-                case khOperatorToken_GREATER:
-                    kharray_append(&operations, khAstComparisonExpressionType_GREATER);
-                    break;
-                case khOperatorToken_LESS_EQUAL:
-                    kharray_append(&operations, khAstComparisonExpressionType_LESS_EQUAL);
-                    break;
-                case khOperatorToken_GREATER_EQUAL:
-                    kharray_append(&operations, khAstComparisonExpressionType_GREATER_EQUAL);
-                    break;
-
-                default:
-                    goto out;
-            }
+    // Its otherwise value
+    khAstExpression* otherwise = allocate(sizeof(khAstExpression));
+    *otherwise = exparseBinary(cursor, Precedence_OR, ignore_newline, filter_type);
 
-            skipToken(cursor);
-            kharray_append(&operands, exparseRange(cursor, ignore_newline, filter_type));
-
-            khToken_delete(&token);
-            token = currentToken(cursor, ignore_newline);
-        }
-    out:
-
-        expression = (khAstExpression){.begin = origin,
-                                       .end = *cursor,
-                                       .type = khAstExpressionType_COMPARISON,
-                                       .comparison = {.operations = operations, .operands = operands}};
-    }
-
-
-    khToken_delete(&token);
-    return expression;
-}
-
-static khAstExpression exparseRange(char32_t** cursor, EXPARSE_ARGS) {
-    RCD_BINARY(exparseBitwiseOr, khOperatorToken_RANGE, khAstBinaryExpressionType_RANGE);
-}
-
-static khAstExpression exparseBitwiseOr(char32_t** cursor, EXPARSE_ARGS) {
-    RCD_BINARY(exparseBitwiseXor, khOperatorToken_BIT_OR, khAstBinaryExpressionType_BIT_OR);
-}
-
-static khAstExpression exparseBitwiseXor(char32_t** cursor, EXPARSE_ARGS) {
-    RCD_BINARY(exparseBitwiseAnd, khOperatorToken_BIT_XOR, khAstBinaryExpressionType_BIT_XOR);
-}
-
-static khAstExpression exparseBitwiseAnd(char32_t** cursor, EXPARSE_ARGS) {
-    RCD_BINARY(exparseBitwiseShifts, khOperatorToken_BIT_AND, khAstBinaryExpressionType_BIT_AND);
-}
+    khAstExpression* value_ptr = allocate(sizeof(khAstExpression));
+    *value_ptr = value;
 
-static khAstExpression exparseBitwiseShifts(char32_t** cursor, EXPARSE_ARGS) {
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = token.begin;
-    khToken_delete(&token);
-
-    khAstExpression expression = exparseAddSub(cursor, ignore_newline, filter_type);
-
-    if (filter_type) {
-        return expression;
-    }
-
-    token = currentToken(cursor, ignore_newline);
-
-    // Self-explanatory
-    while (token.type == khTokenType_OPERATOR) {
-        switch (token.operator_v) {
-            case khOperatorToken_BIT_LSHIFT:
-                RCD_BINARY_CASE(exparseAddSub, khAstBinaryExpressionType_BIT_LSHIFT);
-            case khOperatorToken_BIT_RSHIFT:
-                RCD_BINARY_CASE(exparseAddSub, khAstBinaryExpressionType_BIT_RSHIFT);
-
-            default:
-                goto out;
-        }
-    }
-out:
-
-    khToken_delete(&token);
-    return expression;
+    return (khAstExpression){
+        .begin = origin,
+        .end = previousEnd(cursor),
+        .type = khAstExpressionType_TERNARY,
+        .ternary = {.value = value_ptr, .condition = condition, .otherwise = otherwise}};
 }
 
-static khAstExpression exparseAddSub(char32_t** cursor, EXPARSE_ARGS) {
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = token.begin;
-    khToken_delete(&token);
-
-    khAstExpression expression = exparseMulDivModDot(cursor, ignore_newline, filter_type);
+// Chains of comparisons, like `a < b <= c`, are a single expression rather than nested binary ones
+static khAstExpression exparseComparison(khToken** cursor, uint8_t* origin, khAstExpression first,
+                                         EXPARSE_ARGS) {
+    kharray(khAstComparisonExpressionType) operations = newArray(khAstComparisonExpressionType, NULL);
+    kharray(khAstExpression) operands = newArray(khAstExpression, khAstExpression_delete);
+    kharray_append(&operands, first);
 
-    if (filter_type) {
-        return expression;
-    }
-
-    token = currentToken(cursor, ignore_newline);
-
-    // Self-explanatory
-    while (token.type == khTokenType_OPERATOR) {
-        switch (token.operator_v) {
-            case khOperatorToken_ADD:
-                RCD_BINARY_CASE(exparseMulDivModDot, khAstBinaryExpressionType_ADD);
-            case khOperatorToken_SUB:
-                RCD_BINARY_CASE(exparseMulDivModDot, khAstBinaryExpressionType_SUB);
+    khToken* token = currentToken(cursor, ignore_newline);
+    while (precedenceOf(token) == Precedence_COMPARISON) {
+        kharray_append(&operations, binary_operators[token->operator_v].type);
+        skipToken(cursor);
+        kharray_append(&operands,
+                       exparseBinary(cursor, Precedence_RANGE, ignore_newline, filter_type));
 
-            default:
-                goto out;
-        }
+        token = currentToken(cursor, ignore_newline);
     }
-out:
 
-    khToken_delete(&token);
-    return expression;
+    return (khAstExpression){.begin = origin,
+                             .end = previousEnd(cursor),
+                             .type = khAstExpressionType_COMPARISON,
+                             .comparison = {.operations = operations, .operands = operands}};
 }
 
-static khAstExpression exparseMulDivModDot(char32_t** cursor, EXPARSE_ARGS) {
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = token.begin;
-    khToken_delete(&token);
-
-    khAstExpression expression = exparseUnary(cursor, ignore_newline, filter_type);
-
-    if (filter_type) {
-        return expression;
-    }
+// Prefix operators, which are only allowed where unary operators bind at least as tightly as the
+// precedence. A `not` starting the operand of a logical operator binds looser than comparisons
+static khAstExpression exparseUnary(khToken** cursor, Precedence precedence, EXPARSE_ARGS) {
+    khToken* token = currentToken(cursor, ignore_newline);
+    uint8_t* origin = token->begin;
 
-    token = currentToken(cursor, ignore_newline);
-
-    // Self-explanatory
-    while (token.type == khTokenType_OPERATOR) {
-        switch (token.operator_v) {
-            case khOperatorToken_MUL:
-                RCD_BINARY_CASE(exparseUnary, khAstBinaryExpressionType_MUL);
-            case khOperatorToken_DIV:
-                RCD_BINARY_CASE(exparseUnary, khAstBinaryExpressionType_DIV);
-            case khOperatorToken_MOD:
-                RCD_BINARY_CASE(exparseUnary, khAstBinaryExpressionType_MOD);
-            case khOperatorToken_DOT:
-                RCD_BINARY_CASE(exparseUnary, khAstBinaryExpressionType_DOT);
-
-            default:
-                goto out;
-        }
+    if (token->type != khTokenType_OPERATOR || precedence > Precedence_UNARY) {
+        return exparseReverseUnary(cursor, ignore_newline, filter_type);
     }
-out:
-
-    khToken_delete(&token);
-    return expression;
-}
-
 
-// Like RCD_BINARY_CASE, but for unary operators
-#define RCD_UNARY_CASE(FUNCTION, OPERATOR)                                            \
-    {                                                                                 \
-        skipToken(cursor);                                                            \
-                                                                                      \
-        khAstExpression* expression = malloc(sizeof(khAstExpression));                \
-        *expression = exparseUnary(cursor, ignore_newline, filter_type);              \
-                                                                                      \
-        khToken_delete(&token);                                                       \
-        return (khAstExpression){.begin = origin,                                     \
-                                 .end = *cursor,                                      \
-                                 .type = khAstExpressionType_UNARY,                   \
-                                 .unary = {.type = OPERATOR, .operand = expression}}; \
-    }
+    khAstUnaryExpressionType type;
+    Precedence operand_precedence = Precedence_UNARY;
+    switch (token->operator_v) {
+        case khOperatorToken_ADD:
+            type = khAstUnaryExpressionType_POSITIVE;
+            break;
+        case khOperatorToken_SUB:
+            type = khAstUnaryExpressionType_NEGATIVE;
+            break;
 
+        case khOperatorToken_NOT:
+            type = khAstUnaryExpressionType_NOT;
+            if (precedence <= Precedence_NOT) {
+                operand_precedence = Precedence_NOT;
+            }
+            break;
+        case khOperatorToken_BIT_NOT:
+            type = khAstUnaryExpressionType_BIT_NOT;
+            break;
 
-static khAstExpression exparseUnary(char32_t** cursor, EXPARSE_ARGS) {
-    if (filter_type) {
-        return exparsePow(cursor, ignore_newline, filter_type);
+        default:
+            return exparseReverseUnary(cursor, ignore_newline, filter_type);
     }
 
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = token.begin;
-
-    // All same-precedence unary operators
-    if (token.type == khTokenType_OPERATOR) {
-        switch (token.operator_v) {
-            case khOperatorToken_ADD:
-                RCD_UNARY_CASE(exparsePow, khAstUnaryExpressionType_POSITIVE);
-            case khOperatorToken_SUB:
-                RCD_UNARY_CASE(exparsePow, khAstUnaryExpressionType_NEGATIVE);
+    skipToken(cursor);
 
-            case khOperatorToken_NOT:
-                RCD_UNARY_CASE(exparsePow, khAstUnaryExpressionType_NOT);
-            case khOperatorToken_BIT_NOT:
-                RCD_UNARY_CASE(exparsePow, khAstUnaryExpressionType_BIT_NOT);
+    khAstExpression* operand = allocate(sizeof(khAstExpression));
+    *operand = exparseBinary(cursor, operand_precedence, ignore_newline, filter_type);
 
-            default:
-                khToken_delete(&token);
-                return exparsePow(cursor, ignore_newline, filter_type);
-        }
-    }
-    else {
-        khToken_delete(&token);
-        return exparsePow(cursor, ignore_newline, filter_type);
-    }
-}
-
-static khAstExpression exparsePow(char32_t** cursor, EXPARSE_ARGS) {
-    RCD_BINARY(exparseReverseUnary, khOperatorToken_POW, khAstBinaryExpressionType_POW);
+    return (khAstExpression){.begin = origin,
+                             .end = previousEnd(cursor),
+                             .type = khAstExpressionType_UNARY,
+                             .unary = {.type = type, .operand = operand}};
 }
 
-static khAstExpression exparseReverseUnary(char32_t** cursor, EXPARSE_ARGS) {
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = token.begin;
-    khToken_delete(&token);
+static khAstExpression exparseReverseUnary(khToken** cursor, EXPARSE_ARGS) {
+    khToken* token = currentToken(cursor, ignore_newline);
+    uint8_t* origin = token->begin;
 
     khAstExpression expression = exparseOther(cursor, ignore_newline, filter_type);
     token = currentToken(cursor, ignore_newline);
 
-    while (token.type == khTokenType_DELIMITER || token.type == khTokenType_OPERATOR) {
-        switch (token.type) {
+    while (token->type == khTokenType_DELIMITER || token->type == khTokenType_OPERATOR) {
+        switch (token->type) {
             case khTokenType_DELIMITER:
-                switch (token.delimiter) {
+                switch (token->delimiter) {
                     case khDelimiterToken_PARENTHESIS_OPEN: {
                         if (filter_type) {
                             goto out;
@@ -2004,16 +2079,15 @@ static khAstExpression exparseReverseUnary(char32_t** cursor, EXPARSE_ARGS) {
                             cursor, khDelimiterToken_PARENTHESIS_OPEN,
                             khDelimiterToken_PARENTHESIS_CLOSE, ignore_newline, filter_type);
 
-                        khAstExpression* callee = malloc(sizeof(khAstExpression));
+                        khAstExpression* callee = allocate(sizeof(khAstExpression));
                         *callee = expression;
 
                         expression =
                             (khAstExpression){.begin = origin,
-                                              .end = *cursor,
+                                              .end = previousEnd(cursor),
                                               .type = khAstExpressionType_CALL,
                                               .call = {.callee = callee, .arguments = arguments}};
 
-                        khToken_delete(&token);
                         token = currentToken(cursor, ignore_newline);
                     } break;
 
@@ -2022,102 +2096,96 @@ static khAstExpression exparseReverseUnary(char32_t** cursor, EXPARSE_ARGS) {
                             cursor, khDelimiterToken_SQUARE_BRACKET_OPEN,
                             khDelimiterToken_SQUARE_BRACKET_CLOSE, ignore_newline, filter_type);
 
-                        khAstExpression* indexee = malloc(sizeof(khAstExpression));
+                        khAstExpression* indexee = allocate(sizeof(khAstExpression));
                         *indexee = expression;
 
                         expression =
                             (khAstExpression){.begin = origin,
-                                              .end = *cursor,
+                                              .end = previousEnd(cursor),
                                               .type = khAstExpressionType_INDEX,
                                               .index = {.indexee = indexee, .arguments = arguments}};
 
-                        khToken_delete(&token);
                         token = currentToken(cursor, ignore_newline);
                     } break;
 
                     case khDelimiterToken_DOT: {
-                        kharray(khstring) scope_names = kharray_new(khstring, khstring_delete);
+                        kharray(khstring) scope_names = newArray(khstring, khstring_delete);
 
                         // `(expression).parses.these.scope.things`
-                        while (token.type == khTokenType_DELIMITER &&
-                               token.delimiter == khDelimiterToken_DOT) {
+                        while (token->type == khTokenType_DELIMITER &&
+                               token->delimiter == khDelimiterToken_DOT) {
                             skipToken(cursor);
-                            khToken_delete(&token);
                             token = currentToken(cursor, ignore_newline);
 
-                            if (token.type == khTokenType_IDENTIFIER) {
-                                kharray_append(&scope_names, khstring_copy(&token.identifier));
+                            if (token->type == khTokenType_IDENTIFIER) {
+                                kharray_append(&scope_names, token->identifier);
 
                                 skipToken(cursor);
-                                khToken_delete(&token);
                                 token = currentToken(cursor, ignore_newline);
                             }
                             else {
-                                raiseError(token.begin, U"expecting an identifier to scope into");
+                                raiseError(token->begin, U"expecting an identifier to scope into");
                             }
                         }
 
-                        khAstExpression* value = malloc(sizeof(khAstExpression));
+                        khAstExpression* value = allocate(sizeof(khAstExpression));
                         *value = expression;
 
                         expression =
                             (khAstExpression){.begin = origin,
-                                              .end = *cursor,
+                                              .end = previousEnd(cursor),
                                               .type = khAstExpressionType_SCOPE,
                                               .scope = {.value = value, .scope_names = scope_names}};
                     } break;
 
                     case khDelimiterToken_EXCLAMATION: {
                         skipToken(cursor);
-                        khToken_delete(&token);
                         token = currentToken(cursor, ignore_newline);
 
-                        khAstExpression* value = malloc(sizeof(khAstExpression));
+                        khAstExpression* value = allocate(sizeof(khAstExpression));
                         *value = expression;
 
                         // Single identifier template argument: `Type!int`
-                        if (token.type == khTokenType_IDENTIFIER) {
+                        if (token->type == khTokenType_IDENTIFIER) {
                             kharray(khAstExpression) template_arguments =
-                                kharray_new(khAstExpression, khAstExpression_delete);
+                                newArray(khAstExpression, khAstExpression_delete);
 
                             kharray_append(
                                 &template_arguments,
-                                ((khAstExpression){.begin = token.begin,
-                                                   .end = token.end,
+                                ((khAstExpression){.begin = token->begin,
+                                                   .end = khToken_end(token),
                                                    .type = khAstExpressionType_IDENTIFIER,
-                                                   .identifier = khstring_copy(&token.identifier)}));
+                                                   .identifier = token->identifier}));
+                            skipToken(cursor);
 
                             expression = (khAstExpression){
                                 .begin = origin,
-                                .end = *cursor,
+                                .end = previousEnd(cursor),
                                 .type = khAstExpressionType_TEMPLATIZE,
                                 .templatize = {.value = value,
                                                .template_arguments = template_arguments}};
 
-                            skipToken(cursor);
-                            khToken_delete(&token);
                             token = currentToken(cursor, ignore_newline);
                         }
                         // Multiple template arguments: `Type!(int, float)`
-                        else if (token.type == khTokenType_DELIMITER &&
-                                 token.delimiter == khDelimiterToken_PARENTHESIS_OPEN) {
+                        else if (token->type == khTokenType_DELIMITER &&
+                                 token->delimiter == khDelimiterToken_PARENTHESIS_OPEN) {
                             kharray(khAstExpression) template_arguments =
                                 exparseList(cursor, khDelimiterToken_PARENTHESIS_OPEN,
                                             khDelimiterToken_PARENTHESIS_CLOSE, ignore_newline, true);
 
                             expression = (khAstExpression){
                                 .begin = origin,
-                                .end = *cursor,
+                                .end = previousEnd(cursor),
                                 .type = khAstExpressionType_TEMPLATIZE,
                                 .templatize = {.value = value,
                                                .template_arguments = template_arguments}};
 
-                            khToken_delete(&token);
                             token = currentToken(cursor, ignore_newline);
                         }
                         else {
-                            free(value);
-                            raiseError(token.begin, U"expecting a type argument for templatizing");
+                            deallocate(value);
+                            raiseError(token->begin, U"expecting a type argument for templatizing");
                         }
                     } break;
 
@@ -2132,57 +2200,54 @@ static khAstExpression exparseReverseUnary(char32_t** cursor, EXPARSE_ARGS) {
     }
 out:
 
-    khToken_delete(&token);
     return expression;
 }
 
-static khAstExpression exparseOther(char32_t** cursor, EXPARSE_ARGS) {
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = token.begin;
+static khAstExpression exparseOther(khToken** cursor, EXPARSE_ARGS) {
+    khToken* token = currentToken(cursor, ignore_newline);
+    uint8_t* origin = token->begin;
     khAstExpression expression =
         (khAstExpression){.begin = NULL, .end = NULL, .type = khAstExpressionType_INVALID};
 
-    switch (token.type) {
+    switch (token->type) {
         case khTokenType_IDENTIFIER: {
+            skipToken(cursor);
             expression = (khAstExpression){.begin = origin,
-                                           .end = *cursor,
+                                           .end = previousEnd(cursor),
                                            .type = khAstExpressionType_IDENTIFIER,
-                                           .identifier = khstring_copy(&token.identifier)};
-
-            skipToken(cursor);
+                                           .identifier = token->identifier};
         } break;
 
         case khTokenType_KEYWORD: {
             // 2 cases
-            if (token.keyword == khKeywordToken_DEF) {
-                char32_t* initial = *cursor;
+            if (token->keyword == khKeywordToken_DEF) {
+                khToken* initial = *cursor;
                 skipToken(&initial);
-                khToken next_token = currentToken(&initial, ignore_newline);
+                khToken* next_token = currentToken(&initial, ignore_newline);
 
                 // A function signature
-                if (next_token.type == khTokenType_DELIMITER &&
-                    next_token.delimiter == khDelimiterToken_EXCLAMATION) {
+                if (next_token->type == khTokenType_DELIMITER &&
+                    next_token->delimiter == khDelimiterToken_EXCLAMATION) {
                     expression = exparseSignature(cursor, ignore_newline);
                 }
                 // A lambda
                 else {
                     if (filter_type) {
-                        raiseError(token.begin, U"expecting a type, not a lambda");
+                        raiseError(token->begin, U"expecting a type, not a lambda");
                     }
 
                     expression = exparseLambda(cursor, ignore_newline);
                 }
 
-                khToken_delete(&next_token);
             }
             else {
-                raiseError(token.begin, U"unexpected keyword in an expression");
+                raiseError(token->begin, U"unexpected keyword in an expression");
                 skipToken(cursor);
             }
         } break;
 
         case khTokenType_DELIMITER:
-            switch (token.keyword) {
+            switch (token->keyword) {
                 // Parentheses enclosed expressions or tuples
                 case khDelimiterToken_PARENTHESIS_OPEN: {
                     kharray(khAstExpression) values =
@@ -2190,36 +2255,39 @@ static khAstExpression exparseOther(char32_t** cursor, EXPARSE_ARGS) {
                                     khDelimiterToken_PARENTHESIS_CLOSE, ignore_newline, filter_type);
 
                     if (kharray_size(&values) == 1) {
-                        expression = khAstExpression_copy(&values[0]);
+                        // Moving the value out of the list, so it's not deleted along with it
+                        expression = khAstExpression_move(&values[0]);
                         kharray_delete(&values);
                     }
                     else {
                         expression = (khAstExpression){.begin = origin,
-                                                       .end = *cursor,
+                                                       .end = previousEnd(cursor),
                                                        .type = khAstExpressionType_TUPLE,
                                                        .tuple = {.values = values}};
                     }
                 } break;
 
                 // Arrays
-                case khDelimiterToken_SQUARE_BRACKET_OPEN:
+                case khDelimiterToken_SQUARE_BRACKET_OPEN: {
                     if (filter_type) {
-                        raiseError(token.begin, U"expecting a type, not an array");
+                        raiseError(token->begin, U"expecting a type, not an array");
                     }
 
-                    expression = (khAstExpression){
-                        .begin = origin,
-                        .end = *cursor,
-                        .type = khAstExpressionType_ARRAY,
-                        .array = {.values = exparseList(cursor, khDelimiterToken_SQUARE_BRACKET_OPEN,
-                                                        khDelimiterToken_SQUARE_BRACKET_CLOSE,
-                                                        ignore_newline, filter_type)}};
-                    break;
+                    // Parsed before its end is taken, which is after the list
+                    kharray(khAstExpression) values =
+                        exparseList(cursor, khDelimiterToken_SQUARE_BRACKET_OPEN,
+                                    khDelimiterToken_SQUARE_BRACKET_CLOSE, ignore_newline, filter_type);
+
+                    expression = (khAstExpression){.begin = origin,
+                                                   .end = previousEnd(cursor),
+                                                   .type = khAstExpressionType_ARRAY,
+                                                   .array = {.values = values}};
+                } break;
 
                 // Dicts
                 case khDelimiterToken_CURLY_BRACKET_OPEN:
                     if (filter_type) {
-                        raiseError(token.begin, U"expecting a type, not a dict");
+                        raiseError(token->begin, U"expecting a type, not a dict");
                     }
 
                     expression = exparseDict(cursor, ignore_newline);
@@ -2230,12 +2298,13 @@ static khAstExpression exparseOther(char32_t** cursor, EXPARSE_ARGS) {
                     // No type-filtering here as it is used for making the slice compound-type
                     // slice: int[...] = expression
                     skipToken(cursor);
-                    expression = (khAstExpression){
-                        .begin = origin, .end = *cursor, .type = khAstExpressionType_ELLIPSIS};
+                    expression = (khAstExpression){.begin = origin,
+                                                   .end = previousEnd(cursor),
+                                                   .type = khAstExpressionType_ELLIPSIS};
                     break;
 
                 default:
-                    raiseError(token.begin, U"unexpected token in an expression");
+                    raiseError(token->begin, U"unexpected token in an expression");
                     skipToken(cursor);
                     break;
             }
@@ -2244,48 +2313,50 @@ static khAstExpression exparseOther(char32_t** cursor, EXPARSE_ARGS) {
         // The rest below are constants (v)
         case khTokenType_CHAR:
             if (filter_type) {
-                raiseError(token.begin, U"expecting a type, not a character");
+                raiseError(token->begin, U"expecting a type, not a character");
             }
 
             skipToken(cursor);
             expression = (khAstExpression){.begin = origin,
-                                           .end = *cursor,
+                                           .end = previousEnd(cursor),
                                            .type = khAstExpressionType_CHAR,
-                                           .char_v = token.char_v};
+                                           .char_v = token->char_v};
             break;
 
         case khTokenType_STRING:
             if (filter_type) {
-                raiseError(token.begin, U"expecting a type, not a string");
+                raiseError(token->begin, U"expecting a type, not a string");
             }
 
             skipToken(cursor);
             expression = (khAstExpression){.begin = origin,
-                                           .end = *cursor,
+                                           .end = previousEnd(cursor),
                                            .type = khAstExpressionType_STRING,
-                                           .string = khstring_copy(&token.string)};
+                                           .string = kh_decodeString(token, parse_arena)};
             break;
 
         case khTokenType_BUFFER:
             if (filter_type) {
-                raiseError(token.begin, U"expecting a type, not a buffer");
+                raiseError(token->begin, U"expecting a type, not a buffer");
             }
 
             skipToken(cursor);
             expression = (khAstExpression){.begin = origin,
-                                           .end = *cursor,
+                                           .end = previousEnd(cursor),
                                            .type = khAstExpressionType_BUFFER,
-                                           .buffer = khbuffer_copy(&token.buffer)};
+                                           .buffer = kh_decodeBuffer(token, parse_arena)};
             break;
 
         case khTokenType_BYTE:
             if (filter_type) {
-                raiseError(token.begin, U"expecting a type, not a byte");
+                raiseError(token->begin, U"expecting a type, not a byte");
             }
 
             skipToken(cursor);
-            expression = (khAstExpression){
-                .begin = origin, .end = *cursor, .type = khAstExpressionType_BYTE, .byte = token.byte};
+            expression = (khAstExpression){.begin = origin,
+                                           .end = previousEnd(cursor),
+                                           .type = khAstExpressionType_BYTE,
+                                           .byte = token->byte};
             break;
 
         case khTokenType_INTEGER:
@@ -2293,146 +2364,143 @@ static khAstExpression exparseOther(char32_t** cursor, EXPARSE_ARGS) {
             // compound-types to be parsed
             // vec: float[3] = expression
             /* if (filter_type) {
-             *     raiseError(token.begin, U"expecting a type, not an integer");
+             *     raiseError(token->begin, U"expecting a type, not an integer");
              * }
              */
 
             skipToken(cursor);
             expression = (khAstExpression){.begin = origin,
-                                           .end = *cursor,
+                                           .end = previousEnd(cursor),
                                            .type = khAstExpressionType_INTEGER,
-                                           .integer = token.integer};
+                                           .integer = token->integer};
             break;
 
         case khTokenType_UINTEGER:
             // Same for unsigned integers
             // vec: float[3U] = expression
             /* if (filter_type) {
-             *     raiseError(token.begin, U"expecting a type, not an unsigned integer");
+             *     raiseError(token->begin, U"expecting a type, not an unsigned integer");
              * }
              */
 
             skipToken(cursor);
             expression = (khAstExpression){.begin = origin,
-                                           .end = *cursor,
+                                           .end = previousEnd(cursor),
                                            .type = khAstExpressionType_UINTEGER,
-                                           .uinteger = token.uinteger};
+                                           .uinteger = token->uinteger};
             break;
 
         case khTokenType_FLOAT:
             if (filter_type) {
-                raiseError(token.begin, U"expecting a type, not a floating-point number");
+                raiseError(token->begin, U"expecting a type, not a floating-point number");
             }
 
             skipToken(cursor);
             expression = (khAstExpression){.begin = origin,
-                                           .end = *cursor,
+                                           .end = previousEnd(cursor),
                                            .type = khAstExpressionType_FLOAT,
-                                           .float_v = token.float_v};
+                                           .float_v = token->float_v};
             break;
 
         case khTokenType_DOUBLE:
             if (filter_type) {
-                raiseError(token.begin, U"expecting a type, not a double floating-point number");
+                raiseError(token->begin, U"expecting a type, not a double floating-point number");
             }
 
             skipToken(cursor);
             expression = (khAstExpression){.begin = origin,
-                                           .end = *cursor,
+                                           .end = previousEnd(cursor),
                                            .type = khAstExpressionType_DOUBLE,
-                                           .double_v = token.double_v};
+                                           .double_v = token->double_v};
             break;
 
         case khTokenType_IFLOAT:
             if (filter_type) {
-                raiseError(token.begin, U"expecting a type, not an imaginary floating-point number");
+                raiseError(token->begin, U"expecting a type, not an imaginary floating-point number");
             }
 
             skipToken(cursor);
             expression = (khAstExpression){.begin = origin,
-                                           .end = *cursor,
+                                           .end = previousEnd(cursor),
                                            .type = khAstExpressionType_IFLOAT,
-                                           .ifloat = token.ifloat};
+                                           .ifloat = token->ifloat};
             break;
 
         case khTokenType_IDOUBLE:
             if (filter_type) {
-                raiseError(token.begin,
+                raiseError(token->begin,
                            U"expecting a type, not an imaginary double floating-point number");
             }
 
             skipToken(cursor);
             expression = (khAstExpression){.begin = origin,
-                                           .end = *cursor,
+                                           .end = previousEnd(cursor),
                                            .type = khAstExpressionType_IDOUBLE,
-                                           .idouble = token.idouble};
+                                           .idouble = token->idouble};
             break;
 
         case khTokenType_NEWLINE:
-            raiseError(token.begin, U"unexpected newline in an expression");
+            raiseError(token->begin, U"unexpected newline in an expression");
             skipToken(cursor);
             break;
 
         case khTokenType_EOF:
-            raiseError(token.begin, U"expecting an expression, met with a dead end");
+            raiseError(token->begin, U"expecting an expression, met with a dead end");
             break;
 
         default:
-            raiseError(token.begin, U"unexpected token in an expression");
+            raiseError(token->begin, U"unexpected token in an expression");
             skipToken(cursor);
             break;
     }
 
-    khToken_delete(&token);
     return expression;
 }
 
-static khAstExpression exparseSignature(char32_t** cursor, bool ignore_newline) {
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = *cursor;
-    khAstSignature signature = {.are_arguments_refs = kharray_new(bool, NULL),
-                                .argument_types = kharray_new(khAstExpression, khAstExpression_delete),
+static khAstExpression exparseSignature(khToken** cursor, bool ignore_newline) {
+    khToken* token = currentToken(cursor, ignore_newline);
+    uint8_t* origin = token->begin;
+    khAstSignature signature = {.are_arguments_refs = newArray(bool, NULL),
+                                .argument_types = newArray(khAstExpression, khAstExpression_delete),
                                 .is_return_type_ref = false,
                                 .opt_return_type = NULL};
 
     // Ensures `def` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_DEF) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_DEF) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, ignore_newline);
     }
     else {
-        raiseError(token.begin, U"expecting a `def` keyword");
+        raiseError(token->begin, U"expecting a `def` keyword");
     }
 
     // Ensures an exclamation mark
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_EXCLAMATION) {
+    if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_EXCLAMATION) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, ignore_newline);
     }
     else {
-        raiseError(token.begin, U"expecting an exclamation mark");
+        raiseError(token->begin, U"expecting an exclamation mark");
     }
 
     // Ensures an opening parenthesis
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_PARENTHESIS_OPEN) {
+    if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_PARENTHESIS_OPEN) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, true);
     }
     else {
-        raiseError(token.begin, U"expecting an opening parenthesis");
+        raiseError(token->begin, U"expecting an opening parenthesis");
     }
 
     // Instant close
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_PARENTHESIS_CLOSE) {
+    if (token->type == khTokenType_DELIMITER &&
+        token->delimiter == khDelimiterToken_PARENTHESIS_CLOSE) {
         skipToken(cursor);
     }
     else {
         while (true) {
             // Handles `ref` arguments
-            if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_REF) {
+            if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_REF) {
                 kharray_append(&signature.are_arguments_refs, true);
                 skipToken(cursor);
             }
@@ -2442,23 +2510,21 @@ static khAstExpression exparseSignature(char32_t** cursor, bool ignore_newline)
 
             // Argument type
             kharray_append(&signature.argument_types, kh_parseExpression(cursor, true, true));
-            khToken_delete(&token);
             token = currentToken(cursor, true);
 
             // Do nothing after a comma
-            if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COMMA) {
+            if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_COMMA) {
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, true);
             }
             // Breaks out of the loop after closing the arglist
-            else if (token.type == khTokenType_DELIMITER &&
-                     token.delimiter == khDelimiterToken_PARENTHESIS_CLOSE) {
+            else if (token->type == khTokenType_DELIMITER &&
+                     token->delimiter == khDelimiterToken_PARENTHESIS_CLOSE) {
                 skipToken(cursor);
                 break;
             }
             else {
-                raiseError(token.begin,
+                raiseError(token->begin,
                            U"expecting a comma or another argument type after an argument type");
                 break;
             }
@@ -2466,171 +2532,160 @@ static khAstExpression exparseSignature(char32_t** cursor, bool ignore_newline)
     }
 
     // Optional return type
-    khToken_delete(&token);
     token = currentToken(cursor, ignore_newline);
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_ARROW) {
+    if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_ARROW) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, ignore_newline);
 
         // Handles `ref` return type
-        if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_REF) {
+        if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_REF) {
             signature.is_return_type_ref = true;
             skipToken(cursor);
         }
 
         // Return type itself
-        signature.opt_return_type = malloc(sizeof(khAstExpression));
+        signature.opt_return_type = allocate(sizeof(khAstExpression));
         *signature.opt_return_type = kh_parseExpression(cursor, ignore_newline, true);
     }
 
-    khToken_delete(&token);
-    return (khAstExpression){
-        .begin = origin, .end = *cursor, .type = khAstExpressionType_SIGNATURE, .signature = signature};
+    return (khAstExpression){.begin = origin,
+                             .end = previousEnd(cursor),
+                             .type = khAstExpressionType_SIGNATURE,
+                             .signature = signature};
 }
 
-static khAstExpression exparseLambda(char32_t** cursor, bool ignore_newline) {
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = *cursor;
-    khAstLambda lambda = {.arguments = kharray_new(khAstVariable, khAstVariable_delete),
+static khAstExpression exparseLambda(khToken** cursor, bool ignore_newline) {
+    khToken* token = currentToken(cursor, ignore_newline);
+    uint8_t* origin = token->begin;
+    khAstLambda lambda = {.arguments = newArray(khAstVariable, khAstVariable_delete),
                           .opt_variadic_argument = NULL,
                           .is_return_type_ref = false,
                           .opt_return_type = NULL,
                           .block = NULL};
 
     // Ensures `def` keyword
-    if (token.type == khTokenType_KEYWORD && token.keyword == khKeywordToken_DEF) {
+    if (token->type == khTokenType_KEYWORD && token->keyword == khKeywordToken_DEF) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, ignore_newline);
     }
     else {
-        raiseError(token.begin, U"expecting a `def` keyword");
+        raiseError(token->begin, U"expecting a `def` keyword");
     }
 
     sparseFunctionOrLambda(cursor, &lambda.arguments, &lambda.opt_variadic_argument,
                            &lambda.is_return_type_ref, &lambda.opt_return_type, &lambda.block);
 
-    khToken_delete(&token);
-    return (khAstExpression){
-        .begin = origin, .end = *cursor, .type = khAstExpressionType_LAMBDA, .lambda = lambda};
+    return (khAstExpression){.begin = origin,
+                             .end = previousEnd(cursor),
+                             .type = khAstExpressionType_LAMBDA,
+                             .lambda = lambda};
 }
 
-static khAstExpression exparseDict(char32_t** cursor, bool ignore_newline) {
-    khToken token = currentToken(cursor, ignore_newline);
-    char32_t* origin = *cursor;
-    khAstDict dict = {.keys = kharray_new(khAstExpression, khAstExpression_delete),
-                      .values = kharray_new(khAstExpression, khAstExpression_delete)};
+static khAstExpression exparseDict(khToken** cursor, bool ignore_newline) {
+    khToken* token = currentToken(cursor, ignore_newline);
+    uint8_t* origin = token->begin;
+    khAstDict dict = {.keys = newArray(khAstExpression, khAstExpression_delete),
+                      .values = newArray(khAstExpression, khAstExpression_delete)};
 
     // Ensures an opening curly bracket
-    if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_CURLY_BRACKET_OPEN) {
+    if (token->type == khTokenType_DELIMITER &&
+        token->delimiter == khDelimiterToken_CURLY_BRACKET_OPEN) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, true);
     }
     else {
-        raiseError(token.begin, U"expecting an opening curly bracket");
+        raiseError(token->begin, U"expecting an opening curly bracket");
     }
 
     // Instant close
-    if (token.type == khTokenType_DELIMITER &&
-        token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
+    if (token->type == khTokenType_DELIMITER &&
+        token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
         skipToken(cursor);
     }
     else {
         while (true) {
             // Key
             kharray_append(&dict.keys, kh_parseExpression(cursor, true, false));
-            khToken_delete(&token);
             token = currentToken(cursor, true);
 
             // Ensures a colon
-            if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COLON) {
+            if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_COLON) {
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, true);
             }
             else {
-                raiseError(token.begin, U"expecting a colon after the key for its value pair");
+                raiseError(token->begin, U"expecting a colon after the key for its value pair");
             }
 
             // Value
             kharray_append(&dict.values, kh_parseExpression(cursor, true, false));
-            khToken_delete(&token);
             token = currentToken(cursor, true);
 
             // Do nothing after a comma
-            if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COMMA) {
+            if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_COMMA) {
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, true);
             }
             // Breaks out of the loop after dict close
-            else if (token.type == khTokenType_DELIMITER &&
-                     token.delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
+            else if (token->type == khTokenType_DELIMITER &&
+                     token->delimiter == khDelimiterToken_CURLY_BRACKET_CLOSE) {
                 skipToken(cursor);
                 break;
             }
             else {
                 raiseError(
-                    token.begin,
+                    token->begin,
                     U"expecting a comma with another pair of key and value or a closing delimiter");
                 break;
             }
         }
     }
 
-    khToken_delete(&token);
     return (khAstExpression){
-        .begin = origin, .end = *cursor, .type = khAstExpressionType_DICT, .dict = dict};
+        .begin = origin, .end = previousEnd(cursor), .type = khAstExpressionType_DICT, .dict = dict};
 }
 
-static kharray(khAstExpression) exparseList(char32_t** cursor, khDelimiterToken opening_delimiter,
+static kharray(khAstExpression) exparseList(khToken** cursor, khDelimiterToken opening_delimiter,
                                             khDelimiterToken closing_delimiter, EXPARSE_ARGS) {
-    kharray(khAstExpression) expressions = kharray_new(khAstExpression, khAstExpression_delete);
-    khToken token = currentToken(cursor, ignore_newline);
+    kharray(khAstExpression) expressions = newArray(khAstExpression, khAstExpression_delete);
+    khToken* token = currentToken(cursor, ignore_newline);
 
     // Ensures the opening delimiter
-    if (token.type == khTokenType_DELIMITER && token.delimiter == opening_delimiter) {
+    if (token->type == khTokenType_DELIMITER && token->delimiter == opening_delimiter) {
         skipToken(cursor);
-        khToken_delete(&token);
         token = currentToken(cursor, true);
     }
     else {
-        raiseError(token.begin, U"expecting an opening delimiter");
+        raiseError(token->begin, U"expecting an opening delimiter");
     }
 
     // Instant close
-    if (token.type == khTokenType_DELIMITER && token.delimiter == closing_delimiter) {
+    if (token->type == khTokenType_DELIMITER && token->delimiter == closing_delimiter) {
         skipToken(cursor);
     }
     else {
         while (true) {
             // Expression
             kharray_append(&expressions, kh_parseExpression(cursor, true, filter_type));
-            khToken_delete(&token);
             token = currentToken(cursor, true);
 
             // Do nothing after a comma
-            if (token.type == khTokenType_DELIMITER && token.delimiter == khDelimiterToken_COMMA) {
+            if (token->type == khTokenType_DELIMITER && token->delimiter == khDelimiterToken_COMMA) {
                 skipToken(cursor);
-                khToken_delete(&token);
                 token = currentToken(cursor, true);
             }
             // Breaks out of the loop after list close
-            else if (token.type == khTokenType_DELIMITER && token.delimiter == closing_delimiter) {
+            else if (token->type == khTokenType_DELIMITER && token->delimiter == closing_delimiter) {
                 skipToken(cursor);
                 break;
             }
             else {
-                raiseError(token.begin,
+                raiseError(token->begin,
                            U"expecting a comma with another element or a closing delimiter");
                 break;
             }
         }
     }
 
-    khToken_delete(&token);
-
     return expressions;
 }
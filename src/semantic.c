@@ -0,0 +1,732 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <kithare/core/ast.h>
+#include <kithare/core/error.h>
+#include <kithare/core/semantic.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/hashmap.h>
+#include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
+
+
+const char* khSymbolType_name(khSymbolType type) {
+    switch (type) {
+        case khSymbolType_IMPORT:
+            return "import";
+        case khSymbolType_FUNCTION:
+            return "function";
+        case khSymbolType_CLASS:
+            return "class";
+        case khSymbolType_STRUCT:
+            return "struct";
+        case khSymbolType_ENUM:
+            return "enum";
+        case khSymbolType_ENUM_MEMBER:
+            return "enum_member";
+        case khSymbolType_ALIAS:
+            return "alias";
+        case khSymbolType_VARIABLE:
+            return "variable";
+        case khSymbolType_ARGUMENT:
+            return "argument";
+        case khSymbolType_TEMPLATE_ARGUMENT:
+            return "template_argument";
+        case khSymbolType_ITERATOR:
+            return "iterator";
+
+        default:
+            return "invalid";
+    }
+}
+
+
+static void khScope_delete(khScope* scope) {
+    if (scope->names != NULL) {
+        khhashmap_delete(&scope->names);
+    }
+}
+
+void khSymbolTable_delete(khSymbolTable* table) {
+    kharray_delete(&table->symbols);
+    kharray_delete(&table->scopes);
+    kharray_delete(&table->references);
+}
+
+static inline void writeIndex(khWriter* writer, size_t index) {
+    if (index != SIZE_MAX) {
+        khWriter_uint(writer, index, 10);
+    }
+    else {
+        khWriter_cstring(writer, "null");
+    }
+}
+
+void khSymbolTable_write(khSymbolTable* table, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"symbols\": [\n");
+    for (size_t i = 0; i < kharray_size(&table->symbols); i++) {
+        khSymbol* symbol = &table->symbols[i];
+
+        khWriter_cstring(writer, "{\"type\": ");
+        khWriter_quoteCstring(writer, khSymbolType_name(symbol->type));
+        khWriter_cstring(writer, ", \"name\": ");
+        khWriter_quote(writer, &symbol->name);
+        khWriter_cstring(writer, ", \"begin\": ");
+        khWriter_uint(writer, symbol->begin - origin, 10);
+        khWriter_cstring(writer, ", \"scope\": ");
+        khWriter_uint(writer, symbol->scope, 10);
+        khWriter_cstring(writer, ", \"members\": ");
+        writeIndex(writer, symbol->members);
+        khWriter_cstring(writer, i < kharray_size(&table->symbols) - 1 ? "},\n" : "}\n");
+    }
+
+    khWriter_cstring(writer, "], \"scopes\": [\n");
+    for (size_t i = 0; i < kharray_size(&table->scopes); i++) {
+        khScope* scope = &table->scopes[i];
+
+        khWriter_cstring(writer, "{\"parent\": ");
+        writeIndex(writer, scope->parent);
+        khWriter_cstring(writer, ", \"begin\": ");
+        writeIndex(writer, scope->begin != NULL ? (size_t)(scope->begin - origin) : SIZE_MAX);
+        khWriter_cstring(writer, i < kharray_size(&table->scopes) - 1 ? "},\n" : "}\n");
+    }
+
+    khWriter_cstring(writer, "], \"references\": [\n");
+    for (size_t i = 0; i < kharray_size(&table->references); i++) {
+        khReference* reference = &table->references[i];
+
+        khWriter_cstring(writer, "{\"name\": ");
+        khWriter_quote(writer, &reference->name);
+        khWriter_cstring(writer, ", \"begin\": ");
+        khWriter_uint(writer, reference->begin - origin, 10);
+        khWriter_cstring(writer, ", \"symbol\": ");
+        writeIndex(writer, reference->symbol);
+        khWriter_cstring(writer, i < kharray_size(&table->references) - 1 ? "},\n" : "}\n");
+    }
+
+    khWriter_cstring(writer, "]}");
+}
+
+static inline size_t findSymbol(khSymbolTable* table, size_t scope, khstring* name) {
+    khhashmap(khScopeEntry)* names = &table->scopes[scope].names;
+    khScopeEntry* entry = *names != NULL ? khhashmap_find(names, *name) : NULL;
+    return entry != NULL ? entry->symbol : SIZE_MAX;
+}
+
+size_t khSymbolTable_lookup(khSymbolTable* table, size_t scope, khstring* name) {
+    for (; scope != SIZE_MAX; scope = table->scopes[scope].parent) {
+        size_t symbol = findSymbol(table, scope, name);
+        if (symbol != SIZE_MAX) {
+            return symbol;
+        }
+    }
+
+    return SIZE_MAX;
+}
+
+
+// A symbol made visible, with the one of the same name it hides until its scope ends
+typedef struct {
+    size_t symbol;
+    size_t hidden; // SIZE_MAX if there's none
+} Shadow;
+
+// The symbol of the statement which declared it, by where the statement begins
+typedef struct {
+    uint8_t* key;
+    size_t symbol;
+} Declaration;
+
+// Rather than looking names up through every scope up to the module's, the innermost symbol of each
+// name is kept in a single map as the scopes open and close, so resolving a name is a single lookup
+typedef struct {
+    khSymbolTable* table;
+    size_t scope; // What's being resolved in
+    khhashmap(khScopeEntry) visible;
+    kharray(Shadow) shadows; // Innermost last
+    khhashmap(Declaration) declarations;
+    khhashmap(khScopeEntry) builtins; // Whether each name which isn't declared is built in, once seen
+    bool is_including; // Names which aren't declared may be from an included module
+    kharray(khError) errors; // Raised once they're all found, in the order of the source
+} Resolver;
+
+// Where the resolver was before a scope was entered
+typedef struct {
+    size_t scope;
+    size_t shadows;
+} Frame;
+
+
+static inline void raiseNameError(Resolver* resolver, uint8_t* ptr, const char32_t* message,
+                                  khstring* name) {
+    khstring string = khstring_new(message);
+    khstring_concatenateCstring(&string, U" `");
+    khstring_concatenate(&string, name);
+    khstring_append(&string, U'`');
+    kharray_append(&resolver->errors,
+                   ((khError){.type = khErrorType_SEMANTIC, .message = string, .data = ptr}));
+}
+
+static const char32_t* builtin_names[] = {
+    U"none", U"true",   U"false",  U"bool",   U"byte",    U"char",  U"int",   U"uint", U"float",
+    U"double", U"ifloat", U"idouble", U"str", U"buffer", U"any", U"print", U"input", U"len"};
+
+static bool isBuiltin(Resolver* resolver, khstring* name) {
+    khScopeEntry* entry = khhashmap_find(&resolver->builtins, *name);
+    if (entry != NULL) {
+        return entry->symbol;
+    }
+
+    bool is_builtin = false;
+    for (size_t i = 0; i < sizeof(builtin_names) / sizeof(builtin_names[0]) && !is_builtin; i++) {
+        is_builtin = khstring_equalCstring(name, builtin_names[i]);
+    }
+
+    khhashmap_put(&resolver->builtins, ((khScopeEntry){.key = *name, .symbol = is_builtin}));
+    return is_builtin;
+}
+
+static inline size_t newScope(Resolver* resolver, size_t parent, uint8_t* begin) {
+    kharray_append(&resolver->table->scopes,
+                   ((khScope){.parent = parent, .begin = begin, .names = NULL}));
+    return kharray_size(&resolver->table->scopes) - 1;
+}
+
+// Adds a symbol to a scope without making it visible; only functions can be redeclared in the same
+// scope, as overloads
+static size_t addSymbol(Resolver* resolver, size_t scope, khSymbolType type, khstring name,
+                        uint8_t* begin) {
+    khSymbolTable* table = resolver->table;
+    size_t previous = findSymbol(table, scope, &name);
+
+    if (previous == SIZE_MAX) {
+        if (table->scopes[scope].names == NULL) {
+            table->scopes[scope].names =
+                khhashmap_new(khScopeEntry, khhashmap_hashPointer, khhashmap_equalPointer, NULL);
+        }
+        khhashmap_put(&table->scopes[scope].names,
+                      ((khScopeEntry){.key = name, .symbol = kharray_size(&table->symbols)}));
+    }
+    else if (type != khSymbolType_FUNCTION || table->symbols[previous].type != khSymbolType_FUNCTION) {
+        raiseNameError(resolver, begin, U"redeclared name", &name);
+    }
+
+    kharray_append(&table->symbols, ((khSymbol){.type = type,
+                                                .name = name,
+                                                .begin = begin,
+                                                .scope = scope,
+                                                .members = SIZE_MAX}));
+    return kharray_size(&table->symbols) - 1;
+}
+
+static void makeVisible(Resolver* resolver, size_t symbol) {
+    khstring name = resolver->table->symbols[symbol].name;
+    khScopeEntry* entry = khhashmap_find(&resolver->visible, name);
+
+    if (entry != NULL) {
+        kharray_append(&resolver->shadows, ((Shadow){.symbol = symbol, .hidden = entry->symbol}));
+        entry->symbol = symbol;
+    }
+    else {
+        kharray_append(&resolver->shadows, ((Shadow){.symbol = symbol, .hidden = SIZE_MAX}));
+        khhashmap_put(&resolver->visible, ((khScopeEntry){.key = name, .symbol = symbol}));
+    }
+}
+
+// Adds a symbol to the scope being resolved in, seen from there on
+static inline size_t declare(Resolver* resolver, khSymbolType type, khstring name, uint8_t* begin) {
+    size_t symbol = addSymbol(resolver, resolver->scope, type, name, begin);
+    makeVisible(resolver, symbol);
+    return symbol;
+}
+
+// Makes what's already declared in the scope visible
+static Frame enterScope(Resolver* resolver, size_t scope) {
+    Frame frame = {.scope = resolver->scope, .shadows = kharray_size(&resolver->shadows)};
+    resolver->scope = scope;
+
+    khhashmap(khScopeEntry)* names = &resolver->table->scopes[scope].names;
+    if (*names != NULL) {
+        for (size_t i = 0; i < khhashmap_capacity(names); i++) {
+            if (khhashmap_isOccupied(names, i)) {
+                makeVisible(resolver, (*names)[i].symbol);
+            }
+        }
+    }
+
+    return frame;
+}
+
+static void exitScope(Resolver* resolver, Frame frame) {
+    while (kharray_size(&resolver->shadows) > frame.shadows) {
+        Shadow* shadow = &resolver->shadows[kharray_size(&resolver->shadows) - 1];
+        khstring name = resolver->table->symbols[shadow->symbol].name;
+
+        if (shadow->hidden != SIZE_MAX) {
+            khhashmap_find(&resolver->visible, name)->symbol = shadow->hidden;
+        }
+        else {
+            khhashmap_remove(&resolver->visible, name);
+        }
+        kharray_setSize(&resolver->shadows, kharray_size(&resolver->shadows) - 1);
+    }
+
+    resolver->scope = frame.scope;
+}
+
+static void declareBlock(Resolver* resolver, size_t scope, kharray(khAstStatement) * block,
+                         bool are_variables_declared);
+
+// Declares the block's functions, classes and such in the scope being resolved in, seen from there on
+static void declareInScope(Resolver* resolver, kharray(khAstStatement) * block) {
+    khSymbolTable* table = resolver->table;
+    size_t first = kharray_size(&table->symbols);
+    declareBlock(resolver, resolver->scope, block, false);
+
+    // Besides those of their members, and those redeclared
+    for (size_t i = first; i < kharray_size(&table->symbols); i++) {
+        if (table->symbols[i].scope == resolver->scope &&
+            findSymbol(table, resolver->scope, &table->symbols[i].name) == i) {
+            makeVisible(resolver, i);
+        }
+    }
+}
+
+static size_t resolveName(Resolver* resolver, khstring name, uint8_t* begin) {
+    khScopeEntry* entry = khhashmap_find(&resolver->visible, name);
+    size_t symbol = entry != NULL ? entry->symbol : SIZE_MAX;
+
+    if (symbol == SIZE_MAX && !resolver->is_including && !isBuiltin(resolver, &name)) {
+        raiseNameError(resolver, begin, U"unknown name", &name);
+    }
+
+    kharray_append(&resolver->table->references,
+                   ((khReference){.name = name, .begin = begin, .symbol = symbol}));
+    return symbol;
+}
+
+
+static void resolveExpression(Resolver* resolver, khAstExpression* expression);
+static void resolveBlock(Resolver* resolver, kharray(khAstStatement) * block,
+                         bool are_variables_declared);
+
+static inline void resolveExpressions(Resolver* resolver, kharray(khAstExpression) * expressions) {
+    for (size_t i = 0; i < kharray_size(expressions); i++) {
+        resolveExpression(resolver, &(*expressions)[i]);
+    }
+}
+
+static inline void resolveOptionalExpression(Resolver* resolver, khAstExpression* opt_expression) {
+    if (opt_expression != NULL) {
+        resolveExpression(resolver, opt_expression);
+    }
+}
+
+// Its type and initializer are resolved before its names are declared, so `x := x` is of another `x`
+static void resolveVariable(Resolver* resolver, khAstVariable* variable, khSymbolType type,
+                            uint8_t* begin, bool is_declared) {
+    resolveOptionalExpression(resolver, variable->opt_type);
+    resolveOptionalExpression(resolver, variable->opt_initializer);
+
+    if (!is_declared) {
+        for (size_t i = 0; i < kharray_size(&variable->names); i++) {
+            declare(resolver, type, variable->names[i], begin);
+        }
+    }
+}
+
+// Arguments, in a scope of their own which the block is in
+static void resolveFunction(Resolver* resolver, uint8_t* begin, kharray(khstring) * template_arguments,
+                            kharray(khAstVariable) * arguments, khAstVariable* opt_variadic_argument,
+                            khAstExpression* opt_return_type, kharray(khAstStatement) * block) {
+    Frame frame = enterScope(resolver, newScope(resolver, resolver->scope, begin));
+
+    if (template_arguments != NULL) {
+        for (size_t i = 0; i < kharray_size(template_arguments); i++) {
+            declare(resolver, khSymbolType_TEMPLATE_ARGUMENT, (*template_arguments)[i], begin);
+        }
+    }
+
+    for (size_t i = 0; i < kharray_size(arguments); i++) {
+        resolveVariable(resolver, &(*arguments)[i], khSymbolType_ARGUMENT, begin, false);
+    }
+    if (opt_variadic_argument != NULL) {
+        resolveVariable(resolver, opt_variadic_argument, khSymbolType_ARGUMENT, begin, false);
+    }
+
+    resolveOptionalExpression(resolver, opt_return_type);
+    declareInScope(resolver, block);
+    resolveBlock(resolver, block, false);
+    exitScope(resolver, frame);
+}
+
+// Each of the scope names is looked up in the members of what's before it, for as long as it has any,
+// like `Enum.MEMBER` or `Class.Struct.member`
+static void resolveScope(Resolver* resolver, khAstExpression* expression) {
+    khAstScopeExpression* scope_exp = &expression->scope;
+    resolveExpression(resolver, scope_exp->value);
+    if (scope_exp->value->type != khAstExpressionType_IDENTIFIER) {
+        return;
+    }
+
+    khSymbolTable* table = resolver->table;
+    khReference* value = &table->references[kharray_size(&table->references) - 1];
+    size_t symbol = value->symbol;
+
+    for (size_t i = 0; i < kharray_size(&scope_exp->scope_names) && symbol != SIZE_MAX; i++) {
+        khstring* name = &scope_exp->scope_names[i];
+        size_t members = table->symbols[symbol].members;
+        if (members == SIZE_MAX) {
+            break;
+        }
+
+        khSymbolType type = table->symbols[symbol].type;
+        symbol = findSymbol(table, members, name);
+
+        // Classes and structs may have more members, from what they inherit or outside of them
+        if (symbol == SIZE_MAX) {
+            if (type == khSymbolType_ENUM) {
+                raiseNameError(resolver, expression->begin, U"unknown enum member", name);
+            }
+            break;
+        }
+
+        kharray_append(&table->references,
+                       ((khReference){.name = *name, .begin = expression->begin, .symbol = symbol}));
+    }
+}
+
+static void resolveExpression(Resolver* resolver, khAstExpression* expression) {
+    switch (expression->type) {
+        case khAstExpressionType_IDENTIFIER:
+            resolveName(resolver, expression->identifier, expression->begin);
+            break;
+
+        case khAstExpressionType_TUPLE:
+            resolveExpressions(resolver, &expression->tuple.values);
+            break;
+        case khAstExpressionType_ARRAY:
+            resolveExpressions(resolver, &expression->array.values);
+            break;
+        case khAstExpressionType_DICT:
+            for (size_t i = 0; i < kharray_size(&expression->dict.keys); i++) {
+                resolveExpression(resolver, &expression->dict.keys[i]);
+                resolveExpression(resolver, &expression->dict.values[i]);
+            }
+            break;
+
+        case khAstExpressionType_SIGNATURE:
+            resolveExpressions(resolver, &expression->signature.argument_types);
+            resolveOptionalExpression(resolver, expression->signature.opt_return_type);
+            break;
+        case khAstExpressionType_LAMBDA: {
+            khAstLambda* lambda = &expression->lambda;
+            resolveFunction(resolver, expression->begin, NULL, &lambda->arguments,
+                            lambda->opt_variadic_argument, lambda->opt_return_type, &lambda->block);
+        } break;
+
+        case khAstExpressionType_UNARY:
+            resolveExpression(resolver, expression->unary.operand);
+            break;
+        case khAstExpressionType_BINARY:
+            resolveExpression(resolver, expression->binary.left);
+            resolveExpression(resolver, expression->binary.right);
+            break;
+        case khAstExpressionType_TERNARY:
+            resolveExpression(resolver, expression->ternary.value);
+            resolveExpression(resolver, expression->ternary.condition);
+            resolveExpression(resolver, expression->ternary.otherwise);
+            break;
+        case khAstExpressionType_COMPARISON:
+            resolveExpressions(resolver, &expression->comparison.operands);
+            break;
+        case khAstExpressionType_CALL:
+            resolveExpression(resolver, expression->call.callee);
+            resolveExpressions(resolver, &expression->call.arguments);
+            break;
+        case khAstExpressionType_INDEX:
+            resolveExpression(resolver, expression->index.indexee);
+            resolveExpressions(resolver, &expression->index.arguments);
+            break;
+
+        case khAstExpressionType_SCOPE:
+            resolveScope(resolver, expression);
+            break;
+        case khAstExpressionType_TEMPLATIZE:
+            resolveExpression(resolver, expression->templatize.value);
+            resolveExpressions(resolver, &expression->templatize.template_arguments);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+static inline void addDeclaration(Resolver* resolver, khAstStatement* statement, size_t symbol) {
+    khhashmap_put(&resolver->declarations, ((Declaration){.key = statement->begin, .symbol = symbol}));
+}
+
+// Adds what's seen throughout a block to the scope before the block is resolved: functions, classes,
+// structs, enums, aliases and imports, and variables too if `are_variables_declared`. The members of
+// classes, structs and enums are declared along with them, so they're known wherever they're scoped
+// into
+static void declareBlock(Resolver* resolver, size_t scope, kharray(khAstStatement) * block,
+                         bool are_variables_declared) {
+    for (size_t i = 0; i < kharray_size(block); i++) {
+        khAstStatement* statement = &(*block)[i];
+
+        switch (statement->type) {
+            case khAstStatementType_VARIABLE:
+                if (are_variables_declared) {
+                    khAstVariable* variable = &statement->variable;
+                    for (size_t j = 0; j < kharray_size(&variable->names); j++) {
+                        addSymbol(resolver, scope, khSymbolType_VARIABLE, variable->names[j],
+                                  statement->begin);
+                    }
+                }
+                break;
+
+            case khAstStatementType_IMPORT: {
+                khAstImport* import_v = &statement->import_v;
+                khstring name = import_v->opt_alias != NULL
+                                    ? *import_v->opt_alias
+                                    : import_v->path[kharray_size(&import_v->path) - 1];
+                addSymbol(resolver, scope, khSymbolType_IMPORT, name, statement->begin);
+            } break;
+
+            case khAstStatementType_INCLUDE:
+                resolver->is_including = true;
+                break;
+
+            // Those of more than one identifier, like `def Class.method()`, are declared elsewhere
+            case khAstStatementType_FUNCTION:
+                if (kharray_size(&statement->function.identifiers) == 1) {
+                    addDeclaration(resolver, statement,
+                                   addSymbol(resolver, scope, khSymbolType_FUNCTION,
+                                             statement->function.identifiers[0], statement->begin));
+                }
+                break;
+
+            case khAstStatementType_CLASS:
+            case khAstStatementType_STRUCT: {
+                bool is_class = statement->type == khAstStatementType_CLASS;
+                khstring name = is_class ? statement->class_v.name : statement->struct_v.name;
+                kharray(khstring)* template_arguments =
+                    is_class ? &statement->class_v.template_arguments
+                             : &statement->struct_v.template_arguments;
+                kharray(khAstStatement)* members = is_class ? &statement->class_v.block
+                                                            : &statement->struct_v.block;
+
+                size_t symbol = addSymbol(resolver, scope,
+                                          is_class ? khSymbolType_CLASS : khSymbolType_STRUCT, name,
+                                          statement->begin);
+                size_t members_scope = newScope(resolver, scope, statement->begin);
+                resolver->table->symbols[symbol].members = members_scope;
+                addDeclaration(resolver, statement, symbol);
+
+                for (size_t j = 0; j < kharray_size(template_arguments); j++) {
+                    addSymbol(resolver, members_scope, khSymbolType_TEMPLATE_ARGUMENT,
+                              (*template_arguments)[j], statement->begin);
+                }
+                declareBlock(resolver, members_scope, members, true);
+            } break;
+
+            case khAstStatementType_ENUM: {
+                khAstEnum* enum_v = &statement->enum_v;
+                size_t symbol = addSymbol(resolver, scope, khSymbolType_ENUM, enum_v->name,
+                                          statement->begin);
+                size_t members_scope = newScope(resolver, scope, statement->begin);
+                resolver->table->symbols[symbol].members = members_scope;
+
+                for (size_t j = 0; j < kharray_size(&enum_v->members); j++) {
+                    addSymbol(resolver, members_scope, khSymbolType_ENUM_MEMBER, enum_v->members[j],
+                              statement->begin);
+                }
+            } break;
+
+            case khAstStatementType_ALIAS:
+                addSymbol(resolver, scope, khSymbolType_ALIAS, statement->alias.name,
+                          statement->begin);
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+// Its block is in a scope of its own, unless it's empty
+static inline void resolveNestedBlock(Resolver* resolver, uint8_t* begin,
+                                      kharray(khAstStatement) * block) {
+    if (kharray_size(block) == 0) {
+        return;
+    }
+
+    Frame frame = enterScope(resolver, newScope(resolver, resolver->scope, begin));
+    declareInScope(resolver, block);
+    resolveBlock(resolver, block, false);
+    exitScope(resolver, frame);
+}
+
+static void resolveStatement(Resolver* resolver, khAstStatement* statement,
+                             bool are_variables_declared) {
+    switch (statement->type) {
+        case khAstStatementType_VARIABLE:
+            resolveVariable(resolver, &statement->variable, khSymbolType_VARIABLE, statement->begin,
+                            are_variables_declared);
+            break;
+        case khAstStatementType_EXPRESSION:
+            resolveExpression(resolver, &statement->expression);
+            break;
+
+        case khAstStatementType_FUNCTION: {
+            khAstFunction* function = &statement->function;
+            if (kharray_size(&function->identifiers) > 1) {
+                resolveName(resolver, function->identifiers[0], statement->begin);
+            }
+
+            resolveFunction(resolver, statement->begin, &function->template_arguments,
+                            &function->arguments, function->opt_variadic_argument,
+                            function->opt_return_type, &function->block);
+        } break;
+
+        case khAstStatementType_CLASS:
+        case khAstStatementType_STRUCT: {
+            Declaration* declaration = khhashmap_find(&resolver->declarations, statement->begin);
+            size_t members = resolver->table->symbols[declaration->symbol].members;
+
+            Frame frame = enterScope(resolver, members);
+            if (statement->type == khAstStatementType_CLASS) {
+                resolveOptionalExpression(resolver, statement->class_v.opt_base_type);
+                resolveBlock(resolver, &statement->class_v.block, true);
+            }
+            else {
+                resolveBlock(resolver, &statement->struct_v.block, true);
+            }
+            exitScope(resolver, frame);
+        } break;
+
+        case khAstStatementType_ALIAS:
+            resolveExpression(resolver, &statement->alias.expression);
+            break;
+
+        case khAstStatementType_IF_BRANCH: {
+            khAstIfBranch* if_branch = &statement->if_branch;
+            for (size_t i = 0; i < kharray_size(&if_branch->branch_conditions); i++) {
+                resolveExpression(resolver, &if_branch->branch_conditions[i]);
+                resolveNestedBlock(resolver, statement->begin, &if_branch->branch_blocks[i]);
+            }
+            resolveNestedBlock(resolver, statement->begin, &if_branch->else_block);
+        } break;
+
+        case khAstStatementType_WHILE_LOOP:
+            resolveExpression(resolver, &statement->while_loop.condition);
+            resolveNestedBlock(resolver, statement->begin, &statement->while_loop.block);
+            break;
+        case khAstStatementType_DO_WHILE_LOOP:
+            resolveNestedBlock(resolver, statement->begin, &statement->do_while_loop.block);
+            resolveExpression(resolver, &statement->do_while_loop.condition);
+            break;
+
+        case khAstStatementType_FOR_LOOP: {
+            khAstForLoop* for_loop = &statement->for_loop;
+            resolveExpression(resolver, &for_loop->iteratee);
+
+            Frame frame = enterScope(resolver, newScope(resolver, resolver->scope, statement->begin));
+            for (size_t i = 0; i < kharray_size(&for_loop->iterators); i++) {
+                declare(resolver, khSymbolType_ITERATOR, for_loop->iterators[i], statement->begin);
+            }
+
+            declareInScope(resolver, &for_loop->block);
+            resolveBlock(resolver, &for_loop->block, false);
+            exitScope(resolver, frame);
+        } break;
+
+        case khAstStatementType_RETURN:
+            resolveExpressions(resolver, &statement->return_v.values);
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Its declarations must already be in the scope being resolved in
+static void resolveBlock(Resolver* resolver, kharray(khAstStatement) * block,
+                         bool are_variables_declared) {
+    for (size_t i = 0; i < kharray_size(block); i++) {
+        resolveStatement(resolver, &(*block)[i], are_variables_declared);
+    }
+}
+
+// By where they are in the source, then in the order they were found, as each check finds its own
+// together, like redeclarations while declaring
+static int compareErrors(const void* a, const void* b) {
+    khError* a_error = *(khError**)a;
+    khError* b_error = *(khError**)b;
+
+    if (a_error->data != b_error->data) {
+        return (uint8_t*)a_error->data < (uint8_t*)b_error->data ? -1 : 1;
+    }
+    return (a_error > b_error) - (a_error < b_error);
+}
+
+static void raiseInOrder(kharray(khError) * errors) {
+    kharray(khError*) order = kharray_new(khError*, NULL);
+    kharray_reserve(&order, kharray_size(errors));
+    for (size_t i = 0; i < kharray_size(errors); i++) {
+        kharray_append(&order, &(*errors)[i]);
+    }
+
+    qsort(order, kharray_size(&order), sizeof(khError*), compareErrors);
+    for (size_t i = 0; i < kharray_size(&order); i++) {
+        kh_raiseError(*order[i]);
+    }
+
+    kharray_delete(&order);
+    kharray_forget(errors);
+    kharray_delete(errors);
+}
+
+khSymbolTable kh_resolve(kharray(khAstStatement) * ast) {
+    khSymbolTable table = {.symbols = kharray_new(khSymbol, NULL),
+                           .scopes = kharray_new(khScope, khScope_delete),
+                           .references = kharray_new(khReference, NULL)};
+
+    Resolver resolver = {
+        .table = &table,
+        .scope = SIZE_MAX,
+        .visible = khhashmap_new(khScopeEntry, khhashmap_hashPointer, khhashmap_equalPointer, NULL),
+        .shadows = kharray_new(Shadow, NULL),
+        .declarations =
+            khhashmap_new(Declaration, khhashmap_hashPointer, khhashmap_equalPointer, NULL),
+        .builtins = khhashmap_new(khScopeEntry, khhashmap_hashPointer, khhashmap_equalPointer, NULL),
+        .is_including = false,
+        .errors = kharray_new(khError, khError_delete)};
+
+    // Everything in the module is seen throughout it
+    size_t module = newScope(&resolver, SIZE_MAX, NULL);
+    declareBlock(&resolver, module, ast, true);
+
+    Frame frame = enterScope(&resolver, module);
+    resolveBlock(&resolver, ast, true);
+    exitScope(&resolver, frame);
+
+    // In the order of the source, like those of the lexer and the parser
+    raiseInOrder(&resolver.errors);
+
+    khhashmap_delete(&resolver.visible);
+    kharray_delete(&resolver.shadows);
+    khhashmap_delete(&resolver.declarations);
+    khhashmap_delete(&resolver.builtins);
+    return table;
+}
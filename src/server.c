@@ -0,0 +1,526 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <kithare/core/ast.h>
+#include <kithare/core/error.h>
+#include <kithare/core/module.h>
+#include <kithare/core/parser.h>
+#include <kithare/core/semantic.h>
+#include <kithare/core/server.h>
+#include <kithare/lib/io.h>
+#include <kithare/lib/thread.h>
+#include <kithare/lib/writer.h>
+
+
+// Of those which weren't found
+static void deleteDependency(khstring* dependency) {
+    if (*dependency != NULL) {
+        khstring_delete(dependency);
+    }
+}
+
+static khServerFile* khServerFile_new(khbuffer source) {
+    khServerFile* file = (khServerFile*)malloc(sizeof(khServerFile));
+    file->tree = khSyntaxTree_new(source);
+    file->lines = khLineTable_new(&file->tree.source);
+    file->dependencies = NULL;
+    file->dependency_errors = NULL;
+    file->dependency_root = NULL;
+    file->name_errors = NULL;
+    return file;
+}
+
+// What's made of the source after it's parsed, which is done again once it's needed
+static void forgetDerived(khServerFile* file) {
+    if (file->dependencies != NULL) {
+        kharray_delete(&file->dependencies);
+        kharray_delete(&file->dependency_errors);
+    }
+    if (file->dependency_root != NULL) {
+        khstring_delete(&file->dependency_root);
+    }
+    if (file->name_errors != NULL) {
+        kharray_delete(&file->name_errors);
+    }
+}
+
+static void khServerFile_delete(khServerFile* file) {
+    forgetDerived(file);
+    khSyntaxTree_delete(&file->tree);
+    khLineTable_delete(&file->lines);
+    free(file);
+}
+
+static void khServerEntry_delete(khServerEntry* entry) {
+    khstring_delete(&entry->key);
+    khServerFile_delete(entry->file);
+}
+
+khServer khServer_new(kharray(khstring) search_directories, size_t threads) {
+    return (khServer){.files = khhashmap_new(khServerEntry, khhashmap_hashString,
+                                             khhashmap_equalString, khServerEntry_delete),
+                      .search_directories = search_directories,
+                      .threads = threads > 0 ? threads : 1};
+}
+
+void khServer_delete(khServer* server) {
+    khhashmap_delete(&server->files);
+    kharray_delete(&server->search_directories);
+}
+
+
+// Takes the path; the file is replaced if there's one already
+static khServerFile* putFile(khServer* server, khstring path, khbuffer source) {
+    khServerFile* file = khServerFile_new(source);
+    khhashmap_put(&server->files, ((khServerEntry){.key = path, .file = file}));
+    return file;
+}
+
+static inline khServerFile* findFile(khServer* server, khstring* path) {
+    khServerEntry* entry = khhashmap_find(&server->files, *path);
+    return entry != NULL ? entry->file : NULL;
+}
+
+// Read from its file the first time it's needed, NULL if there's none
+static khServerFile* getFile(khServer* server, khstring* path) {
+    khServerFile* file = findFile(server, path);
+    if (file != NULL) {
+        return file;
+    }
+
+    bool found;
+    khbuffer source = kh_readFile(path, &found);
+    if (!found) {
+        khbuffer_delete(&source);
+        return NULL;
+    }
+
+    return putFile(server, khstring_copy(path), source);
+}
+
+static void editFile(khServerFile* file, size_t begin, size_t end, khbuffer* replacement) {
+    khSyntaxTree_edit(&file->tree, begin, end, *replacement, khbuffer_size(replacement));
+
+    khLineTable_delete(&file->lines);
+    file->lines = khLineTable_new(&file->tree.source);
+    forgetDerived(file);
+}
+
+
+// Resolved against the search directories, or the entry's directory without them, as `kh_loadModules`
+// does; they're kept until the file is edited or they're resolved from another root
+static void resolveDependencies(khServer* server, khServerFile* file, khstring* path,
+                                khstring* opt_root) {
+    if (file->dependencies != NULL) {
+        bool same_root = opt_root == NULL ? file->dependency_root == NULL
+                                          : file->dependency_root != NULL &&
+                                                khstring_equal(&file->dependency_root, opt_root);
+        if (same_root) {
+            return;
+        }
+        forgetDerived(file);
+    }
+
+    kharray(khstring) default_directories = kharray_new(khstring, khstring_delete);
+    kharray(khstring)* search_directories = &server->search_directories;
+    if (opt_root != NULL) {
+        kharray_append(&default_directories, khstring_copy(opt_root));
+        search_directories = &default_directories;
+        file->dependency_root = khstring_copy(opt_root);
+    }
+
+    file->dependencies = kharray_new(khstring, deleteDependency);
+    file->dependency_errors = kharray_new(khError, khError_delete);
+
+    kharray(khAstStatement)* ast = &file->tree.ast;
+    for (size_t i = 0; i < kharray_size(ast); i++) {
+        khAstStatement* statement = &(*ast)[i];
+        if (statement->type != khAstStatementType_IMPORT &&
+            statement->type != khAstStatementType_INCLUDE) {
+            continue;
+        }
+
+        khstring dependency = kh_findDependency(path, statement, search_directories);
+        if (dependency == NULL) {
+            khstring message = khstring_new(U"module not found: ");
+            khstring name = kh_dependencyName(statement);
+            khstring_concatenate(&message, &name);
+            khstring_delete(&name);
+
+            kharray_append(&file->dependency_errors, ((khError){.type = khErrorType_MODULE,
+                                                                .message = message,
+                                                                .data = statement->begin}));
+        }
+
+        kharray_append(&file->dependencies, dependency);
+    }
+
+    kharray_delete(&default_directories);
+}
+
+// Resolving names doesn't depend on other modules, so it's only done again after an edit
+static kharray(khError) * resolveNames(khServerFile* file) {
+    if (file->name_errors == NULL) {
+        kharray(khError) previous = kh_swapErrors(kharray_new(khError, khError_delete));
+
+        khSymbolTable table = kh_resolve(&file->tree.ast);
+        khSymbolTable_delete(&table);
+
+        file->name_errors = kh_swapErrors(previous);
+    }
+
+    return &file->name_errors;
+}
+
+
+// Modules which aren't kept yet, read and parsed in parallel
+typedef struct {
+    kharray(khstring) paths;
+    kharray(khServerFile*) files; // NULL for those which couldn't be read
+} Loads;
+
+static void load(void* loads_v, size_t index) {
+    Loads* loads = (Loads*)loads_v;
+
+    bool found;
+    khbuffer source = kh_readFile(&loads->paths[index], &found);
+    if (found) {
+        loads->files[index] = khServerFile_new(source);
+    }
+    else {
+        khbuffer_delete(&source);
+    }
+}
+
+// Breadth-first from the entry, a level of modules at a time; those found for the first time are all
+// loaded at once before their own dependencies are looked at
+static kharray(khstring) findModules(khServer* server, khstring* entry, khstring* opt_root) {
+    kharray(khstring) modules = kharray_new(khstring, khstring_delete);
+    khhashmap(khServerEntry) seen =
+        khhashmap_new(khServerEntry, khhashmap_hashString, khhashmap_equalString, NULL);
+
+    kharray_append(&modules, khstring_copy(entry));
+    khhashmap_put(&seen, ((khServerEntry){.key = modules[0], .file = NULL}));
+
+    size_t level = 0;
+    while (level < kharray_size(&modules)) {
+        size_t level_end = kharray_size(&modules);
+        Loads loads = {.paths = kharray_new(khstring, NULL), .files = kharray_new(khServerFile*, NULL)};
+
+        for (size_t i = level; i < level_end; i++) {
+            if (findFile(server, &modules[i]) == NULL) {
+                kharray_append(&loads.paths, modules[i]);
+                kharray_append(&loads.files, NULL);
+            }
+        }
+
+        kh_parallelFor(kharray_size(&loads.paths), server->threads, load, &loads);
+        for (size_t i = 0; i < kharray_size(&loads.paths); i++) {
+            if (loads.files[i] != NULL) {
+                khhashmap_put(&server->files, ((khServerEntry){.key = khstring_copy(&loads.paths[i]),
+                                                               .file = loads.files[i]}));
+            }
+        }
+        kharray_delete(&loads.paths);
+        kharray_delete(&loads.files);
+
+        for (size_t i = level; i < level_end; i++) {
+            khServerFile* file = findFile(server, &modules[i]);
+            if (file == NULL) {
+                continue;
+            }
+
+            resolveDependencies(server, file, &modules[i], opt_root);
+            for (size_t j = 0; j < kharray_size(&file->dependencies); j++) {
+                khstring* dependency = &file->dependencies[j];
+                if (*dependency != NULL && khhashmap_find(&seen, *dependency) == NULL) {
+                    kharray_append(&modules, khstring_copy(dependency));
+                    khhashmap_put(&seen, ((khServerEntry){.key = modules[kharray_size(&modules) - 1],
+                                                          .file = NULL}));
+                }
+            }
+        }
+
+        level = level_end;
+    }
+
+    khhashmap_delete(&seen);
+    return modules;
+}
+
+
+static inline void writeErrors(khWriter* writer, khServerFile* file, kharray(khError) * errors,
+                               bool* is_first) {
+    if (kharray_size(errors) > 0) {
+        khWriter_cstring(writer, *is_first ? "" : ",\n");
+        kh_writeErrorList(writer, errors, &file->tree.source, &file->lines);
+        // Its last newline, before the next list
+        kharray_setSize(&writer->buffer, kharray_size(&writer->buffer) - 1);
+        *is_first = false;
+    }
+}
+
+static void writeDiagnostics(khWriter* writer, khServerFile* file) {
+    khWriter_cstring(writer, "\"errors\": [\n");
+    bool is_first = true;
+    writeErrors(writer, file, &file->tree.errors, &is_first);
+    writeErrors(writer, file, resolveNames(file), &is_first);
+    khWriter_cstring(writer, is_first ? "]" : "\n]");
+}
+
+static void writeAst(khWriter* writer, khServerFile* file) {
+    kharray(khAstStatement)* ast = &file->tree.ast;
+
+    khWriter_cstring(writer, "\"ast\": [\n");
+    for (size_t i = 0; i < kharray_size(ast); i++) {
+        khAstStatement_write(&(*ast)[i], file->tree.source, writer);
+        khWriter_cstring(writer, i < kharray_size(ast) - 1 ? ",\n" : "\n");
+    }
+
+    khWriter_cstring(writer, "],\n\"errors\": [\n");
+    bool is_first = true;
+    writeErrors(writer, file, &file->tree.errors, &is_first);
+    khWriter_cstring(writer, is_first ? "]" : "\n]");
+}
+
+static void writeModules(khWriter* writer, khServer* server, khstring* entry) {
+    khstring directory = kh_directoryOf(entry);
+    bool is_defaulted = kharray_size(&server->search_directories) == 0;
+    kharray(khstring) modules = findModules(server, entry, is_defaulted ? &directory : NULL);
+
+    khWriter_cstring(writer, "\"modules\": [\n");
+    for (size_t i = 0; i < kharray_size(&modules); i++) {
+        khServerFile* file = findFile(server, &modules[i]);
+
+        khWriter_cstring(writer, "{\"file\": ");
+        khWriter_quote(writer, &modules[i]);
+        if (file == NULL) {
+            khWriter_cstring(writer, ", \"error\": \"couldn't read the module\"");
+        }
+        else {
+            khWriter_cstring(writer, ", \"dependencies\": [");
+            for (size_t j = 0; j < kharray_size(&file->dependencies); j++) {
+                if (file->dependencies[j] != NULL) {
+                    khWriter_quote(writer, &file->dependencies[j]);
+                }
+                else {
+                    khWriter_cstring(writer, "null");
+                }
+                khWriter_cstring(writer, j < kharray_size(&file->dependencies) - 1 ? ", " : "");
+            }
+
+            khWriter_cstring(writer, "],\n\"errors\": [\n");
+            bool is_first = true;
+            writeErrors(writer, file, &file->tree.errors, &is_first);
+            writeErrors(writer, file, &file->dependency_errors, &is_first);
+            khWriter_cstring(writer, is_first ? "]" : "\n]");
+        }
+        khWriter_cstring(writer, i < kharray_size(&modules) - 1 ? "},\n" : "}\n");
+    }
+    khWriter_cstring(writer, "]");
+
+    kharray_delete(&modules);
+    khstring_delete(&directory);
+}
+
+
+// A line without its newline, NULL at the end of the input
+static khbuffer readLine(FILE* input) {
+    khbuffer line = khbuffer_new("");
+    int chr;
+    while ((chr = fgetc(input)) != EOF && chr != '\n') {
+        khbuffer_append(&line, (uint8_t)chr);
+    }
+
+    if (chr == EOF && khbuffer_size(&line) == 0) {
+        khbuffer_delete(&line);
+        return NULL;
+    }
+    if (khbuffer_size(&line) > 0 && line[khbuffer_size(&line) - 1] == '\r') {
+        kharray_setSize(&line, kharray_size(&line) - 1);
+    }
+
+    return line;
+}
+
+// The word at the cursor, which is moved past it and the spaces after
+static bool readWord(uint8_t** cursor, uint8_t* end, uint8_t** begin, size_t* size) {
+    *begin = *cursor;
+    while (*cursor < end && **cursor != ' ') {
+        (*cursor)++;
+    }
+    *size = *cursor - *begin;
+
+    while (*cursor < end && **cursor == ' ') {
+        (*cursor)++;
+    }
+    return *size > 0;
+}
+
+static bool readNumber(uint8_t** cursor, uint8_t* end, size_t* number) {
+    uint8_t* begin;
+    size_t size;
+    if (!readWord(cursor, end, &begin, &size)) {
+        return false;
+    }
+
+    *number = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (begin[i] < '0' || begin[i] > '9' || *number > (SIZE_MAX - 9) / 10) {
+            return false;
+        }
+        *number = *number * 10 + (begin[i] - '0');
+    }
+
+    return true;
+}
+
+static inline bool isCommand(uint8_t* word, size_t size, const char* command) {
+    return size == strlen(command) && memcmp(word, command, size) == 0;
+}
+
+static void respond(khWriter* output, khWriter* body) {
+    khWriter_cstring(output, "Content-Length: ");
+    khWriter_uint(output, khbuffer_size(&body->buffer), 10);
+    khWriter_cstring(output, "\r\n\r\n");
+    khWriter_utf8(output, body->buffer, khbuffer_size(&body->buffer));
+
+    khWriter_flush(output);
+    fflush(output->stream);
+    kharray_setSize(&body->buffer, 0);
+}
+
+void khServer_serve(khServer* server, FILE* input, FILE* output) {
+    khWriter output_writer = khWriter_new(output);
+    khWriter body = khWriter_new(NULL);
+
+    khbuffer line;
+    while ((line = readLine(input)) != NULL) {
+        uint8_t* cursor = line;
+        uint8_t* end = line + khbuffer_size(&line);
+        uint8_t* command;
+        size_t command_size;
+
+        if (!readWord(&cursor, end, &command, &command_size)) {
+            khbuffer_delete(&line);
+            continue;
+        }
+        if (isCommand(command, command_size, "exit")) {
+            khbuffer_delete(&line);
+            break;
+        }
+
+        // Arguments, then the path in the rest of the line
+        size_t numbers[3];
+        size_t number_count = isCommand(command, command_size, "change") ? 1
+                              : isCommand(command, command_size, "edit") ? 3
+                                                                          : 0;
+        bool is_valid = true;
+        for (size_t i = 0; i < number_count && is_valid; i++) {
+            is_valid = readNumber(&cursor, end, &numbers[i]);
+        }
+
+        // Content of a change or an edit, which follows the line. Deletions and emptied files have none
+        // to read, so their content stays empty
+        khbuffer content = khbuffer_new("");
+        if (is_valid && number_count > 0 && numbers[number_count - 1] > 0) {
+            // In chunks, so a bogus length only costs as much memory as what actually arrives
+            size_t size = numbers[number_count - 1];
+            uint8_t chunk[4096];
+            size_t read;
+            do {
+                size_t remaining = size - khbuffer_size(&content);
+                read = fread(chunk, 1, remaining < sizeof(chunk) ? remaining : sizeof(chunk), input);
+                kharray_memory(&content, &chunk[0], read, NULL);
+            } while (read == sizeof(chunk) && khbuffer_size(&content) < size);
+            is_valid = khbuffer_size(&content) == size;
+        }
+
+        khbuffer path_bytes = khbuffer_new("");
+        kharray_memory(&path_bytes, cursor, end - cursor, NULL);
+        khstring relative_path = kh_decodeUtf8(&path_bytes);
+        khstring path = kh_normalizePath(&relative_path);
+        khbuffer_delete(&path_bytes);
+        khstring_delete(&relative_path);
+        is_valid &= cursor < end;
+
+        khWriter_cstring(&body, "{\"file\": ");
+        khWriter_quote(&body, &path);
+        khWriter_cstring(&body, ",\n");
+
+        khServerFile* file;
+        if (!is_valid) {
+            khWriter_cstring(&body, "\"error\": \"invalid request\"");
+        }
+        else if (isCommand(command, command_size, "open")) {
+            bool found;
+            khbuffer source = kh_readFile(&path, &found);
+            if (found) {
+                file = putFile(server, khstring_copy(&path), source);
+                writeDiagnostics(&body, file);
+            }
+            else {
+                khbuffer_delete(&source);
+                khhashmap_remove(&server->files, path);
+                khWriter_cstring(&body, "\"error\": \"file not found\"");
+            }
+        }
+        else if (isCommand(command, command_size, "change")) {
+            file = putFile(server, khstring_copy(&path), content);
+            content = NULL;
+            writeDiagnostics(&body, file);
+        }
+        else if (isCommand(command, command_size, "close")) {
+            khWriter_cstring(&body, khhashmap_remove(&server->files, path) ? "\"closed\": true"
+                                                                            : "\"closed\": false");
+        }
+        else if (isCommand(command, command_size, "edit") ||
+                 isCommand(command, command_size, "diagnostics") ||
+                 isCommand(command, command_size, "parse")) {
+            file = getFile(server, &path);
+            if (file == NULL) {
+                khWriter_cstring(&body, "\"error\": \"file not found\"");
+            }
+            else if (isCommand(command, command_size, "edit")) {
+                editFile(file, numbers[0], numbers[1], &content);
+                writeDiagnostics(&body, file);
+            }
+            else if (isCommand(command, command_size, "diagnostics")) {
+                writeDiagnostics(&body, file);
+            }
+            else {
+                writeAst(&body, file);
+            }
+        }
+        else if (isCommand(command, command_size, "modules")) {
+            if (getFile(server, &path) == NULL) {
+                khWriter_cstring(&body, "\"error\": \"file not found\"");
+            }
+            else {
+                writeModules(&body, server, &path);
+            }
+        }
+        else {
+            khWriter_cstring(&body, "\"error\": \"unknown command\"");
+        }
+
+        khWriter_cstring(&body, "\n}\n");
+        respond(&output_writer, &body);
+
+        if (content != NULL) {
+            khbuffer_delete(&content);
+        }
+        khstring_delete(&path);
+        khbuffer_delete(&line);
+    }
+
+    khWriter_delete(&body);
+    khWriter_delete(&output_writer);
+}
@@ -0,0 +1,162 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <kithare/core/stats.h>
+
+// Nothing of it without `kh_STATS`, see `kithare/core/stats.h`
+#ifdef kh_STATS
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <kithare/core/ast.h>
+#include <kithare/core/token.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/writer.h>
+
+
+#define TOKEN_TYPES (khTokenType_IDOUBLE + 1)
+#define STATEMENT_TYPES (khAstStatementType_RETURN + 1)
+#define EXPRESSION_TYPES (khAstExpressionType_TEMPLATIZE + 1)
+
+// Relaxed, as they're only read once everything's done
+static atomic_uint_fast64_t phase_nanoseconds[khStatsPhase_COUNT];
+static atomic_size_t token_counts[TOKEN_TYPES];
+static atomic_size_t statement_counts[STATEMENT_TYPES];
+static atomic_size_t expression_counts[EXPRESSION_TYPES];
+static atomic_size_t allocation_count;
+static atomic_size_t allocation_bytes;
+
+static const char* phase_names[khStatsPhase_COUNT] = {"read", "lexicate", "parse", "serialize"};
+
+static inline void increment(atomic_size_t* counter, size_t amount) {
+    atomic_fetch_add_explicit(counter, amount, memory_order_relaxed);
+}
+
+
+uint64_t kh_nanoseconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
+#endif
+}
+
+void kh_addPhaseTime(khStatsPhase phase, uint64_t nanoseconds) {
+    atomic_fetch_add_explicit(&phase_nanoseconds[phase], nanoseconds, memory_order_relaxed);
+}
+
+void kh_countAllocation(size_t size) {
+    increment(&allocation_count, 1);
+    increment(&allocation_bytes, size);
+}
+
+void kh_countTokens(kharray(khToken) * tokens) {
+    // Counted locally first, so there aren't as many atomic additions as there are tokens
+    size_t counts[TOKEN_TYPES] = {0};
+    for (size_t i = 0; i < kharray_size(tokens); i++) {
+        counts[(*tokens)[i].type]++;
+    }
+
+    for (size_t i = 0; i < TOKEN_TYPES; i++) {
+        if (counts[i] > 0) {
+            increment(&token_counts[i], counts[i]);
+        }
+    }
+}
+
+
+typedef struct {
+    size_t statements[STATEMENT_TYPES];
+    size_t expressions[EXPRESSION_TYPES];
+} AstCounts;
+
+static void countExpression(khAstExpression* expression, void* counts) {
+    ((AstCounts*)counts)->expressions[expression->type]++;
+}
+
+static void countStatement(khAstStatement* statement, void* counts) {
+    ((AstCounts*)counts)->statements[statement->type]++;
+}
+
+void kh_countAst(kharray(khAstStatement) * ast) {
+    AstCounts counts = {{0}, {0}};
+    khAstVisitor visitor = {
+        .expression = countExpression, .statement = countStatement, .data = &counts};
+    for (size_t i = 0; i < kharray_size(ast); i++) {
+        khAstStatement_visit(&(*ast)[i], &visitor);
+    }
+
+    for (size_t i = 0; i < STATEMENT_TYPES; i++) {
+        if (counts.statements[i] > 0) {
+            increment(&statement_counts[i], counts.statements[i]);
+        }
+    }
+
+    for (size_t i = 0; i < EXPRESSION_TYPES; i++) {
+        if (counts.expressions[i] > 0) {
+            increment(&expression_counts[i], counts.expressions[i]);
+        }
+    }
+}
+
+
+// `"name": count` pairs of an object, each on a line of its own
+static void writeCount(khWriter* writer, const char* name, size_t count, bool is_last) {
+    khWriter_cstring(writer, "    ");
+    khWriter_quoteCstring(writer, name);
+    khWriter_cstring(writer, ": ");
+    khWriter_uint(writer, count, 10);
+    khWriter_cstring(writer, is_last ? "\n" : ",\n");
+}
+
+void kh_writeStats(khWriter* writer) {
+    khWriter_cstring(writer, "{\n\"seconds\": {\n");
+    for (size_t i = 0; i < khStatsPhase_COUNT; i++) {
+        khWriter_cstring(writer, "    ");
+        khWriter_quoteCstring(writer, phase_names[i]);
+        khWriter_cstring(writer, ": ");
+        khWriter_float(writer, (double)atomic_load(&phase_nanoseconds[i]) / 1e9, 6, 10);
+        khWriter_cstring(writer, i < khStatsPhase_COUNT - 1 ? ",\n" : "\n");
+    }
+
+    khWriter_cstring(writer, "},\n\"tokens\": {\n");
+    for (size_t i = 0; i < TOKEN_TYPES; i++) {
+        writeCount(writer, khTokenType_name(i), atomic_load(&token_counts[i]), i == TOKEN_TYPES - 1);
+    }
+
+    khWriter_cstring(writer, "},\n\"statements\": {\n");
+    for (size_t i = 0; i < STATEMENT_TYPES; i++) {
+        writeCount(writer, khAstStatementType_name(i), atomic_load(&statement_counts[i]),
+                   i == STATEMENT_TYPES - 1);
+    }
+
+    khWriter_cstring(writer, "},\n\"expressions\": {\n");
+    for (size_t i = 0; i < EXPRESSION_TYPES; i++) {
+        writeCount(writer, khAstExpressionType_name(i), atomic_load(&expression_counts[i]),
+                   i == EXPRESSION_TYPES - 1);
+    }
+
+    khWriter_cstring(writer, "},\n\"allocations\": ");
+    khWriter_uint(writer, atomic_load(&allocation_count), 10);
+    khWriter_cstring(writer, ",\n\"allocated_bytes\": ");
+    khWriter_uint(writer, atomic_load(&allocation_bytes), 10);
+    khWriter_cstring(writer, "\n}\n");
+}
+
+#endif
@@ -5,374 +5,352 @@
  * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
  */
 
+#include <string.h>
+
+#include <kithare/core/lexer.h>
 #include <kithare/core/token.h>
 #include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
 
 
-khstring khTokenType_string(khTokenType type) {
+const char* khTokenType_name(khTokenType type) {
     switch (type) {
         case khTokenType_INVALID:
-            return khstring_new(U"invalid");
+            return "invalid";
         case khTokenType_EOF:
-            return khstring_new(U"eof");
+            return "eof";
         case khTokenType_NEWLINE:
-            return khstring_new(U"newline");
+            return "newline";
         case khTokenType_COMMENT:
-            return khstring_new(U"comment");
+            return "comment";
 
         case khTokenType_IDENTIFIER:
-            return khstring_new(U"identifier");
+            return "identifier";
         case khTokenType_KEYWORD:
-            return khstring_new(U"keyword");
+            return "keyword";
         case khTokenType_DELIMITER:
-            return khstring_new(U"delimiter");
+            return "delimiter";
         case khTokenType_OPERATOR:
-            return khstring_new(U"operator");
+            return "operator";
 
         case khTokenType_CHAR:
-            return khstring_new(U"char");
+            return "char";
         case khTokenType_STRING:
-            return khstring_new(U"string");
+            return "string";
         case khTokenType_BUFFER:
-            return khstring_new(U"buffer");
+            return "buffer";
 
         case khTokenType_BYTE:
-            return khstring_new(U"byte");
+            return "byte";
         case khTokenType_INTEGER:
-            return khstring_new(U"integer");
+            return "integer";
         case khTokenType_UINTEGER:
-            return khstring_new(U"uinteger");
+            return "uinteger";
         case khTokenType_FLOAT:
-            return khstring_new(U"float");
+            return "float";
         case khTokenType_DOUBLE:
-            return khstring_new(U"double");
+            return "double";
         case khTokenType_IDOUBLE:
-            return khstring_new(U"idouble");
+            return "idouble";
         case khTokenType_IFLOAT:
-            return khstring_new(U"ifloat");
+            return "ifloat";
 
         default:
-            return khstring_new(U"unknown");
+            return "unknown";
     }
 }
 
+khstring khTokenType_string(khTokenType type) {
+    const char* name = khTokenType_name(type);
+    return kh_decodeUtf8Memory((const uint8_t*)name, strlen(name));
+}
 
-khstring khKeywordToken_string(khKeywordToken keyword) {
+
+const char* khKeywordToken_name(khKeywordToken keyword) {
     switch (keyword) {
         case khKeywordToken_IMPORT:
-            return khstring_new(U"import");
+            return "import";
         case khKeywordToken_INCLUDE:
-            return khstring_new(U"include");
+            return "include";
         case khKeywordToken_AS:
-            return khstring_new(U"as");
+            return "as";
         case khKeywordToken_DEF:
-            return khstring_new(U"def");
+            return "def";
         case khKeywordToken_CLASS:
-            return khstring_new(U"class");
+            return "class";
         case khKeywordToken_INHERITS:
-            return khstring_new(U"inherits");
+            return "inherits";
         case khKeywordToken_STRUCT:
-            return khstring_new(U"struct");
+            return "struct";
         case khKeywordToken_ENUM:
-            return khstring_new(U"enum");
+            return "enum";
         case khKeywordToken_ALIAS:
-            return khstring_new(U"alias");
+            return "alias";
 
         case khKeywordToken_REF:
-            return khstring_new(U"ref");
+            return "ref";
         case khKeywordToken_WILD:
-            return khstring_new(U"wild");
+            return "wild";
         case khKeywordToken_INCASE:
-            return khstring_new(U"incase");
+            return "incase";
         case khKeywordToken_STATIC:
-            return khstring_new(U"static");
+            return "static";
 
         case khKeywordToken_IF:
-            return khstring_new(U"if");
+            return "if";
         case khKeywordToken_ELIF:
-            return khstring_new(U"elif");
+            return "elif";
         case khKeywordToken_ELSE:
-            return khstring_new(U"else");
+            return "else";
         case khKeywordToken_FOR:
-            return khstring_new(U"for");
+            return "for";
         case khKeywordToken_IN:
-            return khstring_new(U"in");
+            return "in";
         case khKeywordToken_WHILE:
-            return khstring_new(U"while");
+            return "while";
         case khKeywordToken_DO:
-            return khstring_new(U"do");
+            return "do";
         case khKeywordToken_BREAK:
-            return khstring_new(U"break");
+            return "break";
         case khKeywordToken_CONTINUE:
-            return khstring_new(U"continue");
+            return "continue";
         case khKeywordToken_RETURN:
-            return khstring_new(U"return");
+            return "return";
 
         default:
-            return khstring_new(U"unknown");
+            return "unknown";
     }
 }
 
+khstring khKeywordToken_string(khKeywordToken keyword) {
+    const char* name = khKeywordToken_name(keyword);
+    return kh_decodeUtf8Memory((const uint8_t*)name, strlen(name));
+}
+
 
-khstring khDelimiterToken_string(khDelimiterToken delimiter) {
+const char* khDelimiterToken_name(khDelimiterToken delimiter) {
     switch (delimiter) {
         case khDelimiterToken_DOT:
-            return khstring_new(U".");
+            return ".";
         case khDelimiterToken_COMMA:
-            return khstring_new(U",");
+            return ",";
         case khDelimiterToken_COLON:
-            return khstring_new(U":");
+            return ":";
         case khDelimiterToken_SEMICOLON:
-            return khstring_new(U";");
+            return ";";
         case khDelimiterToken_EXCLAMATION:
-            return khstring_new(U"!");
+            return "!";
 
         case khDelimiterToken_PARENTHESIS_OPEN:
-            return khstring_new(U"(");
+            return "(";
         case khDelimiterToken_PARENTHESIS_CLOSE:
-            return khstring_new(U")");
+            return ")";
         case khDelimiterToken_CURLY_BRACKET_OPEN:
-            return khstring_new(U"{");
+            return "{";
         case khDelimiterToken_CURLY_BRACKET_CLOSE:
-            return khstring_new(U"}");
+            return "}";
         case khDelimiterToken_SQUARE_BRACKET_OPEN:
-            return khstring_new(U"[");
+            return "[";
         case khDelimiterToken_SQUARE_BRACKET_CLOSE:
-            return khstring_new(U"]");
+            return "]";
 
         case khDelimiterToken_ARROW:
-            return khstring_new(U"->");
+            return "->";
         case khDelimiterToken_ELLIPSIS:
-            return khstring_new(U"...");
+            return "...";
 
         default:
-            return khstring_new(U"unknown");
+            return "unknown";
     }
 }
 
+khstring khDelimiterToken_string(khDelimiterToken delimiter) {
+    const char* name = khDelimiterToken_name(delimiter);
+    return kh_decodeUtf8Memory((const uint8_t*)name, strlen(name));
+}
 
-khstring khOperatorToken_string(khOperatorToken operator_v) {
+
+const char* khOperatorToken_name(khOperatorToken operator_v) {
     switch (operator_v) {
         case khOperatorToken_ASSIGN:
-            return khstring_new(U"=");
+            return "=";
         case khOperatorToken_RANGE:
-            return khstring_new(U"..");
+            return "..";
 
         case khOperatorToken_ADD:
-            return khstring_new(U"+");
+            return "+";
         case khOperatorToken_SUB:
-            return khstring_new(U"-");
+            return "-";
         case khOperatorToken_MUL:
-            return khstring_new(U"*");
+            return "*";
         case khOperatorToken_DIV:
-            return khstring_new(U"/");
+            return "/";
         case khOperatorToken_MOD:
-            return khstring_new(U"%");
+            return "%";
         case khOperatorToken_DOT:
-            return khstring_new(U"@");
+            return "@";
         case khOperatorToken_POW:
-            return khstring_new(U"^");
+            return "^";
 
         case khOperatorToken_IP_ADD:
-            return khstring_new(U"+=");
+            return "+=";
         case khOperatorToken_IP_SUB:
-            return khstring_new(U"-=");
+            return "-=";
         case khOperatorToken_IP_MUL:
-            return khstring_new(U"*=");
+            return "*=";
         case khOperatorToken_IP_DIV:
-            return khstring_new(U"/=");
+            return "/=";
         case khOperatorToken_IP_MOD:
-            return khstring_new(U"%=");
+            return "%=";
         case khOperatorToken_IP_DOT:
-            return khstring_new(U"@=");
+            return "@=";
         case khOperatorToken_IP_POW:
-            return khstring_new(U"^=");
+            return "^=";
 
         case khOperatorToken_EQUAL:
-            return khstring_new(U"==");
+            return "==";
         case khOperatorToken_UNEQUAL:
-            return khstring_new(U"!=");
+            return "!=";
         case khOperatorToken_LESS:
-            return khstring_new(U"<");
+            return "<";
         case khOperatorToken_GREATER:
-            return khstring_new(U">");
+            return ">";
         case khOperatorToken_LESS_EQUAL:
-            return khstring_new(U"<=");
+            return "<=";
         case khOperatorToken_GREATER_EQUAL:
-            return khstring_new(U">=");
+            return ">=";
 
         case khOperatorToken_NOT:
-            return khstring_new(U"not");
+            return "not";
         case khOperatorToken_AND:
-            return khstring_new(U"and");
+            return "and";
         case khOperatorToken_OR:
-            return khstring_new(U"or");
+            return "or";
         case khOperatorToken_XOR:
-            return khstring_new(U"xor");
+            return "xor";
 
         case khOperatorToken_BIT_NOT:
-            return khstring_new(U"~");
+            return "~";
         case khOperatorToken_BIT_AND:
-            return khstring_new(U"&");
+            return "&";
         case khOperatorToken_BIT_OR:
-            return khstring_new(U"|");
+            return "|";
         case khOperatorToken_BIT_LSHIFT:
-            return khstring_new(U"<<");
+            return "<<";
         case khOperatorToken_BIT_RSHIFT:
-            return khstring_new(U">>");
+            return ">>";
 
         case khOperatorToken_IP_BIT_AND:
-            return khstring_new(U"&=");
+            return "&=";
         case khOperatorToken_IP_BIT_OR:
-            return khstring_new(U"|=");
+            return "|=";
         case khOperatorToken_IP_BIT_XOR:
-            return khstring_new(U"~=");
+            return "~=";
         case khOperatorToken_IP_BIT_LSHIFT:
-            return khstring_new(U"<<=");
+            return "<<=";
         case khOperatorToken_IP_BIT_RSHIFT:
-            return khstring_new(U">>=");
-
-        default:
-            return khstring_new(U"unknown");
-    }
-}
-
-
-khToken khToken_copy(khToken* token) {
-    khToken copy = *token;
-
-    switch (token->type) {
-        case khTokenType_IDENTIFIER:
-            copy.identifier = khstring_copy(&token->identifier);
-            break;
-
-        case khTokenType_STRING:
-            copy.string = khstring_copy(&token->string);
-            break;
-
-        case khTokenType_BUFFER:
-            copy.buffer = khbuffer_copy(&token->buffer);
-            break;
+            return ">>=";
 
         default:
-            break;
+            return "unknown";
     }
-
-    return copy;
 }
 
-void khToken_delete(khToken* token) {
-    switch (token->type) {
-        case khTokenType_IDENTIFIER:
-            khstring_delete(&token->identifier);
-            break;
-
-        case khTokenType_STRING:
-            khstring_delete(&token->string);
-            break;
-
-        case khTokenType_BUFFER:
-            khbuffer_delete(&token->buffer);
-            break;
-
-        default:
-            break;
-    }
+khstring khOperatorToken_string(khOperatorToken operator_v) {
+    const char* name = khOperatorToken_name(operator_v);
+    return kh_decodeUtf8Memory((const uint8_t*)name, strlen(name));
 }
 
-khstring khToken_string(khToken* token, char32_t* origin) {
-    khstring string = khstring_new(U"{\"type\": ");
 
-    khstring type_str = khTokenType_string(token->type);
-    khstring quoted_type_str = khstring_quote(&type_str);
-    khstring_concatenate(&string, &quoted_type_str);
+void khToken_write(khToken* token, uint8_t* origin, khWriter* writer) {
+    khWriter_cstring(writer, "{\"type\": ");
+    khWriter_quoteCstring(writer, khTokenType_name(token->type));
 
-    khstring_concatenateCstring(&string, U", \"begin\": ");
+    khWriter_cstring(writer, ", \"begin\": ");
     if (token->begin != NULL) {
-        khstring begin_str = kh_uintToString(token->begin - origin, 10);
-        khstring_concatenate(&string, &begin_str);
-        khstring_delete(&begin_str);
+        khWriter_uint(writer, token->begin - origin, 10);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"end\": ");
-    if (token->end != NULL) {
-        khstring end_str = kh_uintToString(token->end - origin, 10);
-        khstring_concatenate(&string, &end_str);
-        khstring_delete(&end_str);
+    khWriter_cstring(writer, ", \"end\": ");
+    if (token->begin != NULL) {
+        khWriter_uint(writer, khToken_end(token) - origin, 10);
     }
     else {
-        khstring_concatenateCstring(&string, U"null");
+        khWriter_cstring(writer, "null");
     }
 
-    khstring_concatenateCstring(&string, U", \"value\": ");
-    khstring value;
+    khWriter_cstring(writer, ", \"value\": ");
     switch (token->type) {
         case khTokenType_IDENTIFIER:
-            value = khstring_quote(&token->identifier);
+            khWriter_quote(writer, &token->identifier);
+            break;
+        case khTokenType_KEYWORD:
+            khWriter_quoteCstring(writer, khKeywordToken_name(token->keyword));
+            break;
+        case khTokenType_DELIMITER:
+            khWriter_quoteCstring(writer, khDelimiterToken_name(token->delimiter));
+            break;
+        case khTokenType_OPERATOR:
+            khWriter_quoteCstring(writer, khOperatorToken_name(token->operator_v));
             break;
-        case khTokenType_KEYWORD: {
-            khstring keyword_str = khKeywordToken_string(token->keyword);
-            value = khstring_quote(&keyword_str);
-            khstring_delete(&keyword_str);
-        } break;
-        case khTokenType_DELIMITER: {
-            khstring delimiter_str = khDelimiterToken_string(token->delimiter);
-            value = khstring_quote(&delimiter_str);
-            khstring_delete(&delimiter_str);
-        } break;
-        case khTokenType_OPERATOR: {
-            khstring operator_str = khOperatorToken_string(token->operator_v);
-            value = khstring_quote(&operator_str);
-            khstring_delete(&operator_str);
-        } break;
 
         case khTokenType_CHAR:
-            khstring_append(&string, U'\"');
-            value = kh_escapeChar(token->char_v);
-            khstring_append(&value, U'\"');
+            khWriter_byte(writer, '\"');
+            khWriter_escapeChar(writer, token->char_v);
+            khWriter_byte(writer, '\"');
             break;
-        case khTokenType_STRING:
-            value = khstring_quote(&token->string);
+        case khTokenType_STRING: {
+            khstring string = kh_decodeString(token, NULL);
+            khWriter_quote(writer, &string);
+            khstring_delete(&string);
             break;
-        case khTokenType_BUFFER:
-            value = khbuffer_quote(&token->buffer);
+        }
+        case khTokenType_BUFFER: {
+            khbuffer buffer = kh_decodeBuffer(token, NULL);
+            khWriter_quoteBuffer(writer, &buffer);
+            khbuffer_delete(&buffer);
             break;
+        }
 
         case khTokenType_BYTE:
-            khstring_append(&string, U'\"');
-            value = kh_escapeChar(token->byte);
-            khstring_append(&value, U'\"');
+            khWriter_byte(writer, '\"');
+            khWriter_escapeChar(writer, token->byte);
+            khWriter_byte(writer, '\"');
             break;
         case khTokenType_INTEGER:
-            value = kh_intToString(token->integer, 10);
+            khWriter_int(writer, token->integer, 10);
             break;
         case khTokenType_UINTEGER:
-            value = kh_uintToString(token->uinteger, 10);
+            khWriter_uint(writer, token->uinteger, 10);
             break;
         case khTokenType_FLOAT:
-            value = kh_floatToString(token->float_v, 8, 10);
+            khWriter_float(writer, token->float_v, 8, 10);
             break;
         case khTokenType_DOUBLE:
-            value = kh_floatToString(token->double_v, 16, 10);
+            khWriter_float(writer, token->double_v, 16, 10);
             break;
         case khTokenType_IFLOAT:
-            value = kh_floatToString(token->ifloat, 8, 10);
+            khWriter_float(writer, token->ifloat, 8, 10);
             break;
         case khTokenType_IDOUBLE:
-            value = kh_floatToString(token->idouble, 16, 10);
+            khWriter_float(writer, token->idouble, 16, 10);
             break;
 
         default:
-            value = khstring_new(U"null");
+            khWriter_cstring(writer, "null");
             break;
     }
 
-    khstring_concatenate(&string, &value);
-    khstring_delete(&value);
-    khstring_append(&string, U'}');
+    khWriter_byte(writer, '}');
+}
 
+khstring khToken_string(khToken* token, uint8_t* origin) {
+    khWriter writer = khWriter_new(NULL);
+    khToken_write(token, origin, &writer);
+    khstring string = khWriter_take(&writer);
+    khWriter_delete(&writer);
     return string;
 }
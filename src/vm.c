@@ -0,0 +1,431 @@
+/*
+ * This file is a part of the Kithare programming language source code.
+ * The source code for Kithare programming language is distributed under the MIT license,
+ *     and it is available as a repository at https://github.com/Kithare/Kithare
+ * Copyright (C) 2022 Kithare Organization at https://www.kithare.de
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <kithare/core/bytecode.h>
+#include <kithare/core/error.h>
+#include <kithare/core/vm.h>
+#include <kithare/lib/array.h>
+#include <kithare/lib/string.h>
+#include <kithare/lib/writer.h>
+
+
+// Frames are contiguous windows of the registers, which are 8MiB, and calls can only be this deep
+#define REGISTERS (1 << 20)
+#define MAX_DEPTH (1 << 16)
+
+typedef struct {
+    khBytecodeFunction* function;
+    khInstruction* pc; // Where the caller continues
+    khValue* base;
+} Frame;
+
+
+static inline void raiseError(uint8_t* ptr, const char32_t* message) {
+    kh_raiseError(
+        (khError){.type = khErrorType_RUNTIME, .message = khstring_new(message), .data = ptr});
+}
+
+uint64_t kh_powUint(uint64_t base, uint64_t exponent) {
+    uint64_t result = 1;
+    for (; exponent > 0; exponent >>= 1) {
+        if (exponent & 1) {
+            result *= base;
+        }
+        base *= base;
+    }
+    return result;
+}
+
+int64_t kh_powInt(int64_t base, int64_t exponent) {
+    if (exponent < 0) {
+        return base == 1 ? 1 : base == -1 ? (exponent & 1 ? -1 : 1) : 0;
+    }
+    return (int64_t)kh_powUint((uint64_t)base, (uint64_t)exponent);
+}
+
+// Saturated, and NaN being 0, instead of being undefined
+static inline int64_t floatToInt(double value) {
+    if (isnan(value)) {
+        return 0;
+    }
+    else if (value >= 9223372036854775807.0) {
+        return INT64_MAX;
+    }
+    else if (value <= -9223372036854775808.0) {
+        return INT64_MIN;
+    }
+    return (int64_t)value;
+}
+
+
+bool kh_execute(khBytecode* bytecode, khWriter* output) {
+    khValue* stack = calloc(REGISTERS, sizeof(khValue));
+    Frame* frames = malloc(MAX_DEPTH * sizeof(Frame));
+    size_t depth = 0;
+
+    khBytecodeFunction* function = &bytecode->functions[0];
+    khValue* base = stack;
+    khInstruction* pc = function->code;
+    khInstruction instruction;
+    const char32_t* error = NULL;
+
+    if (function->registers > REGISTERS) {
+        raiseError(function->positions[0], U"stack overflow");
+        free(stack);
+        free(frames);
+        return false;
+    }
+
+// Signed arithmetic wraps around, done unsigned
+#define A (base[instruction.a])
+#define B (base[instruction.b])
+#define C (base[instruction.c])
+#define WRAP(OPERATOR) (int64_t)((uint64_t)B.integer OPERATOR(uint64_t) C.integer)
+
+    // Threaded, each operation jumping straight to the next one, where there are labels as values;
+    // otherwise, a switch in a loop
+#ifdef __GNUC__
+    static const void* labels[khOpcode_COUNT] = {
+        [khOpcode_MOVE] = &&op_MOVE,
+        [khOpcode_LOAD_INT] = &&op_LOAD_INT,
+        [khOpcode_LOAD_CONSTANT] = &&op_LOAD_CONSTANT,
+        [khOpcode_LOAD_STRING] = &&op_LOAD_STRING,
+        [khOpcode_INT_TO_FLOAT] = &&op_INT_TO_FLOAT,
+        [khOpcode_FLOAT_TO_INT] = &&op_FLOAT_TO_INT,
+        [khOpcode_TO_BOOL] = &&op_TO_BOOL,
+        [khOpcode_ADD_INT] = &&op_ADD_INT,
+        [khOpcode_ADD_INT_IMMEDIATE] = &&op_ADD_INT_IMMEDIATE,
+        [khOpcode_SUB_INT] = &&op_SUB_INT,
+        [khOpcode_MUL_INT] = &&op_MUL_INT,
+        [khOpcode_DIV_INT] = &&op_DIV_INT,
+        [khOpcode_MOD_INT] = &&op_MOD_INT,
+        [khOpcode_POW_INT] = &&op_POW_INT,
+        [khOpcode_NEGATE_INT] = &&op_NEGATE_INT,
+        [khOpcode_BIT_AND] = &&op_BIT_AND,
+        [khOpcode_BIT_OR] = &&op_BIT_OR,
+        [khOpcode_BIT_XOR] = &&op_BIT_XOR,
+        [khOpcode_BIT_NOT] = &&op_BIT_NOT,
+        [khOpcode_BIT_LSHIFT] = &&op_BIT_LSHIFT,
+        [khOpcode_BIT_RSHIFT] = &&op_BIT_RSHIFT,
+        [khOpcode_ADD_FLOAT] = &&op_ADD_FLOAT,
+        [khOpcode_SUB_FLOAT] = &&op_SUB_FLOAT,
+        [khOpcode_MUL_FLOAT] = &&op_MUL_FLOAT,
+        [khOpcode_DIV_FLOAT] = &&op_DIV_FLOAT,
+        [khOpcode_MOD_FLOAT] = &&op_MOD_FLOAT,
+        [khOpcode_POW_FLOAT] = &&op_POW_FLOAT,
+        [khOpcode_NEGATE_FLOAT] = &&op_NEGATE_FLOAT,
+        [khOpcode_EQUAL_INT] = &&op_EQUAL_INT,
+        [khOpcode_UNEQUAL_INT] = &&op_UNEQUAL_INT,
+        [khOpcode_LESS_INT] = &&op_LESS_INT,
+        [khOpcode_LESS_EQUAL_INT] = &&op_LESS_EQUAL_INT,
+        [khOpcode_EQUAL_FLOAT] = &&op_EQUAL_FLOAT,
+        [khOpcode_UNEQUAL_FLOAT] = &&op_UNEQUAL_FLOAT,
+        [khOpcode_LESS_FLOAT] = &&op_LESS_FLOAT,
+        [khOpcode_LESS_EQUAL_FLOAT] = &&op_LESS_EQUAL_FLOAT,
+        [khOpcode_NOT] = &&op_NOT,
+        [khOpcode_JUMP] = &&op_JUMP,
+        [khOpcode_JUMP_IF] = &&op_JUMP_IF,
+        [khOpcode_JUMP_UNLESS] = &&op_JUMP_UNLESS,
+        [khOpcode_CALL] = &&op_CALL,
+        [khOpcode_RETURN] = &&op_RETURN,
+        [khOpcode_RETURN_NONE] = &&op_RETURN_NONE,
+        [khOpcode_MISSING_RETURN] = &&op_MISSING_RETURN,
+        [khOpcode_PRINT_INT] = &&op_PRINT_INT,
+        [khOpcode_PRINT_FLOAT] = &&op_PRINT_FLOAT,
+        [khOpcode_PRINT_BOOL] = &&op_PRINT_BOOL,
+        [khOpcode_PRINT_STRING] = &&op_PRINT_STRING,
+        [khOpcode_PRINT_CHAR] = &&op_PRINT_CHAR};
+
+#define OPERATION(NAME) op_##NAME:
+#define DISPATCH() goto* labels[(instruction = *pc++).opcode]
+
+    DISPATCH();
+#else
+#define OPERATION(NAME) case khOpcode_##NAME:
+#define DISPATCH() goto dispatch
+
+dispatch:
+    instruction = *pc++;
+    switch (instruction.opcode) {
+#endif
+
+    OPERATION(MOVE) {
+        A = B;
+        DISPATCH();
+    }
+    OPERATION(LOAD_INT) {
+        A.integer = instruction.wide;
+        DISPATCH();
+    }
+    OPERATION(LOAD_CONSTANT) {
+        A = bytecode->constants[instruction.wide];
+        DISPATCH();
+    }
+    OPERATION(LOAD_STRING) {
+        A.string = &bytecode->strings[instruction.wide];
+        DISPATCH();
+    }
+
+    OPERATION(INT_TO_FLOAT) {
+        A.float_v = (double)B.integer;
+        DISPATCH();
+    }
+    OPERATION(FLOAT_TO_INT) {
+        A.integer = floatToInt(B.float_v);
+        DISPATCH();
+    }
+    OPERATION(TO_BOOL) {
+        A.integer = B.integer != 0;
+        DISPATCH();
+    }
+
+    OPERATION(ADD_INT) {
+        A.integer = WRAP(+);
+        DISPATCH();
+    }
+    OPERATION(ADD_INT_IMMEDIATE) {
+        A.integer = (int64_t)((uint64_t)B.integer + (uint64_t)(int64_t)(int16_t)instruction.c);
+        DISPATCH();
+    }
+    OPERATION(SUB_INT) {
+        A.integer = WRAP(-);
+        DISPATCH();
+    }
+    OPERATION(MUL_INT) {
+        A.integer = WRAP(*);
+        DISPATCH();
+    }
+    OPERATION(DIV_INT) {
+        if (C.integer == 0) {
+            error = U"division by zero";
+            goto end;
+        }
+        // Dividing the least int by -1 overflows
+        A.integer = C.integer == -1 ? (int64_t)(0 - (uint64_t)B.integer) : B.integer / C.integer;
+        DISPATCH();
+    }
+    OPERATION(MOD_INT) {
+        if (C.integer == 0) {
+            error = U"modulo by zero";
+            goto end;
+        }
+        A.integer = C.integer == -1 ? 0 : B.integer % C.integer;
+        DISPATCH();
+    }
+    OPERATION(POW_INT) {
+        A.integer = kh_powInt(B.integer, C.integer);
+        DISPATCH();
+    }
+    OPERATION(NEGATE_INT) {
+        A.integer = (int64_t)(0 - (uint64_t)B.integer);
+        DISPATCH();
+    }
+    OPERATION(BIT_AND) {
+        A.integer = B.integer & C.integer;
+        DISPATCH();
+    }
+    OPERATION(BIT_OR) {
+        A.integer = B.integer | C.integer;
+        DISPATCH();
+    }
+    OPERATION(BIT_XOR) {
+        A.integer = B.integer ^ C.integer;
+        DISPATCH();
+    }
+    OPERATION(BIT_NOT) {
+        A.integer = ~B.integer;
+        DISPATCH();
+    }
+    OPERATION(BIT_LSHIFT) {
+        A.integer = (int64_t)((uint64_t)B.integer << (C.integer & 63));
+        DISPATCH();
+    }
+    OPERATION(BIT_RSHIFT) {
+        A.integer = B.integer >> (C.integer & 63);
+        DISPATCH();
+    }
+
+    OPERATION(ADD_FLOAT) {
+        A.float_v = B.float_v + C.float_v;
+        DISPATCH();
+    }
+    OPERATION(SUB_FLOAT) {
+        A.float_v = B.float_v - C.float_v;
+        DISPATCH();
+    }
+    OPERATION(MUL_FLOAT) {
+        A.float_v = B.float_v * C.float_v;
+        DISPATCH();
+    }
+    OPERATION(DIV_FLOAT) {
+        A.float_v = B.float_v / C.float_v;
+        DISPATCH();
+    }
+    OPERATION(MOD_FLOAT) {
+        A.float_v = fmod(B.float_v, C.float_v);
+        DISPATCH();
+    }
+    OPERATION(POW_FLOAT) {
+        A.float_v = pow(B.float_v, C.float_v);
+        DISPATCH();
+    }
+    OPERATION(NEGATE_FLOAT) {
+        A.float_v = -B.float_v;
+        DISPATCH();
+    }
+
+    OPERATION(EQUAL_INT) {
+        A.integer = B.integer == C.integer;
+        DISPATCH();
+    }
+    OPERATION(UNEQUAL_INT) {
+        A.integer = B.integer != C.integer;
+        DISPATCH();
+    }
+    OPERATION(LESS_INT) {
+        A.integer = B.integer < C.integer;
+        DISPATCH();
+    }
+    OPERATION(LESS_EQUAL_INT) {
+        A.integer = B.integer <= C.integer;
+        DISPATCH();
+    }
+    OPERATION(EQUAL_FLOAT) {
+        A.integer = B.float_v == C.float_v;
+        DISPATCH();
+    }
+    OPERATION(UNEQUAL_FLOAT) {
+        A.integer = B.float_v != C.float_v;
+        DISPATCH();
+    }
+    OPERATION(LESS_FLOAT) {
+        A.integer = B.float_v < C.float_v;
+        DISPATCH();
+    }
+    OPERATION(LESS_EQUAL_FLOAT) {
+        A.integer = B.float_v <= C.float_v;
+        DISPATCH();
+    }
+    OPERATION(NOT) {
+        A.integer = B.integer == 0;
+        DISPATCH();
+    }
+
+    OPERATION(JUMP) {
+        pc += instruction.wide;
+        DISPATCH();
+    }
+    OPERATION(JUMP_IF) {
+        if (A.integer != 0) {
+            pc += instruction.wide;
+        }
+        DISPATCH();
+    }
+    OPERATION(JUMP_UNLESS) {
+        if (A.integer == 0) {
+            pc += instruction.wide;
+        }
+        DISPATCH();
+    }
+
+    OPERATION(CALL) {
+        khBytecodeFunction* callee = &bytecode->functions[instruction.wide];
+        khValue* callee_base = base + instruction.a;
+        if (depth == MAX_DEPTH || callee_base + callee->registers > stack + REGISTERS) {
+            error = U"stack overflow";
+            goto end;
+        }
+
+        frames[depth++] = (Frame){.function = function, .pc = pc, .base = base};
+        function = callee;
+        base = callee_base;
+        pc = callee->code;
+        DISPATCH();
+    }
+    OPERATION(RETURN) {
+        khValue value = A;
+        if (depth == 0) {
+            goto end;
+        }
+
+        Frame* frame = &frames[--depth];
+        base[0] = value;
+        function = frame->function;
+        pc = frame->pc;
+        base = frame->base;
+        DISPATCH();
+    }
+    OPERATION(RETURN_NONE) {
+        if (depth == 0) {
+            goto end;
+        }
+
+        Frame* frame = &frames[--depth];
+        function = frame->function;
+        pc = frame->pc;
+        base = frame->base;
+        DISPATCH();
+    }
+    OPERATION(MISSING_RETURN) {
+        error = U"reached the end of a function without returning a value";
+        goto end;
+    }
+
+    OPERATION(PRINT_INT) {
+        khWriter_int(output, A.integer, 10);
+        goto separate;
+    }
+    OPERATION(PRINT_FLOAT) {
+        khWriter_float(output, A.float_v, 6, 10);
+        goto separate;
+    }
+    OPERATION(PRINT_BOOL) {
+        khWriter_cstring(output, A.integer ? "true" : "false");
+        goto separate;
+    }
+    OPERATION(PRINT_STRING) {
+        khWriter_string(output, A.string);
+        goto separate;
+    }
+    OPERATION(PRINT_CHAR) {
+        khWriter_char(output, instruction.b);
+        DISPATCH();
+    }
+
+#ifndef __GNUC__
+    default:
+        goto end;
+    }
+#endif
+
+separate:
+    if (instruction.b != 0) {
+        khWriter_char(output, instruction.b);
+    }
+    DISPATCH();
+
+#undef A
+#undef B
+#undef C
+#undef WRAP
+#undef OPERATION
+#undef DISPATCH
+
+end:
+    if (error != NULL) {
+        raiseError(function->positions[pc - function->code - 1], error);
+    }
+
+    free(stack);
+    free(frames);
+    return error == NULL;
+}